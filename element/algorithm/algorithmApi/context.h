@@ -19,6 +19,7 @@
 
 #include "common/bmnn_utils.h"
 #include "common/common_defs.h"
+#include "common/device_memory_pool.h"
 #include "common/object_metadata.h"
 
 namespace sophon_stream {
@@ -34,6 +35,23 @@ class Context {
   virtual ~Context() = default;
 };
 
+/**
+ * @brief 取batch输入tensor中第slot个位置的第inputIndex个输入的显存
+ */
+inline bool getBatchSlotMem(const std::shared_ptr<common::bmTensors>& batch,
+                            int inputIndex, int slot, int maxBatch,
+                            bm_device_mem_t* mem) {
+  if (batch == nullptr || slot < 0 || slot >= maxBatch ||
+      inputIndex >= batch->tensors.size())
+    return false;
+  const bm_device_mem_t& batchMem = batch->tensors[inputIndex]->device_mem;
+  unsigned int slotBytes = bm_mem_get_device_size(batchMem) / maxBatch;
+  *mem = bm_mem_from_device(
+      bm_mem_get_device_addr(batchMem) + (unsigned long long)slot * slotBytes,
+      slotBytes);
+  return true;
+}
+
 }  // namespace element
 }  // namespace sophon_stream
 
@@ -22,6 +22,10 @@ class Inference {
                 nullptr>
   std::shared_ptr<sophon_stream::common::bmTensors> mergeInputDeviceMem(
       std::shared_ptr<T> context, common::ObjectMetadatas& objectMetadatas) {
+    // 前处理已经把整批结果写进同一个batch输入tensor时直接使用，不再拷贝
+    auto filledBatch = getFilledBatch(context, objectMetadatas);
+    if (filledBatch != nullptr) return filledBatch;
+
     // 合并inputBMtensors，并且申请连续的outputBMtensors
     std::shared_ptr<sophon_stream::common::bmTensors> inputTensors =
         std::make_shared<sophon_stream::common::bmTensors>();
@@ -30,7 +34,8 @@ class Inference {
         [](sophon_stream::common::bmTensors* p) {
           for (int i = 0; i < p->tensors.size(); ++i)
             if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-              bm_free_device(p->handle, p->tensors[i]->device_mem);
+              common::SingletonDeviceMemoryPool::getInstance().free(
+                  p->handle, p->tensors[i]->device_mem);
             }
           delete p;
           p = nullptr;
@@ -51,7 +56,7 @@ class Inference {
       if (BM_FLOAT32 == context->bmNetwork->m_netinfo->input_dtypes[0])
         input_bytes *= 4;
       // malloc空间
-      auto ret = bm_malloc_device_byte_heap(
+      auto ret = common::SingletonDeviceMemoryPool::getInstance().allocHeap(
           inputTensors->handle, &inputTensors->tensors[i]->device_mem, STREAM_NPU_HEAP,
           input_bytes);
       STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
@@ -68,6 +73,36 @@ class Inference {
     return inputTensors;
   }
 
+  /**
+   * @brief 所有帧都按顺序写在同一个batch输入tensor中时返回该tensor，否则返回nullptr
+   */
+  template <typename T, typename U = Context,
+            typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
+                nullptr>
+  std::shared_ptr<sophon_stream::common::bmTensors> getFilledBatch(
+      std::shared_ptr<T> context, common::ObjectMetadatas& objectMetadatas) {
+    if (objectMetadatas.empty() ||
+        objectMetadatas[0]->mInputBMtensors == nullptr)
+      return nullptr;
+    auto batch = objectMetadatas[0]->mInputBMtensors->batch;
+    if (batch == nullptr) return nullptr;
+    for (int j = 0; j < objectMetadatas.size(); ++j) {
+      if (objectMetadatas[j]->mFrame->mEndOfStream) break;
+      auto& inputTensors = objectMetadatas[j]->mInputBMtensors;
+      if (inputTensors == nullptr || inputTensors->batch != batch ||
+          inputTensors->batch_slot != j)
+        return nullptr;
+      for (int i = 0; i < context->input_num; ++i) {
+        bm_device_mem_t slotMem;
+        if (!getBatchSlotMem(batch, i, j, context->max_batch, &slotMem) ||
+            bm_mem_get_device_addr(slotMem) !=
+                bm_mem_get_device_addr(inputTensors->tensors[i]->device_mem))
+          return nullptr;
+      }
+    }
+    return batch;
+  }
+
   template <typename T, typename U = Context,
             typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
                 nullptr>
@@ -80,7 +115,8 @@ class Inference {
         [](sophon_stream::common::bmTensors* p) {
           for (int i = 0; i < p->tensors.size(); ++i)
             if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-              bm_free_device(p->handle, p->tensors[i]->device_mem);
+              common::SingletonDeviceMemoryPool::getInstance().free(
+                  p->handle, p->tensors[i]->device_mem);
             }
           delete p;
           p = nullptr;
@@ -111,7 +147,7 @@ class Inference {
         max_size *= 2;
       
       // malloc空间
-      auto ret = bm_malloc_device_byte_heap(
+      auto ret = common::SingletonDeviceMemoryPool::getInstance().allocHeap(
           outputTensors->handle, &outputTensors->tensors[i]->device_mem, STREAM_NPU_HEAP,
           max_size);
       STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
@@ -135,7 +171,8 @@ class Inference {
           [](sophon_stream::common::bmTensors* p) {
             for (int i = 0; i < p->tensors.size(); ++i)
               if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-                bm_free_device(p->handle, p->tensors[i]->device_mem);
+                common::SingletonDeviceMemoryPool::getInstance().free(
+                  p->handle, p->tensors[i]->device_mem);
               }
             delete p;
             p = nullptr;
@@ -163,7 +200,7 @@ class Inference {
         if (BM_FLOAT32 == context->bmNetwork->m_netinfo->output_dtypes[j])
           max_size *= 4;
         max_size /= context->max_batch;
-        auto ret = bm_malloc_device_byte_heap(
+        auto ret = common::SingletonDeviceMemoryPool::getInstance().allocHeap(
             objectMetadatas[i]->mOutputBMtensors->handle,
             &objectMetadatas[i]->mOutputBMtensors->tensors[j]->device_mem, STREAM_NPU_HEAP,
             max_size);
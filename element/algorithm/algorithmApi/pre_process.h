@@ -10,7 +10,9 @@
 #ifndef SOPHON_STREAM_ELEMENT_ALGORITHMAPI_PREPROCESS_H_
 #define SOPHON_STREAM_ELEMENT_ALGORITHMAPI_PREPROCESS_H_
 
+#include "common/fused_preprocess.h"
 #include "context.h"
+#include "tiling.h"
 
 namespace sophon_stream {
 namespace element {
@@ -45,12 +47,21 @@ class PreProcess {
           std::make_shared<sophon_stream::common::bmTensors>();
       int channelId = obj->mFrame->mChannelId;
       int frameId = obj->mFrame->mFrameId;
+      int maxBatch = context->max_batch;
       obj->mInputBMtensors.reset(
           new sophon_stream::common::bmTensors(),
-          [channelId, frameId](sophon_stream::common::bmTensors* p) {
+          [channelId, frameId, maxBatch](sophon_stream::common::bmTensors* p) {
             for (int i = 0; i < p->tensors.size(); ++i) {
+              // 写在batch输入tensor中的显存随batch一起释放
+              bm_device_mem_t slotMem;
+              if (getBatchSlotMem(p->batch, i, p->batch_slot, maxBatch,
+                                  &slotMem) &&
+                  bm_mem_get_device_addr(slotMem) ==
+                      bm_mem_get_device_addr(p->tensors[i]->device_mem))
+                continue;
               if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-                bm_free_device(p->handle, p->tensors[i]->device_mem);
+                common::SingletonDeviceMemoryPool::getInstance().free(
+                  p->handle, p->tensors[i]->device_mem);
               }
             }
 
@@ -70,6 +81,151 @@ class PreProcess {
       }
     }
   }
+
+  /**
+   * @brief 申请第index个ObjectMetadata第inputIndex个输入的显存，前处理结果写入其中。
+   * max_batch>1时在本批共享的batch输入tensor中取第index个位置，
+   * 推理时直接使用整个batch，省去mergeInputDeviceMem的拷贝；
+   * 取不到位置时单独申请显存。需要先调用initTensors
+   */
+  template <typename T, typename U = Context,
+            typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
+                nullptr>
+  bm_status_t getInputDeviceMem(std::shared_ptr<T> context,
+                                common::ObjectMetadatas& objectMetadatas,
+                                int index, int inputIndex, int sizeByte,
+                                bm_device_mem_t* mem) {
+    auto& inputTensors = objectMetadatas[index]->mInputBMtensors;
+    if (context->max_batch > 1 &&
+        objectMetadatas.size() <= context->max_batch) {
+      if (inputTensors->batch == nullptr)
+        reserveBatchSlots(context, objectMetadatas);
+      if (getBatchSlotMem(inputTensors->batch, inputIndex,
+                          inputTensors->batch_slot, context->max_batch, mem) &&
+          bm_mem_get_device_size(*mem) >= sizeByte) {
+        bm_mem_set_device_size(mem, sizeByte);
+        return BM_SUCCESS;
+      }
+    }
+    return common::SingletonDeviceMemoryPool::getInstance().allocHeap(
+        context->handle, mem, STREAM_NPU_HEAP, sizeByte);
+  }
+
+  /**
+   * @brief 在CPU上用融合算子完成一帧的前处理，代替
+   * storage_convert -> copy_to -> vpp_convert_padding -> convert_to的链式调用，
+   * 用于没有VPP的主机。只支持NV12/YUV420P输入和FP32/INT8模型，
+   * 不支持时返回false，由调用者走原来的流程
+   */
+  template <typename T, typename U = Context,
+            typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
+                nullptr>
+  bool fusedPreProcessFrame(std::shared_ptr<T> context,
+                            common::ObjectMetadatas& objectMetadatas,
+                            int index) {
+    bm_image& image = *objectMetadatas[index]->mFrame->mSpData;
+    common::YuvImageView view;
+    if (image.image_format == FORMAT_NV12) {
+      view.format = common::YuvFormat::NV12;
+    } else if (image.image_format == FORMAT_YUV420P) {
+      view.format = common::YuvFormat::YUV420P;
+    } else {
+      return false;
+    }
+    auto dtype = context->bmNetwork->m_netinfo->input_dtypes[0];
+    if (dtype != BM_FLOAT32 && dtype != BM_INT8) return false;
+
+    int planeNum = bm_image_get_plane_num(image);
+    int sizes[3] = {0};
+    bm_image_get_byte_size(image, sizes);
+    bm_image_get_stride(image, view.stride);
+    thread_local std::vector<uint8_t> hostImage;
+    hostImage.resize(sizes[0] + sizes[1] + sizes[2]);
+    void* buffers[3] = {nullptr};
+    for (int i = 0, offset = 0; i < planeNum; offset += sizes[i], ++i)
+      buffers[i] = hostImage.data() + offset;
+    if (bm_image_copy_device_to_host(image, buffers) != BM_SUCCESS)
+      return false;
+    view.width = image.width;
+    view.height = image.height;
+    for (int i = 0; i < planeNum; ++i)
+      view.data[i] = static_cast<const uint8_t*>(buffers[i]);
+
+    common::FusedPreprocessParam param;
+    param.netW = context->net_w;
+    param.netH = context->net_h;
+    param.bgr2rgb = context->bgr2rgb;
+    param.alpha[0] = context->converto_attr.alpha_0;
+    param.alpha[1] = context->converto_attr.alpha_1;
+    param.alpha[2] = context->converto_attr.alpha_2;
+    param.beta[0] = context->converto_attr.beta_0;
+    param.beta[1] = context->converto_attr.beta_1;
+    param.beta[2] = context->converto_attr.beta_2;
+    if (context->roi_predefined ||
+        !objectMetadatas[index]->mTileRect.empty()) {
+      bmcv_rect_t rect = tiling::cropRect(context, *objectMetadatas[index]);
+      param.roiX = rect.start_x;
+      param.roiY = rect.start_y;
+      param.roiW = rect.crop_w;
+      param.roiH = rect.crop_h;
+    }
+
+    int count = 3 * context->net_w * context->net_h;
+    int sizeByte = count * bmrt_data_type_size(dtype);
+    thread_local std::vector<uint8_t> hostTensor;
+    hostTensor.resize(sizeByte);
+    if (dtype == BM_INT8)
+      common::fusedPreprocess(view, param,
+                              reinterpret_cast<int8_t*>(hostTensor.data()));
+    else
+      common::fusedPreprocess(view, param,
+                              reinterpret_cast<float*>(hostTensor.data()));
+
+    bm_device_mem_t mem;
+    auto ret =
+        getInputDeviceMem(context, objectMetadatas, index, 0, sizeByte, &mem);
+    STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
+    bm_memcpy_s2d_partial(context->handle, mem, hostTensor.data(), sizeByte);
+    objectMetadatas[index]->mInputBMtensors->tensors[0]->device_mem = mem;
+    return true;
+  }
+
+ private:
+  template <typename T>
+  void reserveBatchSlots(std::shared_ptr<T> context,
+                         common::ObjectMetadatas& objectMetadatas) {
+    std::shared_ptr<sophon_stream::common::bmTensors> batch;
+    batch.reset(new sophon_stream::common::bmTensors(),
+                [](sophon_stream::common::bmTensors* p) {
+                  for (int i = 0; i < p->tensors.size(); ++i)
+                    if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
+                      common::SingletonDeviceMemoryPool::getInstance().free(
+                          p->handle, p->tensors[i]->device_mem);
+                    }
+                  delete p;
+                  p = nullptr;
+                });
+    batch->handle = context->handle;
+    batch->tensors.resize(context->input_num);
+    for (int i = 0; i < context->input_num; ++i) {
+      batch->tensors[i] = std::make_shared<bm_tensor_t>();
+      batch->tensors[i]->dtype = context->bmNetwork->m_netinfo->input_dtypes[i];
+      batch->tensors[i]->shape =
+          context->bmNetwork->m_netinfo->stages[0].input_shapes[i];
+      batch->tensors[i]->st_mode = BM_STORE_1N;
+      size_t bytes = bmrt_shape_count(&batch->tensors[i]->shape) *
+                     bmrt_data_type_size(batch->tensors[i]->dtype);
+      auto ret = common::SingletonDeviceMemoryPool::getInstance().allocHeap(
+          batch->handle, &batch->tensors[i]->device_mem, STREAM_NPU_HEAP,
+          bytes);
+      STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
+    }
+    for (int j = 0; j < objectMetadatas.size(); ++j) {
+      if (objectMetadatas[j]->mInputBMtensors == nullptr) continue;
+      objectMetadatas[j]->mInputBMtensors->batch = batch;
+      objectMetadatas[j]->mInputBMtensors->batch_slot = j;
+    }
+  }
 };
 }  // namespace element
 }  // namespace sophon_stream
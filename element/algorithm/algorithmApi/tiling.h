@@ -0,0 +1,276 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_ALGORITHMAPI_TILING_H_
+#define SOPHON_STREAM_ELEMENT_ALGORITHMAPI_TILING_H_
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/object_metadata.h"
+
+namespace sophon_stream {
+namespace element {
+
+/**
+ * @brief 高分辨率画面的切块推理。
+ * 把一帧切成互相重叠的块，每块作为一个ObjectMetadata占用检测模型的一个batch位置，
+ * 各块的检测框换算回原图后跨块合并。这里只有CPU上的切块与合并逻辑，不依赖模型
+ */
+namespace tiling {
+
+/**
+ * @brief 跨块合并方式：NMM把重合的框合并为它们的外接框，可以还原跨块目标的完整范围；
+ * NMS只保留一个框；WBF按分数加权平均重合的框
+ */
+enum class MergeMethod { NMM, NMS, WBF };
+
+/**
+ * @brief 跨块合并时两个框的重合度：IOU为交并比，
+ * IOS为交集占较小框的比例，被块边界截断的框与完整的框IOU不高，IOS接近1
+ */
+enum class MatchMetric { IOU, IOS };
+
+struct TileParams {
+  bool enabled = false;
+  int tileW = 640;
+  int tileH = 640;
+  /**
+   * @brief 相邻块重叠的比例，[0, 0.9]
+   */
+  float overlap = 0.2f;
+  /**
+   * @brief 是否再加一次整帧推理，与各块的结果一起合并，用于找回跨块的大目标
+   */
+  bool fullFrame = false;
+  /**
+   * @brief 帧带有mMotionRegions时只推理与变化区域相交的块
+   */
+  bool motionOnly = false;
+  MergeMethod mergeMethod = MergeMethod::NMM;
+  MatchMetric matchMetric = MatchMetric::IOS;
+  float mergeThreshold = 0.5f;
+};
+
+inline bool parseMergeMethod(const std::string& name, MergeMethod* method) {
+  if (name == "nmm") {
+    *method = MergeMethod::NMM;
+  } else if (name == "nms") {
+    *method = MergeMethod::NMS;
+  } else if (name == "wbf") {
+    *method = MergeMethod::WBF;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+inline bool parseMatchMetric(const std::string& name, MatchMetric* metric) {
+  if (name == "iou") {
+    *metric = MatchMetric::IOU;
+  } else if (name == "ios") {
+    *metric = MatchMetric::IOS;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 长为length的边上各块的起点。块数取满足重叠比例的最小值，
+ * 块在边上均匀分布，第一块从0开始，最后一块与边的末端对齐
+ */
+inline std::vector<int> tileOffsets(int length, int tile, float overlap) {
+  if (length <= tile || tile <= 0) return {0};
+  overlap = std::min(std::max(overlap, 0.f), 0.9f);
+  int step = std::max(static_cast<int>(tile * (1.f - overlap)), 1);
+  int num = (length - tile + step - 1) / step + 1;
+  std::vector<int> offsets(num);
+  for (int i = 0; i < num; ++i)
+    offsets[i] = static_cast<long long>(length - tile) * i / (num - 1);
+  return offsets;
+}
+
+/**
+ * @brief 区域area内的所有块，按行排列。area小于块时块与area相同
+ */
+inline std::vector<common::Rectangle<int>> planTiles(
+    const common::Rectangle<int>& area, const TileParams& params) {
+  int tileW = std::min(params.tileW, area.mWidth);
+  int tileH = std::min(params.tileH, area.mHeight);
+  std::vector<common::Rectangle<int>> tiles;
+  for (int y : tileOffsets(area.mHeight, tileH, params.overlap))
+    for (int x : tileOffsets(area.mWidth, tileW, params.overlap))
+      tiles.emplace_back(area.mX + x, area.mY + y, tileW, tileH);
+  return tiles;
+}
+
+inline bool intersects(const common::Rectangle<int>& a,
+                       const common::Rectangle<int>& b) {
+  return a.left() < b.right() && b.left() < a.right() && a.top() < b.bottom() &&
+         b.top() < a.bottom();
+}
+
+/**
+ * @brief 一帧要推理的区域：切块，按变化区域筛选，需要时再加上整个area
+ * @param[in] motionRegions : 帧的mMotionRegions，为空时不筛选
+ */
+inline std::vector<common::Rectangle<int>> frameTiles(
+    const common::Rectangle<int>& area,
+    const std::vector<common::Rectangle<int>>& motionRegions,
+    const TileParams& params) {
+  auto tiles = planTiles(area, params);
+  if (params.motionOnly && !motionRegions.empty()) {
+    tiles.erase(std::remove_if(tiles.begin(), tiles.end(),
+                               [&](const common::Rectangle<int>& tile) {
+                                 for (const auto& region : motionRegions)
+                                   if (intersects(tile, region)) return false;
+                                 return true;
+                               }),
+                tiles.end());
+  }
+  bool wholeArea = tiles.size() == 1 && tiles[0].mWidth == area.mWidth &&
+                   tiles[0].mHeight == area.mHeight;
+  if (params.fullFrame && !wholeArea) tiles.push_back(area);
+  return tiles;
+}
+
+/**
+ * @brief 每个块一个ObjectMetadata，与frame共用mFrame与mArena，mTileRect为块的位置。
+ * 块只在检测element内部经过前处理、推理、后处理，不向下游发送
+ */
+inline common::ObjectMetadatas makeTileObjectMetadatas(
+    const std::shared_ptr<common::ObjectMetadata>& frame,
+    const std::vector<common::Rectangle<int>>& tiles) {
+  common::ObjectMetadatas tileObjs;
+  tileObjs.reserve(tiles.size());
+  for (const auto& tile : tiles) {
+    auto tileObj = std::make_shared<common::ObjectMetadata>();
+    tileObj->mFrame = frame->mFrame;
+    tileObj->mArena = frame->mArena;
+    tileObj->mTileRect = tile;
+    tileObjs.push_back(tileObj);
+  }
+  return tileObjs;
+}
+
+/**
+ * @brief 前后处理中一个ObjectMetadata在原图中对应的区域：
+ * 切块时为所在的块，否则为配置的roi或整帧
+ */
+template <typename T>
+bmcv_rect_t cropRect(const T& context, const common::ObjectMetadata& obj) {
+  if (!obj.mTileRect.empty())
+    return {obj.mTileRect.mX, obj.mTileRect.mY, obj.mTileRect.mWidth,
+            obj.mTileRect.mHeight};
+  if (context->roi_predefined) return context->roi;
+  return {0, 0, obj.mFrame->mSpData->width, obj.mFrame->mSpData->height};
+}
+
+/**
+ * @brief 合并用的检测框，原图坐标。source为调用者的下标，合并后用来找回原来的结果
+ */
+struct Detection {
+  float x1, y1, x2, y2;
+  float score;
+  int classId;
+  int source;
+};
+
+inline float matchRatio(const Detection& a, const Detection& b,
+                        MatchMetric metric) {
+  float w = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+  float h = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+  if (w <= 0 || h <= 0) return 0.f;
+  float inter = w * h;
+  float areaA = (a.x2 - a.x1) * (a.y2 - a.y1);
+  float areaB = (b.x2 - b.x1) * (b.y2 - b.y1);
+  float denom = metric == MatchMetric::IOS ? std::min(areaA, areaB)
+                                           : areaA + areaB - inter;
+  return denom > 0 ? inter / denom : 0.f;
+}
+
+inline float boxArea(const Detection& det) {
+  return (det.x2 - det.x1) * (det.y2 - det.y1);
+}
+
+/**
+ * @brief 同类别的框按分数从高到低贪心聚类，与聚类中分数最高的框重合度超过阈值的归入该类。
+ * 比目标小的块只能看到目标的一部分，聚类中可能全是被块边界截断的框：
+ * NMM与聚类当前的外接框比较，外接框变大后重新检查剩下的框，结果为所有框的外接框；
+ * NMS保留聚类中面积最大的框，只有一个框完整时取到完整的框；
+ * WBF按分数加权平均坐标，适合与iou一起合并整帧推理和块中重复的完整框。
+ * 分数取最高值，返回的框按分数从高到低排列，source为聚类中分数最高的框的source
+ */
+inline std::vector<Detection> mergeDetections(std::vector<Detection> dets,
+                                              const TileParams& params) {
+  std::stable_sort(dets.begin(), dets.end(),
+                   [](const Detection& a, const Detection& b) {
+                     return a.score > b.score;
+                   });
+  std::vector<char> merged(dets.size(), 0);
+  std::vector<Detection> results;
+  for (size_t i = 0; i < dets.size(); ++i) {
+    if (merged[i]) continue;
+    Detection fused = dets[i];
+    Detection largest = dets[i];
+    float weight = dets[i].score;
+    float x1 = dets[i].x1 * weight, y1 = dets[i].y1 * weight;
+    float x2 = dets[i].x2 * weight, y2 = dets[i].y2 * weight;
+    bool grown = true;
+    while (grown) {
+      grown = false;
+      for (size_t j = i + 1; j < dets.size(); ++j) {
+        if (merged[j] || dets[j].classId != dets[i].classId) continue;
+        const Detection& anchor =
+            params.mergeMethod == MergeMethod::NMM ? fused : dets[i];
+        if (matchRatio(anchor, dets[j], params.matchMetric) <=
+            params.mergeThreshold)
+          continue;
+        merged[j] = 1;
+        float w = dets[j].score;
+        x1 += dets[j].x1 * w;
+        y1 += dets[j].y1 * w;
+        x2 += dets[j].x2 * w;
+        y2 += dets[j].y2 * w;
+        weight += w;
+        if (boxArea(dets[j]) > boxArea(largest)) largest = dets[j];
+        if (params.mergeMethod == MergeMethod::NMM) {
+          fused.x1 = std::min(fused.x1, dets[j].x1);
+          fused.y1 = std::min(fused.y1, dets[j].y1);
+          fused.x2 = std::max(fused.x2, dets[j].x2);
+          fused.y2 = std::max(fused.y2, dets[j].y2);
+          grown = true;
+        }
+      }
+    }
+    if (params.mergeMethod == MergeMethod::NMS) {
+      fused.x1 = largest.x1;
+      fused.y1 = largest.y1;
+      fused.x2 = largest.x2;
+      fused.y2 = largest.y2;
+    } else if (params.mergeMethod == MergeMethod::WBF && weight > 0) {
+      fused.x1 = x1 / weight;
+      fused.y1 = y1 / weight;
+      fused.x2 = x2 / weight;
+      fused.y2 = y2 / weight;
+    }
+    results.push_back(fused);
+  }
+  return results;
+}
+
+}  // namespace tiling
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_ALGORITHMAPI_TILING_H_
@@ -0,0 +1,199 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_ALGORITHMAPI_YOLO_HEAD_H_
+#define SOPHON_STREAM_ELEMENT_ALGORITHMAPI_YOLO_HEAD_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sophon_stream {
+namespace element {
+
+/**
+ * @brief YOLO系列后处理共用的检测头解码函数。
+ * 解码时先用物体置信度与最高的类别阈值比较，淘汰绝大多数候选框后才做类别argmax与框的计算
+ */
+namespace yolo {
+
+/**
+ * @brief exp的多项式近似，[-87, 88]内相对误差小于2e-7，可内联、无分支
+ */
+inline float fastExp(float x) {
+  x = std::fmin(std::fmax(x, -87.0f), 88.0f);
+  // x = n * ln2 + r, |r| <= ln2 / 2
+  float n = std::floor(x * 1.44269504088896341f + 0.5f);
+  float r = x - n * 0.693359375f + n * 2.12194440e-4f;
+  float p = 1.9875691500e-4f;
+  p = p * r + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  p = p * r * r + r + 1.0f;
+  // 乘以2^n
+  std::int32_t bits = (static_cast<std::int32_t>(n) + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+inline float fastSigmoid(float x) { return 1.0f / (1.0f + fastExp(-x)); }
+
+/**
+ * @brief sigmoid的反函数。sigmoid单调递增，概率阈值换算为logit后可直接与网络输出比较
+ */
+inline float logit(float p) {
+  if (p <= 0.f) return -std::numeric_limits<float>::infinity();
+  if (p >= 1.f) return std::numeric_limits<float>::infinity();
+  return -std::log(1.f / p - 1.f);
+}
+
+/**
+ * @brief 连续存放的num个类别分数中的最大值与下标，多个最大值时取第一个
+ */
+inline int argmax(const float* data, int num, float* maxValue) {
+  if (num <= 0) {
+    *maxValue = 0.f;
+    return 0;
+  }
+  float best = data[0];
+  int index = 0;
+#if defined(__AVX2__) || defined(__ARM_NEON)
+#if defined(__AVX2__)
+  constexpr int LANES = 8;
+#else
+  constexpr int LANES = 4;
+#endif
+  if (num >= LANES) {
+    int i = LANES;
+#if defined(__AVX2__)
+    __m256 vmax = _mm256_loadu_ps(data);
+    for (; i + 8 <= num; i += 8)
+      vmax = _mm256_max_ps(vmax, _mm256_loadu_ps(data + i));
+    float lanes[8];
+    _mm256_storeu_ps(lanes, vmax);
+    for (float lane : lanes) best = std::max(best, lane);
+#else
+    float32x4_t vmax = vld1q_f32(data);
+    for (; i + 4 <= num; i += 4)
+      vmax = vmaxq_f32(vmax, vld1q_f32(data + i));
+    float lanes[4];
+    vst1q_f32(lanes, vmax);
+    for (float lane : lanes) best = std::max(best, lane);
+#endif
+    for (; i < num; ++i) best = std::max(best, data[i]);
+    // 向量部分只求最大值，下标再顺序找一遍
+    while (index + 1 < num && data[index] != best) ++index;
+    *maxValue = best;
+    return index;
+  }
+#endif
+  // std::fmax要处理NaN，比直接比较慢得多，标量部分一次遍历同时记下标
+  for (int i = 1; i < num; ++i) {
+    if (data[i] > best) {
+      best = data[i];
+      index = i;
+    }
+  }
+  *maxValue = best;
+  return index;
+}
+
+/**
+ * @brief 类别在前、候选框在后([classNum][boxNum])存放的分数，求每个候选框的最大类别。
+ * 内层循环沿候选框连续访问，下标用掩码选择而不用条件表达式，编译器才能向量化
+ */
+inline void argmaxColumns(const float* data, int classNum, int boxNum,
+                          std::vector<float>& maxValues,
+                          std::vector<int>& maxIndices) {
+  maxValues.assign(data, data + boxNum);
+  maxIndices.assign(boxNum, 0);
+  float* __restrict values = maxValues.data();
+  int* __restrict indices = maxIndices.data();
+  for (int j = 1; j < classNum; ++j) {
+    const float* __restrict row = data + j * boxNum;
+    for (int i = 0; i < boxNum; ++i) {
+      int greater = -static_cast<int>(row[i] > values[i]);
+      indices[i] = (indices[i] & ~greater) | (j & greater);
+      values[i] = std::max(values[i], row[i]);
+    }
+  }
+}
+
+/**
+ * @brief 每个类别的置信度阈值。每次后处理开始时取一次，避免逐个候选框按类别名查表
+ */
+template <typename T>
+std::vector<float> classThresholds(const T& context, int classNum) {
+  std::vector<float> thresholds(classNum, context->thresh_conf_min);
+  if (!context->class_thresh_valid) return thresholds;
+  const int named =
+      std::min<int>(classNum, static_cast<int>(context->class_names.size()));
+  for (int i = 0; i < named; ++i) {
+    auto it = context->thresh_conf.find(context->class_names[i]);
+    if (it != context->thresh_conf.end()) thresholds[i] = it->second;
+  }
+  return thresholds;
+}
+
+/**
+ * @brief 所有类别阈值中最小的一个，低于它的候选框不可能通过任何类别的阈值
+ */
+inline float minThreshold(const std::vector<float>& thresholds,
+                          float fallback) {
+  if (thresholds.empty()) return fallback;
+  return *std::min_element(thresholds.begin(), thresholds.end());
+}
+
+/**
+ * @brief anchor形式的检测头(YOLOv5/v7)：由网格位置与anchor解码中心点与宽高，
+ * 输出相对网络输入的cx, cy, w, h
+ * @param[in] ptr : 该候选框的输出，前4个为x, y, w, h的logit
+ * @param[in] cell : 候选框在特征图中的下标，即 y * featW + x
+ */
+inline void decodeAnchorBox(const float* ptr, int cell, int featW, int featH,
+                            int netW, int netH, float anchorW, float anchorH,
+                            float* box) {
+  float sx = fastSigmoid(ptr[0]);
+  float sy = fastSigmoid(ptr[1]);
+  float sw = fastSigmoid(ptr[2]) * 2;
+  float sh = fastSigmoid(ptr[3]) * 2;
+  box[0] = (sx * 2 - 0.5f + cell % featW) / featW * netW;
+  box[1] = (sy * 2 - 0.5f + cell / featW) / featH * netH;
+  box[2] = sw * sw * anchorW;
+  box[3] = sh * sh * anchorH;
+}
+
+/**
+ * @brief anchor-free网格形式的检测头(YOLOX)：输出相对网络输入的cx, cy, w, h
+ */
+inline void decodeGridBox(const float* ptr, int gridX, int gridY, int stride,
+                          float* box) {
+  box[0] = (ptr[0] + gridX) * stride;
+  box[1] = (ptr[1] + gridY) * stride;
+  box[2] = fastExp(ptr[2]) * stride;
+  box[3] = fastExp(ptr[3]) * stride;
+}
+
+}  // namespace yolo
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_ALGORITHMAPI_YOLO_HEAD_H_
@@ -25,6 +25,9 @@ class Bytetrack : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  // 只使用检测框，不读取图像
+  bool needsPixelData() const override { return false; }
+
   static constexpr const char* CONFIG_INTERNAL_FRAME_RATE_FIELD = "frame_rate";
   static constexpr const char* CONFIG_INTERNAL_TRACK_BUFFER_FIELD =
       "track_buffer";
@@ -40,6 +43,8 @@ class Bytetrack : public ::sophon_stream::framework::Element {
       "correct_box";
   static constexpr const char* CONFIG_INTERNAL_AGNOSTIC_FIELD =
       "agnostic";
+  static constexpr const char* CONFIG_INTERNAL_KEYFRAME_UNCERTAINTY_FIELD =
+      "keyframe_uncertainty";
 
  private:
   std::shared_ptr<BytetrackContext> mContext;  // context对象
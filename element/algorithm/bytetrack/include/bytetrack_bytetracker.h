@@ -32,6 +32,7 @@ struct BytetrackContext {
   int minBoxArea;
   bool correctBox;
   bool agnostic;
+  float keyframeUncertainty;
 };
 
 class BYTETracker {
@@ -41,7 +42,16 @@ class BYTETracker {
 
   void update(std::shared_ptr<common::ObjectMetadata>& objects);
 
+  /**
+   * @brief 没有检测结果的插值帧，用卡尔曼滤波预测已确认轨迹在本帧的位置
+   * @return 有轨迹的位置标准差超过框高的keyframeUncertainty倍，需要尽快检测
+   */
+  bool predict(std::shared_ptr<common::ObjectMetadata>& objects);
+
  private:
+  void fill_objects(std::shared_ptr<common::ObjectMetadata>& objects,
+                    const STracks& output_stracks);
+
   void joint_stracks(STracks& tlista, STracks& tlistb, STracks& results);
 
   void sub_stracks(STracks& tlista, STracks& tlistb);
@@ -79,6 +89,7 @@ class BYTETracker {
   int class_offset;
   bool correct_box;
   bool agnostic;
+  float keyframe_uncertainty;
 
   STracks tracked_stracks;
   STracks lost_stracks;
@@ -11,6 +11,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include "common/keyframe_scheduler.h"
 #include "common/logger.h"
 #include "element_factory.h"
 
@@ -67,12 +68,20 @@ common::ErrorCode Bytetrack::initContext(const std::string& json) {
     mContext->agnostic =
         agnosticIt != configure.end() ? agnosticIt->get<bool>() : true;
 
+    auto keyframeUncertaintyIt =
+        configure.find(CONFIG_INTERNAL_KEYFRAME_UNCERTAINTY_FIELD);
+    mContext->keyframeUncertainty = keyframeUncertaintyIt != configure.end()
+                                        ? keyframeUncertaintyIt->get<float>()
+                                        : 0.15;
+
     IVS_DEBUG(
         "Bytetrack::initContext: frameRate: {0}, trackBuffer: {1}, "
         "trackThresh: {2}, "
-        "highThresh: {3}, matchThresh: {4}, correctBox: {5}, agnostic: {6}",
+        "highThresh: {3}, matchThresh: {4}, correctBox: {5}, agnostic: {6}, "
+        "keyframeUncertainty: {7}",
         mContext->frameRate, mContext->trackBuffer, mContext->trackThresh,
-        mContext->highThresh, mContext->matchThresh, mContext->correctBox, mContext->agnostic);
+        mContext->highThresh, mContext->matchThresh, mContext->correctBox,
+        mContext->agnostic, mContext->keyframeUncertainty);
 
   } while (false);
 
@@ -111,14 +120,19 @@ common::ErrorCode Bytetrack::initInternal(const std::string& json) {
 
 /**
  * update tracker
- * @param[in/out] objectMetadatas:  更新 tracker
+ * @param[in/out] objectMetadatas:  更新 tracker，插值帧输出预测的目标框
  */
 void Bytetrack::process(
     int dataPipeId, std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
   auto byteTrackerIt = mByteTrackerMap.find(dataPipeId);
   if (mByteTrackerMap.end() != byteTrackerIt) {
     auto byteTracker = byteTrackerIt->second;
-    if (byteTracker) {
+    if (byteTracker && objectMetadata->mInterpolated) {
+      // 预测不确定时请求解码element下一帧做检测
+      if (byteTracker->predict(objectMetadata))
+        common::SingletonKeyframeScheduler::getInstance().requestKeyframe(
+            getGraphId(), objectMetadata->mFrame->mChannelId);
+    } else if (byteTracker) {
       byteTracker->update(objectMetadata);
     } else {
       IVS_WARN("empty byteTrackerMap for dataPipeId : {0}", dataPipeId);
@@ -145,42 +159,32 @@ common::ErrorCode Bytetrack::doWork(int dataPipeId) {
     return errorCode;
   }
 
-  common::ObjectMetadatas pendingObjectMetadatas;
-
-  std::shared_ptr<common::ObjectMetadata> objectMetadata = nullptr;
-
-  while (getThreadStatus() == ThreadStatus::RUN) {
-    auto data = popInputData(inputPort, dataPipeId);
-    if (!data) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      continue;
-    }
-    objectMetadata = std::static_pointer_cast<common::ObjectMetadata>(data);
-    pendingObjectMetadatas.push_back(objectMetadata);
-    if (!objectMetadata->mFilter) {
-      break;
-    }
-    if (objectMetadata->mFrame->mEndOfStream) {
-      break;
-    }
+  auto data = popInputData(inputPort, dataPipeId);
+  while (!data && (getThreadStatus() == ThreadStatus::RUN)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    data = popInputData(inputPort, dataPipeId);
   }
-  if (objectMetadata != nullptr) process(dataPipeId, objectMetadata);
-
-  for (auto& obj : pendingObjectMetadatas) {
-    int channel_id_internal = obj->mFrame->mChannelIdInternal;
-    int pipeId =
-        getSinkElementFlag()
-            ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
-
-    errorCode =
-        pushOutputData(outputPort, pipeId, std::static_pointer_cast<void>(obj));
-    if (common::ErrorCode::SUCCESS != errorCode) {
-      IVS_WARN(
-          "Send data fail, element id: {0:d}, output port: {1:d}, data: "
-          "{2:p}",
-          getId(), outputPort, static_cast<void*>(obj.get()));
-    }
+  if (data == nullptr) return common::ErrorCode::SUCCESS;
+
+  auto objectMetadata = std::static_pointer_cast<common::ObjectMetadata>(data);
+  // 跳过检测的帧不更新跟踪器，直接送往下游。不能攒到下一个检测帧再发，
+  // motion_gate后画面长时间静止时会一直积压
+  if (!objectMetadata->mFilter || objectMetadata->mInterpolated ||
+      objectMetadata->mFrame->mEndOfStream)
+    process(dataPipeId, objectMetadata);
+
+  int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
+  int pipeId =
+      getSinkElementFlag()
+          ? 0
+          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+  errorCode = pushOutputData(outputPort, pipeId,
+                             std::static_pointer_cast<void>(objectMetadata));
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_WARN(
+        "Send data fail, element id: {0:d}, output port: {1:d}, data: "
+        "{2:p}",
+        getId(), outputPort, static_cast<void*>(objectMetadata.get()));
   }
 
   return common::ErrorCode::SUCCESS;
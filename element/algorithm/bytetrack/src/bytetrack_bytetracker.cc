@@ -9,6 +9,8 @@
 
 #include "bytetrack_bytetracker.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 namespace sophon_stream {
 namespace element {
@@ -27,6 +29,7 @@ BYTETracker::BYTETracker(const std::shared_ptr<BytetrackContext> mContext) {
   this->class_offset = 7000;
   this->correct_box = mContext->correctBox;
   this->agnostic = mContext->agnostic;
+  this->keyframe_uncertainty = mContext->keyframeUncertainty;
 }
 
 BYTETracker::~BYTETracker() {}
@@ -232,16 +235,62 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
       output_stracks.push_back(this->tracked_stracks[i]);
   }
 
+  fill_objects(objects, output_stracks);
+}
+
+bool BYTETracker::predict(std::shared_ptr<common::ObjectMetadata>& objects) {
+  this->frame_id++;
+  STracks activated_stracks;
+  STracks strack_pool;
+  STracks output_stracks;
+  for (int i = 0; i < this->tracked_stracks.size(); i++) {
+    if (this->tracked_stracks[i]->is_activated)
+      activated_stracks.push_back(this->tracked_stracks[i]);
+  }
+  // 与update中的预测相同，丢失的轨迹也要预测，保证每一帧预测一次
+  joint_stracks(activated_stracks, this->lost_stracks, strack_pool);
+  STrack::multi_predict(strack_pool, this->kalman_filter);
+
+  bool uncertain = false;
+  for (int i = 0; i < activated_stracks.size(); i++) {
+    std::shared_ptr<STrack> track = activated_stracks[i];
+    if (track->state != TrackState::Tracked) continue;
+    // correct_box为false时卡尔曼状态不随检测更新，沿用上一次的框
+    if (this->correct_box) {
+      track->static_tlwh();
+      track->static_tlbr();
+    }
+    if (track->tlwh[2] * track->tlwh[3] > this->min_box_area)
+      output_stracks.push_back(track);
+
+    float height = track->mean.at<float>(3);
+    float variance = std::max(track->covariance.at<float>(0, 0),
+                              track->covariance.at<float>(1, 1));
+    if (this->keyframe_uncertainty > 0 && height > 0 &&
+        std::sqrt(variance) > this->keyframe_uncertainty * height)
+      uncertain = true;
+  }
+
+  fill_objects(objects, output_stracks);
+  return uncertain;
+}
+
+void BYTETracker::fill_objects(
+    std::shared_ptr<common::ObjectMetadata>& objects,
+    const STracks& output_stracks) {
+  // 上游可能已经释放了图像，以Frame中记录的宽高为准
+  int frameWidth = objects->mFrame->mSpData ? objects->mFrame->mSpData->width
+                                            : objects->mFrame->mWidth;
+  int frameHeight = objects->mFrame->mSpData ? objects->mFrame->mSpData->height
+                                             : objects->mFrame->mHeight;
   // objects->mSubObjectMetadatas.clear();
   objects->mDetectedObjectMetadatas.clear();
   objects->mTrackedObjectMetadatas.clear();
   for (auto track_box : output_stracks) {
-    std::shared_ptr<common::ObjectMetadata> subOutputMetaData =
-        std::make_shared<common::ObjectMetadata>();
     std::shared_ptr<common::DetectedObjectMetadata> mDetectedObjectMetadata =
-        std::make_shared<common::DetectedObjectMetadata>();
+        common::makeInArena<common::DetectedObjectMetadata>(objects->mArena);
     std::shared_ptr<common::TrackedObjectMetadata> mTrackedObjectMetadata =
-        std::make_shared<common::TrackedObjectMetadata>();
+        common::makeInArena<common::TrackedObjectMetadata>(objects->mArena);
 
     mDetectedObjectMetadata->mBox.mX =
         track_box->tlwh[0] < 0 ? 0 : track_box->tlwh[0];
@@ -254,17 +303,13 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
           track_box->class_id * this->class_offset;
     }
     mDetectedObjectMetadata->mBox.mWidth =
-        mDetectedObjectMetadata->mBox.mX + track_box->tlwh[2] <
-                objects->mFrame->mSpData->width
+        mDetectedObjectMetadata->mBox.mX + track_box->tlwh[2] < frameWidth
             ? track_box->tlwh[2]
-            : (objects->mFrame->mSpData->width -
-               mDetectedObjectMetadata->mBox.mX);
+            : (frameWidth - mDetectedObjectMetadata->mBox.mX);
     mDetectedObjectMetadata->mBox.mHeight =
-        mDetectedObjectMetadata->mBox.mY + track_box->tlwh[3] <
-                objects->mFrame->mSpData->height
+        mDetectedObjectMetadata->mBox.mY + track_box->tlwh[3] < frameHeight
             ? track_box->tlwh[3]
-            : (objects->mFrame->mSpData->height -
-               mDetectedObjectMetadata->mBox.mY);
+            : (frameHeight - mDetectedObjectMetadata->mBox.mY);
     mDetectedObjectMetadata->mClassify = track_box->class_id;
     mDetectedObjectMetadata->mScores.push_back(track_box->score);
     mTrackedObjectMetadata->mTrackId = track_box->track_id;
@@ -81,6 +81,11 @@ class Lprnet : public ::sophon_stream::framework::Element {
   bool use_infer = false;
   bool use_post = false;
 
+  // 各阶段耗时直方图，由MetricsRegistry持有
+  ::sophon_stream::common::Histogram* mPreLatency = nullptr;
+  ::sophon_stream::common::Histogram* mInferLatency = nullptr;
+  ::sophon_stream::common::Histogram* mPostLatency = nullptr;
+
   std::string mFpsProfilerName;
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
@@ -98,6 +98,9 @@ common::ErrorCode Lprnet::initInternal(const std::string& json) {
 
       mFpsProfiler.config(mFpsProfilerName, 100);
     }
+    mPreLatency = registerStageLatency("pre");
+    mInferLatency = registerStageLatency("infer");
+    mPostLatency = registerStageLatency("post");
 
     // 新建context,预处理,推理和后处理对象
     mContext = std::make_shared<LprnetContext>();
@@ -126,6 +129,7 @@ void Lprnet::process(common::ObjectMetadatas& objectMetadatas) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   // 预处理
   if (use_pre) {
+    common::ScopedLatency latency(mPreLatency);
     errorCode = mPreProcess->preProcess(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -136,6 +140,7 @@ void Lprnet::process(common::ObjectMetadatas& objectMetadatas) {
   }
   // 推理
   if (use_infer) {
+    common::ScopedLatency latency(mInferLatency);
     errorCode = mInference->predict(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -145,7 +150,10 @@ void Lprnet::process(common::ObjectMetadatas& objectMetadatas) {
     }
   }
   // 后处理
-  if (use_post) mPostProcess->postProcess(mContext, objectMetadatas);
+  if (use_post) {
+    common::ScopedLatency latency(mPostLatency);
+    mPostProcess->postProcess(mContext, objectMetadatas);
+  }
 }
 
 common::ErrorCode Lprnet::doWork(int dataPipeId) {
@@ -75,6 +75,9 @@ class Posec3d : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_CLASS_NAMES_FILE_FIELD =
       "class_names_file";
   static constexpr const char* CONFIG_INTERNAL_FRAMES_NUM_FIELD = "frames_num";
+  static constexpr const char* CONFIG_INTERNAL_WINDOW_SIZE_FIELD =
+      "window_size";
+  static constexpr const char* CONFIG_INTERNAL_STRIDE_FIELD = "stride";
 
  private:
   std::shared_ptr<Posec3dContext> mContext;          // context对象
@@ -89,8 +92,17 @@ class Posec3d : public ::sophon_stream::framework::Element {
   std::string mFpsProfilerName;
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
+  // 滑动窗口模式下，每路最近一次的识别结果，赋给两次识别之间的帧
+  std::map<int, std::vector<std::shared_ptr<common::RecognizedObjectMetadata>>>
+      mLastRecognized;
+  std::mutex mLastRecognizedMtx;
+
   common::ErrorCode initContext(const std::string& json);
   void process(common::ObjectMetadatas& objectMetadatas);
+  /**
+   * @brief 滑动窗口模式：每次处理一帧，窗口满且达到步长时识别
+   */
+  common::ErrorCode doWorkWindow(int dataPipeId);
 };
 
 }  // namespace posec3d
@@ -34,6 +34,11 @@ class Posec3dContext : public ::sophon_stream::element::Context {
 
   std::vector<std::string> class_names;
   float input_scale;
+
+  // 滑动窗口模式：每路缓存最近window_size帧的关键点，每stride帧识别一次
+  // stride<=0时按frames_num整段识别
+  int window_size;
+  int stride;
 };
 }  // namespace posec3d
 }  // namespace element
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_POSEC3D_HEATMAP_H_
+#define SOPHON_STREAM_ELEMENT_POSEC3D_HEATMAP_H_
+
+#include <algorithm>
+#include <cmath>
+
+namespace sophon_stream {
+namespace element {
+namespace posec3d {
+
+/**
+ * @brief 在img_w宽的heatmap上按最大值叠加一个关键点的高斯分布。
+ * exp(-(dx^2 + dy^2) / 2sigma^2) = exp(-dx^2 / 2sigma^2) * exp(-dy^2 /
+ * 2sigma^2)，先算x、y两个一维表，再按行做外积，内层循环连续访问内存，可被编译器向量化
+ */
+inline void splatGaussian(float* heatmap, int img_w, int img_h, float mu_x,
+                          float mu_y, float sigma, float peak) {
+  int st_x = std::max(int(mu_x - 3 * sigma), 0);
+  int ed_x = std::min(int(mu_x + 3 * sigma) + 1, img_w);
+  int st_y = std::max(int(mu_y - 3 * sigma), 0);
+  int ed_y = std::min(int(mu_y + 3 * sigma) + 1, img_h);
+  if (st_x >= ed_x || st_y >= ed_y) return;
+
+  // 3sigma范围内的点数很少，放在栈上
+  constexpr int MAX_KERNEL = 64;
+  int kernel_w = ed_x - st_x;
+  if (kernel_w > MAX_KERNEL || ed_y - st_y > MAX_KERNEL) {
+    for (int patch_y = st_y; patch_y < ed_y; patch_y++)
+      for (int patch_x = st_x; patch_x < ed_x; patch_x++) {
+        float value = exp(-(std::pow(patch_x - mu_x, 2) +
+                            std::pow(patch_y - mu_y, 2)) /
+                          2 / std::pow(sigma, 2)) *
+                      peak;
+        float& dst = heatmap[patch_y * img_w + patch_x];
+        if (value > dst) dst = value;
+      }
+    return;
+  }
+  double inv = 1.0 / (2.0 * sigma * sigma);
+  float gx[MAX_KERNEL];
+  for (int k = 0; k < kernel_w; k++) {
+    double d = st_x + k - mu_x;
+    gx[k] = float(std::exp(-d * d * inv));
+  }
+  for (int patch_y = st_y; patch_y < ed_y; patch_y++) {
+    double d = patch_y - mu_y;
+    float row_scale = float(std::exp(-d * d * inv) * peak);
+    float* __restrict dst = heatmap + patch_y * img_w + st_x;
+    for (int k = 0; k < kernel_w; k++)
+      dst[k] = std::max(dst[k], gx[k] * row_scale);
+  }
+}
+
+}  // namespace posec3d
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_POSEC3D_HEATMAP_H_
@@ -10,6 +10,10 @@
 #ifndef SOPHON_STREAM_ELEMENT_POSEC3D_PRE_PROCESS_H_
 #define SOPHON_STREAM_ELEMENT_POSEC3D_PRE_PROCESS_H_
 
+#include <cstdint>
+#include <map>
+#include <mutex>
+
 #include "algorithmApi/pre_process.h"
 #include "posec3d_context.h"
 
@@ -21,6 +25,39 @@ using fpptr_dim3 = std::vector<
     std::shared_ptr<std::vector<std::shared_ptr<std::vector<float>>>>>;
 using fpptr_dim2 = std::vector<std::shared_ptr<std::vector<float>>>;
 
+/**
+ * @brief 关键点从原图坐标到heatmap坐标的变换，与poseCompact、resize、centerCrop一致
+ * @brief x' = (x - offset_x) * scale_x - crop_x
+ */
+struct PoseTransform {
+  float offset_x, offset_y;
+  float scale_x, scale_y;
+  float crop_x, crop_y;
+  // poseCompact得到的包围框，用于判断后续窗口能否沿用该变换
+  float box_min_x, box_min_y, box_max_x, box_max_y;
+  bool compacted;
+};
+
+/**
+ * @brief 单路的关键点环形缓冲，每帧追加一次
+ * @brief 每帧缓存按当前变换生成的heatmap切片，变换不变时直接复用
+ */
+struct KeypointWindow {
+  struct FrameKeypoints {
+    std::vector<std::vector<float>> keypoints;
+    std::vector<std::vector<float>> scores;
+    std::vector<float> heatmap;   // [keypoints][net_h][net_w]
+    std::uint64_t transform_id;  // 生成heatmap时的变换序号，0表示未生成
+  };
+  std::vector<FrameKeypoints> frames;
+  int head = 0;  // 下一帧写入的位置
+  int count = 0;
+  int since_last_run = 0;
+  int frame_h = 0, frame_w = 0;
+  PoseTransform transform;
+  std::uint64_t transform_id = 0;
+};
+
 class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
  public:
   /**
@@ -34,7 +71,25 @@ class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
                                common::ObjectMetadatas& objectMetadatas);
   void init(std::shared_ptr<Posec3dContext> context);
 
+  /**
+   * @brief 滑动窗口模式：将一帧的关键点追加到该路的窗口
+   * @return 窗口已满且距上次识别达到stride帧时返回true，此时需要对该帧做预处理
+   */
+  bool appendFrame(std::shared_ptr<Posec3dContext> context,
+                   std::shared_ptr<common::ObjectMetadata> objectMetadata);
+
+  /**
+   * @brief 码流结束时释放该路的窗口
+   */
+  void releaseWindow(int channelId);
+
  private:
+  /**
+   * @brief 计算重采样的帧下标，规则与uniformSampleFrames一致
+   */
+  std::vector<int> sampleFrameIndices(int num_frames, int clip_len,
+                                      int num_clips, int seed);
+
   /**
    * @brief 对一个batch的数据做重采样
    * @param sampled_keypoints 重采样关键点结果
@@ -124,6 +179,44 @@ class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
    */
   void initTensors(std::shared_ptr<Posec3dContext> context,
                    common::ObjectMetadatas& objectMetadatas);
+
+  /**
+   * @brief 为模型输入分配设备内存，返回可写入heatmap的host地址
+   */
+  float* mapHeatmap(std::shared_ptr<Posec3dContext> context,
+                    std::shared_ptr<common::ObjectMetadata> obj, int out_num);
+
+  /**
+   * @brief 将写好的heatmap同步到设备内存
+   */
+  void uploadHeatmap(std::shared_ptr<Posec3dContext> context,
+                     std::shared_ptr<common::ObjectMetadata> obj,
+                     float* heatmap);
+
+  /**
+   * @brief 滑动窗口模式：由窗口内的关键点生成模型输入
+   */
+  common::ErrorCode preProcessWindow(std::shared_ptr<Posec3dContext> context,
+                                     common::ObjectMetadatas& objectMetadatas);
+
+  /**
+   * @brief 计算窗口的关键点变换，新的关键点仍落在上次的包围框内时沿用上次的变换
+   */
+  void updateTransform(std::shared_ptr<Posec3dContext> context,
+                       KeypointWindow& window);
+
+  /**
+   * @brief 生成一帧的heatmap切片
+   */
+  void generateHeatmapSlice(std::shared_ptr<Posec3dContext> context,
+                            const PoseTransform& transform,
+                            KeypointWindow::FrameKeypoints& frame);
+
+  // 包围框缩小到上次的该比例以下时重新计算变换
+  static constexpr float TRANSFORM_REUSE_MIN_RATIO = 0.8f;
+
+  std::map<int, std::shared_ptr<KeypointWindow>> mWindows;
+  std::mutex mWindowsMtx;
 };
 
 }  // namespace posec3d
@@ -43,6 +43,13 @@ common::ErrorCode Posec3d::initContext(const std::string& json) {
     // 2. get input
     auto frameNum = configure.find(CONFIG_INTERNAL_FRAMES_NUM_FIELD);
     mContext->max_batch = frameNum->get<int>();
+    auto windowSizeIt = configure.find(CONFIG_INTERNAL_WINDOW_SIZE_FIELD);
+    mContext->window_size = configure.end() != windowSizeIt
+                                ? windowSizeIt->get<int>()
+                                : mContext->max_batch;
+    auto strideIt = configure.find(CONFIG_INTERNAL_STRIDE_FIELD);
+    mContext->stride =
+        configure.end() != strideIt ? strideIt->get<int>() : 0;
     auto inputTensor = mContext->bmNetwork->inputTensor(0);
     mContext->input_num = mContext->bmNetwork->m_netinfo->input_num;
     mContext->m_net_crops_clips = inputTensor->get_shape()->dims[0];
@@ -155,8 +162,67 @@ void Posec3d::process(common::ObjectMetadatas& objectMetadatas) {
   if (use_post) mPostProcess->postProcess(mContext, objectMetadatas);
 }
 
+common::ErrorCode Posec3d::doWorkWindow(int dataPipeId) {
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  int inputPort = getInputPorts()[0];
+  int outputPort = 0;
+  if (!getSinkElementFlag()) {
+    std::vector<int> outputPorts = getOutputPorts();
+    outputPort = outputPorts[0];
+  }
+
+  auto data = popInputData(inputPort, dataPipeId);
+  while (!data && (getThreadStatus() == ThreadStatus::RUN)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    data = popInputData(inputPort, dataPipeId);
+  }
+  if (data == nullptr) return common::ErrorCode::SUCCESS;
+  auto objectMetadata = std::static_pointer_cast<common::ObjectMetadata>(data);
+  int channelId = objectMetadata->mFrame->mChannelId;
+
+  common::ObjectMetadatas objectMetadatas;
+  if (objectMetadata->mFrame->mEndOfStream) {
+    if (use_pre) mPreProcess->releaseWindow(channelId);
+    std::lock_guard<std::mutex> lk(mLastRecognizedMtx);
+    mLastRecognized.erase(channelId);
+  } else if (!objectMetadata->mFilter) {
+    // pre阶段每帧追加到窗口，窗口就绪的帧作为main继续推理和后处理
+    if (use_pre ? mPreProcess->appendFrame(mContext, objectMetadata)
+                : objectMetadata->is_main)
+      objectMetadatas.push_back(objectMetadata);
+  }
+
+  process(objectMetadatas);
+
+  if (use_post && !objectMetadata->mFrame->mEndOfStream) {
+    std::lock_guard<std::mutex> lk(mLastRecognizedMtx);
+    if (objectMetadatas.size() > 0)
+      mLastRecognized[channelId] = objectMetadata->mRecognizedObjectMetadatas;
+    else
+      objectMetadata->mRecognizedObjectMetadatas = mLastRecognized[channelId];
+  }
+
+  int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
+  int outDataPipeId =
+      getSinkElementFlag()
+          ? 0
+          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+  errorCode = pushOutputData(outputPort, outDataPipeId,
+                             std::static_pointer_cast<void>(objectMetadata));
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_WARN(
+        "Send data fail, element id: {0:d}, output port: {1:d}, data: "
+        "{2:p}",
+        getId(), outputPort, static_cast<void*>(objectMetadata.get()));
+  }
+  mFpsProfiler.add(1);
+
+  return common::ErrorCode::SUCCESS;
+}
+
 common::ErrorCode Posec3d::doWork(int dataPipeId) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  if (mContext->stride > 0) return doWorkWindow(dataPipeId);
 
   common::ObjectMetadatas objectMetadatas;
   std::vector<int> inputPorts = getInputPorts();
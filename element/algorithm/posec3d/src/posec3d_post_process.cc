@@ -50,7 +50,7 @@ void Posec3dPostProcess::postProcess(std::shared_ptr<Posec3dContext> context,
   float confidence = *(output_data + class_id);
   std::string res = context->class_names[class_id];
   std::shared_ptr<common::RecognizedObjectMetadata> recData =
-      std::make_shared<common::RecognizedObjectMetadata>();
+      common::makeInArena<common::RecognizedObjectMetadata>(obj->mArena);
   recData->mLabelName = res;
   recData->mScores.push_back(confidence);
   obj->mRecognizedObjectMetadatas.push_back(recData);
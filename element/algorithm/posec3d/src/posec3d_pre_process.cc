@@ -13,19 +13,48 @@
 #include <cmath>
 #include <cstdlib>
 #include <fstream>
+#include <thread>
 
 #include "common/logger.h"
+#include "posec3d_heatmap.h"
 
 namespace sophon_stream {
 namespace element {
 namespace posec3d {
 
+namespace {
+
+// 每个线程至少处理的帧数，帧数少时不值得起线程
+constexpr int MIN_FRAMES_PER_THREAD = 8;
+
+/**
+ * @brief 把[0, num)分成若干段在多个线程中执行func(begin, end)
+ */
+template <typename Func>
+void parallelFrames(int num, Func func) {
+  int thread_num = std::min<int>(std::thread::hardware_concurrency(),
+                                 num / MIN_FRAMES_PER_THREAD);
+  if (thread_num <= 1) {
+    func(0, num);
+    return;
+  }
+  std::vector<std::thread> threads;
+  threads.reserve(thread_num - 1);
+  int step = (num + thread_num - 1) / thread_num;
+  for (int begin = step; begin < num; begin += step)
+    threads.emplace_back(func, begin, std::min(begin + step, num));
+  func(0, std::min(step, num));
+  for (auto& thread : threads) thread.join();
+}
+
+}  // namespace
+
 void Posec3dPreProcess::init(std::shared_ptr<Posec3dContext> context) {}
 
-common::ErrorCode Posec3dPreProcess::uniformSampleFrames(
-    fpptr_dim3& sampled_keypoints, fpptr_dim3& sampled_keypoint_scores,
-    int clip_len, int num_clips, int seed) {
-  int num_frames = sampled_keypoints.size();
+std::vector<int> Posec3dPreProcess::sampleFrameIndices(int num_frames,
+                                                      int clip_len,
+                                                      int num_clips,
+                                                      int seed) {
   std::vector<int> inds;
   srand(seed);
 
@@ -59,6 +88,15 @@ common::ErrorCode Posec3dPreProcess::uniformSampleFrames(
       }
     }
   }
+  return inds;
+}
+
+common::ErrorCode Posec3dPreProcess::uniformSampleFrames(
+    fpptr_dim3& sampled_keypoints, fpptr_dim3& sampled_keypoint_scores,
+    int clip_len, int num_clips, int seed) {
+  int num_frames = sampled_keypoints.size();
+  std::vector<int> inds =
+      sampleFrameIndices(num_frames, clip_len, num_clips, seed);
 
   // filter frames
   for (int i = 0; i < inds.size(); i++) {
@@ -240,52 +278,28 @@ common::ErrorCode Posec3dPreProcess::generatePoseTarget(
   float* data = heatmap;
   memset((void*)data, 0, out_num * sizeof(float));
   int heatmap_start_indx = out_num / 2;
-  for (int i = 0; i < num_frame; i++) {
-    for (int j = 0; j < num_c; j++) {
-      for (int person_id = 0; person_id < sampled_keypoints[i]->size();
-           person_id++) {
-        if (sampled_keypoint_scores[i]->at(person_id)->at(j) < eps) continue;
-
-        float mu_x = sampled_keypoints[i]->at(person_id)->at(j * 2);
-        float mu_y = sampled_keypoints[i]->at(person_id)->at(j * 2 + 1);
-
-        int st_x = std::max(int(mu_x - 3 * sigma), 0);
-        int ed_x = std::min(int(mu_x + 3 * sigma) + 1, img_w);
-        int st_y = std::max(int(mu_y - 3 * sigma), 0);
-        int ed_y = std::min(int(mu_y + 3 * sigma) + 1, img_h);
-        if (st_x >= ed_x || st_y >= ed_y) continue;
-
+  // 每帧写各自的切片，按帧分给多个线程
+  parallelFrames(num_frame, [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      for (int j = 0; j < num_c; j++) {
         float* base = data + i / clip_len * num_c * clip_len * img_h * img_w +
                       j * clip_len * img_h * img_w +
                       i % clip_len * img_h * img_w;
-        for (int patch_x = st_x; patch_x < ed_x; patch_x++)
-          for (int patch_y = st_y; patch_y < ed_y; patch_y++) {
-            float value = exp(-(std::pow(patch_x - mu_x, 2) +
-                                std::pow(patch_y - mu_y, 2)) /
-                              2 / std::pow(sigma, 2)) *
-                          sampled_keypoint_scores[i]->at(person_id)->at(j);
-            value *= context->input_scale;
-            if (value > *(base + patch_y * img_w + patch_x)) {
-              *(base + patch_y * img_w + patch_x) = value;
-              *(base + patch_y * img_w + patch_x + heatmap_start_indx) = value;
-              /*
-              // original implement
-              if (j == 0)
-                *(base + heatmap_start_indx + patch_y * img_w + img_w - patch_x
-              - 1) = value; else if (j % 2 == 0)
-                *(data + heatmap_start_indx + i / clip_len * num_c * clip_len *
-              img_h * img_w + (j - 1) * clip_len * img_h * img_w + i % clip_len
-              * img_h * img_w + patch_y * img_w + img_w - patch_x - 1) = value;
-              else if (j % 2 == 1)
-                *(data + heatmap_start_indx + i / clip_len * num_c * clip_len *
-              img_h * img_w + (j + 1) * clip_len * img_h * img_w + i % clip_len
-              * img_h * img_w + patch_y * img_w + img_w - patch_x - 1) = value;
-              */
-            }
-          }
+        for (int person_id = 0; person_id < sampled_keypoints[i]->size();
+             person_id++) {
+          float score = sampled_keypoint_scores[i]->at(person_id)->at(j);
+          if (score < eps) continue;
+
+          float mu_x = sampled_keypoints[i]->at(person_id)->at(j * 2);
+          float mu_y = sampled_keypoints[i]->at(person_id)->at(j * 2 + 1);
+          splatGaussian(base, img_w, img_h, mu_x, mu_y, sigma,
+                        score * context->input_scale);
+        }
       }
     }
-  }
+  });
+  // 后一半输入与前一半相同
+  memcpy(data + heatmap_start_indx, data, heatmap_start_indx * sizeof(float));
 
   return common::ErrorCode::SUCCESS;
 }
@@ -331,6 +345,7 @@ common::ErrorCode Posec3dPreProcess::preProcess(
     std::shared_ptr<Posec3dContext> context,
     common::ObjectMetadatas& objectMetadatas) {
   if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
+  if (context->stride > 0) return preProcessWindow(context, objectMetadatas);
   initTensors(context, objectMetadatas);
 
   fpptr_dim3 keypoints;
@@ -371,48 +386,254 @@ common::ErrorCode Posec3dPreProcess::preProcess(
   centerCrop(keypoints, new_shape, crop_quadruple, crop_size);
   int out_num = context->m_net_crops_clips * context->m_net_channel *
                 context->m_net_keypoints * context->net_h * context->net_w;
-  int size_byte = out_num * sizeof(float);
   // input data set into obj0 mem
+  float* heatmap = mapHeatmap(context, objectMetadatas[0], out_num);
+  generatePoseTarget(context, keypoints, sampled_keypoints,
+                     sampled_keypoint_scores, new_shape, heatmap, out_num, 0.6,
+                     1.0, clip_len);
+  uploadHeatmap(context, objectMetadatas[0], heatmap);
+
+  objectMetadatas[0]->is_main = true;
+
+  return common::ErrorCode::SUCCESS;
+}
+
+float* Posec3dPreProcess::mapHeatmap(
+    std::shared_ptr<Posec3dContext> context,
+    std::shared_ptr<common::ObjectMetadata> obj, int out_num) {
+  int size_byte = out_num * sizeof(float);
   auto ret = bm_malloc_device_byte_heap(
-      context->handle,
-      &objectMetadatas[0]->mInputBMtensors->tensors[0]->device_mem, STREAM_NPU_HEAP,
-      size_byte);
+      context->handle, &obj->mInputBMtensors->tensors[0]->device_mem,
+      STREAM_NPU_HEAP, size_byte);
   STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
 
-  // generate heatmap input
-  float* heatmap = nullptr;
   if (context->bmNetwork->is_soc) {
     unsigned long long addr;
     assert(BM_SUCCESS ==
            bm_mem_mmap_device_mem(
-               context->handle,
-               &objectMetadatas[0]->mInputBMtensors->tensors[0]->device_mem,
+               context->handle, &obj->mInputBMtensors->tensors[0]->device_mem,
                &addr));
-    objectMetadatas[0]->mInputBMtensors->cpu_data.resize(1);
-    objectMetadatas[0]->mInputBMtensors->cpu_data[0] = (float*)addr;
-    heatmap = objectMetadatas[0]->mInputBMtensors->cpu_data[0];
-  } else
-    heatmap = new float[out_num];
-  generatePoseTarget(context, keypoints, sampled_keypoints,
-                     sampled_keypoint_scores, new_shape, heatmap, out_num, 0.6,
-                     1.0, clip_len);
+    obj->mInputBMtensors->cpu_data.resize(1);
+    obj->mInputBMtensors->cpu_data[0] = (float*)addr;
+    return obj->mInputBMtensors->cpu_data[0];
+  }
+  return new float[out_num];
+}
 
+void Posec3dPreProcess::uploadHeatmap(
+    std::shared_ptr<Posec3dContext> context,
+    std::shared_ptr<common::ObjectMetadata> obj, float* heatmap) {
   if (context->bmNetwork->is_soc)
     assert(BM_SUCCESS ==
            bm_mem_flush_device_mem(
-               context->handle,
-               &objectMetadatas[0]->mInputBMtensors->tensors[0]->device_mem));
+               context->handle, &obj->mInputBMtensors->tensors[0]->device_mem));
   else {
     assert(BM_SUCCESS ==
-           bm_memcpy_s2d(
-               context->handle,
-               objectMetadatas[0]->mInputBMtensors->tensors[0]->device_mem,
-               (void*)heatmap));
+           bm_memcpy_s2d(context->handle,
+                         obj->mInputBMtensors->tensors[0]->device_mem,
+                         (void*)heatmap));
     delete[] heatmap;
   }
+}
+
+bool Posec3dPreProcess::appendFrame(
+    std::shared_ptr<Posec3dContext> context,
+    std::shared_ptr<common::ObjectMetadata> objectMetadata) {
+  int channelId = objectMetadata->mFrame->mChannelId;
+  std::shared_ptr<KeypointWindow> window;
+  {
+    std::lock_guard<std::mutex> lk(mWindowsMtx);
+    auto& windowPtr = mWindows[channelId];
+    if (windowPtr == nullptr) {
+      windowPtr = std::make_shared<KeypointWindow>();
+      windowPtr->frames.resize(context->window_size);
+    }
+    window = windowPtr;
+  }
 
-  objectMetadatas[0]->is_main = true;
+  // 覆盖最旧的一帧，保留各vector的容量
+  auto& frame = window->frames[window->head];
+  std::size_t person_num = objectMetadata->mPosedObjectMetadatas.size();
+  frame.keypoints.resize(person_num);
+  frame.scores.resize(person_num);
+  for (std::size_t i = 0; i < person_num; ++i) {
+    auto& poseObj = objectMetadata->mPosedObjectMetadatas[i];
+    frame.keypoints[i].assign(poseObj->keypoints.begin(),
+                              poseObj->keypoints.end());
+    frame.scores[i].assign(poseObj->scores.begin(), poseObj->scores.end());
+  }
+  frame.transform_id = 0;
+
+  window->head = (window->head + 1) % context->window_size;
+  window->count = std::min(window->count + 1, context->window_size);
+  window->since_last_run++;
+  window->frame_h = objectMetadata->mFrame->mSpData->height;
+  window->frame_w = objectMetadata->mFrame->mSpData->width;
+
+  if (window->count < context->window_size ||
+      window->since_last_run < context->stride)
+    return false;
+  window->since_last_run = 0;
+  return true;
+}
+
+void Posec3dPreProcess::releaseWindow(int channelId) {
+  std::lock_guard<std::mutex> lk(mWindowsMtx);
+  mWindows.erase(channelId);
+}
+
+void Posec3dPreProcess::updateTransform(std::shared_ptr<Posec3dContext> context,
+                                        KeypointWindow& window) {
+  const float padding = 0.25;
+  const int threshold = 10;
+  float min_x = INT_MAX, min_y = INT_MAX, max_x = INT_MIN, max_y = INT_MIN;
+  for (auto& frame : window.frames) {
+    for (auto& person : frame.keypoints) {
+      for (int i = 0; i + 1 < person.size(); i += 2) {
+        min_x = std::min(min_x, person[i]);
+        min_y = std::min(min_y, person[i + 1]);
+        max_x = std::max(max_x, person[i]);
+        max_y = std::max(max_y, person[i + 1]);
+      }
+    }
+  }
+  bool compacted = !(max_x - min_x < threshold || max_y - min_y < threshold);
+
+  // 沿用上次的变换：关键点仍在上次的包围框内，且包围框没有明显缩小
+  auto& last = window.transform;
+  if (window.transform_id != 0 && compacted && last.compacted &&
+      min_x >= last.box_min_x && max_x <= last.box_max_x &&
+      min_y >= last.box_min_y && max_y <= last.box_max_y) {
+    float half_size = std::max(max_x - min_x, max_y - min_y) / 2 * (1 + padding);
+    float last_half_size = std::max(last.box_max_x - last.box_min_x,
+                                    last.box_max_y - last.box_min_y) /
+                           2;
+    if (half_size >= TRANSFORM_REUSE_MIN_RATIO * last_half_size) return;
+  }
+
+  // poseCompact, hw_ratio = {1.0, 1.0}, allow_imgpad = true
+  PoseTransform transform;
+  transform.compacted = compacted;
+  int img_h = window.frame_h, img_w = window.frame_w;
+  if (compacted) {
+    float center_x = (max_x + min_x) / 2;
+    float center_y = (max_y + min_y) / 2;
+    float half_width = (max_x - min_x) / 2 * (1 + padding);
+    float half_height = (max_y - min_y) / 2 * (1 + padding);
+    half_height = std::max(half_width, half_height);
+    half_width = std::max(half_height, half_width);
+    transform.box_min_x = int(center_x - half_width);
+    transform.box_max_x = int(center_x + half_width);
+    transform.box_min_y = int(center_y - half_height);
+    transform.box_max_y = int(center_y + half_height);
+    img_h = int(transform.box_max_y - transform.box_min_y);
+    img_w = int(transform.box_max_x - transform.box_min_x);
+    transform.offset_x = transform.box_min_x;
+    transform.offset_y = transform.box_min_y;
+  } else {
+    transform.box_min_x = transform.box_min_y = 0;
+    transform.box_max_x = img_w;
+    transform.box_max_y = img_h;
+    transform.offset_x = transform.offset_y = 0;
+  }
+
+  // resize, keep_ratio, 短边缩放到heatmap尺寸
+  float scale_factor = float(std::min(context->net_h, context->net_w)) /
+                       float(std::min(img_h, img_w));
+  int new_w = int(img_w * scale_factor + 0.5);
+  int new_h = int(img_h * scale_factor + 0.5);
+  transform.scale_x = float(new_w) / float(img_w);
+  transform.scale_y = float(new_h) / float(img_h);
+
+  // centerCrop
+  transform.crop_x = (new_w - context->net_w) / 2;
+  transform.crop_y = (new_h - context->net_h) / 2;
+
+  window.transform = transform;
+  window.transform_id++;
+}
+
+void Posec3dPreProcess::generateHeatmapSlice(
+    std::shared_ptr<Posec3dContext> context, const PoseTransform& transform,
+    KeypointWindow::FrameKeypoints& frame) {
+  const float eps = 1e-4;
+  const float sigma = 0.6;
+  int img_h = context->net_h, img_w = context->net_w;
+  int num_c = context->m_net_keypoints;
+  frame.heatmap.assign(num_c * img_h * img_w, 0.f);
+
+  for (int j = 0; j < num_c; j++) {
+    float* base = frame.heatmap.data() + j * img_h * img_w;
+    for (int person_id = 0; person_id < frame.keypoints.size(); person_id++) {
+      float score = frame.scores[person_id][j];
+      if (score < eps) continue;
+
+      float mu_x =
+          (frame.keypoints[person_id][j * 2] - transform.offset_x) *
+              transform.scale_x -
+          transform.crop_x;
+      float mu_y =
+          (frame.keypoints[person_id][j * 2 + 1] - transform.offset_y) *
+              transform.scale_y -
+          transform.crop_y;
+
+      splatGaussian(base, img_w, img_h, mu_x, mu_y, sigma,
+                    score * context->input_scale);
+    }
+  }
+}
+
+common::ErrorCode Posec3dPreProcess::preProcessWindow(
+    std::shared_ptr<Posec3dContext> context,
+    common::ObjectMetadatas& objectMetadatas) {
+  auto& obj = objectMetadatas[0];
+  std::shared_ptr<KeypointWindow> window;
+  {
+    std::lock_guard<std::mutex> lk(mWindowsMtx);
+    auto windowIt = mWindows.find(obj->mFrame->mChannelId);
+    if (windowIt == mWindows.end()) return common::ErrorCode::SUCCESS;
+    window = windowIt->second;
+  }
+  initTensors(context, objectMetadatas);
+  updateTransform(context, *window);
+
+  int clip_len = context->m_net_channel;
+  int num_clips = context->m_net_crops_clips / 2;
+  int slice_num = context->net_h * context->net_w;
+  int num_c = context->m_net_keypoints;
+  int out_num = context->m_net_crops_clips * clip_len * num_c * slice_num;
+  float* heatmap = mapHeatmap(context, obj, out_num);
+
+  // 窗口中最旧的一帧位于head
+  std::vector<int> inds =
+      sampleFrameIndices(window->count, clip_len, num_clips, 255);
+  // 采样可能重复取同一帧，先找出需要重新生成切片的帧，再按帧分给多个线程
+  std::vector<KeypointWindow::FrameKeypoints*> stale;
+  for (int ind : inds) {
+    auto& frame = window->frames[(window->head + ind) % context->window_size];
+    if (frame.transform_id == window->transform_id) continue;
+    frame.transform_id = window->transform_id;
+    stale.push_back(&frame);
+  }
+  parallelFrames(stale.size(), [&](int begin, int end) {
+    for (int i = begin; i < end; i++)
+      generateHeatmapSlice(context, window->transform, *stale[i]);
+  });
+  for (int i = 0; i < inds.size(); i++) {
+    auto& frame =
+        window->frames[(window->head + inds[i]) % context->window_size];
+    for (int j = 0; j < num_c; j++) {
+      float* dst = heatmap + i / clip_len * num_c * clip_len * slice_num +
+                   j * clip_len * slice_num + i % clip_len * slice_num;
+      memcpy(dst, frame.heatmap.data() + j * slice_num,
+             slice_num * sizeof(float));
+    }
+  }
+  // 后一半输入与前一半相同，见generatePoseTarget
+  memcpy(heatmap + out_num / 2, heatmap, out_num / 2 * sizeof(float));
+  uploadHeatmap(context, obj, heatmap);
 
+  obj->is_main = true;
   return common::ErrorCode::SUCCESS;
 }
 
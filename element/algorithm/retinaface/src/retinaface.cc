@@ -118,6 +118,9 @@ common::ErrorCode Retinaface::initInternal(const std::string& json) {
 
       mFpsProfiler.config(mFpsProfilerName, 100);
     }
+    mPreLatency = registerStageLatency("pre");
+    mInferLatency = registerStageLatency("infer");
+    mPostLatency = registerStageLatency("post");
 
     // 新建context,预处理,推理和后处理对象
     mContext = std::make_shared<RetinafaceContext>();
@@ -145,6 +148,7 @@ common::ErrorCode Retinaface::initInternal(const std::string& json) {
 void Retinaface::process(common::ObjectMetadatas& objectMetadatas) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   if (use_pre) {
+    common::ScopedLatency latency(mPreLatency);
     errorCode = mPreProcess->preProcess(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -155,6 +159,7 @@ void Retinaface::process(common::ObjectMetadatas& objectMetadatas) {
   }
   // 推理
   if (use_infer) {
+    common::ScopedLatency latency(mInferLatency);
     errorCode = mInference->predict(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -164,7 +169,10 @@ void Retinaface::process(common::ObjectMetadatas& objectMetadatas) {
     }
   }
   // 后处理
-  if (use_post) mPostProcess->postProcess(mContext, objectMetadatas);
+  if (use_post) {
+    common::ScopedLatency latency(mPostLatency);
+    mPostProcess->postProcess(mContext, objectMetadatas);
+  }
 }
 
 common::ErrorCode Retinaface::doWork(int dataPipeId) {
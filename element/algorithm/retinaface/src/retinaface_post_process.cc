@@ -82,7 +82,7 @@ void RetinafacePostProcess::postProcess(
 
     for (int i = 0; i < face_num; i++) {
       std::shared_ptr<common::FaceObjectMetadata> detData =
-          std::make_shared<common::FaceObjectMetadata>();
+          common::makeInArena<common::FaceObjectMetadata>(obj->mArena);
       detData->left = faceInfo[i].rect.x1;
       detData->right = faceInfo[i].rect.x2;
       detData->top = faceInfo[i].rect.y1;
@@ -11,6 +11,7 @@
 #define SOPHON_STREAM_ELEMENT_YOLOV5_CONTEXT_H_
 
 #include "algorithmApi/context.h"
+#include "algorithmApi/tiling.h"
 
 namespace sophon_stream {
 namespace element {
@@ -67,9 +68,9 @@ class Yolov5Context : public ::sophon_stream::element::Context {
   std::unordered_map<std::string, float> thresh_conf;  // 置信度阈值
   float thresh_nms;                                    // nms iou阈值
   std::vector<std::string> class_names;
+  // class_names在LabelTable中的id
+  std::vector<int> class_label_ids;
   bool class_thresh_valid = false;
-  float
-      log_conf_threshold;  // 应用log运算符到阈值可在box过滤时省略box置信度的sigmoid计算
 
   int class_num = 80;  // default is coco names
   int m_frame_h, m_frame_w;
@@ -82,6 +83,8 @@ class Yolov5Context : public ::sophon_stream::element::Context {
 
   bmcv_rect_t roi;
   bool roi_predefined = false;
+  bool cpu_preprocess = false;  // 是否在CPU上用融合算子做前处理
+  tiling::TileParams tile;      // 切块推理，配置了tile时启用
   int thread_number;
   unsigned int m_max_det = UINT_MAX, m_min_det = 0;
 };
@@ -52,8 +52,6 @@ class Yolov5PostProcess : public ::sophon_stream::element::PostProcess {
   void setTpuKernelMem(std::shared_ptr<Yolov5Context> context,
                        common::ObjectMetadatas& objectMetadatas,
                        tpu_kernel& tpu_k);
-  float sigmoid(float x);
-  int argmax(float* data, int num);
   void NMS(YoloV5BoxVec& dets, float nmsConfidence);
   void postProcessCPU(std::shared_ptr<Yolov5Context> context,
                       common::ObjectMetadatas& objectMetadatas);
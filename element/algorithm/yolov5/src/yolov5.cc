@@ -15,7 +15,7 @@ namespace sophon_stream {
 namespace element {
 namespace yolov5 {
 
-Yolov5::Yolov5() {}
+Yolov5::Yolov5() { mUseDetectionTable = true; }
 
 Yolov5::~Yolov5() {}
 
@@ -55,6 +55,8 @@ common::ErrorCode Yolov5::initContext(const std::string& json) {
         while (std::getline(istream, line)) {
           line = line.substr(0, line.length());
           mContext->class_names.push_back(line);
+          mContext->class_label_ids.push_back(
+              common::SingletonLabelTable::getInstance().intern(line));
           // if (mContext->thresh_conf_min != -1) {
           //   mContext->thresh_conf.insert({line, mContext->thresh_conf_min});
           // }
@@ -69,7 +71,6 @@ common::ErrorCode Yolov5::initContext(const std::string& json) {
                                       ? mContext->thresh_conf_min
                                       : thresh_it->second;
     }
-    mContext->log_conf_threshold = -std::log(1 / mContext->thresh_conf_min - 1);
 
     auto threshNmsIt = configure.find(CONFIG_INTERNAL_THRESHOLD_NMS_FIELD);
     mContext->thresh_nms = threshNmsIt->get<float>();
@@ -94,6 +95,11 @@ common::ErrorCode Yolov5::initContext(const std::string& json) {
     }
     mContext->use_tpu_kernel = tpu_kernelIt->get<bool>();
 
+    auto cpuPreprocessIt =
+        configure.find(CONFIG_INTERNAL_CPU_PREPROCESS_FIELD);
+    if (configure.end() != cpuPreprocessIt && cpuPreprocessIt->is_boolean())
+      mContext->cpu_preprocess = cpuPreprocessIt->get<bool>();
+
     auto max_detIt = configure.find(CONFIG_INTERNAL_MAX_DET_FILED);
     auto min_detIt = configure.find(CONFIG_INTERNAL_MIN_DET_FILED);
     if (configure.end() != max_detIt) {
@@ -203,6 +209,52 @@ common::ErrorCode Yolov5::initContext(const std::string& json) {
       mContext->roi.crop_h =
           roi_it->find(CONFIG_INTERNAL_HEIGHT_FILED)->get<int>();
     }
+
+    // 8. tile
+    auto tileIt = configure.find(CONFIG_INTERNAL_TILE_FIELD);
+    if (configure.end() != tileIt && tileIt->is_object()) {
+      auto& tile = mContext->tile;
+      tile.enabled = true;
+      // 块默认与网络输入一样大，推理时不缩放
+      tile.tileW = mContext->net_w;
+      tile.tileH = mContext->net_h;
+      auto tileWidthIt = tileIt->find(CONFIG_INTERNAL_WIDTH_FILED);
+      if (tileIt->end() != tileWidthIt && tileWidthIt->is_number_integer())
+        tile.tileW = tileWidthIt->get<int>();
+      auto tileHeightIt = tileIt->find(CONFIG_INTERNAL_HEIGHT_FILED);
+      if (tileIt->end() != tileHeightIt && tileHeightIt->is_number_integer())
+        tile.tileH = tileHeightIt->get<int>();
+      auto overlapIt = tileIt->find(CONFIG_INTERNAL_OVERLAP_FIELD);
+      if (tileIt->end() != overlapIt && overlapIt->is_number())
+        tile.overlap = overlapIt->get<float>();
+      auto fullFrameIt = tileIt->find(CONFIG_INTERNAL_FULL_FRAME_FIELD);
+      if (tileIt->end() != fullFrameIt && fullFrameIt->is_boolean())
+        tile.fullFrame = fullFrameIt->get<bool>();
+      auto motionOnlyIt = tileIt->find(CONFIG_INTERNAL_MOTION_ONLY_FIELD);
+      if (tileIt->end() != motionOnlyIt && motionOnlyIt->is_boolean())
+        tile.motionOnly = motionOnlyIt->get<bool>();
+      auto mergeIt = tileIt->find(CONFIG_INTERNAL_MERGE_FIELD);
+      if (tileIt->end() != mergeIt && mergeIt->is_string() &&
+          !tiling::parseMergeMethod(mergeIt->get<std::string>(),
+                                    &tile.mergeMethod))
+        IVS_WARN("Unknown tile merge method: {0}, use nmm",
+                 mergeIt->get<std::string>());
+      auto matchIt = tileIt->find(CONFIG_INTERNAL_MATCH_FIELD);
+      if (tileIt->end() != matchIt && matchIt->is_string() &&
+          !tiling::parseMatchMetric(matchIt->get<std::string>(),
+                                    &tile.matchMetric))
+        IVS_WARN("Unknown tile match metric: {0}, use ios",
+                 matchIt->get<std::string>());
+      auto mergeThresholdIt =
+          tileIt->find(CONFIG_INTERNAL_MERGE_THRESHOLD_FIELD);
+      if (tileIt->end() != mergeThresholdIt && mergeThresholdIt->is_number())
+        tile.mergeThreshold = mergeThresholdIt->get<float>();
+      IVS_INFO(
+          "Yolov5 tiled inference, tile: {0}x{1}, overlap: {2}, full frame: "
+          "{3}, motion only: {4}",
+          tile.tileW, tile.tileH, tile.overlap, tile.fullFrame,
+          tile.motionOnly);
+    }
     mContext->thread_number = getThreadNumber();
   } while (false);
   return common::ErrorCode::SUCCESS;
@@ -237,6 +289,9 @@ common::ErrorCode Yolov5::initInternal(const std::string& json) {
 
       mFpsProfiler.config(mFpsProfilerName, 100);
     }
+    mPreLatency = registerStageLatency("pre");
+    mInferLatency = registerStageLatency("infer");
+    mPostLatency = registerStageLatency("post");
 
     // 新建context,预处理,推理和后处理对象
     mContext = std::make_shared<Yolov5Context>();
@@ -264,6 +319,7 @@ common::ErrorCode Yolov5::initInternal(const std::string& json) {
 void Yolov5::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   if (use_pre) {
+    common::ScopedLatency latency(mPreLatency);
     errorCode = mPreProcess->preProcess(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -274,6 +330,7 @@ void Yolov5::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   }
   // 推理
   if (use_infer) {
+    common::ScopedLatency latency(mInferLatency);
     errorCode = mInference->predict(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -283,8 +340,73 @@ void Yolov5::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
     }
   }
   // 后处理
-  if (use_post)
+  if (use_post) {
+    common::ScopedLatency latency(mPostLatency);
     mPostProcess->postProcess(mContext, objectMetadatas, dataPipeId);
+  }
+}
+
+std::vector<common::Rectangle<int>> Yolov5::planTiles(
+    const std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
+  if (objectMetadata->mFrame->mEndOfStream ||
+      objectMetadata->mFrame->mSpData == nullptr)
+    return {};
+  bmcv_rect_t area = tiling::cropRect(mContext, *objectMetadata);
+  return tiling::frameTiles(common::Rectangle<int>(area.start_x, area.start_y,
+                                                   area.crop_w, area.crop_h),
+                            objectMetadata->mMotionRegions, mContext->tile);
+}
+
+void Yolov5::processTiles(common::ObjectMetadatas& objectMetadatas,
+                          int dataPipeId) {
+  // 各帧的块依次排列，一组max_batch个块中可以有多帧的块
+  common::ObjectMetadatas tileObjs;
+  std::vector<int> owners;
+  std::vector<int> tileNums(objectMetadatas.size(), 0);
+  for (int i = 0; i < objectMetadatas.size(); ++i) {
+    auto tiles = tiling::makeTileObjectMetadatas(
+        objectMetadatas[i], planTiles(objectMetadatas[i]));
+    tileNums[i] = tiles.size();
+    tileObjs.insert(tileObjs.end(), tiles.begin(), tiles.end());
+    owners.insert(owners.end(), tiles.size(), i);
+  }
+  for (int begin = 0; begin < tileObjs.size(); begin += mContext->max_batch) {
+    int end = std::min<int>(begin + mContext->max_batch, tileObjs.size());
+    common::ObjectMetadatas batch(tileObjs.begin() + begin,
+                                  tileObjs.begin() + end);
+    process(batch, dataPipeId);
+  }
+
+  // 块的检测框已经换算到原图，同一帧各块的框跨块合并
+  std::vector<std::vector<tiling::Detection>> detections(
+      objectMetadatas.size());
+  std::vector<std::vector<int>> labelIds(objectMetadatas.size());
+  for (int t = 0; t < tileObjs.size(); ++t) {
+    int owner = owners[t];
+    if (tileObjs[t]->mErrorCode != common::ErrorCode::SUCCESS)
+      objectMetadatas[owner]->mErrorCode = tileObjs[t]->mErrorCode;
+    const common::DetectionTable& table = tileObjs[t]->mDetectionTable;
+    for (std::size_t row = 0; row < table.size(); ++row) {
+      detections[owner].push_back(
+          {static_cast<float>(table.mX[row]), static_cast<float>(table.mY[row]),
+           static_cast<float>(table.mX[row] + table.mWidth[row]),
+           static_cast<float>(table.mY[row] + table.mHeight[row]),
+           table.mScore[row], table.mClassId[row],
+           static_cast<int>(labelIds[owner].size())});
+      labelIds[owner].push_back(table.mLabelId[row]);
+    }
+  }
+  for (int i = 0; i < objectMetadatas.size(); ++i) {
+    // 只有一块时块内已经做过NMS
+    auto merged = tileNums[i] > 1
+                      ? tiling::mergeDetections(detections[i], mContext->tile)
+                      : detections[i];
+    common::DetectionTable& table = objectMetadatas[i]->mDetectionTable;
+    table.reserve(table.size() + merged.size());
+    for (const auto& det : merged)
+      table.add(det.x1, det.y1, det.x2 - det.x1, det.y2 - det.y1, det.score,
+                det.classId, labelIds[i][det.source]);
+  }
 }
 
 common::ErrorCode Yolov5::doWork(int dataPipeId) {
@@ -301,7 +423,10 @@ common::ErrorCode Yolov5::doWork(int dataPipeId) {
 
   common::ObjectMetadatas pendingObjectMetadatas;
 
-  while (objectMetadatas.size() < mContext->max_batch &&
+  // 切块需要前处理、推理、后处理在同一个element中，一帧占用多个batch位置
+  bool tiled = mContext->tile.enabled && use_pre && use_infer && use_post;
+  int batchSlots = 0;
+  while (batchSlots < mContext->max_batch &&
          (getThreadStatus() == ThreadStatus::RUN)) {
     // 如果队列为空则等待
     auto data = popInputData(inputPort, dataPipeId);
@@ -312,7 +437,11 @@ common::ErrorCode Yolov5::doWork(int dataPipeId) {
 
     auto objectMetadata =
         std::static_pointer_cast<common::ObjectMetadata>(data);
-    if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
+    if (!objectMetadata->mFilter) {
+      objectMetadatas.push_back(objectMetadata);
+      batchSlots +=
+          tiled ? std::max<int>(planTiles(objectMetadata).size(), 1) : 1;
+    }
 
     pendingObjectMetadatas.push_back(objectMetadata);
 
@@ -321,7 +450,10 @@ common::ErrorCode Yolov5::doWork(int dataPipeId) {
     }
   }
 
-  process(objectMetadatas, dataPipeId);
+  if (tiled)
+    processTiles(objectMetadatas, dataPipeId);
+  else
+    process(objectMetadatas, dataPipeId);
 
   for (auto& objectMetadata : pendingObjectMetadatas) {
     int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
@@ -9,6 +9,9 @@
 
 #include "yolov5_post_process.h"
 
+#include "algorithmApi/tiling.h"
+#include "algorithmApi/yolo_head.h"
+
 namespace sophon_stream {
 namespace element {
 namespace yolov5 {
@@ -80,22 +83,6 @@ Yolov5PostProcess::~Yolov5PostProcess() {
   }
 }
 
-int Yolov5PostProcess::argmax(float* data, int num) {
-  float max_value = 0.0;
-  int max_index = 0;
-  for (int i = 0; i < num; ++i) {
-    float value = data[i];
-    if (value > max_value) {
-      max_value = value;
-      max_index = i;
-    }
-  }
-
-  return max_index;
-}
-
-float Yolov5PostProcess::sigmoid(float x) { return 1.0 / (1 + expf(-x)); }
-
 void Yolov5PostProcess::NMS(YoloV5BoxVec& dets, float nmsConfidence) {
   int length = dets.size();
   int index = length - 1;
@@ -141,7 +128,8 @@ void Yolov5PostProcess::setTpuKernelMem(
   std::vector<std::vector<std::shared_ptr<bm_device_mem_t>>> in_dev_mems(
       context->max_batch,
       std::vector<std::shared_ptr<bm_device_mem_t>>(input_num));
-  for (int batch_idx = 0; batch_idx < context->max_batch; ++batch_idx) {
+  int batch_num = std::min<int>(context->max_batch, objectMetadatas.size());
+  for (int batch_idx = 0; batch_idx < batch_num; ++batch_idx) {
     if (objectMetadatas[batch_idx]->mFrame->mEndOfStream) break;
     for (int i = 0; i < input_num; i++)
       in_dev_mems[batch_idx][i] = std::make_shared<bm_device_mem_t>(
@@ -183,31 +171,21 @@ void Yolov5PostProcess::postProcessTPUKERNEL(
     common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   tpu_kernel& tpu_k = multi_thread_tpu_kernel[dataPipeId];
   setTpuKernelMem(context, objectMetadatas, tpu_k);
-  for (int i = 0; i < context->max_batch; i++) {
+  // 跳过的帧与切块的最后一组都可能不足max_batch
+  int batch_num = std::min<int>(context->max_batch, objectMetadatas.size());
+  for (int i = 0; i < batch_num; i++) {
     if (objectMetadatas[i]->mFrame->mEndOfStream) break;
-    bm_image image = *objectMetadatas[i]->mFrame->mSpData;
+    bmcv_rect_t crop_rect = tiling::cropRect(context, *objectMetadatas[i]);
     int tx1 = 0, ty1 = 0;
 #if USE_ASPECT_RATIO
     bool isAlignWidth = false;
     float ratio =
-        context->roi_predefined
-            ? get_aspect_scaled_ratio(context->roi.crop_w, context->roi.crop_h,
-                                      context->net_w, context->net_h,
-                                      &isAlignWidth)
-            : get_aspect_scaled_ratio(image.width, image.height, context->net_w,
-                                      context->net_h, &isAlignWidth);
+        get_aspect_scaled_ratio(crop_rect.crop_w, crop_rect.crop_h,
+                                context->net_w, context->net_h, &isAlignWidth);
     if (isAlignWidth) {
-      ty1 = (int)((context->net_h -
-                   (int)((context->roi_predefined ? context->roi.crop_h
-                                                  : image.height) *
-                         ratio)) /
-                  2);
+      ty1 = (int)((context->net_h - (int)(crop_rect.crop_h * ratio)) / 2);
     } else {
-      tx1 = (int)((context->net_w -
-                   (int)((context->roi_predefined ? context->roi.crop_w
-                                                  : image.width) *
-                         ratio)) /
-                  2);
+      tx1 = (int)((context->net_w - (int)(crop_rect.crop_w * ratio)) / 2);
     }
 #endif
 
@@ -246,25 +224,17 @@ void Yolov5PostProcess::postProcessTPUKERNEL(
       temp_bbox.x = std::max(int(centerX - temp_bbox.width / 2), 0);
       temp_bbox.y = std::max(int(centerY - temp_bbox.height / 2), 0);
 
-      std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
-      detData->mBox.mX = temp_bbox.x;
-      detData->mBox.mY = temp_bbox.y;
-      detData->mBox.mWidth =
-          std::min(temp_bbox.width, image.width - temp_bbox.x);
-      detData->mBox.mHeight =
-          std::min(temp_bbox.height, image.height - temp_bbox.y);
-      detData->mScores.push_back(temp_bbox.score);
-      detData->mClassify = temp_bbox.class_id;
-      if (context->roi_predefined) {
-        detData->mBox.mX += context->roi.start_x;
-        detData->mBox.mY += context->roi.start_y;
-      }
-      if (detData->mBox.mWidth > context->m_min_det &&
-          detData->mBox.mHeight > context->m_min_det &&
-          detData->mBox.mWidth < context->m_max_det &&
-          detData->mBox.mHeight < context->m_max_det)
-        objectMetadatas[i]->mDetectedObjectMetadatas.push_back(detData);
+      int x = temp_bbox.x;
+      int y = temp_bbox.y;
+      int width = std::min(temp_bbox.width, crop_rect.crop_w - temp_bbox.x);
+      int height = std::min(temp_bbox.height, crop_rect.crop_h - temp_bbox.y);
+      x += crop_rect.start_x;
+      y += crop_rect.start_y;
+      if (width > context->m_min_det && height > context->m_min_det &&
+          width < context->m_max_det && height < context->m_max_det)
+        objectMetadatas[i]->mDetectionTable.add(x, y, width, height,
+                                                temp_bbox.score,
+                                                temp_bbox.class_id);
     }
   }
 }
@@ -287,31 +257,21 @@ void Yolov5PostProcess::postProcessCPU(
     }
 
     yolobox_vec.clear();
-    int frame_width = obj->mFrame->mSpData->width;
-    int frame_height = obj->mFrame->mSpData->height;
+    // 切块时为所在的块，否则为roi或整帧，框先在其中计算再加上起点
+    bmcv_rect_t crop_rect = tiling::cropRect(context, *obj);
+    int frame_width = crop_rect.crop_w;
+    int frame_height = crop_rect.crop_h;
 
     int tx1 = 0, ty1 = 0;
 #if USE_ASPECT_RATIO
     bool isAlignWidth = false;
     float ratio =
-        context->roi_predefined
-            ? get_aspect_scaled_ratio(context->roi.crop_w, context->roi.crop_h,
-                                      context->net_w, context->net_h,
-                                      &isAlignWidth)
-            : get_aspect_scaled_ratio(frame_width, frame_height, context->net_w,
-                                      context->net_h, &isAlignWidth);
+        get_aspect_scaled_ratio(frame_width, frame_height, context->net_w,
+                                context->net_h, &isAlignWidth);
     if (isAlignWidth) {
-      ty1 = (int)((context->net_h -
-                   (int)((context->roi_predefined ? context->roi.crop_h
-                                                  : frame_height) *
-                         ratio)) /
-                  2);
+      ty1 = (int)((context->net_h - (int)(frame_height * ratio)) / 2);
     } else {
-      tx1 = (int)((context->net_w -
-                   (int)((context->roi_predefined ? context->roi.crop_w
-                                                  : frame_width) *
-                         ratio)) /
-                  2);
+      tx1 = (int)((context->net_w - (int)(frame_width * ratio)) / 2);
     }
 #endif
     int min_idx = 0;
@@ -334,16 +294,13 @@ void Yolov5PostProcess::postProcessCPU(
     auto out_tensor = outputTensors[min_idx];
     int nout = out_tensor->get_shape()->dims[context->min_dim - 1];
     int m_class_num = nout - 5;
-#if USE_MULTICLASS_NMS
-    int out_nout = nout;
-#else
-    int out_nout = 7;
-#endif
     int max_wh = 7680;
     bool agnostic = false;
 
-    float* output_data = nullptr;
-    std::vector<float> decoded_data;
+    // 每个类别的阈值与其中最小的一个，物体置信度低于最小阈值的候选框直接跳过
+    std::vector<float> thresholds =
+        yolo::classThresholds(context, context->class_num);
+    float min_thresh = yolo::minThreshold(thresholds, context->thresh_conf_min);
 
     if (context->min_dim == 3 && context->output_num != 1) {
       std::cout << "--> WARNING: the current bmodel has redundant outputs"
@@ -361,10 +318,8 @@ void Yolov5PostProcess::postProcessCPU(
       const int anchor_num = anchors[0].size();
       assert(context->output_num == (int)anchors.size());
       assert(box_num > 0);
-      if ((int)decoded_data.size() != box_num * out_nout) {
-        decoded_data.resize(box_num * out_nout);
-      }
-      float* dst = decoded_data.data();
+      // 物体置信度的sigmoid与阈值比较换成logit与换算后的阈值比较
+      float obj_logit_thresh = yolo::logit(min_thresh);
       for (int tidx = 0; tidx < context->output_num; ++tidx) {
         auto output_tensor = outputTensors[tidx];
         int feat_c = output_tensor->get_shape()->dims[1];
@@ -377,79 +332,22 @@ void Yolov5PostProcess::postProcessCPU(
 
         for (int anchor_idx = 0; anchor_idx < anchor_num; anchor_idx++) {
           float* ptr = tensor_data + anchor_idx * feature_size;
-          for (int i = 0; i < area; i++) {
-            if (ptr[4] > context->log_conf_threshold) {
-              dst[0] = (sigmoid(ptr[0]) * 2 - 0.5 + i % feat_w) / feat_w *
-                       context->net_w;
-              dst[1] = (sigmoid(ptr[1]) * 2 - 0.5 + i / feat_w) / feat_h *
-                       context->net_h;
-              dst[2] =
-                  pow((sigmoid(ptr[2]) * 2), 2) * anchors[tidx][anchor_idx][0];
-              dst[3] =
-                  pow((sigmoid(ptr[3]) * 2), 2) * anchors[tidx][anchor_idx][1];
-              dst[4] = sigmoid(ptr[4]);
+          for (int i = 0; i < area; i++, ptr += nout) {
+            if (ptr[4] <= obj_logit_thresh) continue;
+            float score = yolo::fastSigmoid(ptr[4]);
+            float dst[4];
 #if USE_MULTICLASS_NMS
-              for (int d = 5; d < nout; d++) dst[d] = ptr[d];
-#else
-              dst[5] = ptr[5];
-              dst[6] = 5;
-              for (int d = 6; d < nout; d++) {
-                if (ptr[d] > dst[5]) {
-                  dst[5] = ptr[d];
-                  dst[6] = d;
-                }
-              }
-              dst[6] -= 5;
-#endif
-              float score = dst[4];
-#if USE_MULTICLASS_NMS
-              float centerX = dst[0];
-              float centerY = dst[1];
-              float width = dst[2];
-              float height = dst[3];
-              for (int j = 0; j < m_class_num; j++) {
-                float confidence = dst[5 + j];
-                int class_id = j;
-                float cur_class_thresh =
-                    context->class_thresh_valid
-                        ? context->thresh_conf[context->class_names[class_id]]
-                        : context->thresh_conf_min;
-                float box_transformed_m_conf_threshold =
-                    -std::log(score / cur_class_thresh - 1);
-                if (confidence > box_transformed_m_conf_threshold) {
-                  YoloV5Box box;
-                  if (!agnostic)
-                    box.x = centerX - width / 2 + class_id * max_wh;
-                  else
-                    box.x = centerX - width / 2;
-                  if (box.x < 0) box.x = 0;
-                  if (!agnostic)
-                    box.y = centerY - height / 2 + class_id * max_wh;
-                  else
-                    box.y = centerY - height / 2;
-                  if (box.y < 0) box.y = 0;
-                  box.width = width;
-                  box.height = height;
-                  box.class_id = class_id;
-                  box.score = sigmoid(confidence) * score;
-                  yolobox_vec.push_back(box);
-                }
-              }
-#else
-              int class_id = dst[6];
-              float confidence = dst[5];
-              float cur_class_thresh =
-                  context->class_thresh_valid
-                      ? context->thresh_conf[context->class_names[class_id]]
-                      : context->thresh_conf_min;
-              float box_transformed_m_conf_threshold =
-                  -std::log(score / cur_class_thresh - 1);
-              if (confidence > box_transformed_m_conf_threshold) {
-                float centerX = dst[0];
-                float centerY = dst[1];
-                float width = dst[2];
-                float height = dst[3];
-
+            yolo::decodeAnchorBox(ptr, i, feat_w, feat_h, context->net_w,
+                                  context->net_h, anchors[tidx][anchor_idx][0],
+                                  anchors[tidx][anchor_idx][1], dst);
+            float centerX = dst[0];
+            float centerY = dst[1];
+            float width = dst[2];
+            float height = dst[3];
+            for (int j = 0; j < m_class_num; j++) {
+              int class_id = j;
+              float confidence = yolo::fastSigmoid(ptr[5 + j]) * score;
+              if (confidence > thresholds[class_id]) {
                 YoloV5Box box;
                 if (!agnostic)
                   box.x = centerX - width / 2 + class_id * max_wh;
@@ -464,34 +362,58 @@ void Yolov5PostProcess::postProcessCPU(
                 box.width = width;
                 box.height = height;
                 box.class_id = class_id;
-                confidence = sigmoid(confidence);
-                box.score = confidence * score;
+                box.score = confidence;
                 yolobox_vec.push_back(box);
               }
-#endif
             }
-            dst += out_nout;
-            ptr += nout;
+#else
+            // 类别的logit最大时sigmoid也最大，先在logit上取argmax
+            float confidence;
+            int class_id = yolo::argmax(ptr + 5, m_class_num, &confidence);
+            confidence = yolo::fastSigmoid(confidence) * score;
+            if (confidence > thresholds[class_id]) {
+              yolo::decodeAnchorBox(
+                  ptr, i, feat_w, feat_h, context->net_w, context->net_h,
+                  anchors[tidx][anchor_idx][0], anchors[tidx][anchor_idx][1],
+                  dst);
+              float centerX = dst[0];
+              float centerY = dst[1];
+              float width = dst[2];
+              float height = dst[3];
+
+              YoloV5Box box;
+              if (!agnostic)
+                box.x = centerX - width / 2 + class_id * max_wh;
+              else
+                box.x = centerX - width / 2;
+              if (box.x < 0) box.x = 0;
+              if (!agnostic)
+                box.y = centerY - height / 2 + class_id * max_wh;
+              else
+                box.y = centerY - height / 2;
+              if (box.y < 0) box.y = 0;
+              box.width = width;
+              box.height = height;
+              box.class_id = class_id;
+              box.score = confidence;
+              yolobox_vec.push_back(box);
+            }
+#endif
           }
         }
       }
-      output_data = decoded_data.data();
     } else {
       assert(box_num == 0 || box_num == out_tensor->get_shape()->dims[1]);
       box_num = out_tensor->get_shape()->dims[1];
-      output_data = (float*)out_tensor->get_cpu_data();
+      float* output_data = (float*)out_tensor->get_cpu_data();
       for (int i = 0; i < box_num; i++) {
         float* ptr = output_data + i * nout;
         float score = ptr[4];
-        int class_id = argmax(&ptr[5], context->class_num);
-        float confidence = ptr[class_id + 5];
-        if (score > (context->class_thresh_valid
-                         ? context->thresh_conf[context->class_names[class_id]]
-                         : context->thresh_conf_min) &&
-            confidence * score >
-                (context->class_thresh_valid
-                     ? context->thresh_conf[context->class_names[class_id]]
-                     : context->thresh_conf_min)) {
+        if (score <= min_thresh) continue;
+        float confidence;
+        int class_id = yolo::argmax(ptr + 5, context->class_num, &confidence);
+        if (score > thresholds[class_id] &&
+            confidence * score > thresholds[class_id]) {
           float centerX = ptr[0];
           float centerY = ptr[1];
           float width = ptr[2];
@@ -546,29 +468,19 @@ void Yolov5PostProcess::postProcessCPU(
           box.height = frame_height - box.y;
       }
 
-    for (auto bbox : yolobox_vec) {
-      std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
-      detData->mBox.mX = bbox.x;
-      detData->mBox.mY = bbox.y;
-      detData->mBox.mWidth = bbox.width;
-      detData->mBox.mHeight = bbox.height;
-      detData->mScores.push_back(bbox.score);
-      detData->mClassify = bbox.class_id;
-
-      if (context->roi_predefined) {
-        detData->mBox.mX += context->roi.start_x;
-        detData->mBox.mY += context->roi.start_y;
-      }
-
-      if (context->class_thresh_valid) {
-        detData->mLabelName = context->class_names[detData->mClassify];
-      }
-      if (detData->mBox.mWidth > context->m_min_det &&
-          detData->mBox.mHeight > context->m_min_det &&
-          detData->mBox.mWidth < context->m_max_det &&
-          detData->mBox.mHeight < context->m_max_det)
-        obj->mDetectedObjectMetadatas.push_back(detData);
+    // 检测结果直接写入按列存放的检测表，没有逐个框的分配
+    common::DetectionTable& table = obj->mDetectionTable;
+    table.reserve(table.size() + yolobox_vec.size());
+    for (const auto& bbox : yolobox_vec) {
+      int x = bbox.x + crop_rect.start_x;
+      int y = bbox.y + crop_rect.start_y;
+      int labelId = context->class_thresh_valid
+                        ? context->class_label_ids[bbox.class_id]
+                        : -1;
+      if (bbox.width > context->m_min_det && bbox.height > context->m_min_det &&
+          bbox.width < context->m_max_det && bbox.height < context->m_max_det)
+        table.add(x, y, bbox.width, bbox.height, bbox.score, bbox.class_id,
+                  labelId);
     }
     ++idx;
   }
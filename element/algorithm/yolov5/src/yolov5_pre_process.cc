@@ -25,6 +25,11 @@ common::ErrorCode Yolov5PreProcess::preProcess(
   int i = 0;
   for (auto& objMetadata : objectMetadatas) {
     if (objMetadata->mFrame->mSpData == nullptr) continue;
+    if (context->cpu_preprocess &&
+        fusedPreProcessFrame(context, objectMetadatas, i)) {
+      i++;
+      continue;
+    }
     bm_image resized_img;
     bm_image converto_img;
     bm_image image0 = *objMetadata->mFrame->mSpData;
@@ -33,7 +38,8 @@ common::ErrorCode Yolov5PreProcess::preProcess(
     if (image0.image_format != jsonPlanner) {
       bm_image_create(context->handle, image0.height, image0.width, jsonPlanner,
                       image0.data_type, &image1);
-      auto ret = bm_image_alloc_dev_mem_heap_mask(image1, STREAM_VPU_HEAP_MASK);
+      auto ret = common::SingletonDeviceMemoryPool::getInstance().allocImage(
+          context->handle, image1, STREAM_VPU_HEAP_MASK);
       STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
       bmcv_image_storage_convert(context->handle, 1, &image0, &image1);
     } else {
@@ -51,7 +57,8 @@ common::ErrorCode Yolov5PreProcess::preProcess(
                       image1.image_format, image1.data_type, &image_aligned,
                       stride2);
 
-      auto ret = bm_image_alloc_dev_mem_heap_mask(image_aligned, STREAM_VPU_HEAP_MASK);
+      auto ret = common::SingletonDeviceMemoryPool::getInstance().allocImage(
+          context->handle, image_aligned, STREAM_VPU_HEAP_MASK);
       STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
       bmcv_copy_to_atrr_t copyToAttr;
       memset(&copyToAttr, 0, sizeof(copyToAttr));
@@ -64,14 +71,12 @@ common::ErrorCode Yolov5PreProcess::preProcess(
       image_aligned = image1;
     }
     // #ifdef USE_ASPECT_RATIO
+    // 切块时为所在的块，否则为roi或整帧
+    bmcv_rect_t crop_rect = tiling::cropRect(context, *objMetadata);
     bool isAlignWidth = false;
-    float ratio = context->roi_predefined
-                      ? get_aspect_scaled_ratio(
-                            context->roi.crop_w, context->roi.crop_h,
-                            context->net_w, context->net_h, &isAlignWidth)
-                      : get_aspect_scaled_ratio(image0.width, image0.height,
-                                                context->net_w, context->net_h,
-                                                &isAlignWidth);
+    float ratio =
+        get_aspect_scaled_ratio(crop_rect.crop_w, crop_rect.crop_h,
+                                context->net_w, context->net_h, &isAlignWidth);
     bmcv_padding_atrr_t padding_attr;
     memset(&padding_attr, 0, sizeof(padding_attr));
     padding_attr.dst_crop_sty = 0;
@@ -81,9 +86,7 @@ common::ErrorCode Yolov5PreProcess::preProcess(
     padding_attr.padding_r = 114;
     padding_attr.if_memset = 1;
     if (isAlignWidth) {
-      padding_attr.dst_crop_h = context->roi_predefined
-                                    ? (context->roi.crop_h * ratio)
-                                    : (image0.height * ratio);
+      padding_attr.dst_crop_h = crop_rect.crop_h * ratio;
       padding_attr.dst_crop_w = context->net_w;
 
       int ty1 = (int)((context->net_h - padding_attr.dst_crop_h) / 2);
@@ -91,9 +94,7 @@ common::ErrorCode Yolov5PreProcess::preProcess(
       padding_attr.dst_crop_stx = 0;
     } else {
       padding_attr.dst_crop_h = context->net_h;
-      padding_attr.dst_crop_w = context->roi_predefined
-                                    ? (context->roi.crop_w * ratio)
-                                    : (image0.width * ratio);
+      padding_attr.dst_crop_w = crop_rect.crop_w * ratio;
 
       int tx1 = (int)((context->net_w - padding_attr.dst_crop_w) / 2);
       padding_attr.dst_crop_sty = 0;
@@ -104,9 +105,9 @@ common::ErrorCode Yolov5PreProcess::preProcess(
     int strides[3] = {aligned_net_w, aligned_net_w, aligned_net_w};
     bm_image_create(context->handle, context->net_h, context->net_w,
                     jsonPlanner, DATA_TYPE_EXT_1N_BYTE, &resized_img, strides);
-    auto ret = bm_image_alloc_dev_mem_heap_mask(resized_img, STREAM_VPP_HEAP_MASK);
+    auto ret = common::SingletonDeviceMemoryPool::getInstance().allocImage(
+        context->handle, resized_img, STREAM_VPP_HEAP_MASK);
     STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
-    bmcv_rect_t crop_rect{0, 0, image1.width, image1.height};
     if (context->roi_predefined) {
       if (context->roi.start_x > image1.width ||
           context->roi.start_y > image1.height ||
@@ -115,20 +116,22 @@ common::ErrorCode Yolov5PreProcess::preProcess(
         IVS_CRITICAL("ROI AREA OUT OF RANGE");
         abort();
       }
-      ret = bmcv_image_vpp_convert_padding(context->bmContext->handle(), 1,
-                                           image_aligned, &resized_img,
-                                           &padding_attr, &context->roi);
-    } else {
-      ret = bmcv_image_vpp_convert_padding(context->bmContext->handle(), 1,
-                                           image_aligned, &resized_img,
-                                           &padding_attr, &crop_rect);
     }
+    ret = bmcv_image_vpp_convert_padding(context->bmContext->handle(), 1,
+                                         image_aligned, &resized_img,
+                                         &padding_attr, &crop_rect);
     STREAM_CHECK(ret == 0, "Vpp Convert Padding Failed! Program Terminated.")
 
-    if (image0.image_format != FORMAT_BGR_PLANAR) {
+    if (image0.image_format != jsonPlanner) {
+      common::SingletonDeviceMemoryPool::getInstance().freeImage(
+          context->handle, image1);
       bm_image_destroy(image1);
     }
-    if (need_copy) bm_image_destroy(image_aligned);
+    if (need_copy) {
+      common::SingletonDeviceMemoryPool::getInstance().freeImage(
+          context->handle, image_aligned);
+      bm_image_destroy(image_aligned);
+    }
 
     bm_image_data_format_ext img_dtype = DATA_TYPE_EXT_FLOAT32;
     auto tensor = context->bmNetwork->inputTensor(0);
@@ -144,7 +147,7 @@ common::ErrorCode Yolov5PreProcess::preProcess(
     bm_device_mem_t mem;
     int size_byte = 0;
     bm_image_get_byte_size(converto_img, &size_byte);
-    ret = bm_malloc_device_byte_heap(context->handle, &mem, STREAM_NPU_HEAP, size_byte);
+    ret = getInputDeviceMem(context, objectMetadatas, i, 0, size_byte, &mem);
     STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
 
     bm_image_attach(converto_img, &mem);
@@ -152,6 +155,8 @@ common::ErrorCode Yolov5PreProcess::preProcess(
     bmcv_image_convert_to(context->handle, 1, context->converto_attr,
                           &resized_img, &converto_img);
 
+    common::SingletonDeviceMemoryPool::getInstance().freeImage(context->handle,
+                                                               resized_img);
     bm_image_destroy(resized_img);
 
     bm_image_get_device_mem(
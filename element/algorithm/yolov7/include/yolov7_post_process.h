@@ -52,8 +52,6 @@ class Yolov7PostProcess : public ::sophon_stream::element::PostProcess {
   void setTpuKernelMem(std::shared_ptr<Yolov7Context> context,
                        common::ObjectMetadatas& objectMetadatas,
                        tpu_kernel& tpu_k);
-  float sigmoid(float x);
-  int argmax(float* data, int num);
   void NMS(YoloV7BoxVec& dets, float nmsConfidence);
   void postProcessCPU(std::shared_ptr<Yolov7Context> context,
                       common::ObjectMetadatas& objectMetadatas);
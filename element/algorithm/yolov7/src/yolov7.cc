@@ -217,6 +217,9 @@ common::ErrorCode Yolov7::initInternal(const std::string& json) {
 
       mFpsProfiler.config(mFpsProfilerName, 100);
     }
+    mPreLatency = registerStageLatency("pre");
+    mInferLatency = registerStageLatency("infer");
+    mPostLatency = registerStageLatency("post");
 
     // 新建context,预处理,推理和后处理对象
     mContext = std::make_shared<Yolov7Context>();
@@ -244,6 +247,7 @@ common::ErrorCode Yolov7::initInternal(const std::string& json) {
 void Yolov7::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   if (use_pre) {
+    common::ScopedLatency latency(mPreLatency);
     errorCode = mPreProcess->preProcess(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -254,6 +258,7 @@ void Yolov7::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   }
   // 推理
   if (use_infer) {
+    common::ScopedLatency latency(mInferLatency);
     errorCode = mInference->predict(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -263,8 +268,10 @@ void Yolov7::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
     }
   }
   // 后处理
-  if (use_post)
+  if (use_post) {
+    common::ScopedLatency latency(mPostLatency);
     mPostProcess->postProcess(mContext, objectMetadatas, dataPipeId);
+  }
 }
 
 common::ErrorCode Yolov7::doWork(int dataPipeId) {
@@ -9,6 +9,8 @@
 
 #include "yolov7_post_process.h"
 
+#include "algorithmApi/yolo_head.h"
+
 namespace sophon_stream {
 namespace element {
 namespace yolov7 {
@@ -79,22 +81,6 @@ Yolov7PostProcess::~Yolov7PostProcess() {
   }
 }
 
-int Yolov7PostProcess::argmax(float* data, int num) {
-  float max_value = 0.0;
-  int max_index = 0;
-  for (int i = 0; i < num; ++i) {
-    float value = data[i];
-    if (value > max_value) {
-      max_value = value;
-      max_index = i;
-    }
-  }
-
-  return max_index;
-}
-
-float Yolov7PostProcess::sigmoid(float x) { return 1.0 / (1 + expf(-x)); }
-
 void Yolov7PostProcess::NMS(YoloV7BoxVec& dets, float nmsConfidence) {
   int length = dets.size();
   int index = length - 1;
@@ -246,7 +232,8 @@ void Yolov7PostProcess::postProcessTPUKERNEL(
       temp_bbox.y = std::max(int(centerY - temp_bbox.height / 2), 0);
 
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(
+              objectMetadatas[i]->mArena);
       detData->mBox.mX = temp_bbox.x;
       detData->mBox.mY = temp_bbox.y;
       detData->mBox.mWidth = temp_bbox.width;
@@ -327,8 +314,10 @@ void Yolov7PostProcess::postProcessCPU(
     auto out_tensor = outputTensors[min_idx];
     int nout = out_tensor->get_shape()->dims[context->min_dim - 1];
 
-    float* output_data = nullptr;
-    std::vector<float> decoded_data;
+    // 每个类别的阈值与其中最小的一个，物体置信度低于最小阈值的候选框直接跳过
+    std::vector<float> thresholds =
+        yolo::classThresholds(context, context->class_num);
+    float min_thresh = yolo::minThreshold(thresholds, context->thresh_conf_min);
 
     if (context->min_dim == 3 && context->output_num != 1) {
       std::cout << "--> WARNING: the current bmodel has redundant outputs"
@@ -346,10 +335,8 @@ void Yolov7PostProcess::postProcessCPU(
       const int anchor_num = anchors[0].size();
       assert(context->output_num == (int)anchors.size());
       assert(box_num > 0);
-      if ((int)decoded_data.size() != box_num * nout) {
-        decoded_data.resize(box_num * nout);
-      }
-      float* dst = decoded_data.data();
+      // 物体置信度的sigmoid与阈值比较换成logit与换算后的阈值比较
+      float obj_logit_thresh = yolo::logit(min_thresh);
       for (int tidx = 0; tidx < context->output_num; ++tidx) {
         auto output_tensor = outputTensors[tidx];
         int feat_c = output_tensor->get_shape()->dims[1];
@@ -362,63 +349,50 @@ void Yolov7PostProcess::postProcessCPU(
 
         for (int anchor_idx = 0; anchor_idx < anchor_num; anchor_idx++) {
           float* ptr = tensor_data + anchor_idx * feature_size;
-          for (int i = 0; i < area; i++) {
-            float score = sigmoid(ptr[4]);
-            if (score >= context->thresh_conf_min) {
-              int class_id = argmax(&ptr[5], context->class_num);
-              float confidence = sigmoid(ptr[class_id + 5]);
-              float cur_class_thresh =
-                  context->class_thresh_valid
-                      ? context->thresh_conf[context->class_names[class_id]]
-                      : context->thresh_conf_min;
-              if (confidence * score >= cur_class_thresh) {
-                dst[0] = (sigmoid(ptr[0]) * 2 - 0.5 + i % feat_w) / feat_w *
-                         context->net_w;
-                dst[1] = (sigmoid(ptr[1]) * 2 - 0.5 + i / feat_w) / feat_h *
-                         context->net_h;
-                dst[2] = pow((sigmoid(ptr[2]) * 2), 2) *
-                         anchors[tidx][anchor_idx][0];
-                dst[3] = pow((sigmoid(ptr[3]) * 2), 2) *
-                         anchors[tidx][anchor_idx][1];
-                for (int d = 5; d < nout; d++) {
-                  dst[d] = sigmoid(ptr[d]);
-                }
-                float centerX = (dst[0] + 1 - tx1) / ratio - 1;
-                float centerY = (dst[1] + 1 - ty1) / ratio - 1;
-                float width = (dst[2] + 0.5) / ratio;
-                float height = (dst[3] + 0.5) / ratio;
-
-                YoloV7Box box;
-                box.x = int(centerX - width / 2);
-                if (box.x < 0) box.x = 0;
-                box.y = int(centerY - height / 2);
-                if (box.y < 0) box.y = 0;
-                box.width = width;
-                box.height = height;
-                box.class_id = class_id;
-                box.score = confidence * score;
-                yolobox_vec.push_back(box);
-              }
-            }
-            dst += nout;
-            ptr += nout;
+          for (int i = 0; i < area; i++, ptr += nout) {
+            if (ptr[4] < obj_logit_thresh) continue;
+            float score = yolo::fastSigmoid(ptr[4]);
+            // 类别的logit最大时sigmoid也最大，先在logit上取argmax
+            float confidence;
+            int class_id =
+                yolo::argmax(ptr + 5, context->class_num, &confidence);
+            confidence = yolo::fastSigmoid(confidence);
+            if (confidence * score < thresholds[class_id]) continue;
+
+            float dst[4];
+            yolo::decodeAnchorBox(
+                ptr, i, feat_w, feat_h, context->net_w, context->net_h,
+                anchors[tidx][anchor_idx][0], anchors[tidx][anchor_idx][1],
+                dst);
+            float centerX = (dst[0] + 1 - tx1) / ratio - 1;
+            float centerY = (dst[1] + 1 - ty1) / ratio - 1;
+            float width = (dst[2] + 0.5) / ratio;
+            float height = (dst[3] + 0.5) / ratio;
+
+            YoloV7Box box;
+            box.x = int(centerX - width / 2);
+            if (box.x < 0) box.x = 0;
+            box.y = int(centerY - height / 2);
+            if (box.y < 0) box.y = 0;
+            box.width = width;
+            box.height = height;
+            box.class_id = class_id;
+            box.score = confidence * score;
+            yolobox_vec.push_back(box);
           }
         }
       }
-      output_data = decoded_data.data();
     } else {
       assert(box_num == 0 || box_num == out_tensor->get_shape()->dims[1]);
       box_num = out_tensor->get_shape()->dims[1];
-      output_data = (float*)out_tensor->get_cpu_data();
+      float* output_data = (float*)out_tensor->get_cpu_data();
       for (int i = 0; i < box_num; i++) {
         float* ptr = output_data + i * nout;
         float score = ptr[4];
-        int class_id = argmax(&ptr[5], context->class_num);
-        float confidence = ptr[class_id + 5];
-        if (confidence * score >
-            (context->class_thresh_valid
-                 ? context->thresh_conf[context->class_names[class_id]]
-                 : context->thresh_conf_min)) {
+        if (score <= min_thresh) continue;
+        float confidence;
+        int class_id = yolo::argmax(ptr + 5, context->class_num, &confidence);
+        if (confidence * score > thresholds[class_id]) {
           float centerX = (ptr[0] + 1 - tx1) / ratio - 1;
           float centerY = (ptr[1] + 1 - ty1) / ratio - 1;
           float width = (ptr[2] + 0.5) / ratio;
@@ -442,7 +416,7 @@ void Yolov7PostProcess::postProcessCPU(
 
     for (auto bbox : yolobox_vec) {
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
       detData->mBox.mX = bbox.x;
       detData->mBox.mY = bbox.y;
       detData->mBox.mWidth = bbox.width;
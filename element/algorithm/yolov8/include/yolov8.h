@@ -73,6 +73,15 @@ class Yolov8 : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_WIDTH_FILED = "width";
   static constexpr const char* CONFIG_INTERNAL_HEIGHT_FILED = "height";
   static constexpr const char* CONFIG_INTERNAL_TASK_TYPE_FILED = "task_type";
+  static constexpr const char* CONFIG_INTERNAL_TILE_FIELD = "tile";
+  static constexpr const char* CONFIG_INTERNAL_OVERLAP_FIELD = "overlap";
+  static constexpr const char* CONFIG_INTERNAL_FULL_FRAME_FIELD = "full_frame";
+  static constexpr const char* CONFIG_INTERNAL_MOTION_ONLY_FIELD =
+      "motion_only";
+  static constexpr const char* CONFIG_INTERNAL_MERGE_FIELD = "merge";
+  static constexpr const char* CONFIG_INTERNAL_MATCH_FIELD = "match";
+  static constexpr const char* CONFIG_INTERNAL_MERGE_THRESHOLD_FIELD =
+      "merge_threshold";
 
   // yolov8_seg_tpu_opt
   static constexpr const char* CONFIG_INTERNAL_SEG_TPU_OPT_FILED = "seg_tpu_opt";      // yolov8_seg是否使用TPU后处理
@@ -88,11 +97,25 @@ class Yolov8 : public ::sophon_stream::framework::Element {
   bool use_infer = false;
   bool use_post = false;
 
+  // 各阶段耗时直方图，由MetricsRegistry持有
+  ::sophon_stream::common::Histogram* mPreLatency = nullptr;
+  ::sophon_stream::common::Histogram* mInferLatency = nullptr;
+  ::sophon_stream::common::Histogram* mPostLatency = nullptr;
+
   std::string mFpsProfilerName;
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
   common::ErrorCode initContext(const std::string& json);
   void process(common::ObjectMetadatas& objectMetadatas, int dataPipeId);
+  /**
+   * @brief 一帧要推理的块，结束帧与没有图像的帧为空
+   */
+  std::vector<common::Rectangle<int>> planTiles(
+      const std::shared_ptr<common::ObjectMetadata>& objectMetadata);
+  /**
+   * @brief 各帧切块后按max_batch分组推理，再把每帧各块的检测框合并写入该帧
+   */
+  void processTiles(common::ObjectMetadatas& objectMetadatas, int dataPipeId);
 };
 
 }  // namespace yolov8
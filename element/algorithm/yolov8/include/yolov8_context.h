@@ -11,6 +11,7 @@
 #define SOPHON_STREAM_ELEMENT_YOLOV8_CONTEXT_H_
 
 #include "algorithmApi/context.h"
+#include "algorithmApi/tiling.h"
 
 namespace sophon_stream {
 namespace element {
@@ -53,6 +54,7 @@ class Yolov8Context : public ::sophon_stream::element::Context {
 
   bmcv_rect_t roi;
   bool roi_predefined = false;
+  tiling::TileParams tile;  // 切块推理，配置了tile时启用，只支持Detect
   int thread_number;
 
   // yolov8_seg_tpu_opt
@@ -64,8 +64,6 @@ class Yolov8PostProcess : public ::sophon_stream::element::PostProcess {
  private:
   std::shared_ptr<Yolov8Context> global_context = nullptr;
 
-  float sigmoid(float x);
-  int argmax(float* data, int num);
   void NMS(YoloV8BoxVec& dets, float nmsConfidence);
   void postProcessDet(std::shared_ptr<Yolov8Context> context,
                       common::ObjectMetadatas& objectMetadatas);
@@ -262,6 +262,55 @@ common::ErrorCode Yolov8::initContext(const std::string& json) {
       mContext->roi.crop_h =
           roi_it->find(CONFIG_INTERNAL_HEIGHT_FILED)->get<int>();
     }
+
+    // 8. tile
+    auto tileIt = configure.find(CONFIG_INTERNAL_TILE_FIELD);
+    if (configure.end() != tileIt && tileIt->is_object()) {
+      auto& tile = mContext->tile;
+      tile.enabled = mContext->taskType == TaskType::Detect;
+      if (!tile.enabled)
+        IVS_WARN("Yolov8 tiled inference only supports Detect, ignore tile");
+      // 块默认与网络输入一样大，推理时不缩放
+      tile.tileW = mContext->net_w;
+      tile.tileH = mContext->net_h;
+      auto tileWidthIt = tileIt->find(CONFIG_INTERNAL_WIDTH_FILED);
+      if (tileIt->end() != tileWidthIt && tileWidthIt->is_number_integer())
+        tile.tileW = tileWidthIt->get<int>();
+      auto tileHeightIt = tileIt->find(CONFIG_INTERNAL_HEIGHT_FILED);
+      if (tileIt->end() != tileHeightIt && tileHeightIt->is_number_integer())
+        tile.tileH = tileHeightIt->get<int>();
+      auto overlapIt = tileIt->find(CONFIG_INTERNAL_OVERLAP_FIELD);
+      if (tileIt->end() != overlapIt && overlapIt->is_number())
+        tile.overlap = overlapIt->get<float>();
+      auto fullFrameIt = tileIt->find(CONFIG_INTERNAL_FULL_FRAME_FIELD);
+      if (tileIt->end() != fullFrameIt && fullFrameIt->is_boolean())
+        tile.fullFrame = fullFrameIt->get<bool>();
+      auto motionOnlyIt = tileIt->find(CONFIG_INTERNAL_MOTION_ONLY_FIELD);
+      if (tileIt->end() != motionOnlyIt && motionOnlyIt->is_boolean())
+        tile.motionOnly = motionOnlyIt->get<bool>();
+      auto mergeIt = tileIt->find(CONFIG_INTERNAL_MERGE_FIELD);
+      if (tileIt->end() != mergeIt && mergeIt->is_string() &&
+          !tiling::parseMergeMethod(mergeIt->get<std::string>(),
+                                    &tile.mergeMethod))
+        IVS_WARN("Unknown tile merge method: {0}, use nmm",
+                 mergeIt->get<std::string>());
+      auto matchIt = tileIt->find(CONFIG_INTERNAL_MATCH_FIELD);
+      if (tileIt->end() != matchIt && matchIt->is_string() &&
+          !tiling::parseMatchMetric(matchIt->get<std::string>(),
+                                    &tile.matchMetric))
+        IVS_WARN("Unknown tile match metric: {0}, use ios",
+                 matchIt->get<std::string>());
+      auto mergeThresholdIt =
+          tileIt->find(CONFIG_INTERNAL_MERGE_THRESHOLD_FIELD);
+      if (tileIt->end() != mergeThresholdIt && mergeThresholdIt->is_number())
+        tile.mergeThreshold = mergeThresholdIt->get<float>();
+      if (tile.enabled)
+        IVS_INFO(
+            "Yolov8 tiled inference, tile: {0}x{1}, overlap: {2}, full frame: "
+            "{3}, motion only: {4}",
+            tile.tileW, tile.tileH, tile.overlap, tile.fullFrame,
+            tile.motionOnly);
+    }
     mContext->thread_number = getThreadNumber();
   } while (false);
   return common::ErrorCode::SUCCESS;
@@ -296,6 +345,9 @@ common::ErrorCode Yolov8::initInternal(const std::string& json) {
 
       mFpsProfiler.config(mFpsProfilerName, 100);
     }
+    mPreLatency = registerStageLatency("pre");
+    mInferLatency = registerStageLatency("infer");
+    mPostLatency = registerStageLatency("post");
 
     // 新建context,预处理,推理和后处理对象
     mContext = std::make_shared<Yolov8Context>();
@@ -323,6 +375,7 @@ common::ErrorCode Yolov8::initInternal(const std::string& json) {
 void Yolov8::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   if (use_pre) {
+    common::ScopedLatency latency(mPreLatency);
     errorCode = mPreProcess->preProcess(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -333,6 +386,7 @@ void Yolov8::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   }
   // 推理
   if (use_infer) {
+    common::ScopedLatency latency(mInferLatency);
     errorCode = mInference->predict(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
@@ -342,8 +396,76 @@ void Yolov8::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
     }
   }
   // 后处理
-  if (use_post)
+  if (use_post) {
+    common::ScopedLatency latency(mPostLatency);
     mPostProcess->postProcess(mContext, objectMetadatas, dataPipeId);
+  }
+}
+
+std::vector<common::Rectangle<int>> Yolov8::planTiles(
+    const std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
+  if (objectMetadata->mFrame->mEndOfStream ||
+      objectMetadata->mFrame->mSpData == nullptr)
+    return {};
+  bmcv_rect_t area = tiling::cropRect(mContext, *objectMetadata);
+  return tiling::frameTiles(common::Rectangle<int>(area.start_x, area.start_y,
+                                                   area.crop_w, area.crop_h),
+                            objectMetadata->mMotionRegions, mContext->tile);
+}
+
+void Yolov8::processTiles(common::ObjectMetadatas& objectMetadatas,
+                          int dataPipeId) {
+  // 各帧的块依次排列，一组max_batch个块中可以有多帧的块
+  common::ObjectMetadatas tileObjs;
+  std::vector<int> owners;
+  std::vector<int> tileNums(objectMetadatas.size(), 0);
+  for (int i = 0; i < objectMetadatas.size(); ++i) {
+    auto tiles = tiling::makeTileObjectMetadatas(
+        objectMetadatas[i], planTiles(objectMetadatas[i]));
+    tileNums[i] = tiles.size();
+    tileObjs.insert(tileObjs.end(), tiles.begin(), tiles.end());
+    owners.insert(owners.end(), tiles.size(), i);
+  }
+  for (int begin = 0; begin < tileObjs.size(); begin += mContext->max_batch) {
+    int end = std::min<int>(begin + mContext->max_batch, tileObjs.size());
+    common::ObjectMetadatas batch(tileObjs.begin() + begin,
+                                  tileObjs.begin() + end);
+    process(batch, dataPipeId);
+  }
+
+  // 块的检测框已经换算到原图，同一帧各块的框跨块合并
+  std::vector<std::vector<tiling::Detection>> detections(
+      objectMetadatas.size());
+  std::vector<std::vector<std::shared_ptr<common::DetectedObjectMetadata>>>
+      detObjs(objectMetadatas.size());
+  for (int t = 0; t < tileObjs.size(); ++t) {
+    int owner = owners[t];
+    if (tileObjs[t]->mErrorCode != common::ErrorCode::SUCCESS)
+      objectMetadatas[owner]->mErrorCode = tileObjs[t]->mErrorCode;
+    for (auto& detObj : tileObjs[t]->mDetectedObjectMetadatas) {
+      const auto& box = detObj->mBox;
+      detections[owner].push_back(
+          {static_cast<float>(box.mX), static_cast<float>(box.mY),
+           static_cast<float>(box.right()), static_cast<float>(box.bottom()),
+           detObj->mScores.empty() ? 0.f : detObj->mScores[0],
+           detObj->mClassify, static_cast<int>(detObjs[owner].size())});
+      detObjs[owner].push_back(detObj);
+    }
+  }
+  for (int i = 0; i < objectMetadatas.size(); ++i) {
+    // 只有一块时块内已经做过NMS
+    auto merged = tileNums[i] > 1
+                      ? tiling::mergeDetections(detections[i], mContext->tile)
+                      : detections[i];
+    for (const auto& det : merged) {
+      auto& detObj = detObjs[i][det.source];
+      detObj->mBox.mX = det.x1;
+      detObj->mBox.mY = det.y1;
+      detObj->mBox.mWidth = det.x2 - det.x1;
+      detObj->mBox.mHeight = det.y2 - det.y1;
+      objectMetadatas[i]->mDetectedObjectMetadatas.push_back(detObj);
+    }
+  }
 }
 
 common::ErrorCode Yolov8::doWork(int dataPipeId) {
@@ -360,7 +482,10 @@ common::ErrorCode Yolov8::doWork(int dataPipeId) {
 
   common::ObjectMetadatas pendingObjectMetadatas;
 
-  while (objectMetadatas.size() < mContext->max_batch &&
+  // 切块需要前处理、推理、后处理在同一个element中，一帧占用多个batch位置
+  bool tiled = mContext->tile.enabled && use_pre && use_infer && use_post;
+  int batchSlots = 0;
+  while (batchSlots < mContext->max_batch &&
          (getThreadStatus() == ThreadStatus::RUN)) {
     // 如果队列为空则等待
     auto data = popInputData(inputPort, dataPipeId);
@@ -371,7 +496,11 @@ common::ErrorCode Yolov8::doWork(int dataPipeId) {
 
     auto objectMetadata =
         std::static_pointer_cast<common::ObjectMetadata>(data);
-    if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
+    if (!objectMetadata->mFilter) {
+      objectMetadatas.push_back(objectMetadata);
+      batchSlots +=
+          tiled ? std::max<int>(planTiles(objectMetadata).size(), 1) : 1;
+    }
 
     pendingObjectMetadatas.push_back(objectMetadata);
 
@@ -380,7 +509,10 @@ common::ErrorCode Yolov8::doWork(int dataPipeId) {
     }
   }
 
-  process(objectMetadatas, dataPipeId);
+  if (tiled)
+    processTiles(objectMetadatas, dataPipeId);
+  else
+    process(objectMetadatas, dataPipeId);
 
   for (auto& objectMetadata : pendingObjectMetadatas) {
     int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
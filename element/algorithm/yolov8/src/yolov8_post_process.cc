@@ -10,6 +10,9 @@
 
 #include "yolov8_post_process.h"
 
+#include "algorithmApi/tiling.h"
+#include "algorithmApi/yolo_head.h"
+
 namespace sophon_stream {
 namespace element {
 namespace yolov8 {
@@ -18,22 +21,6 @@ void Yolov8PostProcess::init(std::shared_ptr<Yolov8Context> context) {}
 
 Yolov8PostProcess::~Yolov8PostProcess() {}
 
-int Yolov8PostProcess::argmax(float* data, int num) {
-  float max_value = 0.0;
-  int max_index = 0;
-  for (int i = 0; i < num; ++i) {
-    float value = data[i];
-    if (value > max_value) {
-      max_value = value;
-      max_index = i;
-    }
-  }
-
-  return max_index;
-}
-
-float Yolov8PostProcess::sigmoid(float x) { return 1.0 / (1 + expf(-x)); }
-
 void Yolov8PostProcess::NMS(YoloV8BoxVec& dets, float nmsConfidence) {
   int length = dets.size();
   int index = length - 1;
@@ -147,7 +134,8 @@ void Yolov8PostProcess::postProcessCls(
              obj->mFrame->mChannelId, obj->mFrame->mFrameId, max_idx,
              max_score);
 
-    auto clsData = std::make_shared<common::RecognizedObjectMetadata>();
+    auto clsData = common::makeInArena<common::RecognizedObjectMetadata>(
+        obj->mArena);
     clsData->mScores.push_back(max_score);
     clsData->mTopKLabels.push_back(max_idx);
     obj->mRecognizedObjectMetadatas.push_back(clsData);
@@ -263,7 +251,7 @@ void Yolov8PostProcess::postProcessPose(
 
     for (auto bbox : yolobox_vec) {
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
 
       detData->mBox.mX = bbox.x1 - PATCH;
       detData->mBox.mY = bbox.y1 - PATCH;
@@ -273,7 +261,7 @@ void Yolov8PostProcess::postProcessPose(
       detData->mClassify = bbox.class_id;
 
       std::shared_ptr<common::PosedObjectMetadata> poseData =
-          std::make_shared<common::PosedObjectMetadata>();
+          common::makeInArena<common::PosedObjectMetadata>(obj->mArena);
       poseData->keypoints = bbox.kps;
 
       if (context->roi_predefined) {
@@ -307,30 +295,20 @@ void Yolov8PostProcess::postProcessDetOpt(
           obj->mOutputBMtensors->tensors[i].get(), context->bmNetwork->is_soc);
     }
     yolobox_vec.clear();
-    int frame_width = obj->mFrame->mSpData->width;
-    int frame_height = obj->mFrame->mSpData->height;
+    // 切块时为所在的块，否则为roi或整帧，框先在其中计算再加上起点
+    bmcv_rect_t crop_rect = tiling::cropRect(context, *obj);
+    int frame_width = crop_rect.crop_w;
+    int frame_height = crop_rect.crop_h;
     int tx1 = 0, ty1 = 0;
 #ifdef USE_ASPECT_RATIO
     bool isAlignWidth = false;
     float ratio =
-        context->roi_predefined
-            ? get_aspect_scaled_ratio(context->roi.crop_w, context->roi.crop_h,
-                                      context->net_w, context->net_h,
-                                      &isAlignWidth)
-            : get_aspect_scaled_ratio(frame_width, frame_height, context->net_w,
-                                      context->net_h, &isAlignWidth);
+        get_aspect_scaled_ratio(frame_width, frame_height, context->net_w,
+                                context->net_h, &isAlignWidth);
     if (isAlignWidth) {
-      ty1 = (int)((context->net_h -
-                   (int)((context->roi_predefined ? context->roi.crop_h
-                                                  : frame_height) *
-                         ratio)) /
-                  2);
+      ty1 = (int)((context->net_h - (int)(frame_height * ratio)) / 2);
     } else {
-      tx1 = (int)((context->net_w -
-                   (int)((context->roi_predefined ? context->roi.crop_w
-                                                  : frame_width) *
-                         ratio)) /
-                  2);
+      tx1 = (int)((context->net_w - (int)(frame_width * ratio)) / 2);
     }
 #endif
     int min_idx = 0;
@@ -364,22 +342,13 @@ void Yolov8PostProcess::postProcessDetOpt(
 
     // Candidates
     float* cls_conf = output_data + 4;
+    std::vector<float> thresholds = yolo::classThresholds(context, m_class_num);
     for (int i = 0; i < feat_num; i++) {
       // best class
-      float max_value = 0.0;
-      int max_index = 0;
-      for (int j = 0; j < m_class_num; j++) {
-        float cur_value = cls_conf[i * nout + j];
-        if (cur_value > max_value) {
-          max_value = cur_value;
-          max_index = j;
-        }
-      }
-      float cur_class_thresh =
-          context->class_thresh_valid
-              ? context->thresh_conf[context->class_names[max_index]]
-              : context->thresh_conf_min;
-      if (max_value >= cur_class_thresh) {
+      float max_value;
+      int max_index =
+          yolo::argmax(cls_conf + i * nout, m_class_num, &max_value);
+      if (max_value >= thresholds[max_index]) {
         YoloV8Box box;
         box.score = max_value;
         box.class_id = max_index;
@@ -421,7 +390,7 @@ void Yolov8PostProcess::postProcessDetOpt(
       float height = (yolobox_vec[i].y2 - yolobox_vec[i].y1) / ratio;
 
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
       detData->mBox.mX = std::max(int(centerx - width / 2), 0);
       detData->mBox.mY = std::max(int(centery - height / 2), 0);
       detData->mBox.mWidth = width;
@@ -429,10 +398,8 @@ void Yolov8PostProcess::postProcessDetOpt(
       detData->mScores.push_back(yolobox_vec[i].score);
       detData->mClassify = yolobox_vec[i].class_id;
 
-      if (context->roi_predefined) {
-        detData->mBox.mX += context->roi.start_x;
-        detData->mBox.mY += context->roi.start_y;
-      }
+      detData->mBox.mX += crop_rect.start_x;
+      detData->mBox.mY += crop_rect.start_y;
 
       // check the range of box
       if (detData->mBox.mX + detData->mBox.mWidth >=
@@ -460,6 +427,9 @@ void Yolov8PostProcess::postProcessDet(
     common::ObjectMetadatas& objectMetadatas) {
   // Yolov8 vec
   YoloV8BoxVec yolobox_vec;
+  // 每个候选框的最大类别分数与类别，各帧复用
+  std::vector<float> max_values;
+  std::vector<int> max_indices;
 
   int idx = 0;
   for (auto obj : objectMetadatas) {
@@ -474,30 +444,20 @@ void Yolov8PostProcess::postProcessDet(
     }
 
     yolobox_vec.clear();
-    int frame_width = obj->mFrame->mSpData->width;
-    int frame_height = obj->mFrame->mSpData->height;
+    // 切块时为所在的块，否则为roi或整帧，框先在其中计算再加上起点
+    bmcv_rect_t crop_rect = tiling::cropRect(context, *obj);
+    int frame_width = crop_rect.crop_w;
+    int frame_height = crop_rect.crop_h;
     int tx1 = 0, ty1 = 0;
 #ifdef USE_ASPECT_RATIO
     bool isAlignWidth = false;
     float ratio =
-        context->roi_predefined
-            ? get_aspect_scaled_ratio(context->roi.crop_w, context->roi.crop_h,
-                                      context->net_w, context->net_h,
-                                      &isAlignWidth)
-            : get_aspect_scaled_ratio(frame_width, frame_height, context->net_w,
-                                      context->net_h, &isAlignWidth);
+        get_aspect_scaled_ratio(frame_width, frame_height, context->net_w,
+                                context->net_h, &isAlignWidth);
     if (isAlignWidth) {
-      ty1 = (int)((context->net_h -
-                   (int)((context->roi_predefined ? context->roi.crop_h
-                                                  : frame_height) *
-                         ratio)) /
-                  2);
+      ty1 = (int)((context->net_h - (int)(frame_height * ratio)) / 2);
     } else {
-      tx1 = (int)((context->net_w -
-                   (int)((context->roi_predefined ? context->roi.crop_w
-                                                  : frame_width) *
-                         ratio)) /
-                  2);
+      tx1 = (int)((context->net_w - (int)(frame_width * ratio)) / 2);
     }
 #endif
     int min_idx = 0;
@@ -541,24 +501,17 @@ void Yolov8PostProcess::postProcessDet(
     output_data =
         (float*)out_tensor->get_cpu_data();  // 如果只有一张图片不要需修改
     float* cls_conf = output_data + 4 * feature_num;
+    // 分数按类别存放，一次求出所有候选框的最大类别
+    yolo::argmaxColumns(cls_conf, m_class_num, feature_num, max_values,
+                        max_indices);
+    std::vector<float> thresholds = yolo::classThresholds(context, m_class_num);
+    float min_thresh = yolo::minThreshold(thresholds, context->thresh_conf_min);
     for (int i = 0; i < feature_num; i++) {
       // best class
-      float max_value = 0.0;
-      int max_index = 0;
-      for (int j = 0; j < m_class_num; j++) {
-        float cur_value = cls_conf[i + j * feature_num];
-        if (cur_value > max_value) {
-          max_value = cur_value;
-          max_index = j;
-        }
-      }
-
-      float cur_class_thresh =
-          context->class_thresh_valid
-              ? context->thresh_conf[context->class_names[max_index]]
-              : context->thresh_conf_min;
-
-      if (max_value >= cur_class_thresh) {
+      float max_value = max_values[i];
+      if (max_value < min_thresh) continue;
+      int max_index = max_indices[i];
+      if (max_value >= thresholds[max_index]) {
         YoloV8Box box;
         box.score = max_value;
         box.class_id = max_index;
@@ -608,7 +561,7 @@ void Yolov8PostProcess::postProcessDet(
 
     for (auto bbox : yolobox_vec) {
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
       detData->mBox.mX = std::max(int(bbox.x1), 0);
       detData->mBox.mY = std::max(int(bbox.y1), 0);
       detData->mBox.mWidth = bbox.x2 - bbox.x1;
@@ -616,10 +569,8 @@ void Yolov8PostProcess::postProcessDet(
       detData->mScores.push_back(bbox.score);
       detData->mClassify = bbox.class_id;
 
-      if (context->roi_predefined) {
-        detData->mBox.mX += context->roi.start_x;
-        detData->mBox.mY += context->roi.start_y;
-      }
+      detData->mBox.mX += crop_rect.start_x;
+      detData->mBox.mY += crop_rect.start_y;
       // check the range of box
       if (detData->mBox.mX + detData->mBox.mWidth >=
           obj->mFrame->mSpData->width) {
@@ -645,6 +596,8 @@ void Yolov8PostProcess::postProcessSeg(
     common::ObjectMetadatas& objectMetadatas) {
   // YoloV8BoxVec
   YoloV8BoxVec yolobox_vec;
+  std::vector<float> max_values;
+  std::vector<int> max_indices;
   int idx = 0;
 
   for (auto obj : objectMetadatas) {
@@ -737,25 +690,18 @@ void Yolov8PostProcess::postProcessSeg(
     // post2:  get detections matrix nx6 (xyxy, score, class_id, mask)
     float* cls_conf = detection_data + 4 * feat_num;
 
+    // 分数按类别存放，一次求出所有候选框的最大类别
+    yolo::argmaxColumns(cls_conf, m_class_num, feat_num, max_values,
+                        max_indices);
+    std::vector<float> thresholds = yolo::classThresholds(context, m_class_num);
+    float min_thresh = yolo::minThreshold(thresholds, context->thresh_conf_min);
     for (int i = 0; i < feat_num; i++) {
       // best class
-      float max_value = 0.0;
-      int max_index = 0;
-
-      for (int j = 0; j < m_class_num; j++) {
-        float cur_value = cls_conf[i + j * feat_num];
-        if (cur_value > max_value) {
-          max_value = cur_value;
-          max_index = j;
-        }
-      }
+      float max_value = max_values[i];
+      if (max_value < min_thresh) continue;
+      int max_index = max_indices[i];
 
-      float cur_class_thresh =
-          context->class_thresh_valid
-              ? context->thresh_conf[context->class_names[max_index]]
-              : context->thresh_conf_min;
-
-      if (max_value >= cur_class_thresh) {
+      if (max_value >= thresholds[max_index]) {
         YoloV8Box box;
         box.score = max_value;
         box.class_id = max_index;
@@ -891,7 +837,7 @@ void Yolov8PostProcess::postProcessSeg(
     // 5. get final results
     for (auto bbox : yolobox_vec_final) {
       std::shared_ptr<common::SegmentedObjectMetadata> segData =
-          std::make_shared<common::SegmentedObjectMetadata>();
+          common::makeInArena<common::SegmentedObjectMetadata>(obj->mArena);
 
       segData->mBox.mX = std::max(int(bbox.x1), 0);
       segData->mBox.mY = std::max(int(bbox.y1), 0);
@@ -1130,15 +1076,12 @@ void Yolov8PostProcess::postProcessObb(
 
     // Candidates
     float* cls_conf = output_data + 4; //output_tensor's last dim: [x, y, w, h, cls_conf0, ..., cls_conf14, rotate_angle]
+    std::vector<float> thresholds = yolo::classThresholds(context, m_class_num);
     for (int i = 0; i < box_num; i++) {
       // multilabel
       for (int j = 0; j < m_class_num; j++) {
         float cur_conf = cls_conf[i * nout + j];
-        float cur_class_thresh =
-          context->class_thresh_valid
-              ? context->thresh_conf[context->class_names[j]]
-              : context->thresh_conf_min;
-        if (cur_conf > cur_class_thresh) {
+        if (cur_conf > thresholds[j]) {
           obbBox box;
           box.score = cur_conf;
           box.class_id = j;
@@ -1174,7 +1117,8 @@ void Yolov8PostProcess::postProcessObb(
 
     for (auto bbox : yolobox_vec) {
       std::shared_ptr<common::ObbObjectMetadata> obbData =
-          std::make_shared<common::ObbObjectMetadata>(xywhr2xyxyxyxy(bbox));
+          common::makeInArena<common::ObbObjectMetadata>(
+              obj->mArena, xywhr2xyxyxyxy(bbox));
 
       if (context->roi_predefined) {
         obbData->add_offset(context->roi.start_x, context->roi.start_y);
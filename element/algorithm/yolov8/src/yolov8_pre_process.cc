@@ -64,14 +64,12 @@ common::ErrorCode Yolov8PreProcess::preProcess(
       image_aligned = image1;
     }
     // #ifdef USE_ASPECT_RATIO
+    // 切块时为所在的块，否则为roi或整帧
+    bmcv_rect_t crop_rect = tiling::cropRect(context, *objMetadata);
     bool isAlignWidth = false;
-    float ratio = context->roi_predefined
-                      ? get_aspect_scaled_ratio(
-                            context->roi.crop_w, context->roi.crop_h,
-                            context->net_w, context->net_h, &isAlignWidth)
-                      : get_aspect_scaled_ratio(image0.width, image0.height,
-                                                context->net_w, context->net_h,
-                                                &isAlignWidth);
+    float ratio =
+        get_aspect_scaled_ratio(crop_rect.crop_w, crop_rect.crop_h,
+                                context->net_w, context->net_h, &isAlignWidth);
     bmcv_padding_atrr_t padding_attr;
     memset(&padding_attr, 0, sizeof(padding_attr));
     padding_attr.dst_crop_sty = 0;
@@ -81,9 +79,7 @@ common::ErrorCode Yolov8PreProcess::preProcess(
     padding_attr.padding_r = 114;
     padding_attr.if_memset = 1;
     if (isAlignWidth) {
-      padding_attr.dst_crop_h = context->roi_predefined
-                                    ? (context->roi.crop_h * ratio)
-                                    : (image0.height * ratio);
+      padding_attr.dst_crop_h = crop_rect.crop_h * ratio;
       padding_attr.dst_crop_w = context->net_w;
 
       int ty1 = (int)((context->net_h - padding_attr.dst_crop_h) / 2);
@@ -91,9 +87,7 @@ common::ErrorCode Yolov8PreProcess::preProcess(
       padding_attr.dst_crop_stx = 0;
     } else {
       padding_attr.dst_crop_h = context->net_h;
-      padding_attr.dst_crop_w = context->roi_predefined
-                                    ? (context->roi.crop_w * ratio)
-                                    : (image0.width * ratio);
+      padding_attr.dst_crop_w = crop_rect.crop_w * ratio;
 
       int tx1 = (int)((context->net_w - padding_attr.dst_crop_w) / 2);
       padding_attr.dst_crop_sty = 0;
@@ -106,7 +100,6 @@ common::ErrorCode Yolov8PreProcess::preProcess(
                     jsonPlanner, DATA_TYPE_EXT_1N_BYTE, &resized_img, strides);
     auto ret = bm_image_alloc_dev_mem_heap_mask(resized_img, STREAM_VPP_HEAP_MASK);
     STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
-    bmcv_rect_t crop_rect{0, 0, image1.width, image1.height};
     if (context->roi_predefined) {
       if (context->roi.start_x > image1.width ||
           context->roi.start_y > image1.height ||
@@ -115,14 +108,10 @@ common::ErrorCode Yolov8PreProcess::preProcess(
         IVS_CRITICAL("ROI AREA OUT OF RANGE");
         abort();
       }
-      ret = bmcv_image_vpp_convert_padding(context->bmContext->handle(), 1,
-                                           image_aligned, &resized_img,
-                                           &padding_attr, &context->roi);
-    } else {
-      ret = bmcv_image_vpp_convert_padding(context->bmContext->handle(), 1,
-                                           image_aligned, &resized_img,
-                                           &padding_attr, &crop_rect);
     }
+    ret = bmcv_image_vpp_convert_padding(context->bmContext->handle(), 1,
+                                         image_aligned, &resized_img,
+                                         &padding_attr, &crop_rect);
     STREAM_CHECK(ret == 0, "Vpp Convert Padding Failed! Program Terminated.")
 
     if (image0.image_format != FORMAT_BGR_PLANAR) {
@@ -142,7 +131,7 @@ common::ErrorCode Yolov8PreProcess::preProcess(
     bm_device_mem_t mem;
     int size_byte = 0;
     bm_image_get_byte_size(converto_img, &size_byte);
-    ret = bm_malloc_device_byte_heap(context->handle, &mem, STREAM_NPU_HEAP, size_byte);
+    ret = getInputDeviceMem(context, objectMetadatas, i, 0, size_byte, &mem);
     STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
     bm_image_attach(converto_img, &mem);
 
@@ -39,8 +39,6 @@ class YoloxPostProcess : public ::sophon_stream::element::PostProcess {
   ~YoloxPostProcess() override;
 
  private:
-  float sigmoid(float x);
-  int argmax(float* data, int num);
   float box_iou(const YoloxBox& a, const YoloxBox& b);
 
   void nms_sorted_bboxes(const std::vector<YoloxBox>& objects,
@@ -9,6 +9,8 @@
 
 #include "yolox_post_process.h"
 
+#include "algorithmApi/yolo_head.h"
+
 namespace sophon_stream {
 namespace element {
 namespace yolox {
@@ -42,21 +44,6 @@ void YoloxPostProcess::init(std::shared_ptr<YoloxContext> context) {
   }
 }
 
-int YoloxPostProcess::argmax(float* data, int num) {
-  float max_value = 0.0;
-  int max_index = 0;
-  for (int i = 0; i < num; ++i) {
-    float value = data[i];
-    if (value > max_value) {
-      max_value = value;
-      max_index = i;
-    }
-  }
-  return max_index;
-}
-
-float YoloxPostProcess::sigmoid(float x) { return 1.0 / (1 + expf(-x)); }
-
 float YoloxPostProcess::box_iou(const YoloxBox& a, const YoloxBox& b) {
   float x = std::min(a.right, b.right) - std::max(a.left, b.left);
   float y = std::min(a.bottom, b.bottom) - std::max(a.top, b.top);
@@ -123,23 +110,27 @@ void YoloxPostProcess::postProcess(std::shared_ptr<YoloxContext> context,
     YoloxBoxVec yolobox_vec;
     int numDim3 = context->class_num + 5;
 
+    std::vector<float> thresholds =
+        yolo::classThresholds(context, context->class_num);
+    float min_thresh = yolo::minThreshold(thresholds, context->thresh_conf_min);
+
     for (size_t i = 0; i < m_box_num; ++i) {
-      // 取出物体置信度
-      float box_objectness = tensor[i * numDim3 + 4];
-      if (box_objectness < context->thresh_conf_min) continue;
-      int max_class_idx = argmax(&tensor[i * numDim3 + 5], context->class_num);
-      float box_prob = box_objectness * tensor[i * numDim3 + 5 + max_class_idx];
-      float cur_class_thresh =
-          context->class_thresh_valid
-              ? context->thresh_conf[context->class_names[max_class_idx]]
-              : context->thresh_conf_min;
-      if (box_prob > cur_class_thresh) {
-        float center_x =
-            (tensor[i * numDim3 + 0] + m_grids_x[i]) * m_expanded_strides[i];
-        float center_y =
-            (tensor[i * numDim3 + 1] + m_grids_y[i]) * m_expanded_strides[i];
-        float w_temp = exp(tensor[i * numDim3 + 2]) * m_expanded_strides[i];
-        float h_temp = exp(tensor[i * numDim3 + 3]) * m_expanded_strides[i];
+      const float* ptr = tensor + i * numDim3;
+      // 取出物体置信度，低于所有类别的阈值时不再看类别
+      float box_objectness = ptr[4];
+      if (box_objectness < min_thresh) continue;
+      float max_class_prob;
+      int max_class_idx =
+          yolo::argmax(ptr + 5, context->class_num, &max_class_prob);
+      float box_prob = box_objectness * max_class_prob;
+      if (box_prob > thresholds[max_class_idx]) {
+        float decoded[4];
+        yolo::decodeGridBox(ptr, m_grids_x[i], m_grids_y[i],
+                            m_expanded_strides[i], decoded);
+        float center_x = decoded[0];
+        float center_y = decoded[1];
+        float w_temp = decoded[2];
+        float h_temp = decoded[3];
 
         center_x *= scale;
         center_y *= scale;
@@ -177,7 +168,7 @@ void YoloxPostProcess::postProcess(std::shared_ptr<YoloxContext> context,
     for (size_t i = 0; i < picked.size(); i++) {
       auto bbox = yolobox_vec[picked[i]];
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
       detData->mBox.mX = bbox.left;
       detData->mBox.mY = bbox.top;
       detData->mBox.mWidth = bbox.width;
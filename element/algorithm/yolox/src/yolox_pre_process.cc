@@ -143,7 +143,7 @@ common::ErrorCode YoloxPreProcess::preProcess(
       bm_device_mem_t mem;
       int size_byte = 0;
       bm_image_get_byte_size(converto_img, &size_byte);
-      ret = bm_malloc_device_byte(context->handle, &mem, size_byte);
+      ret = getInputDeviceMem(context, objectMetadatas, i, 0, size_byte, &mem);
       STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
       bm_image_attach(converto_img, &mem);
 
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 
+#include "bmcv_api_ext.h"
 #include "common/error_code.h"
 
 namespace sophon_stream {
@@ -40,6 +41,10 @@ struct ChannelOperateRequest {
   std::string json;
   double fps;
   int sampleInterval;
+  /**
+   * @brief 每detectInterval帧检测一次，其余帧由跟踪器预测目标框
+   */
+  int detectInterval = 1;
   int base64Port;
   std::vector<int> skip_element;
   SampleStrategy sampleStrategy;
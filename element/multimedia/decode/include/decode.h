@@ -13,6 +13,8 @@
 #include <dlfcn.h>
 #include <sys/prctl.h>
 
+#include "common/metrics.h"
+#include "decode_scheduler.h"
 #include "decoder.h"
 #include "element_factory.h"
 
@@ -129,7 +131,10 @@ struct ChannelInfo {
   std::shared_ptr<Decoder> mSpDecoder;
   std::shared_ptr<std::mutex> mMtx;
   std::shared_ptr<std::condition_variable> mCv;
+  // 由DecodeScheduler调度时为nullptr
   std::shared_ptr<ThreadWrapper> mThreadWrapper;
+  // DROP策略下抽帧丢弃的帧数，通道启动时取得
+  common::Counter* mSampleDropped = nullptr;
 };
 
 class Decode : public ::sophon_stream::framework::Element {
@@ -152,11 +157,14 @@ class Decode : public ::sophon_stream::framework::Element {
   static constexpr const char* JSON_BASE64_PORT = "base64_port";
   static constexpr const char* JSON_SKIP_ELEMENT = "skip_element";
   static constexpr const char* JSON_SAMPLE_STRATEGY = "sample_strategy";
+  static constexpr const char* JSON_DETECT_INTERVAL = "detect_interval";
   static constexpr const char* JSON_ROI_FILED = "roi";
   static constexpr const char* JSON_LEFT_FILED = "left";
   static constexpr const char* JSON_TOP_FILED = "top";
   static constexpr const char* JSON_WIDTH_FILED = "width";
   static constexpr const char* JSON_HEIGHT_FILED = "height";
+  static constexpr const char* JSON_SCHEDULER_WORKER_NUM_FILED =
+      "scheduler_worker_num";
 
  private:
   std::map<int, std::shared_ptr<ChannelInfo>> mThreadsPool;
@@ -180,6 +188,32 @@ class Decode : public ::sophon_stream::framework::Element {
   common::ErrorCode process(const std::shared_ptr<ChannelTask>& channelTask,
                             const std::shared_ptr<ChannelInfo>& channelInfo);
 
+  /**
+   * @brief 判断该路是否交给mScheduler调度
+   * @brief CAMERA需要多路同步取帧，BASE64会阻塞等待数据，仍然使用独立线程
+   */
+  bool isScheduled(const ChannelOperateRequest& request) const;
+
+  common::ErrorCode initThreadTask(
+      const std::shared_ptr<ChannelTask>& channelTask,
+      const std::shared_ptr<ChannelInfo>& channelInfo);
+
+  common::ErrorCode initScheduledTask(
+      const std::shared_ptr<ChannelTask>& channelTask,
+      const std::shared_ptr<ChannelInfo>& channelInfo);
+
+  /**
+   * @brief 停止所有码流，调度器上的码流在释放mThreadsPoolMtx后移除，
+   * 避免与正在执行的process()互相等待
+   */
+  void stopAllTasks();
+
+  /**
+   * @brief 调度器工作线程数量，为0时每一路使用一个独立线程
+   */
+  int mSchedulerWorkerNum = 0;
+  std::shared_ptr<DecodeScheduler> mScheduler;
+
   common::ErrorCode parse_channel_task(
       std::shared_ptr<ChannelTask>& channelTask);
 
@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_DECODE_SCHEDULER_H_
+#define SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_DECODE_SCHEDULER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/error_code.h"
+#include "common/logger.h"
+#include "common/no_copyable.h"
+
+namespace sophon_stream {
+namespace element {
+namespace decode {
+
+/**
+ * @brief 多路解码调度器
+ * 使用少量工作线程轮流驱动多路码流的demux/decode，替代每一路一个线程的模式。
+ * 帧率控制通过时间轮定时唤醒实现，断流重连按指数退避重新调度。
+ */
+class DecodeScheduler : public ::sophon_stream::common::NoCopyable {
+ public:
+  /**
+   * @brief 单次调度的执行结果
+   * CONTINUE: 成功取到一帧，按帧间隔继续调度
+   * RETRY: 取帧失败（如正在重连），按退避时间重新调度
+   * FINISH: 码流结束，不再调度
+   */
+  enum class StepResult {
+    CONTINUE,
+    RETRY,
+    FINISH,
+  };
+
+  using StepHandler = std::function<StepResult(void)>;
+
+  DecodeScheduler();
+  ~DecodeScheduler();
+
+  /**
+   * @brief 启动时间轮线程和工作线程
+   * @param[in] workerNum : 工作线程数量
+   */
+  common::ErrorCode start(int workerNum);
+
+  common::ErrorCode stop();
+
+  /**
+   * @brief 添加一路码流，立即进入就绪队列
+   * @param[in] intervalMs : 帧间隔，<=0 表示不控制帧率
+   * @param[in] handler : 每次被调度时执行，取一帧并推送到下游
+   */
+  common::ErrorCode addChannel(int channelId, double intervalMs,
+                               StepHandler handler);
+
+  /**
+   * @brief 移除一路码流，如果该路正在执行，会等待本次执行结束
+   * @brief 不能在该路自身的StepHandler中调用
+   */
+  common::ErrorCode removeChannel(int channelId);
+
+  common::ErrorCode pauseChannel(int channelId);
+
+  common::ErrorCode resumeChannel(int channelId);
+
+  static constexpr int TICK_MS = 2;
+  static constexpr int WHEEL_SIZE = 512;
+  static constexpr int BACKOFF_MIN_MS = 100;
+  static constexpr int BACKOFF_MAX_MS = 10000;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  enum class ChannelState {
+    WAITING,
+    READY,
+    RUNNING,
+    PAUSED,
+  };
+
+  struct ScheduledChannel {
+    int mChannelId;
+    StepHandler mHandler;
+    double mIntervalMs;
+    int mBackoffMs = 0;
+    ChannelState mState = ChannelState::READY;
+    bool mPauseRequested = false;
+    bool mRemoved = false;
+    // 每次重新挂入时间轮时递增，用于识别时间轮中已失效的定时项
+    std::uint64_t mArmId = 0;
+    Clock::time_point mNextDue;
+  };
+
+  struct WheelEntry {
+    std::shared_ptr<ScheduledChannel> mChannel;
+    std::uint64_t mArmId;
+    std::uint64_t mRounds;
+  };
+
+  void timerRun();
+  void workerRun();
+
+  /**
+   * @brief 将channel挂入时间轮，delayMs <= 0 时直接进入就绪队列
+   * @brief 调用者需持有mMutex
+   */
+  void arm(const std::shared_ptr<ScheduledChannel>& channel, double delayMs);
+  void makeReady(const std::shared_ptr<ScheduledChannel>& channel);
+
+  std::mutex mMutex;
+  std::condition_variable mReadyCv;
+  std::condition_variable mIdleCv;
+
+  std::map<int, std::shared_ptr<ScheduledChannel>> mChannels;
+  std::deque<std::shared_ptr<ScheduledChannel>> mReadyQueue;
+
+  std::vector<std::list<WheelEntry>> mWheel;
+  std::uint64_t mCurrentTick = 0;
+
+  std::atomic<bool> mRunning;
+  std::shared_ptr<std::thread> mTimerThread;
+  std::vector<std::shared_ptr<std::thread>> mWorkers;
+};
+
+}  // namespace decode
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_DECODE_SCHEDULER_H_
@@ -19,7 +19,12 @@
 
 #include "channel.h"
 #include "common/no_copyable.h"
+#ifdef STREAM_HOST_BACKEND
+// 主机CPU后端没有sophon-ffmpeg，用OpenCV解码
+#include "host_decode.h"
+#else
 #include "ff_decode.h"
+#endif
 #include "http_base64_mgr.h"
 
 namespace sophon_stream {
@@ -37,6 +42,16 @@ class Decoder : public ::sophon_stream::common::NoCopyable {
       std::shared_ptr<common::ObjectMetadata>& objectMetadata);
   void uninit();
 
+  /**
+   * @brief 由外部调度器控制帧率和重连间隔，process()不再阻塞等待
+   */
+  void setExternalPacing(bool enable);
+
+  /**
+   * @brief 帧间隔(ms)，不控制帧率时返回0
+   */
+  double getFrameInterval() const;
+
  private:
   bm_handle_t m_handle;
   VideoDecFFM decoder;
@@ -44,6 +59,8 @@ class Decoder : public ::sophon_stream::common::NoCopyable {
   std::string mUrl;
   int mDeviceId;
   int mGraphId;
+  // 本路的ObjectMetadata、Frame与子metadata从该池分配
+  std::shared_ptr<common::MetadataPool> mMetadataPool;
   int mLoopNum;
   int mImgIndex;
   int mFrameCount;
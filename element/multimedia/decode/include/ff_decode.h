@@ -37,6 +37,8 @@ extern "C" {
 #define EXTRA_FRAME_BUFFER_NUM 2
 #define USEING_MEM_HEAP2 4
 #define USEING_MEM_HEAP1 2
+#define RECONNECT_BACKOFF_MIN_MS 100
+#define RECONNECT_BACKOFF_MAX_MS 10000
 
 static const int DISCONNECTED_ERROR_CODE = -22;
 
@@ -106,8 +108,26 @@ class VideoDecFFM {
   /* set fps */
   void setFps(int f);
 
+  /* frame interval in ms, 0 if fps is not controlled */
+  double getFrameInterval() const;
+
+  /* when enabled, grab() and picDec() do not sleep for fps control and a
+   * broken stream is reconnected once per grab() instead of blocking until
+   * success. Used when the caller schedules grabs by itself. */
+  void setExternalPacing(bool enable);
+
+  /* true if the last grab() failed to reconnect a broken stream */
+  bool isReconnecting() const;
+
  private:
   bool quit_flag = false;
+  bool external_pacing = false;
+  bool reconnecting = false;
+
+  /* per-decoder copies of the thread_local decode flags, restored before
+   * converting a frame because grab() may run on different threads */
+  bool dec_hardware_decode = true;
+  bool dec_data_on_device_mem = true;
 
   int is_rtsp;
   int is_rtmp;
@@ -152,6 +172,9 @@ class VideoDecFFM {
 
   void reConnectVideoStream();
 
+  /* close and reopen the stream, then try to grab one frame */
+  AVFrame* reopenAndGrab(int& eof);
+
   AVFrame* flushDecoder();
 
   AVFrame* grabFrame(int& eof);
@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_HOST_DECODE_H_
+#define SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_HOST_DECODE_H_
+
+#include <sys/time.h>
+
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+
+#include "channel.h"
+#include "common/object_metadata.h"
+
+#define USEING_MEM_HEAP2 4
+#define USEING_MEM_HEAP1 2
+
+using sampleStrategy =
+    ::sophon_stream::element::decode::ChannelOperateRequest::SampleStrategy;
+
+/**
+ * @brief 主机CPU后端(TARGET_ARCH=host)的解码，接口与ff_decode.h中的VideoDecFFM相同。
+ * 视频文件、rtsp/rtmp与摄像头用OpenCV的VideoCapture解码，图片用imread，
+ * 解码结果转为YUV420P写入主机内存中的bm_image，与硬件解码输出的格式一致，
+ * 后面的element可以走融合前处理。不支持gb28181
+ */
+class VideoDecFFM {
+ public:
+  VideoDecFFM();
+  ~VideoDecFFM();
+
+  /* open video decoder */
+  int openDec(bm_handle_t* dec_handle, const char* input);
+
+  /* grab a frame and convert it to a YUV420P bm_image */
+  std::shared_ptr<bm_image> grab(int& frame_id, int& eof, int64_t& pts,
+                                 int sampleInterval, sampleStrategy strategy);
+
+  /* get frame count */
+  void mFrameCount(const char* video_file, int& mFrameCount);
+
+  /* close video decoder */
+  void closeDec();
+
+  /* pic dec */
+  std::shared_ptr<bm_image> picDec(bm_handle_t& handle, const char* path);
+
+  /* set fps */
+  void setFps(int f);
+
+  /* frame interval in ms, 0 if fps is not controlled */
+  double getFrameInterval() const;
+
+  /* see ff_decode.h */
+  void setExternalPacing(bool enable);
+
+  /* true if the last grab() failed to reconnect a broken stream */
+  bool isReconnecting() const;
+
+ private:
+  void paceFrame();
+
+  bool external_pacing = false;
+  bool reconnecting = false;
+  bool is_stream = false;
+
+  int frame_id = 0;
+  double fps = -1;
+  double frame_interval_time = 0;  // ms
+  struct timeval last_time;
+
+  bm_handle_t* handle = nullptr;
+  std::string inputUrl;
+  cv::VideoCapture capture;
+  cv::Mat bgr;
+};
+
+/**
+ * @brief BGR图像转为主机内存中YUV420P的bm_image，宽高向下取偶数
+ */
+std::shared_ptr<bm_image> bgrToBmImage(bm_handle_t& handle, const cv::Mat& bgr);
+
+#endif  // SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_HOST_DECODE_H_
@@ -9,6 +9,10 @@
 
 #include "decode.h"
 
+#include <algorithm>
+
+#include "common/keyframe_scheduler.h"
+
 namespace sophon_stream {
 namespace element {
 namespace decode {
@@ -19,14 +23,32 @@ std::unordered_map<int, std::atomic<int>> Decode::mChannelCountMap;
 std::unordered_map<int, std::queue<int>> Decode::mChannelIdInternalReleasedMap;
 
 Decode::~Decode() {
-  std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
-  for (auto& channelInfo : mThreadsPool) {
-    channelInfo.second->mThreadWrapper->stop();
-  }
-  mThreadsPool.clear();
+  stopAllTasks();
+  if (mScheduler) mScheduler->stop();
   bm_dev_free(handle_);
 }
 
+void Decode::stopAllTasks() {
+  std::vector<std::pair<int, std::shared_ptr<ChannelInfo>>> scheduledChannels;
+  {
+    std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
+    for (auto& channelInfo : mThreadsPool) {
+      if (channelInfo.second->mThreadWrapper) {
+        channelInfo.second->mThreadWrapper->stop();
+        channelInfo.second->mSpDecoder->uninit();
+        channelInfo.second->mThreadWrapper.reset();
+      } else {
+        scheduledChannels.push_back(channelInfo);
+      }
+    }
+    mThreadsPool.clear();
+  }
+  for (auto& channelInfo : scheduledChannels) {
+    mScheduler->removeChannel(channelInfo.first);
+    channelInfo.second->mSpDecoder->uninit();
+  }
+}
+
 common::ErrorCode Decode::initInternal(const std::string& json) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   do {
@@ -39,6 +61,15 @@ common::ErrorCode Decode::initInternal(const std::string& json) {
     mFpsProfiler.config("fps_decode", 100);
     int dev_id = getDeviceId();
     bm_dev_request(&handle_, dev_id);
+
+    auto workerNumIt = configure.find(JSON_SCHEDULER_WORKER_NUM_FILED);
+    if (configure.end() != workerNumIt && workerNumIt->is_number_integer()) {
+      mSchedulerWorkerNum = workerNumIt->get<int>();
+    }
+    if (mSchedulerWorkerNum > 0) {
+      mScheduler = std::make_shared<DecodeScheduler>();
+      errorCode = mScheduler->start(mSchedulerWorkerNum);
+    }
   } while (false);
 
   return errorCode;
@@ -48,13 +79,7 @@ void Decode::onStart() { IVS_INFO("Decode start..."); }
 
 void Decode::onStop() {
   IVS_INFO("Decode stop...");
-  std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
-  for (auto& channelInfo : mThreadsPool) {
-    channelInfo.second->mThreadWrapper->stop();
-    channelInfo.second->mSpDecoder->uninit();
-    channelInfo.second->mThreadWrapper.reset();
-  }
-  mThreadsPool.clear();
+  stopAllTasks();
 }
 
 common::ErrorCode Decode::doWork(int dataPipeId) {
@@ -237,6 +262,14 @@ common::ErrorCode Decode::parse_channel_task(
       channelTask->request.sampleInterval = sampleIntervalIt->get<int>();
     }
 
+    channelTask->request.detectInterval = 1;
+    auto detectIntervalIt = configure.find(JSON_DETECT_INTERVAL);
+    if (configure.end() != detectIntervalIt &&
+        detectIntervalIt->is_number_integer()) {
+      channelTask->request.detectInterval =
+          std::max(detectIntervalIt->get<int>(), 1);
+    }
+
     channelTask->request.sampleStrategy =
         ChannelOperateRequest::SampleStrategy::DROP;
     auto strategyIt = configure.find(JSON_SAMPLE_STRATEGY);
@@ -297,66 +330,20 @@ common::ErrorCode Decode::startTask(std::shared_ptr<ChannelTask>& channelTask) {
     return common::ErrorCode::SUCCESS;
   }
 
+  // 新的通道从关键帧开始
+  common::SingletonKeyframeScheduler::getInstance().removeChannel(
+      channelTask->request.graphId, channelTask->request.channelId);
   std::shared_ptr<ChannelInfo> channelInfo = std::make_shared<ChannelInfo>();
-
-  channelInfo->mThreadWrapper = std::make_shared<ThreadWrapper>();
-  channelInfo->mMtx = std::make_shared<std::mutex>();
-  channelInfo->mCv = std::make_shared<std::condition_variable>();
-  channelInfo->mThreadWrapper->init(
-      [this, channelInfo, channelTask]() -> common::ErrorCode {
-        prctl(PR_SET_NAME,
-              std::to_string(channelTask->request.channelId).c_str());
-        IVS_DEBUG("Decoder initialized! Channel Id is {0}",
-                  channelTask->request.channelId);
-        channelInfo->mSpDecoder = std::make_shared<Decoder>();
-        if (!channelInfo->mSpDecoder) {
-          channelTask->response.errorCode =
-              common::ErrorCode::MAKE_ALGORITHM_API_FAIL;
-          std::string error = "Make multimedia api failed! channel id is " +
-                              std::to_string(channelTask->request.channelId);
-          channelTask->response.errorInfo = error;
-          IVS_ERROR("{0}", error);
-          channelInfo->mThreadWrapper->stop(false);
-          channelInfo->mSpDecoder->uninit();
-          return common::ErrorCode(-1);
-        }
-
-        IVS_INFO("channel info decoder address: {0:p}",
-                 static_cast<void*>(channelInfo->mSpDecoder.get()));
-
-        common::ErrorCode ret = channelInfo->mSpDecoder->init(
-            getGraphId(), channelTask->request, handle_);
-        if (ret != common::ErrorCode::SUCCESS) {
-          channelTask->response.errorCode = ret;
-          std::string error = "Decoder init failed! channel id is " +
-                              std::to_string(channelTask->request.channelId);
-          channelTask->response.errorInfo = error;
-        }
-
-        channelInfo->mCv->notify_one();
-
-        return ret;
-      },
-      [this, channelInfo, channelTask]() -> common::ErrorCode {
-        return process(channelTask, channelInfo);
-      },
-      [this, channelInfo, channelTask]() -> common::ErrorCode {
-        std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
-        channelInfo->mThreadWrapper->stop(false);
-        channelInfo->mSpDecoder->uninit();
-        auto iter = mThreadsPool.find(channelTask->request.channelId);
-        if (iter != mThreadsPool.end()) {
-          mThreadsPool.erase(iter);
-        }
-        return channelTask->response.errorCode;
-      });
-  channelInfo->mThreadWrapper->start();
-  std::unique_lock<std::mutex> uq(*channelInfo->mMtx);
-  std::cv_status currentNoTimeout =
-      channelInfo->mCv->wait_for(uq, std::chrono::seconds(120));
-  if (currentNoTimeout == std::cv_status::timeout) {
-    channelTask->response.errorCode = common::ErrorCode::TIMEOUT;
-    return common::ErrorCode::TIMEOUT;
+  channelInfo->mSampleDropped =
+      common::SingletonMetricsRegistry::getInstance().frameDroppedCounter(
+          channelTask->request.channelId, "sample");
+  bool scheduled = isScheduled(channelTask->request);
+  if (scheduled) {
+    common::ErrorCode ret = initScheduledTask(channelTask, channelInfo);
+    if (ret != common::ErrorCode::SUCCESS) return ret;
+  } else {
+    common::ErrorCode ret = initThreadTask(channelTask, channelInfo);
+    if (ret != common::ErrorCode::SUCCESS) return ret;
   }
   mThreadsPool.insert(
       std::make_pair(channelTask->request.channelId, channelInfo));
@@ -375,12 +362,27 @@ common::ErrorCode Decode::startTask(std::shared_ptr<ChannelTask>& channelTask) {
     mChannelIdInternalMap[graph_id][channel_id] = channelIdInternal;
   }
 
+  // channelIdInternal确定之后再开始调度，process()中会用到
+  if (scheduled) {
+    mScheduler->addChannel(
+        channel_id, channelInfo->mSpDecoder->getFrameInterval(),
+        [this, channelInfo,
+         channelTask]() -> DecodeScheduler::StepResult {
+          common::ErrorCode ret = process(channelTask, channelInfo);
+          if (ret == common::ErrorCode::STREAM_END)
+            return DecodeScheduler::StepResult::FINISH;
+          if (ret == common::ErrorCode::ERR_FFMPEG_READ_FRAME)
+            return DecodeScheduler::StepResult::RETRY;
+          return DecodeScheduler::StepResult::CONTINUE;
+        });
+  }
+
   IVS_INFO("add one channel task finished, channel id = {0}", channel_id);
   return channelTask->response.errorCode;
 }
 
 common::ErrorCode Decode::stopTask(std::shared_ptr<ChannelTask>& channelTask) {
-  std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
+  std::unique_lock<std::mutex> lk(mThreadsPoolMtx);
   auto itTask = mThreadsPool.find(channelTask->request.channelId);
   if (itTask == mThreadsPool.end()) {
     channelTask->response.errorCode =
@@ -396,11 +398,23 @@ common::ErrorCode Decode::stopTask(std::shared_ptr<ChannelTask>& channelTask) {
   int channelIdInternal = itChannelId->second;
   mChannelIdInternalReleasedMap[graph_id].push(channelIdInternal);
   mChannelIdInternalMap[graph_id].erase(itChannelId);
+  common::SingletonKeyframeScheduler::getInstance().removeChannel(
+      graph_id, channelTask->request.channelId);
 
-  common::ErrorCode errorCode = itTask->second->mThreadWrapper->stop();
-  itTask->second->mSpDecoder->uninit();
-  itTask->second->mThreadWrapper.reset();
-  mThreadsPool.erase(itTask);
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  if (itTask->second->mThreadWrapper) {
+    errorCode = itTask->second->mThreadWrapper->stop();
+    itTask->second->mSpDecoder->uninit();
+    itTask->second->mThreadWrapper.reset();
+    mThreadsPool.erase(itTask);
+  } else {
+    // 正在执行的process()可能需要mThreadsPoolMtx，先解锁再等待其结束
+    std::shared_ptr<ChannelInfo> channelInfo = itTask->second;
+    mThreadsPool.erase(itTask);
+    lk.unlock();
+    mScheduler->removeChannel(channelTask->request.channelId);
+    channelInfo->mSpDecoder->uninit();
+  }
   channelTask->response.errorCode = errorCode;
   IVS_INFO("stop one channel task finished, channel id = {0}",
            channelTask->request.channelId);
@@ -416,6 +430,12 @@ common::ErrorCode Decode::pauseTask(std::shared_ptr<ChannelTask>& channelTask) {
         common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
     return common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
   }
+  if (!itTask->second->mThreadWrapper) {
+    common::ErrorCode errorCode =
+        mScheduler->pauseChannel(channelTask->request.channelId);
+    channelTask->response.errorCode = errorCode;
+    return errorCode;
+  }
   common::ErrorCode errorCode = itTask->second->mThreadWrapper->pause();
   mThreadsPool.erase(itTask);
   channelTask->response.errorCode = errorCode;
@@ -431,6 +451,12 @@ common::ErrorCode Decode::resumeTask(
         common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
     return common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
   }
+  if (!itTask->second->mThreadWrapper) {
+    common::ErrorCode errorCode =
+        mScheduler->resumeChannel(channelTask->request.channelId);
+    channelTask->response.errorCode = errorCode;
+    return errorCode;
+  }
   common::ErrorCode errorCode = itTask->second->mThreadWrapper->resume();
   mThreadsPool.erase(itTask);
   channelTask->response.errorCode = errorCode;
@@ -442,13 +468,17 @@ common::ErrorCode Decode::process(
     const std::shared_ptr<ChannelInfo>& channelInfo) {
   std::shared_ptr<common::ObjectMetadata> objectMetadata;
   common::ErrorCode ret = channelInfo->mSpDecoder->process(objectMetadata);
+  // 重连中，没有新的数据
+  if (!objectMetadata) return ret;
   int graphId = channelTask->request.graphId;
   mFpsProfiler.add(1);
   if (ret == common::ErrorCode::STREAM_END) {
     // end of stream , detach thread and erase in mThreadsPool,
     std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
     channelTask->response.errorCode = ret;
-    channelInfo->mThreadWrapper->stop(false);
+    // 由调度器调度时，返回STREAM_END后调度器不再调度该路
+    if (channelInfo->mThreadWrapper)
+      channelInfo->mThreadWrapper->stop(false);
     channelInfo->mSpDecoder->uninit();
     auto iter = mThreadsPool.find(channelTask->request.channelId);
     if (iter != mThreadsPool.end()) {
@@ -465,8 +495,16 @@ common::ErrorCode Decode::process(
   if (objectMetadata->mFilter && !objectMetadata->mFrame->mEndOfStream &&
       channelTask->request.sampleStrategy ==
           ChannelOperateRequest::SampleStrategy::DROP) {
+    if (channelInfo->mSampleDropped) channelInfo->mSampleDropped->inc();
     return common::ErrorCode::SUCCESS;
   }
+  // 检测间隔内的帧跳过检测，目标框由跟踪器预测
+  if (!objectMetadata->mFilter && !objectMetadata->mFrame->mEndOfStream &&
+      !common::SingletonKeyframeScheduler::getInstance().nextIsKeyframe(
+          graphId, channel_id, channelTask->request.detectInterval)) {
+    objectMetadata->mFilter = true;
+    objectMetadata->mInterpolated = true;
+  }
   int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
   int outputPort = 0;
   if (!getSinkElementFlag()) {
@@ -487,6 +525,97 @@ common::ErrorCode Decode::process(
   return ret;
 }
 
+common::ErrorCode Decode::initThreadTask(
+    const std::shared_ptr<ChannelTask>& channelTask,
+    const std::shared_ptr<ChannelInfo>& channelInfo) {
+  channelInfo->mThreadWrapper = std::make_shared<ThreadWrapper>();
+  channelInfo->mMtx = std::make_shared<std::mutex>();
+  channelInfo->mCv = std::make_shared<std::condition_variable>();
+  channelInfo->mThreadWrapper->init(
+      [this, channelInfo, channelTask]() -> common::ErrorCode {
+        prctl(PR_SET_NAME,
+              std::to_string(channelTask->request.channelId).c_str());
+        IVS_DEBUG("Decoder initialized! Channel Id is {0}",
+                  channelTask->request.channelId);
+        channelInfo->mSpDecoder = std::make_shared<Decoder>();
+        if (!channelInfo->mSpDecoder) {
+          channelTask->response.errorCode =
+              common::ErrorCode::MAKE_ALGORITHM_API_FAIL;
+          std::string error = "Make multimedia api failed! channel id is " +
+                              std::to_string(channelTask->request.channelId);
+          channelTask->response.errorInfo = error;
+          IVS_ERROR("{0}", error);
+          channelInfo->mThreadWrapper->stop(false);
+          channelInfo->mSpDecoder->uninit();
+          return common::ErrorCode(-1);
+        }
+
+        IVS_INFO("channel info decoder address: {0:p}",
+                 static_cast<void*>(channelInfo->mSpDecoder.get()));
+
+        common::ErrorCode ret = channelInfo->mSpDecoder->init(
+            getGraphId(), channelTask->request, handle_);
+        if (ret != common::ErrorCode::SUCCESS) {
+          channelTask->response.errorCode = ret;
+          std::string error = "Decoder init failed! channel id is " +
+                              std::to_string(channelTask->request.channelId);
+          channelTask->response.errorInfo = error;
+        }
+
+        channelInfo->mCv->notify_one();
+
+        return ret;
+      },
+      [this, channelInfo, channelTask]() -> common::ErrorCode {
+        return process(channelTask, channelInfo);
+      },
+      [this, channelInfo, channelTask]() -> common::ErrorCode {
+        std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
+        channelInfo->mThreadWrapper->stop(false);
+        channelInfo->mSpDecoder->uninit();
+        auto iter = mThreadsPool.find(channelTask->request.channelId);
+        if (iter != mThreadsPool.end()) {
+          mThreadsPool.erase(iter);
+        }
+        return channelTask->response.errorCode;
+      });
+  channelInfo->mThreadWrapper->start();
+  std::unique_lock<std::mutex> uq(*channelInfo->mMtx);
+  std::cv_status currentNoTimeout =
+      channelInfo->mCv->wait_for(uq, std::chrono::seconds(120));
+  if (currentNoTimeout == std::cv_status::timeout) {
+    channelTask->response.errorCode = common::ErrorCode::TIMEOUT;
+    return common::ErrorCode::TIMEOUT;
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+bool Decode::isScheduled(const ChannelOperateRequest& request) const {
+  return mScheduler != nullptr &&
+         request.sourceType != ChannelOperateRequest::SourceType::CAMERA &&
+         request.sourceType != ChannelOperateRequest::SourceType::BASE64;
+}
+
+common::ErrorCode Decode::initScheduledTask(
+    const std::shared_ptr<ChannelTask>& channelTask,
+    const std::shared_ptr<ChannelInfo>& channelInfo) {
+  IVS_DEBUG("Scheduled decoder initialized! Channel Id is {0}",
+            channelTask->request.channelId);
+  channelInfo->mSpDecoder = std::make_shared<Decoder>();
+  common::ErrorCode ret = channelInfo->mSpDecoder->init(
+      getGraphId(), channelTask->request, handle_);
+  if (ret != common::ErrorCode::SUCCESS) {
+    channelTask->response.errorCode = ret;
+    std::string error = "Decoder init failed! channel id is " +
+                        std::to_string(channelTask->request.channelId);
+    channelTask->response.errorInfo = error;
+    IVS_ERROR("{0}", error);
+    return ret;
+  }
+  channelInfo->mSpDecoder->setExternalPacing(true);
+  return common::ErrorCode::SUCCESS;
+}
+
 REGISTER_WORKER("decode", Decode)
 
 }  // namespace decode
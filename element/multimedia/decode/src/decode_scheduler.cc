@@ -0,0 +1,268 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "decode_scheduler.h"
+
+#include <sys/prctl.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sophon_stream {
+namespace element {
+namespace decode {
+
+DecodeScheduler::DecodeScheduler() : mWheel(WHEEL_SIZE), mRunning(false) {}
+
+DecodeScheduler::~DecodeScheduler() { stop(); }
+
+common::ErrorCode DecodeScheduler::start(int workerNum) {
+  if (mRunning) {
+    IVS_ERROR("Can not start, decode scheduler is already running");
+    return common::ErrorCode::THREAD_STATUS_ERROR;
+  }
+  if (workerNum <= 0) {
+    IVS_ERROR("Decode scheduler worker number must be positive, got {0}",
+              workerNum);
+    return common::ErrorCode::PARAMETER_ERROR;
+  }
+
+  mRunning = true;
+  mTimerThread = std::make_shared<std::thread>(
+      std::bind(&DecodeScheduler::timerRun, this));
+  mWorkers.reserve(workerNum);
+  for (int i = 0; i < workerNum; ++i) {
+    mWorkers.push_back(std::make_shared<std::thread>(
+        std::bind(&DecodeScheduler::workerRun, this)));
+  }
+  IVS_INFO("Decode scheduler started, worker number: {0}", workerNum);
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode DecodeScheduler::stop() {
+  if (!mRunning) return common::ErrorCode::THREAD_STATUS_ERROR;
+
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    mRunning = false;
+  }
+  mReadyCv.notify_all();
+
+  mTimerThread->join();
+  mTimerThread.reset();
+  for (auto& worker : mWorkers) {
+    worker->join();
+  }
+  mWorkers.clear();
+
+  std::lock_guard<std::mutex> lk(mMutex);
+  mChannels.clear();
+  mReadyQueue.clear();
+  for (auto& slot : mWheel) slot.clear();
+  IVS_INFO("Decode scheduler stopped");
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode DecodeScheduler::addChannel(int channelId, double intervalMs,
+                                              StepHandler handler) {
+  std::lock_guard<std::mutex> lk(mMutex);
+  if (mChannels.find(channelId) != mChannels.end()) {
+    IVS_ERROR("Channel is already scheduled, channel id: {0}", channelId);
+    return common::ErrorCode::DECODE_CHANNEL_USED;
+  }
+
+  auto channel = std::make_shared<ScheduledChannel>();
+  channel->mChannelId = channelId;
+  channel->mHandler = handler;
+  channel->mIntervalMs = intervalMs;
+  channel->mNextDue = Clock::now();
+  mChannels[channelId] = channel;
+  makeReady(channel);
+
+  IVS_INFO("Channel scheduled, channel id: {0}, frame interval: {1}ms",
+           channelId, intervalMs);
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode DecodeScheduler::removeChannel(int channelId) {
+  std::unique_lock<std::mutex> lk(mMutex);
+  auto channelIt = mChannels.find(channelId);
+  if (channelIt == mChannels.end()) {
+    return common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
+  }
+  auto channel = channelIt->second;
+  mChannels.erase(channelIt);
+  channel->mRemoved = true;
+  // 时间轮和就绪队列中的残留项会在出队时因mRemoved被丢弃
+  mIdleCv.wait(lk, [&channel]() {
+    return channel->mState != ChannelState::RUNNING;
+  });
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode DecodeScheduler::pauseChannel(int channelId) {
+  std::lock_guard<std::mutex> lk(mMutex);
+  auto channelIt = mChannels.find(channelId);
+  if (channelIt == mChannels.end()) {
+    return common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
+  }
+  auto& channel = channelIt->second;
+  if (channel->mState == ChannelState::RUNNING) {
+    channel->mPauseRequested = true;
+  } else {
+    channel->mState = ChannelState::PAUSED;
+    ++channel->mArmId;
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode DecodeScheduler::resumeChannel(int channelId) {
+  std::lock_guard<std::mutex> lk(mMutex);
+  auto channelIt = mChannels.find(channelId);
+  if (channelIt == mChannels.end()) {
+    return common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
+  }
+  auto& channel = channelIt->second;
+  channel->mPauseRequested = false;
+  if (channel->mState == ChannelState::PAUSED) {
+    channel->mNextDue = Clock::now();
+    makeReady(channel);
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+void DecodeScheduler::makeReady(
+    const std::shared_ptr<ScheduledChannel>& channel) {
+  ++channel->mArmId;
+  channel->mState = ChannelState::READY;
+  mReadyQueue.push_back(channel);
+  mReadyCv.notify_one();
+}
+
+void DecodeScheduler::arm(const std::shared_ptr<ScheduledChannel>& channel,
+                          double delayMs) {
+  if (delayMs <= 0) {
+    makeReady(channel);
+    return;
+  }
+  std::uint64_t ticks = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(std::ceil(delayMs / TICK_MS)));
+  std::uint64_t target = mCurrentTick + ticks;
+  channel->mState = ChannelState::WAITING;
+  WheelEntry entry;
+  entry.mChannel = channel;
+  entry.mArmId = ++channel->mArmId;
+  entry.mRounds = (ticks - 1) / WHEEL_SIZE;
+  mWheel[target % WHEEL_SIZE].push_back(entry);
+}
+
+void DecodeScheduler::timerRun() {
+  prctl(PR_SET_NAME, "decode_timer");
+  auto nextTick = Clock::now();
+  while (mRunning) {
+    nextTick += std::chrono::milliseconds(TICK_MS);
+    std::this_thread::sleep_until(nextTick);
+
+    std::lock_guard<std::mutex> lk(mMutex);
+    // 线程被延迟唤醒时，补齐错过的tick，保证各路的唤醒时间不漂移
+    auto now = Clock::now();
+    while (true) {
+      ++mCurrentTick;
+      auto& slot = mWheel[mCurrentTick % WHEEL_SIZE];
+      for (auto it = slot.begin(); it != slot.end();) {
+        auto& channel = it->mChannel;
+        if (channel->mRemoved || channel->mArmId != it->mArmId ||
+            channel->mState != ChannelState::WAITING) {
+          it = slot.erase(it);
+        } else if (it->mRounds > 0) {
+          --it->mRounds;
+          ++it;
+        } else {
+          channel->mState = ChannelState::READY;
+          mReadyQueue.push_back(channel);
+          it = slot.erase(it);
+        }
+      }
+      if (nextTick + std::chrono::milliseconds(TICK_MS) > now) break;
+      nextTick += std::chrono::milliseconds(TICK_MS);
+    }
+    if (!mReadyQueue.empty()) mReadyCv.notify_all();
+  }
+}
+
+void DecodeScheduler::workerRun() {
+  prctl(PR_SET_NAME, "decode_worker");
+  std::unique_lock<std::mutex> lk(mMutex);
+  while (true) {
+    mReadyCv.wait(lk, [this]() { return !mRunning || !mReadyQueue.empty(); });
+    if (!mRunning) break;
+
+    auto channel = mReadyQueue.front();
+    mReadyQueue.pop_front();
+    if (channel->mRemoved || channel->mState != ChannelState::READY) continue;
+
+    channel->mState = ChannelState::RUNNING;
+    lk.unlock();
+    StepResult result = channel->mHandler();
+    lk.lock();
+
+    if (channel->mRemoved) {
+      channel->mState = ChannelState::PAUSED;
+      mIdleCv.notify_all();
+      continue;
+    }
+
+    if (result == StepResult::FINISH) {
+      channel->mState = ChannelState::PAUSED;
+      auto channelIt = mChannels.find(channel->mChannelId);
+      if (channelIt != mChannels.end() && channelIt->second == channel) {
+        mChannels.erase(channelIt);
+      }
+      mIdleCv.notify_all();
+      continue;
+    }
+
+    if (channel->mPauseRequested) {
+      channel->mPauseRequested = false;
+      channel->mState = ChannelState::PAUSED;
+      mIdleCv.notify_all();
+      continue;
+    }
+
+    auto now = Clock::now();
+    double delayMs = 0;
+    if (result == StepResult::RETRY) {
+      channel->mBackoffMs =
+          channel->mBackoffMs == 0
+              ? BACKOFF_MIN_MS
+              : std::min(channel->mBackoffMs * 2, BACKOFF_MAX_MS);
+      channel->mNextDue = now;
+      delayMs = channel->mBackoffMs;
+      IVS_DEBUG("Channel retry after {0}ms, channel id: {1}",
+                channel->mBackoffMs, channel->mChannelId);
+    } else {
+      channel->mBackoffMs = 0;
+      if (channel->mIntervalMs > 0) {
+        channel->mNextDue += std::chrono::microseconds(
+            static_cast<std::int64_t>(channel->mIntervalMs * 1000));
+        // 落后于计划时不追帧，从当前时刻重新计时
+        if (channel->mNextDue < now) channel->mNextDue = now;
+        delayMs = std::chrono::duration<double, std::milli>(
+                      channel->mNextDue - now)
+                      .count();
+      }
+    }
+    arm(channel, delayMs);
+    mIdleCv.notify_all();
+  }
+}
+
+}  // namespace decode
+}  // namespace element
+}  // namespace sophon_stream
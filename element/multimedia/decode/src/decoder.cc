@@ -92,6 +92,8 @@ common::ErrorCode Decoder::init(int graphId,
     m_handle = handle_;
     mDeviceId = bm_get_devid(m_handle);
     mGraphId = graphId;
+    mMetadataPool =
+        common::SingletonMetadataPools::getInstance().get(request.channelId);
     mSourceType = request.sourceType;
     mImgIndex = 0;
     mRoiPredefined = request.roi_predefined;
@@ -173,8 +175,11 @@ common::ErrorCode Decoder::process(
     int64_t pts = 0;
     spBmImage =
         decoder.grab(frame_id, eof, pts, mSampleInterval, mSampleStrategy);
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    // 外部调度模式下重连失败，本次没有数据，由调度器退避后重试
+    if (decoder.isReconnecting()) {
+      return common::ErrorCode::ERR_FFMPEG_READ_FRAME;
+    }
+    objectMetadata = common::makeFrameObjectMetadata(mMetadataPool);
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = frame_id;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(frame_id);
@@ -199,8 +204,7 @@ common::ErrorCode Decoder::process(
     int64_t pts = 0;
     spBmImage =
         decoder.grab(frame_id, eof, pts, mSampleInterval, mSampleStrategy);
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata = common::makeFrameObjectMetadata(mMetadataPool);
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = frame_id;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(frame_id);
@@ -231,8 +235,7 @@ common::ErrorCode Decoder::process(
 
     spBmImage = decoder.picDec(
         m_handle, mImagePaths[mImgIndex % mImagePaths.size()].c_str());
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata = common::makeFrameObjectMetadata(mMetadataPool);
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = mImgIndex;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(mImgIndex);
@@ -260,8 +263,7 @@ common::ErrorCode Decoder::process(
     std::shared_ptr<bm_image> spBmImage = nullptr;
 
     spBmImage = mgr->grab(m_handle);
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata = common::makeFrameObjectMetadata(mMetadataPool);
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = mImgIndex++;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(mImgIndex);
@@ -299,8 +301,7 @@ common::ErrorCode Decoder::process(
         spBmImage = emptyImage;
     }
     
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata = common::makeFrameObjectMetadata(mMetadataPool);
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = frame_id;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(frame_id);
@@ -361,6 +362,12 @@ common::ErrorCode Decoder::process(
 
 void Decoder::uninit() {}
 
+void Decoder::setExternalPacing(bool enable) {
+  decoder.setExternalPacing(enable);
+}
+
+double Decoder::getFrameInterval() const { return decoder.getFrameInterval(); }
+
 }  // namespace decode
 }  // namespace element
 }  // namespace sophon_stream
\ No newline at end of file
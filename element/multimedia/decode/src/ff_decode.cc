@@ -468,8 +468,12 @@ int VideoDecFFM::openDec(bm_handle_t* dec_handle, const char* input) {
     return ret;
   }
 
+  hardware_decode = true;
+  data_on_device_mem = true;
   ret = openCodecContext(&video_stream_idx, &video_dec_ctx, ifmt_ctx,
                          AVMEDIA_TYPE_VIDEO, bm_get_devid(*dec_handle));
+  dec_hardware_decode = hardware_decode;
+  dec_data_on_device_mem = data_on_device_mem;
 
   if (ret >= 0) {
     width = video_dec_ctx->width;
@@ -761,11 +765,29 @@ AVFrame* VideoDecFFM::grabFrame(int& eof) {
   return frame;
 }
 
+AVFrame* VideoDecFFM::reopenAndGrab(int& eof) {
+  IVS_INFO("grabFrame failed! Try to reconnect...");
+  this->closeDec();
+  int ret = this->openDec(handle, inputUrl.c_str());
+  if (ret < 0) return NULL;
+  // 由于ctrl+C取消推流时会返回EOF，导致stream直接结束，所以这里判断不能是eof
+  AVFrame* avframe = grabFrame(eof);
+  if (eof) {
+    IVS_INFO("reopen eof!");
+  }
+  if (avframe) {
+    IVS_INFO("Successfully reconnected, now continue...");
+    // 如果不改变这个eof，ctrl+C取消然后再次推流，会一直返回eof
+    eof = 0;
+  }
+  return avframe;
+}
+
 std::shared_ptr<bm_image> VideoDecFFM::grab(int& frameId, int& eof,
                                             int64_t& pts, int sampleInterval,
                                             sampleStrategy strategy) {
   // 控制帧率
-  if (fps != -1) {
+  if (fps != -1 && !external_pacing) {
     gettimeofday(&current_time, NULL);
     double time_delta =
         1000 * ((current_time.tv_sec - last_time.tv_sec) +
@@ -776,30 +798,21 @@ std::shared_ptr<bm_image> VideoDecFFM::grab(int& frameId, int& eof,
     gettimeofday(&last_time, NULL);
   }
   std::shared_ptr<bm_image> spBmImage = nullptr;
-  AVFrame* avframe = grabFrame(eof);
+  AVFrame* avframe = reconnecting ? NULL : grabFrame(eof);
   // 没有取到avframe，尝试重连
   if ((!avframe) && (this->is_rtsp || this->is_rtmp || this->is_gb28181)) {
-    // 第一个while，关闭并重新访问url。如果失败，则再次尝试
-    while (1) {
-      IVS_INFO("grabFrame failed! Try to reconnect...");
-      this->closeDec();
-      int ret = this->openDec(handle, inputUrl.c_str());
-      if (ret < 0) continue;
-      // 第二个while，尝试重新获取一帧。如果获取失败，则再次获取
-      // 由于ctrl+C取消推流时会返回EOF，导致stream直接结束，所以这里判断不能是eof
-      while (1) {
-        avframe = grabFrame(eof);
-        if (eof) {
-          IVS_INFO("reopen eof!");
-        }
-        if (avframe) {
-          IVS_INFO("Successfully reconnected, now continue...");
-          // 如果不改变这个eof，ctrl+C取消然后再次推流，会一直返回eof
-          eof = 0;
-          break;
-        }
+    if (external_pacing) {
+      // 只尝试一次，重试间隔由调用者控制
+      avframe = reopenAndGrab(eof);
+      reconnecting = (avframe == NULL);
+      if (reconnecting) return spBmImage;
+    } else {
+      // 重连失败时按指数退避等待，避免连续重试占满CPU
+      int backoff_ms = RECONNECT_BACKOFF_MIN_MS;
+      while (!(avframe = reopenAndGrab(eof))) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+        backoff_ms = std::min(backoff_ms * 2, RECONNECT_BACKOFF_MAX_MS);
       }
-      break;
     }
   }
   frameId = frame_id++;
@@ -818,6 +831,8 @@ std::shared_ptr<bm_image> VideoDecFFM::grab(int& frameId, int& eof,
     delete p;
     p = nullptr;
   });
+  hardware_decode = dec_hardware_decode;
+  data_on_device_mem = dec_data_on_device_mem;
   avframe_to_bm_image(*(this->handle), avframe, spBmImage.get(), false);
   return spBmImage;
 }
@@ -849,7 +864,7 @@ bool is_bmp(const char* filename) {
 std::shared_ptr<bm_image> VideoDecFFM::picDec(bm_handle_t& handle,
                                               const char* path) {
   // 控制帧率
-  if (fps != -1) {
+  if (fps != -1 && !external_pacing) {
     gettimeofday(&current_time, NULL);
     double time_delta =
         1000 * ((current_time.tv_sec - last_time.tv_sec) +
@@ -860,6 +875,8 @@ std::shared_ptr<bm_image> VideoDecFFM::picDec(bm_handle_t& handle,
     gettimeofday(&last_time, NULL);
   }
 
+  // 解码标志是线程局部变量，每张图片重新判断，避免受其它码流影响
+  data_on_device_mem = true;
   string input_name = path;
   if (is_jpg(path)) {
     return jpgDec(handle, input_name);
@@ -1289,3 +1306,11 @@ void VideoDecFFM::setFps(int f) {
   fps = f;
   frame_interval_time = 1 / fps * 1000;
 }
+
+double VideoDecFFM::getFrameInterval() const {
+  return fps == -1 ? 0 : frame_interval_time;
+}
+
+void VideoDecFFM::setExternalPacing(bool enable) { external_pacing = enable; }
+
+bool VideoDecFFM::isReconnecting() const { return reconnecting; }
@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "host_decode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+std::shared_ptr<bm_image> bgrToBmImage(bm_handle_t& handle,
+                                       const cv::Mat& bgr) {
+  std::shared_ptr<bm_image> spBmImage = nullptr;
+  int width = bgr.cols & ~1;
+  int height = bgr.rows & ~1;
+  if (width == 0 || height == 0) return spBmImage;
+
+  cv::Mat i420;
+  cv::cvtColor(bgr(cv::Rect(0, 0, width, height)), i420,
+               cv::COLOR_BGR2YUV_I420);
+  spBmImage.reset(new bm_image, [](bm_image* p) {
+    bm_image_destroy(*p);
+    delete p;
+    p = nullptr;
+  });
+  bm_image_create(handle, height, width, FORMAT_YUV420P, DATA_TYPE_EXT_1N_BYTE,
+                  spBmImage.get());
+  if (bm_image_alloc_dev_mem_heap_mask(*spBmImage, USEING_MEM_HEAP1) !=
+      BM_SUCCESS) {
+    IVS_ERROR("host decode alloc image failed, {0}x{1}", width, height);
+    return nullptr;
+  }
+  // I420为连续的Y、U、V三个平面
+  uint8_t* y = i420.data;
+  uint8_t* u = y + width * height;
+  uint8_t* v = u + width * height / 4;
+  void* buffers[3] = {y, u, v};
+  bm_image_copy_host_to_device(*spBmImage, buffers);
+  return spBmImage;
+}
+
+VideoDecFFM::VideoDecFFM() { gettimeofday(&last_time, NULL); }
+
+VideoDecFFM::~VideoDecFFM() { closeDec(); }
+
+void VideoDecFFM::mFrameCount(const char* video_file, int& mFrameCount) {
+  cv::VideoCapture counter(video_file);
+  mFrameCount = counter.isOpened()
+                    ? static_cast<int>(counter.get(cv::CAP_PROP_FRAME_COUNT))
+                    : 0;
+}
+
+int VideoDecFFM::openDec(bm_handle_t* dec_handle, const char* input) {
+  handle = dec_handle;
+  inputUrl = input;
+  frame_id = 0;
+  is_stream = strstr(input, "rtsp://") || strstr(input, "rtmp://");
+  gettimeofday(&last_time, NULL);
+
+  // /dev/videoN按摄像头编号打开
+  const char* camera = strstr(input, "/dev/video");
+  if (camera)
+    capture.open(atoi(camera + strlen("/dev/video")));
+  else
+    capture.open(inputUrl);
+  if (!capture.isOpened()) {
+    IVS_ERROR("host decode cannot open {0}", inputUrl);
+    return -1;
+  }
+  IVS_INFO("host decode open {0}, {1}x{2}", inputUrl,
+           capture.get(cv::CAP_PROP_FRAME_WIDTH),
+           capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+  return 0;
+}
+
+void VideoDecFFM::closeDec() {
+  if (capture.isOpened()) capture.release();
+  frame_id = 0;
+}
+
+void VideoDecFFM::paceFrame() {
+  if (fps == -1 || external_pacing) return;
+  struct timeval current_time;
+  gettimeofday(&current_time, NULL);
+  double time_delta =
+      1000 * ((current_time.tv_sec - last_time.tv_sec) +
+              (double)(current_time.tv_usec - last_time.tv_usec) / 1000000.0);
+  int time_to_sleep = frame_interval_time - time_delta;
+  if (time_to_sleep > 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(time_to_sleep));
+  gettimeofday(&last_time, NULL);
+}
+
+std::shared_ptr<bm_image> VideoDecFFM::grab(int& frameId, int& eof,
+                                            int64_t& pts, int sampleInterval,
+                                            sampleStrategy strategy) {
+  paceFrame();
+  std::shared_ptr<bm_image> spBmImage = nullptr;
+  bool got = !reconnecting && capture.isOpened() && capture.read(bgr);
+  if (!got && is_stream) {
+    // 与硬件解码相同：外部调度时只重连一次，否则按指数退避重连直到成功
+    int backoff_ms = 100;
+    while (true) {
+      closeDec();
+      got = openDec(handle, inputUrl.c_str()) == 0 && capture.read(bgr);
+      if (got || external_pacing) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+      backoff_ms = std::min(backoff_ms * 2, 10000);
+    }
+    reconnecting = !got;
+    if (reconnecting) return spBmImage;
+  }
+  if (!got) {
+    eof = 1;
+    return spBmImage;
+  }
+  frameId = frame_id++;
+
+  timeval pt;
+  gettimeofday(&pt, NULL);
+  pts = pt.tv_sec * 1e6 + pt.tv_usec;
+
+  if ((strategy == sampleStrategy::DROP) && (frameId % sampleInterval != 0)) {
+    return spBmImage;
+  }
+  return bgrToBmImage(*handle, bgr);
+}
+
+std::shared_ptr<bm_image> VideoDecFFM::picDec(bm_handle_t& handle,
+                                              const char* path) {
+  paceFrame();
+  cv::Mat image = cv::imread(path, cv::IMREAD_COLOR);
+  if (image.empty()) {
+    IVS_ERROR("host decode cannot read picture {0}", path);
+    return nullptr;
+  }
+  return bgrToBmImage(handle, image);
+}
+
+void VideoDecFFM::setFps(int f) {
+  fps = f;
+  frame_interval_time = 1 / fps * 1000;
+}
+
+double VideoDecFFM::getFrameInterval() const {
+  return fps == -1 ? 0 : frame_interval_time;
+}
+
+void VideoDecFFM::setExternalPacing(bool enable) { external_pacing = enable; }
+
+bool VideoDecFFM::isReconnecting() const { return reconnecting; }
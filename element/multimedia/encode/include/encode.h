@@ -14,9 +14,11 @@
 
 #include "element_factory.h"
 #include "encoder.h"
+#include "muxer_pool.h"
 #include "websocketpp/base64/base64.hpp"
 #include "wss.h"
 #include "wss_boost.h"
+#include "wss_mux.h"
 
 namespace sophon_stream {
 namespace element {
@@ -71,6 +73,8 @@ class Encode : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_WSS_PORT_FIELD = "wss_port";
   static constexpr const char* CONFIG_INTERNAL_WSS_BACKEND = "wss_backend";
   static constexpr const char* CONFIG_INTERNAL_FPS_FIELD = "fps";
+  static constexpr const char* CONFIG_INTERNAL_MUX_THREAD_NUM_FIELD =
+      "mux_thread_num";
 
   // for customizing shape and ip
   static constexpr const char* CONFIG_INTERNAL_WIDTH_FIELD = "width";
@@ -95,7 +99,7 @@ class Encode : public ::sophon_stream::framework::Element {
   int height = -1;
 
   enum class WSencType { IMG_ONLY, SERIALIZED };
-  enum class WSSBackend { WEBSOCKETPP, BOOST };
+  enum class WSSBackend { WEBSOCKETPP, BOOST, MUX };
   WSencType mWsEncType = WSencType::IMG_ONLY;
   WSSBackend mWssBackend = WSSBackend::WEBSOCKETPP;
 
@@ -109,6 +113,8 @@ class Encode : public ::sophon_stream::framework::Element {
   std::vector<std::thread> mWSSThreads;
   std::mutex mWSSThreadsMutex;
   std::string mWSSPort;
+  // wss_backend为MUX时使用，所有channel共用wss_port
+  std::shared_ptr<WSSMux> mWSSMux;
 
   // 处理RTSP、RTMP、VIDEO
   void processVideoStream(
@@ -119,6 +125,11 @@ class Encode : public ::sophon_stream::framework::Element {
   // 处理WS
   void processWS(int dataPipeId,
                  std::shared_ptr<common::ObjectMetadata> objectMetadata);
+  // 处理WS，单端口按channel_id分发
+  void processWSMux(std::shared_ptr<common::ObjectMetadata> objectMetadata);
+  // 将一帧编码为WS消息，IMG_ONLY为base64 jpeg，SERIALIZED为json
+  std::string encodeWSData(
+      std::shared_ptr<common::ObjectMetadata> objectMetadata);
   // WS发送停止标识
   void stopWS(int dataPipeId);
 
@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_MUXER_POOL_H_
+#define SOPHON_STREAM_ELEMENT_MUXER_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/logger.h"
+#include "common/no_copyable.h"
+#include "common/singleton.h"
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+/**
+ * @brief 所有Encoder共享的推流线程池
+ * Encoder注册一个推流任务，编码出新包后调用notify()唤醒线程池执行该任务，
+ * 不再为每个Encoder单独起线程轮询。同一个任务同一时刻只会在一个线程中执行，
+ * 执行期间收到的notify会在本次执行结束后再调度一次。
+ */
+class MuxerPool : public ::sophon_stream::common::NoCopyable {
+ public:
+  using MuxTask = std::function<void(void)>;
+
+  /**
+   * @brief 设置线程数，在第一个任务注册、线程池启动之前调用才生效
+   */
+  void setThreadNum(int threadNum);
+
+  /**
+   * @brief 注册推流任务，线程池未启动时启动线程池
+   * @return 任务id
+   */
+  int registerTask(MuxTask task);
+
+  /**
+   * @brief 移除推流任务，如果任务正在执行，会等待本次执行结束
+   * @brief 最后一个任务移除后线程池退出
+   */
+  void unregisterTask(int taskId);
+
+  void notify(int taskId);
+
+  static constexpr int DEFAULT_THREAD_NUM = 2;
+
+ private:
+  friend class common::Singleton<MuxerPool>;
+
+  MuxerPool();
+  ~MuxerPool();
+
+  struct TaskState {
+    MuxTask mTask;
+    bool mScheduled = false;
+    bool mRunning = false;
+    bool mPending = false;
+    bool mRemoved = false;
+  };
+
+  void workerRun();
+
+  std::mutex mMutex;
+  std::condition_variable mReadyCv;
+  std::condition_variable mIdleCv;
+
+  std::map<int, std::shared_ptr<TaskState>> mTasks;
+  std::deque<std::shared_ptr<TaskState>> mReadyQueue;
+  int mNextTaskId = 0;
+
+  int mThreadNum = DEFAULT_THREAD_NUM;
+  bool mRunning = false;
+  std::vector<std::thread> mWorkers;
+};
+
+using SingletonMuxerPool = common::Singleton<MuxerPool>;
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_MUXER_POOL_H_
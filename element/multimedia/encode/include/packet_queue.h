@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_PACKET_QUEUE_H_
+#define SOPHON_STREAM_ELEMENT_PACKET_QUEUE_H_
+
+#include <atomic>
+#include <vector>
+
+#include "common/no_copyable.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+/**
+ * @brief 编码线程与推流线程之间的无锁包队列
+ * 构造时预分配capacity个AVPacket，之后在两个单生产者单消费者的环形队列中循环使用：
+ * 编码线程acquire()取空闲包、编码后push()；推流线程pop()取包、写出后recycle()归还。
+ * 编码侧和推流侧各自只能有一个线程同时访问。
+ */
+class PacketQueue : public ::sophon_stream::common::NoCopyable {
+ public:
+  explicit PacketQueue(int capacity);
+  ~PacketQueue();
+
+  /**
+   * @brief 编码侧：取一个空闲包，包池耗尽（队列已满）时返回nullptr
+   */
+  AVPacket* acquire();
+
+  /**
+   * @brief 编码侧：将编码好的包放入队列
+   */
+  void push(AVPacket* pkt);
+
+  /**
+   * @brief 推流侧：取出最早的包，队列为空时返回nullptr
+   */
+  AVPacket* pop();
+
+  /**
+   * @brief 推流侧：释放包的数据并归还到包池
+   */
+  void recycle(AVPacket* pkt);
+
+  int size() const;
+
+ private:
+  class Ring {
+   public:
+    explicit Ring(int capacity);
+    bool push(AVPacket* pkt);
+    AVPacket* pop();
+    int size() const;
+
+   private:
+    std::vector<AVPacket*> mSlots;
+    std::atomic<std::size_t> mHead;
+    std::atomic<std::size_t> mTail;
+  };
+
+  std::vector<AVPacket*> mPackets;
+  Ring mFree;
+  Ring mReady;
+};
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_PACKET_QUEUE_H_
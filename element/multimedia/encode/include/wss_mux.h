@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_WSS_MUX_H_
+#define SOPHON_STREAM_ELEMENT_WSS_MUX_H_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "common/metrics.h"
+#include "wss.h"
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+/**
+ * @brief 单端口多路复用的websocket server
+ * 客户端通过URL路径订阅某一路，如`ws://{host_ip}:{wss_port}/{channel_id}`，
+ * 也可以在连接后发送`{"subscribe": [2, 3]}`或`{"unsubscribe": [2]}`修改订阅。
+ * 每一帧只编码一次，所有订阅者共享同一份消息；某个客户端发送缓冲积压时，
+ * 只丢弃发往该客户端的帧，不影响其它客户端。
+ */
+class WSSMux {
+ public:
+  WSSMux();
+
+  ~WSSMux();
+
+  /**
+   * @brief 在后台线程中启动server
+   */
+  void start(int port);
+
+  void stop();
+
+  /**
+   * @brief 当前是否有客户端订阅该路，没有时调用者可以跳过编码
+   */
+  bool hasSubscribers(int channelId);
+
+  /**
+   * @brief 将同一份数据发送给该路的所有订阅者
+   */
+  void broadcast(int channelId, const std::string& data);
+
+  /**
+   * @brief 码流结束，向该路的订阅者发送`{"channel_id": id, "eos": true}`并取消订阅，
+   * 只关闭不再订阅任何一路的连接
+   */
+  void closeChannel(int channelId);
+
+  /**
+   * @brief 单个客户端允许积压的发送字节数，超过后丢弃发往该客户端的帧
+   */
+  static constexpr std::size_t MAX_BUFFERED_BYTES = 4 * 1024 * 1024;
+
+ private:
+  void on_open(connection_hdl hdl);
+
+  void on_close(connection_hdl hdl);
+
+  void on_message(connection_hdl hdl, message_ptr msg);
+
+  void subscribe(connection_hdl hdl, int channelId);
+
+  void unsubscribe(connection_hdl hdl, int channelId);
+
+  server m_server;
+  std::thread m_thread;
+  std::atomic<bool> m_running;
+
+  std::mutex m_mutex;
+  // {channel id : 订阅该路的连接}
+  std::map<int, con_list> m_subscribers;
+  // {连接 : 该连接订阅的channel id}
+  std::map<connection_hdl, std::set<int>, std::owner_less<connection_hdl>>
+      m_clients;
+  // {channel id : 慢客户端丢帧计数器}，首次订阅该路时取得
+  std::map<int, common::Counter*> m_slowClientDropped;
+};
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_WSS_MUX_H_
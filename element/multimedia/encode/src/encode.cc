@@ -128,6 +128,8 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
         mWssBackend = WSSBackend::WEBSOCKETPP;
       else if (wsBackend == "BOOST")
         mWssBackend = WSSBackend::BOOST;
+      else if (wsBackend == "MUX")
+        mWssBackend = WSSBackend::MUX;
     }
 
     if (mEncodeType == EncodeType::RTSP || mEncodeType == EncodeType::RTMP ||
@@ -176,6 +178,13 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
       std::map<std::string, int> mEncodeParams;
       mEncodeParams["framerate"] = mFps;
 
+      auto muxThreadNumIt =
+          configure.find(CONFIG_INTERNAL_MUX_THREAD_NUM_FIELD);
+      if (muxThreadNumIt != configure.end()) {
+        SingletonMuxerPool::getInstance().setThreadNum(
+            muxThreadNumIt->get<int>());
+      }
+
       int dev_id = getDeviceId();
       // bm_dev_request(&m_handle, dev_id);
 
@@ -209,6 +218,10 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
             CONFIG_INTERNAL_WSS_PORT_FIELD, json);
         break;
       }
+      if (mWssBackend == WSSBackend::MUX) {
+        mWSSMux = std::make_shared<WSSMux>();
+        mWSSMux->start(std::stoi(mWSSPort));
+      }
     }
 
   } while (false);
@@ -270,7 +283,10 @@ common::ErrorCode Encode::doWork(int dataPipeId) {
     } else if (mEncodeType == EncodeType::IMG_DIR) {
       processImgDir(dataPipeId, objectMetadata);
     } else if (mEncodeType == EncodeType::WS) {
-      processWS(dataPipeId, objectMetadata);
+      if (mWssBackend == WSSBackend::MUX)
+        processWSMux(objectMetadata);
+      else
+        processWS(dataPipeId, objectMetadata);
     } else {
     }
   } else {
@@ -279,6 +295,10 @@ common::ErrorCode Encode::doWork(int dataPipeId) {
         mWssBackend == WSSBackend::WEBSOCKETPP) {
       stopWS(dataPipeId);
     }
+    if (mEncodeType == EncodeType::WS && mWssBackend == WSSBackend::MUX &&
+        objectMetadata->mFrame->mEndOfStream) {
+      mWSSMux->closeChannel(objectMetadata->mFrame->mChannelId);
+    }
   }
 
   // mFpsProfiler.add(1);
@@ -431,6 +451,35 @@ void Encode::processWS(int dataPipeId,
     return;
   }
 
+  // base64 img 存入队列
+  serverIt->second->pushImgDataQueue(encodeWSData(objectMetadata));
+}
+
+// 处理WS，所有channel共用一个端口
+void Encode::processWSMux(
+    std::shared_ptr<common::ObjectMetadata> objectMetadata) {
+  int channel_id = objectMetadata->mFrame->mChannelId;
+  // 没有客户端订阅该路时不做编码
+  if (!mWSSMux->hasSubscribers(channel_id)) {
+    return;
+  }
+  // 多路共用一个连接，payload外加一层带channel_id与frame_id的信封，每帧只拼接一次
+  std::string data = encodeWSData(objectMetadata);
+  std::string envelope = "{\"channel_id\":" + std::to_string(channel_id) +
+                         ",\"frame_id\":" +
+                         std::to_string(objectMetadata->mFrame->mFrameId) +
+                         ",\"data\":";
+  bool quoted = mWsEncType == WSencType::IMG_ONLY;
+  envelope.reserve(envelope.size() + data.size() + 3);
+  if (quoted) envelope += '"';
+  envelope += data;
+  if (quoted) envelope += '"';
+  envelope += '}';
+  mWSSMux->broadcast(channel_id, envelope);
+}
+
+std::string Encode::encodeWSData(
+    std::shared_ptr<common::ObjectMetadata> objectMetadata) {
   std::string data;
   if (mWsEncType == WSencType::IMG_ONLY) {
     void* jpeg_data = NULL;
@@ -478,8 +527,7 @@ void Encode::processWS(int dataPipeId,
     nlohmann::json serializedObj = objectMetadata;
     data = serializedObj.dump();
   }
-  // base64 img 存入队列
-  serverIt->second->pushImgDataQueue(data);
+  return data;
 }
 
 // WS发送停止标识
@@ -9,6 +9,12 @@
 
 #include "encoder.h"
 
+#include <atomic>
+#include <cstdint>
+
+#include "muxer_pool.h"
+#include "packet_queue.h"
+
 namespace sophon_stream {
 namespace element {
 namespace encode {
@@ -76,11 +82,8 @@ class Encoder::Encoder_CC {
   void* jpeg_addr;
   int jpeg_size;
 
-  cv::Mat mat;
-  cv::VideoWriter writer;
-
   AVPixelFormat pix_fmt_;
-  // AVFrame* frame_;
+  AVFrame* frame_;
   AVCodec* encoder_;
   AVDictionary* enc_dict_;
   AVIOContext* avio_ctx_;
@@ -94,21 +97,35 @@ class Encoder::Encoder_CC {
   int map_bmformat_to_avformat(int bmformat);
   int bm_image_to_avframe(bm_handle_t& handle, bm_image* image, AVFrame* frame);
   int flush_encoder();
+  void close_writer();
 
-  bool pushQueue(std::shared_ptr<void> p);
-  std::shared_ptr<void> popQueue();
-  int getSize() const;
-  void flowControlFunc();
+  // 在共享推流线程池中执行：写出队列中的包，断流时按间隔发起重连
+  void muxTask();
+  // 重连在该通道自己的线程中进行，不占用共享推流线程池
+  void reconnect();
+  void joinReconnect();
+
+  // 网络读写阻塞超过期限或正在release时，ffmpeg通过该回调中断
+  static int interruptCallback(void* opaque);
+  void armIoDeadline();
 
   static constexpr const int queueMaxSize = 10;
   static constexpr const int queueMinSize = 5;
-  std::queue<std::shared_ptr<void>> encoderQueue;
-  mutable std::mutex mQueueMtx;
+  static constexpr const int reconnectIntervalMs = 5000;
+  static constexpr const int ioTimeoutMs = 3000;
+  PacketQueue packetQueue;
+  // 编码侧暂存的空包，编码器未产出数据时留到下一帧继续使用
+  AVPacket* spare_pkt_;
+  // 队列首次积累到queueMinSize个包后才开始推流
+  bool started_;
+  std::chrono::steady_clock::time_point next_reconnect_;
+  std::thread reconnect_thread_;
+  std::atomic<bool> reconnecting_{false};
+  std::atomic<bool> abort_io_{false};
+  std::atomic<std::int64_t> io_deadline_{0};
+  int mux_task_id_;
   std::mutex mIsOpenMtx;  // mutex lock for judging if rtsp opened
   std::mutex mMtx;        // mutex lock for clearing context
-
-  std::thread flow_control;
-  bool isRunning = true;
 };
 
 Encoder::Encoder() : _impl(new Encoder_CC()) {}
@@ -190,7 +207,12 @@ void Encoder::Encoder_CC::enc_params_prase() {
     params_map_[it->first] = it->second;
 }
 
-Encoder::Encoder_CC::Encoder_CC() {}
+Encoder::Encoder_CC::Encoder_CC()
+    : frame_(nullptr),
+      packetQueue(queueMaxSize),
+      spare_pkt_(nullptr),
+      started_(false),
+      mux_task_id_(-1) {}
 
 Encoder::Encoder_CC::Encoder_CC(int dev_id, const std::string& enc_fmt,
                                 const std::string& pix_fmt,
@@ -204,10 +226,14 @@ Encoder::Encoder_CC::Encoder_CC(int dev_id, const std::string& enc_fmt,
       opened_(false),
       enc_ctx_(nullptr),
       enc_dict_(nullptr),
+      enc_format_ctx_(nullptr),
       enc_fmt_(enc_fmt),
       enc_params_(enc_params),
       pix_fmt_(AV_PIX_FMT_NONE),
-      channel_idx(channel_idx) {
+      channel_idx(channel_idx),
+      packetQueue(queueMaxSize),
+      spare_pkt_(nullptr),
+      started_(false) {
   bm_dev_request(&handle_, dev_id);
   enc_params_prase();
   if (pix_fmt == "I420") {
@@ -216,128 +242,133 @@ Encoder::Encoder_CC::Encoder_CC(int dev_id, const std::string& enc_fmt,
     pix_fmt_ = AV_PIX_FMT_NV12;
   } else {
   }
-  flow_control = std::thread(&Encoder::Encoder_CC::flowControlFunc, this);
+  frame_ = av_frame_alloc();
+  mux_task_id_ = SingletonMuxerPool::getInstance().registerTask(
+      std::bind(&Encoder::Encoder_CC::muxTask, this));
 }
 
 void Encoder::Encoder_CC::init_writer() {
   if (output_path_.compare(0, 7, "rtmp://") == 0) {
     is_rtmp_ = true;
-    std::string enParams =
-        "gop=" + std::to_string(params_map_["gop"]) +
-        ":gop_preset=" + std::to_string(params_map_["gop_preset"]) +
-        ":bitrate=" + std::to_string(params_map_["bitrate"]);
-    if (enc_fmt_ == "h264_bm") {
-      writer.open(output_path_, cv::VideoWriter::fourcc('H', '2', '6', '4'),
-                  params_map_["framerate"],
-                  cv::Size(params_map_["width"], params_map_["height"]),
-                  enParams, true, bm_get_devid(handle_));
-
-    } else if (enc_fmt_ == "h265_bm") {
-      writer.open(output_path_, cv::VideoWriter::fourcc('h', 'v', 'c', '1'),
-                  params_map_["framerate"],
-                  cv::Size(params_map_["width"], params_map_["height"]),
-                  enParams, true, bm_get_devid(handle_));
-    } else {
+    avformat_alloc_output_context2(&enc_format_ctx_, NULL, "flv",
+                                   output_path_.c_str());
+  } else if (output_path_.compare(0, 7, "rtsp://") == 0) {
+    is_rtsp_ = true;
+    avformat_alloc_output_context2(&enc_format_ctx_, NULL, "rtsp",
+                                   output_path_.c_str());
+    if (!enc_format_ctx_) {
     }
-    opened_ = true;
   } else {
-    if (output_path_.compare(0, 7, "rtsp://") == 0) {
-      is_rtsp_ = true;
-      avformat_alloc_output_context2(&enc_format_ctx_, NULL, "rtsp",
-                                     output_path_.c_str());
-      if (!enc_format_ctx_) {
-      }
-    } else {
-      is_video_file_ = true;
-      avformat_alloc_output_context2(&enc_format_ctx_, NULL, NULL,
-                                     output_path_.c_str());
-      // enc_output_fmt_ = av_guess_format(NULL, output_path_.c_str(), NULL);
-      // if (enc_output_fmt_->video_codec == AV_CODEC_ID_NONE) {
-      // }
-      // enc_format_ctx_->oformat = enc_output_fmt_;
-    }
+    is_video_file_ = true;
+    avformat_alloc_output_context2(&enc_format_ctx_, NULL, NULL,
+                                   output_path_.c_str());
+    // enc_output_fmt_ = av_guess_format(NULL, output_path_.c_str(), NULL);
+    // if (enc_output_fmt_->video_codec == AV_CODEC_ID_NONE) {
+    // }
+    // enc_format_ctx_->oformat = enc_output_fmt_;
+  }
+  if ((is_rtsp_ || is_rtmp_) && enc_format_ctx_) {
+    enc_format_ctx_->interrupt_callback.callback =
+        &Encoder::Encoder_CC::interruptCallback;
+    enc_format_ctx_->interrupt_callback.opaque = this;
+  }
 
-    encoder_ = avcodec_find_encoder_by_name(enc_fmt_.c_str());
-    if (!encoder_) {
-      IVS_ERROR("Cannot find encoder named {0}", enc_fmt_);
-      abort();
-    }
-    enc_ctx_ = avcodec_alloc_context3(encoder_);
-    if (!encoder_) {
-      IVS_ERROR("Cannot alloc encoder named {0}", enc_fmt_);
-      abort();
-    }
+  encoder_ = avcodec_find_encoder_by_name(enc_fmt_.c_str());
+  if (!encoder_) {
+    IVS_ERROR("Cannot find encoder named {0}", enc_fmt_);
+    abort();
+  }
+  enc_ctx_ = avcodec_alloc_context3(encoder_);
+  if (!encoder_) {
+    IVS_ERROR("Cannot alloc encoder named {0}", enc_fmt_);
+    abort();
+  }
 
-    enc_ctx_->codec_id = encoder_->id;
-    enc_ctx_->pix_fmt = pix_fmt_;
-
-    enc_ctx_->width = params_map_["width"];
-    enc_ctx_->height = params_map_["height"];
-    enc_ctx_->gop_size = params_map_["gop"];
-    enc_ctx_->time_base = (AVRational){1, params_map_["framerate"]};
-    enc_ctx_->framerate = (AVRational){params_map_["framerate"], 1};
-
-    av_dict_set_int(&enc_dict_, "sophon_idx", bm_get_devid(handle_), 0);
-    av_dict_set_int(&enc_dict_, "gop_preset", params_map_["gop_preset"], 0);
-    av_dict_set_int(&enc_dict_, "is_dma_buffer", 1, 0);
-    // av_dict_set(&enc_dict_, "rtsp_transport", "tcp", 0);
-
-    if (-1 == params_map_["qp"]) {
-      enc_ctx_->bit_rate_tolerance = params_map_["bitrate"] * 1000;
-      enc_ctx_->bit_rate = (int64_t)params_map_["bitrate"] * 1000;
-    } else {
-      av_dict_set_int(&enc_dict_, "qp", params_map_["qp"], 0);
-    }
+  enc_ctx_->codec_id = encoder_->id;
+  enc_ctx_->pix_fmt = pix_fmt_;
+
+  enc_ctx_->width = params_map_["width"];
+  enc_ctx_->height = params_map_["height"];
+  enc_ctx_->gop_size = params_map_["gop"];
+  enc_ctx_->time_base = (AVRational){1, params_map_["framerate"]};
+  enc_ctx_->framerate = (AVRational){params_map_["framerate"], 1};
+  // flv需要在extradata中携带SPS/PPS
+  if (is_rtmp_) enc_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+  av_dict_set_int(&enc_dict_, "sophon_idx", bm_get_devid(handle_), 0);
+  av_dict_set_int(&enc_dict_, "gop_preset", params_map_["gop_preset"], 0);
+  av_dict_set_int(&enc_dict_, "is_dma_buffer", 1, 0);
+  // av_dict_set(&enc_dict_, "rtsp_transport", "tcp", 0);
+
+  if (-1 == params_map_["qp"]) {
+    enc_ctx_->bit_rate_tolerance = params_map_["bitrate"] * 1000;
+    enc_ctx_->bit_rate = (int64_t)params_map_["bitrate"] * 1000;
+  } else {
+    av_dict_set_int(&enc_dict_, "qp", params_map_["qp"], 0);
+  }
 
-    out_stream_ = avformat_new_stream(enc_format_ctx_, encoder_);
+  out_stream_ = avformat_new_stream(enc_format_ctx_, encoder_);
 
-    out_stream_->time_base = enc_ctx_->time_base;
-    out_stream_->avg_frame_rate = enc_ctx_->framerate;
-    out_stream_->r_frame_rate = out_stream_->avg_frame_rate;
+  out_stream_->time_base = enc_ctx_->time_base;
+  out_stream_->avg_frame_rate = enc_ctx_->framerate;
+  out_stream_->r_frame_rate = out_stream_->avg_frame_rate;
 
-    int ret = avcodec_open2(enc_ctx_, encoder_, &enc_dict_);
-    if (ret < 0) {
-      IVS_ERROR("avcodec_open2 failed!");
-      abort();
-    }
-    ret = avcodec_parameters_from_context(out_stream_->codecpar, enc_ctx_);
-    if (ret < 0) {
-      IVS_ERROR("avcodec_parameters_from_context failed");
-      abort();
-    }
-    if (is_video_file_) {
-      if (!(enc_format_ctx_->oformat->flags & AVFMT_NOFILE)) {
-        ret = avio_open2(&enc_format_ctx_->pb, output_path_.c_str(),
-                         AVIO_FLAG_WRITE, NULL, NULL);
-        if (ret < 0) {
-          IVS_ERROR("avio_open2 failed");
-          abort();
-        }
+  int ret = avcodec_open2(enc_ctx_, encoder_, &enc_dict_);
+  if (ret < 0) {
+    IVS_ERROR("avcodec_open2 failed!");
+    abort();
+  }
+  ret = avcodec_parameters_from_context(out_stream_->codecpar, enc_ctx_);
+  if (ret < 0) {
+    IVS_ERROR("avcodec_parameters_from_context failed");
+    abort();
+  }
+  if (is_video_file_ || is_rtmp_) {
+    if (!(enc_format_ctx_->oformat->flags & AVFMT_NOFILE)) {
+      armIoDeadline();
+      ret = avio_open2(&enc_format_ctx_->pb, output_path_.c_str(),
+                       AVIO_FLAG_WRITE, &enc_format_ctx_->interrupt_callback,
+                       NULL);
+      if (ret < 0 && is_rtmp_) {
+        IVS_ERROR("avio_open2 failed {0}, the RTMP ingest server is unreachable",
+                  ret);
+        std::lock_guard<std::mutex> lock(mIsOpenMtx);
+        opened_ = false;
+        return;
+      }
+      if (ret < 0) {
+        IVS_ERROR("avio_open2 failed");
+        abort();
       }
     }
-    AVDictionary *header_options = NULL;
-    // av_dict_set(&header_options, "rtsp_transport", "tcp", 0);
-    av_dict_set(&header_options, "timeout", "3000000", 0); // 3s
-    ret = avformat_write_header(enc_format_ctx_, &header_options);
-    av_dict_free(&header_options);
-    if (ret < 0) {
-      IVS_ERROR("avformat_write_header failed {0}", ret);
-      IVS_ERROR(
-          "The RTSP ingest server fails to reconnect, check whether it is "
-          "enabled");
-      std::lock_guard<std::mutex> lock(mIsOpenMtx);
-      opened_ = false;
-    } else {
-      IVS_INFO("The RTSP ingest server success to connect!");
-      std::lock_guard<std::mutex> lock(mIsOpenMtx);
-      opened_ = true;
-    }
+  }
+  AVDictionary *header_options = NULL;
+  // av_dict_set(&header_options, "rtsp_transport", "tcp", 0);
+  av_dict_set(&header_options, "timeout", "3000000", 0); // 3s
+  armIoDeadline();
+  ret = avformat_write_header(enc_format_ctx_, &header_options);
+  av_dict_free(&header_options);
+  if (ret < 0) {
+    IVS_ERROR("avformat_write_header failed {0}", ret);
+    IVS_ERROR(
+        "The RTSP/RTMP ingest server fails to reconnect, check whether it is "
+        "enabled");
+    std::lock_guard<std::mutex> lock(mIsOpenMtx);
+    opened_ = false;
+  } else {
+    IVS_INFO("The RTSP/RTMP ingest server success to connect!");
+    std::lock_guard<std::mutex> lock(mIsOpenMtx);
+    opened_ = true;
   }
 }
 
 Encoder::Encoder_CC::~Encoder_CC() {
   // SPDLOG_INFO("release encoder");
   // release();
+  SingletonMuxerPool::getInstance().unregisterTask(mux_task_id_);
+  joinReconnect();
+  if (spare_pkt_) av_packet_free(&spare_pkt_);
+  av_frame_free(&frame_);
   bm_dev_free(handle_);
 }
 
@@ -349,7 +380,7 @@ int Encoder::Encoder_CC::bm_image_to_avframe(bm_handle_t& handle,
   bm_image_format_info info;
   int encode_stride = ((params_map_["width"] + 31) >> 5) << 5;
 
-  if (is_rtsp_ || is_video_file_) {
+  if (is_rtsp_ || is_rtmp_ || is_video_file_) {
     if (pix_fmt_ == AV_PIX_FMT_YUV420P) {
       plane = 3;
       int stride_bmi[3] = {encode_stride, encode_stride / 2, encode_stride / 2};
@@ -464,155 +495,141 @@ bool Encoder::Encoder_CC::is_opened() {
   return opened_;
 }
 
-bool Encoder::Encoder_CC::pushQueue(std::shared_ptr<void> p) {
-  if (getSize() >= queueMaxSize) {
-    return false;
+void Encoder::Encoder_CC::close_writer() {
+  if (enc_dict_) {
+    av_dict_free(&enc_dict_);
+    enc_dict_ = nullptr;
+  }
+  if (enc_ctx_) {
+    avcodec_close(enc_ctx_);
+    avcodec_free_context(&enc_ctx_);
+    enc_ctx_ = nullptr;
+  }
+  if (enc_format_ctx_) {
+    if (!(enc_format_ctx_->oformat->flags & AVFMT_NOFILE))
+      avio_closep(&enc_format_ctx_->pb);
+    avformat_free_context(enc_format_ctx_);
+    enc_format_ctx_ = nullptr;
   }
-  std::lock_guard<std::mutex> lock(mQueueMtx);
-  encoderQueue.push(p);
-  return true;
 }
 
-std::shared_ptr<void> Encoder::Encoder_CC::popQueue() {
-  std::lock_guard<std::mutex> lock(mQueueMtx);
-  std::shared_ptr<void> p = nullptr;
-  // printf("encode queue popping! queue size is %d\n", encoderQueue.size());
-  if (!encoderQueue.empty()) {
-    p = encoderQueue.front();
-    encoderQueue.pop();
-  }
-  return p;
+int Encoder::Encoder_CC::interruptCallback(void* opaque) {
+  auto* encoder = static_cast<Encoder::Encoder_CC*>(opaque);
+  if (encoder->abort_io_) return 1;
+  return std::chrono::steady_clock::now().time_since_epoch().count() >
+         encoder->io_deadline_.load();
 }
 
-int Encoder::Encoder_CC::getSize() const {
-  std::lock_guard<std::mutex> lock(mQueueMtx);
-  return encoderQueue.size();
+void Encoder::Encoder_CC::armIoDeadline() {
+  io_deadline_ = (std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(ioTimeoutMs))
+                     .time_since_epoch()
+                     .count();
 }
 
-void Encoder::Encoder_CC::flowControlFunc() {
-  while (isRunning && getSize() < queueMinSize) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(5));
-  }
-  while (isRunning) {
-    while (!is_opened()) {
-      IVS_INFO(
-          "Try clearing context and reconnecting to the RTSP streaming server "
-          "every 5 seconds");
-      {
-        std::lock_guard<std::mutex> lock(mMtx);
-        if (enc_dict_) {
-          av_dict_free(&enc_dict_);
-          enc_dict_ = nullptr;
-        }
-        if (enc_ctx_) {
-          avcodec_close(enc_ctx_);
-          avcodec_free_context(&enc_ctx_);
-          enc_ctx_ = nullptr;
-        }
-        while (1) {
-          auto p = popQueue();
-          if (p == nullptr) break;
-        }
-      }
-      std::this_thread::sleep_for(std::chrono::milliseconds(5000));
+void Encoder::Encoder_CC::reconnect() {
+  // 上一次重连还在进行
+  if (reconnecting_) return;
+  auto now = std::chrono::steady_clock::now();
+  if (now < next_reconnect_) return;
+  next_reconnect_ = now + std::chrono::milliseconds(reconnectIntervalMs);
+
+  IVS_INFO(
+      "Try clearing context and reconnecting to the streaming server every "
+      "{0} ms",
+      reconnectIntervalMs);
+  // 上一次重连的线程已经结束
+  if (reconnect_thread_.joinable()) reconnect_thread_.join();
+  reconnecting_ = true;
+  // avformat_write_header等待服务器时可能阻塞到网络超时，
+  // 放在共享推流线程池中会让其他通道的队列也停止写出
+  reconnect_thread_ = std::thread([this]() {
+    {
+      std::lock_guard<std::mutex> lock(mMtx);
+      while (AVPacket* pkt = packetQueue.pop()) packetQueue.recycle(pkt);
+      armIoDeadline();
+      close_writer();
       init_writer();
     }
-    auto p = popQueue();
-    if (p == nullptr) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(5));
-      continue;
-    }
+    reconnecting_ = false;
+    // 重连成功后写出期间积累的包
+    if (is_opened()) SingletonMuxerPool::getInstance().notify(mux_task_id_);
+  });
+}
 
-    if (is_rtsp_ || is_video_file_) {
-      std::shared_ptr<AVPacket> pp = std::static_pointer_cast<AVPacket>(p);
-      int ret = av_interleaved_write_frame(enc_format_ctx_, pp.get());
-      if (ret) {
-        IVS_ERROR(
-            "The RTSP stream ingest server fails to connect, check whether it "
-            "is "
-            "enabled");
-        {
-          std::lock_guard<std::mutex> lock(mIsOpenMtx);
-          opened_ = false;
-        }
-      }
+void Encoder::Encoder_CC::joinReconnect() {
+  if (!reconnect_thread_.joinable()) return;
+  // 中断正在进行的连接
+  abort_io_ = true;
+  reconnect_thread_.join();
+  abort_io_ = false;
+}
 
-    } else if (is_rtmp_) {
-      std::shared_ptr<cv::Mat> pp = std::static_pointer_cast<cv::Mat>(p);
-      writer.write(*pp);
+void Encoder::Encoder_CC::muxTask() {
+  if (!is_opened()) {
+    reconnect();
+    return;
+  }
+  if (!started_) {
+    if (packetQueue.size() < queueMinSize) return;
+    started_ = true;
+  }
+
+  while (AVPacket* pkt = packetQueue.pop()) {
+    // 写出超过期限时中断，避免一个断开的服务器长期占住推流线程
+    armIoDeadline();
+    int ret = av_interleaved_write_frame(enc_format_ctx_, pkt);
+    packetQueue.recycle(pkt);
+    if (ret) {
+      IVS_ERROR(
+          "The stream ingest server fails to connect, check whether it is "
+          "enabled");
+      next_reconnect_ = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(reconnectIntervalMs);
+      std::lock_guard<std::mutex> lock(mIsOpenMtx);
+      opened_ = false;
+      break;
     }
   }
-  return;
 }
 
 int Encoder::Encoder_CC::video_write(bm_image& image) {
   if (!is_opened()) {
+    // 由推流线程池按间隔发起重连
+    SingletonMuxerPool::getInstance().notify(mux_task_id_);
     IVS_WARN(
-        "The RTSP stream ingest server fails to connect, so the encoder won't "
+        "The stream ingest server fails to connect, so the encoder won't "
         "push data");
     return -1;
   }
-  if (is_rtsp_ || is_video_file_) {
-    // auto _start_time = std::chrono::high_resolution_clock::now();
-
-    int ret = 0;
-    int got_output = 0;
-    // int64_t start_time = 0;
-    std::shared_ptr<AVFrame> frame_ = nullptr;
-    frame_.reset(av_frame_alloc(), [](AVFrame* p) {
-      if (p != nullptr) {
-        av_frame_free(&p);
-      }
-    });
-    std::shared_ptr<AVPacket> test_enc_pkt = nullptr;
-    test_enc_pkt.reset(av_packet_alloc(), [](AVPacket* p) {
-      if (p != nullptr) {
-        av_packet_free(&p);
-      }
-    });
 
-    ret = bm_image_to_avframe(handle_, &image, frame_.get());
-    if (ret < 0) return -1;
-    test_enc_pkt->data = NULL;
-    test_enc_pkt->size = 0;
-    av_init_packet(test_enc_pkt.get());
+  if (spare_pkt_ == nullptr) spare_pkt_ = packetQueue.acquire();
+  if (spare_pkt_ == nullptr) {
+    // 推流跟不上编码，丢弃当前帧
+    SingletonMuxerPool::getInstance().notify(mux_task_id_);
+    return -1;
+  }
+
+  int ret = bm_image_to_avframe(handle_, &image, frame_);
+  if (ret < 0) return -1;
+  int got_output = 0;
+  {
+    std::lock_guard<std::mutex> lock(mMtx);
     if (!is_opened()) {
-      IVS_WARN(
-          "The RTSP stream ingest server fails to connect, so the encoder "
-          "won't push data");
+      av_frame_unref(frame_);
       return -1;
     }
-    {
-      std::lock_guard<std::mutex> lock(mMtx);
-      ret = avcodec_encode_video2(enc_ctx_, test_enc_pkt.get(), frame_.get(),
-                                  &got_output);
-    }
-
+    ret = avcodec_encode_video2(enc_ctx_, spare_pkt_, frame_, &got_output);
+    av_frame_unref(frame_);
     if (ret < 0) return ret;
-    if (got_output == 0) {
-      return -1;
-    }
-    av_packet_rescale_ts(test_enc_pkt.get(), enc_ctx_->time_base,
+    if (got_output == 0) return -1;
+    av_packet_rescale_ts(spare_pkt_, enc_ctx_->time_base,
                          out_stream_->time_base);
-    pushQueue(std::static_pointer_cast<void>(test_enc_pkt));
-
-    // auto _finish_time = std::chrono::high_resolution_clock::now();
-    // std::chrono::duration<double> dur = _finish_time - _start_time;
-    // IVS_DEBUG("Time Cost on video_write is {0}, Encoder ID is {1}",
-    // dur.count(),
-    //           channel_idx);
-    return ret;
-  }
-  if (is_rtmp_) {
-    cv::Mat write_mat;
-    cv::bmcv::toMAT(&image, write_mat, true);
-    cv::Mat resized;
-    cv::resize(write_mat, resized,
-               cv::Size(params_map_["width"], params_map_["height"]));
-    pushQueue(
-        std::static_pointer_cast<void>(std::make_shared<cv::Mat>(resized)));
-    return 0;
   }
+  packetQueue.push(spare_pkt_);
+  spare_pkt_ = nullptr;
+  SingletonMuxerPool::getInstance().notify(mux_task_id_);
+  return ret;
 }
 
 int Encoder::Encoder_CC::flush_encoder() {
@@ -642,15 +659,22 @@ int Encoder::Encoder_CC::flush_encoder() {
 }
 
 void Encoder::Encoder_CC::release() {
-  isRunning = false;
-  flow_control.join();
-  if (enc_ctx_) {
+  SingletonMuxerPool::getInstance().unregisterTask(mux_task_id_);
+  joinReconnect();
+  if (enc_ctx_ && is_opened()) {
+    while (AVPacket* pkt = packetQueue.pop()) {
+      armIoDeadline();
+      av_interleaved_write_frame(enc_format_ctx_, pkt);
+      packetQueue.recycle(pkt);
+    }
+    armIoDeadline();
     flush_encoder();
+    armIoDeadline();
     av_write_trailer(enc_format_ctx_);
   }
 
-  if (enc_dict_) av_dict_free(&enc_dict_);
-  if (enc_ctx_) avcodec_free_context(&enc_ctx_);
+  armIoDeadline();
+  close_writer();
   opened_ = false;
   return;
 }
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "muxer_pool.h"
+
+#include <sys/prctl.h>
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+MuxerPool::MuxerPool() {}
+
+MuxerPool::~MuxerPool() {
+  std::vector<std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    mRunning = false;
+    workers.swap(mWorkers);
+  }
+  mReadyCv.notify_all();
+  for (auto& worker : workers) worker.join();
+}
+
+void MuxerPool::setThreadNum(int threadNum) {
+  std::lock_guard<std::mutex> lk(mMutex);
+  if (mRunning) {
+    IVS_WARN("Muxer pool is already running with {0} threads, ignore {1}",
+             mThreadNum, threadNum);
+    return;
+  }
+  if (threadNum > 0) mThreadNum = threadNum;
+}
+
+int MuxerPool::registerTask(MuxTask task) {
+  std::lock_guard<std::mutex> lk(mMutex);
+  auto state = std::make_shared<TaskState>();
+  state->mTask = task;
+  int taskId = mNextTaskId++;
+  mTasks[taskId] = state;
+
+  if (!mRunning) {
+    mRunning = true;
+    for (int i = 0; i < mThreadNum; ++i) {
+      mWorkers.emplace_back(&MuxerPool::workerRun, this);
+    }
+    IVS_INFO("Muxer pool started, thread number: {0}", mThreadNum);
+  }
+  return taskId;
+}
+
+void MuxerPool::unregisterTask(int taskId) {
+  std::vector<std::thread> workers;
+  {
+    std::unique_lock<std::mutex> lk(mMutex);
+    auto taskIt = mTasks.find(taskId);
+    if (taskIt == mTasks.end()) return;
+    auto state = taskIt->second;
+    mTasks.erase(taskIt);
+    state->mRemoved = true;
+    mIdleCv.wait(lk, [&state]() { return !state->mRunning; });
+
+    if (mTasks.empty() && mRunning) {
+      mRunning = false;
+      mReadyQueue.clear();
+      workers.swap(mWorkers);
+    }
+  }
+  if (workers.empty()) return;
+  mReadyCv.notify_all();
+  for (auto& worker : workers) worker.join();
+  IVS_INFO("Muxer pool stopped");
+}
+
+void MuxerPool::notify(int taskId) {
+  std::lock_guard<std::mutex> lk(mMutex);
+  auto taskIt = mTasks.find(taskId);
+  if (taskIt == mTasks.end()) return;
+  auto& state = taskIt->second;
+  if (state->mRunning) {
+    state->mPending = true;
+    return;
+  }
+  if (state->mScheduled) return;
+  state->mScheduled = true;
+  mReadyQueue.push_back(state);
+  mReadyCv.notify_one();
+}
+
+void MuxerPool::workerRun() {
+  prctl(PR_SET_NAME, "encode_muxer");
+  std::unique_lock<std::mutex> lk(mMutex);
+  while (true) {
+    mReadyCv.wait(lk, [this]() { return !mRunning || !mReadyQueue.empty(); });
+    if (!mRunning) break;
+
+    auto state = mReadyQueue.front();
+    mReadyQueue.pop_front();
+    state->mScheduled = false;
+    if (state->mRemoved) continue;
+
+    state->mRunning = true;
+    lk.unlock();
+    state->mTask();
+    lk.lock();
+    state->mRunning = false;
+
+    if (state->mRemoved) {
+      mIdleCv.notify_all();
+      continue;
+    }
+    if (state->mPending) {
+      state->mPending = false;
+      state->mScheduled = true;
+      mReadyQueue.push_back(state);
+      mReadyCv.notify_one();
+    }
+  }
+}
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "packet_queue.h"
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+PacketQueue::Ring::Ring(int capacity)
+    : mSlots(capacity + 1, nullptr), mHead(0), mTail(0) {}
+
+bool PacketQueue::Ring::push(AVPacket* pkt) {
+  std::size_t tail = mTail.load(std::memory_order_relaxed);
+  std::size_t next = (tail + 1) % mSlots.size();
+  if (next == mHead.load(std::memory_order_acquire)) return false;
+  mSlots[tail] = pkt;
+  mTail.store(next, std::memory_order_release);
+  return true;
+}
+
+AVPacket* PacketQueue::Ring::pop() {
+  std::size_t head = mHead.load(std::memory_order_relaxed);
+  if (head == mTail.load(std::memory_order_acquire)) return nullptr;
+  AVPacket* pkt = mSlots[head];
+  mHead.store((head + 1) % mSlots.size(), std::memory_order_release);
+  return pkt;
+}
+
+int PacketQueue::Ring::size() const {
+  std::size_t head = mHead.load(std::memory_order_acquire);
+  std::size_t tail = mTail.load(std::memory_order_acquire);
+  return (tail + mSlots.size() - head) % mSlots.size();
+}
+
+PacketQueue::PacketQueue(int capacity) : mFree(capacity), mReady(capacity) {
+  mPackets.reserve(capacity);
+  for (int i = 0; i < capacity; ++i) {
+    AVPacket* pkt = av_packet_alloc();
+    mPackets.push_back(pkt);
+    mFree.push(pkt);
+  }
+}
+
+PacketQueue::~PacketQueue() {
+  for (auto& pkt : mPackets) av_packet_free(&pkt);
+}
+
+AVPacket* PacketQueue::acquire() { return mFree.pop(); }
+
+void PacketQueue::push(AVPacket* pkt) { mReady.push(pkt); }
+
+AVPacket* PacketQueue::pop() { return mReady.pop(); }
+
+void PacketQueue::recycle(AVPacket* pkt) {
+  av_packet_unref(pkt);
+  mFree.push(pkt);
+}
+
+int PacketQueue::size() const { return mReady.size(); }
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
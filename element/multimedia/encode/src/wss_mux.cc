@@ -0,0 +1,198 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "wss_mux.h"
+
+#include <nlohmann/json.hpp>
+
+#include "common/metrics.h"
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+WSSMux::WSSMux() : m_running(false) {}
+
+WSSMux::~WSSMux() { stop(); }
+
+void WSSMux::start(int port) {
+  try {
+    m_server.set_access_channels(websocketpp::log::alevel::none);
+    m_server.init_asio();
+    m_server.set_reuse_addr(true);
+
+    m_server.set_open_handler(bind(&WSSMux::on_open, this, _1));
+    m_server.set_close_handler(bind(&WSSMux::on_close, this, _1));
+    m_server.set_message_handler(bind(&WSSMux::on_message, this, _1, _2));
+
+    m_server.listen(port);
+    m_server.start_accept();
+  } catch (websocketpp::exception const& e) {
+    IVS_ERROR("wss mux init error: {}", e.what());
+    return;
+  }
+
+  m_running = true;
+  m_thread = std::thread([this]() {
+    try {
+      m_server.run();
+    } catch (websocketpp::exception const& e) {
+      IVS_ERROR("wss mux run error: {}", e.what());
+    } catch (...) {
+      IVS_ERROR("wss mux run other error");
+    }
+  });
+  IVS_INFO("wss mux listening on port {0}", port);
+}
+
+void WSSMux::stop() {
+  if (!m_running) return;
+  m_running = false;
+
+  websocketpp::lib::error_code ec;
+  m_server.stop_listening(ec);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& client : m_clients) {
+      m_server.close(client.first, websocketpp::close::status::going_away,
+                     WS_STOP_FLAG, ec);
+    }
+  }
+  m_server.stop();
+  if (m_thread.joinable()) m_thread.join();
+}
+
+void WSSMux::on_open(connection_hdl hdl) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_clients[hdl];
+
+  // URL路径为/{channel_id}时直接订阅，否则等待订阅消息
+  auto con = m_server.get_con_from_hdl(hdl);
+  std::string resource = con->get_resource();
+  std::size_t pos = resource.find_first_not_of('/');
+  if (pos == std::string::npos) return;
+  try {
+    subscribe(hdl, std::stoi(resource.substr(pos)));
+  } catch (...) {
+    IVS_WARN("wss mux ignore resource: {0}", resource);
+  }
+}
+
+void WSSMux::on_close(connection_hdl hdl) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto clientIt = m_clients.find(hdl);
+  if (clientIt == m_clients.end()) return;
+  for (int channelId : clientIt->second) {
+    auto subscribersIt = m_subscribers.find(channelId);
+    if (subscribersIt == m_subscribers.end()) continue;
+    subscribersIt->second.erase(hdl);
+    if (subscribersIt->second.empty()) m_subscribers.erase(subscribersIt);
+  }
+  m_clients.erase(clientIt);
+}
+
+void WSSMux::on_message(connection_hdl hdl, message_ptr msg) {
+  auto request = nlohmann::json::parse(msg->get_payload(), nullptr, false);
+  if (!request.is_object()) {
+    IVS_WARN("wss mux ignore message: {0}", msg->get_payload());
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto subscribeIt = request.find("subscribe");
+  if (subscribeIt != request.end() && subscribeIt->is_array()) {
+    for (auto& channelId : *subscribeIt) {
+      if (channelId.is_number_integer()) subscribe(hdl, channelId.get<int>());
+    }
+  }
+  auto unsubscribeIt = request.find("unsubscribe");
+  if (unsubscribeIt != request.end() && unsubscribeIt->is_array()) {
+    for (auto& channelId : *unsubscribeIt) {
+      if (channelId.is_number_integer())
+        unsubscribe(hdl, channelId.get<int>());
+    }
+  }
+}
+
+void WSSMux::subscribe(connection_hdl hdl, int channelId) {
+  m_clients[hdl].insert(channelId);
+  m_subscribers[channelId].insert(hdl);
+  if (m_slowClientDropped.find(channelId) == m_slowClientDropped.end())
+    m_slowClientDropped[channelId] =
+        common::SingletonMetricsRegistry::getInstance().frameDroppedCounter(
+            channelId, "slow_client");
+}
+
+void WSSMux::unsubscribe(connection_hdl hdl, int channelId) {
+  m_clients[hdl].erase(channelId);
+  auto subscribersIt = m_subscribers.find(channelId);
+  if (subscribersIt == m_subscribers.end()) return;
+  subscribersIt->second.erase(hdl);
+  if (subscribersIt->second.empty()) m_subscribers.erase(subscribersIt);
+}
+
+bool WSSMux::hasSubscribers(int channelId) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_subscribers.find(channelId) != m_subscribers.end();
+}
+
+void WSSMux::broadcast(int channelId, const std::string& data) {
+  std::vector<server::connection_ptr> targets;
+  common::Counter* dropped = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto subscribersIt = m_subscribers.find(channelId);
+    if (subscribersIt == m_subscribers.end()) return;
+    dropped = m_slowClientDropped[channelId];
+    for (auto& hdl : subscribersIt->second) {
+      websocketpp::lib::error_code ec;
+      auto con = m_server.get_con_from_hdl(hdl, ec);
+      if (!ec) targets.push_back(con);
+    }
+  }
+  if (targets.empty()) return;
+
+  // 所有订阅者共享同一份payload
+  message_ptr msg = targets.front()->get_message(
+      websocketpp::frame::opcode::text, data.size());
+  msg->set_payload(data);
+  for (auto& con : targets) {
+    // 客户端消费过慢时丢帧，而不是在发送缓冲中继续排队
+    if (con->get_buffered_amount() > MAX_BUFFERED_BYTES) {
+      IVS_DEBUG("wss mux drop frame for slow client, channel id: {0}",
+                channelId);
+      if (dropped) dropped->inc();
+      continue;
+    }
+    con->send(msg);
+  }
+}
+
+void WSSMux::closeChannel(int channelId) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto subscribersIt = m_subscribers.find(channelId);
+  if (subscribersIt == m_subscribers.end()) return;
+  nlohmann::json eos = {{"channel_id", channelId}, {"eos", true}};
+  std::string eosMsg = eos.dump();
+  for (auto& hdl : subscribersIt->second) {
+    websocketpp::lib::error_code ec;
+    // 只取消该路的订阅，连接还订阅了其它路时保持连接
+    auto clientIt = m_clients.find(hdl);
+    if (clientIt != m_clients.end()) clientIt->second.erase(channelId);
+    m_server.send(hdl, eosMsg, websocketpp::frame::opcode::text, ec);
+    if (clientIt == m_clients.end() || clientIt->second.empty())
+      m_server.close(hdl, websocketpp::close::status::normal, WS_STOP_FLAG,
+                     ec);
+  }
+  m_subscribers.erase(subscribersIt);
+}
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
@@ -89,6 +89,14 @@ inline int intRound(const T a) {
 std::map<int, std::shared_ptr<common::ObjectMetadata>> lastObjectMetadataMap;
 std::mutex mLastObjectMetaDataMtx;
 
+// 跳过检测的帧沿用上一次的结果，插值帧带有跟踪器预测的框，绘制本帧的结果
+inline bool reuseLastResults(
+    const std::shared_ptr<common::ObjectMetadata>& objectMetadata,
+    bool draw_interval) {
+  return objectMetadata->mFilter && !objectMetadata->mInterpolated &&
+         draw_interval;
+}
+
 void draw_bmcv_det_result(
     bm_handle_t& handle, std::shared_ptr<common::ObjectMetadata> objectMetadata,
     std::vector<std::string>& class_names, bm_image& frame,
@@ -100,7 +108,7 @@ void draw_bmcv_det_result(
   std::shared_ptr<common::ObjectMetadata> objData;
   {
     std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
-    objData = (objectMetadata->mFilter && draw_interval)
+    objData = reuseLastResults(objectMetadata, draw_interval)
                   ? lastObjectMetadataMap[objectMetadata->mFrame->mChannelId]
                   : objectMetadata;
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
@@ -157,7 +165,7 @@ void draw_bmcv_track_result(
   std::shared_ptr<common::ObjectMetadata> objData;
   {
     std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
-    objData = (objectMetadata->mFilter && draw_interval)
+    objData = reuseLastResults(objectMetadata, draw_interval)
                   ? lastObjectMetadataMap[objectMetadata->mFrame->mChannelId]
                   : objectMetadata;
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
@@ -216,7 +224,7 @@ void draw_opencv_det_result(
   std::shared_ptr<common::ObjectMetadata> objData;
   {
     std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
-    objData = (objectMetadata->mFilter && draw_interval)
+    objData = reuseLastResults(objectMetadata, draw_interval)
                   ? lastObjectMetadataMap[objectMetadata->mFrame->mChannelId]
                   : objectMetadata;
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
@@ -260,7 +268,7 @@ void draw_opencv_track_result(
   std::shared_ptr<common::ObjectMetadata> objData;
   {
     std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
-    objData = (objectMetadata->mFilter && draw_interval)
+    objData = reuseLastResults(objectMetadata, draw_interval)
                   ? lastObjectMetadataMap[objectMetadata->mFrame->mChannelId]
                   : objectMetadata;
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
@@ -302,7 +310,7 @@ void draw_bmcv_pose_result(
   std::shared_ptr<common::ObjectMetadata> objData;
   {
     std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
-    objData = (objectMetadata->mFilter && draw_interval)
+    objData = reuseLastResults(objectMetadata, draw_interval)
                   ? lastObjectMetadataMap[objectMetadata->mFrame->mChannelId]
                   : objectMetadata;
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
@@ -349,7 +357,7 @@ void draw_opencv_pose_result(
   std::shared_ptr<common::ObjectMetadata> objData;
   {
     std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
-    objData = (objectMetadata->mFilter && draw_interval)
+    objData = reuseLastResults(objectMetadata, draw_interval)
                   ? lastObjectMetadataMap[objectMetadata->mFrame->mChannelId]
                   : objectMetadata;
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
@@ -1142,7 +1150,8 @@ void draw_text_results(
     std::shared_ptr<sophon_stream::common::ObjectMetadata> objectMetadata,
     bm_image& frame, std::vector<bm_image>& overlay_images,
     std::vector<int>& top, std::vector<int>& left, bool draw_interval) {
-  if (!objectMetadata->mFilter || draw_interval) {
+  if (!objectMetadata->mFilter || objectMetadata->mInterpolated ||
+      draw_interval) {
     for (int i = 0; i < overlay_images.size(); i++) {
       bm_image overlay_image = overlay_images[i];
       bmcv_rect_t overlay_info = {top[i], left[i], overlay_image.height,
@@ -1160,7 +1169,7 @@ void draw_opencv_obb_result(
   std::shared_ptr<common::ObjectMetadata> objData;
   {
     std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
-    objData = (objectMetadata->mFilter && draw_interval)
+    objData = reuseLastResults(objectMetadata, draw_interval)
                   ? lastObjectMetadataMap[objectMetadata->mFrame->mChannelId]
                   : objectMetadata;
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
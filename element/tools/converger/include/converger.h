@@ -29,6 +29,9 @@ class Converger : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  // 只合并子对象，不读取图像
+  bool needsPixelData() const override { return false; }
+
   static constexpr const char* CONFIG_INTERNAL_DEFAULT_PORT_FILED =
       "default_port";
 
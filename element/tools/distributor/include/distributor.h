@@ -46,6 +46,8 @@ class Distributor : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_ROUTES_FILED = "routes";
 
   static constexpr const char* CONFIG_INTERNAL_IS_AFFINE_FIELD = "is_affine";
+  static constexpr const char* CONFIG_INTERNAL_DISTRIBUTE_INTERPOLATED_FIELD =
+      "distribute_interpolated";
 
  private:
   void makeSubObjectMetadata(
@@ -102,6 +104,10 @@ class Distributor : public ::sophon_stream::framework::Element {
   sophon_stream::common::Clocker clocker;
 
   bool is_affine = false;
+  /**
+   * @brief 跟踪器预测出目标框的插值帧是否参与分发规则，默认只分发检测过的帧
+   */
+  bool mDistributeInterpolated = false;
 };
 
 }  // namespace distributor
@@ -55,6 +55,11 @@ common::ErrorCode Distributor::initInternal(const std::string& json) {
       is_affine = false;
     }
 
+    auto distributeInterpolatedIt =
+        configure.find(CONFIG_INTERNAL_DISTRIBUTE_INTERPOLATED_FIELD);
+    if (distributeInterpolatedIt != configure.end())
+      mDistributeInterpolated = distributeInterpolatedIt->get<bool>();
+
     auto rules = configure.find(CONFIG_INTERNAL_RULES_FILED);
     for (auto& rule : *rules) {
       auto routes = rule.find(CONFIG_INTERNAL_ROUTES_FILED);
@@ -150,7 +155,9 @@ void Distributor::makeSubObjectMetadata(
     rect.crop_h = detObj->mBox.mHeight;
   }
 
-  subObj->mFrame = std::make_shared<common::Frame>();
+  subObj->mFrame = common::makeInArena<common::Frame>(obj->mArena);
+  // 子任务的结果与主帧共用arena
+  subObj->mArena = obj->mArena;
 
   // crop or not
   if (detObj != nullptr) {
@@ -189,8 +196,12 @@ void Distributor::makeSubObjectMetadata(
   subObj->mFrame->mChannelId = obj->mFrame->mChannelId;
   subObj->mFrame->mChannelIdInternal = obj->mFrame->mChannelIdInternal;
   subObj->mSubId = subId;
+  subObj->mInterpolated = obj->mInterpolated;
   subObj->mFrame->mEndOfStream = obj->mFrame->mEndOfStream;
   subObj->mFrame->mHandle = obj->mFrame->mHandle;
+  // 子对象继承父对象的追踪起点，拆分耗时记在distributor的process段中
+  subObj->mTraceTs = obj->mTraceTs;
+  subObj->mTraceElementId = obj->mTraceElementId;
 }
 
 cv::Mat Distributor::estimateAffine2D(
@@ -248,7 +259,9 @@ void Distributor::makeSubFaceObjectMetadata(
     rect.crop_w = faceObj->right - faceObj->left + 1;
     rect.crop_h = faceObj->bottom - faceObj->top + 1;
   }
-  subObj->mFrame = std::make_shared<common::Frame>();
+  subObj->mFrame = common::makeInArena<common::Frame>(obj->mArena);
+  // 子任务的结果与主帧共用arena
+  subObj->mArena = obj->mArena;
   // crop or not,faceObj != nullptr
   if (faceObj != nullptr) {
     int x1 = faceObj->left;
@@ -420,7 +433,9 @@ void Distributor::makeSubOcrObjectMetadata(
     }
   }
 
-  subObj->mFrame = std::make_shared<common::Frame>();
+  subObj->mFrame = common::makeInArena<common::Frame>(obj->mArena);
+  // 子任务的结果与主帧共用arena
+  subObj->mArena = obj->mArena;
 
   // crop or not
   if (detObj != nullptr) {
@@ -601,11 +616,15 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
     mChannelLastTimes[channel_id_internal] =
         std::vector<float>(mTimeIntervals.size(), -99.0);
   }
+  // 插值帧的目标框是跟踪器预测的，默认不参与分发，也不占用计时器规则
+  bool skipRules = objectMetadata->mInterpolated && !mDistributeInterpolated &&
+                   !objectMetadata->mFrame->mEndOfStream;
   // 判断计时器规则
   float cur_time = clocker.tell_ms() / 1000.0;
   int subId = 0;
   std::unordered_map<std::string, std::unordered_set<int>> class2ports;
-  for (int i = 0; i < mChannelLastTimes[channel_id_internal].size(); ++i) {
+  for (int i = 0;
+       !skipRules && i < mChannelLastTimes[channel_id_internal].size(); ++i) {
     if (cur_time - mChannelLastTimes[channel_id_internal][i] >
             mTimeIntervals[i] ||
         objectMetadata->mFrame->mEndOfStream) {
@@ -620,7 +639,7 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
     }
   }
   // 判断跳帧规则
-  for (int i = 0; i < mFrameIntervals.size(); ++i) {
+  for (int i = 0; !skipRules && i < mFrameIntervals.size(); ++i) {
     if (objectMetadata->mFrame->mFrameId % mFrameIntervals[i] == 0 ||
         objectMetadata->mFrame->mEndOfStream) {
       for (auto class_port_it = mFrameDistribRules[mFrameIntervals[i]].begin();
@@ -637,7 +656,8 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
       for (auto outPort : outputPorts) {
         if (outPort == mDefaultPort) continue;
         std::shared_ptr<common::ObjectMetadata> subObj =
-            std::make_shared<common::ObjectMetadata>();
+            common::makeInArena<common::ObjectMetadata>(
+                objectMetadata->mArena);
         makeSubObjectMetadata(objectMetadata, nullptr, subObj, subId);
         objectMetadata->mSubObjectMetadatas.push_back(subObj);
         ++objectMetadata->numBranches;
@@ -669,7 +689,8 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
           int target_port = *port_it;
           // 构造SubObjectMetadata
           std::shared_ptr<common::ObjectMetadata> subObj =
-              std::make_shared<common::ObjectMetadata>();
+              common::makeInArena<common::ObjectMetadata>(
+                  objectMetadata->mArena);
           makeSubFaceObjectMetadata(objectMetadata, faceObj, subObj, subId);
           objectMetadata->mSubObjectMetadatas.push_back(subObj);
           ++objectMetadata->numBranches;
@@ -704,7 +725,8 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
           int target_port = *port_it;
           // 构造SubObjectMetadata
           std::shared_ptr<common::ObjectMetadata> subObj =
-              std::make_shared<common::ObjectMetadata>();
+              common::makeInArena<common::ObjectMetadata>(
+                  objectMetadata->mArena);
 
           if (class_name == "ppocr") {
             makeSubOcrObjectMetadata(objectMetadata, detObj, subObj, subId);
@@ -740,7 +762,8 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
            port_it != class2ports["full_frame"].end(); ++port_it) {
         // full_frame 分发，也是构造一个新的SubObjectMetadata
         std::shared_ptr<common::ObjectMetadata> subObj =
-            std::make_shared<common::ObjectMetadata>();
+            common::makeInArena<common::ObjectMetadata>(
+                objectMetadata->mArena);
         makeSubObjectMetadata(objectMetadata, nullptr, subObj, -1);
         objectMetadata->mSubObjectMetadatas.push_back(subObj);
         ++objectMetadata->numBranches;
@@ -10,12 +10,15 @@
 #ifndef SOPHON_STREAM_ELEMENT_FAISS_H_
 #define SOPHON_STREAM_ELEMENT_FAISS_H_
 
+#include <nlohmann/json.hpp>
+
 #include "bmcv_api_ext.h"
 
 //#if BMCV_VERSION_MAJOR <= 1
 
 #include "common/object_metadata.h"
 #include "element.h"
+#include "vector_index.h"
 
 extern "C" {
 extern bm_status_t bmcv_faiss_indexflatIP(bm_handle_t handle,
@@ -49,13 +52,25 @@ class Faiss : public ::sophon_stream::framework::Element {
       "default_port";
   static constexpr const char* CONFIG_INTERNAL_DB_DATA_PATH_FILED = "db_path";
   static constexpr const char* CONFIG_INTERNAL_LABEL_PATH_FILED = "label_path";
+  static constexpr const char* CONFIG_INTERNAL_BACKEND_FILED = "backend";
+  static constexpr const char* CONFIG_INTERNAL_INDEX_TYPE_FILED = "index_type";
+  static constexpr const char* CONFIG_INTERNAL_NLIST_FILED = "nlist";
+  static constexpr const char* CONFIG_INTERNAL_NPROBE_FILED = "nprobe";
+  static constexpr const char* CONFIG_INTERNAL_PQ_M_FILED = "pq_m";
+  static constexpr const char* CONFIG_INTERNAL_HNSW_M_FILED = "hnsw_m";
+  static constexpr const char* CONFIG_INTERNAL_EF_CONSTRUCTION_FILED =
+      "ef_construction";
+  static constexpr const char* CONFIG_INTERNAL_EF_SEARCH_FILED = "ef_search";
+  static constexpr const char* CONFIG_INTERNAL_MAX_BATCH_FILED = "max_batch";
+  static constexpr const char* BACKEND_TPU = "tpu";
+  static constexpr const char* BACKEND_CPU = "cpu";
   int subId = 0;
 
  private:
   int mDefaultPort;
 
   int sort_cnt = 5;
-  int query_vecs_num = 1;
+  int query_vecs_num = 8;  // tpu后端一次查询的最大人脸数
   int db_vecs_num = 300;
   int is_transpose = 1;
   int input_dtype = 5;
@@ -63,11 +78,26 @@ class Faiss : public ::sophon_stream::framework::Element {
   int vec_dims = 512;
 
   std::vector<std::string> mClassNames;
-  float* db_data;
-  float* output_dis;
-  int* output_inx;
+  float* db_data = nullptr;
+  float* output_dis = nullptr;
+  int* output_inx = nullptr;
+
+  std::string mBackend = BACKEND_TPU;
+  // cpu后端的索引，search可以在多个线程中并发调用
+  std::unique_ptr<VectorIndex> mIndex;
+  // 二进制底库中每一行的id，tpu后端用来把行号换成label下标
+  std::vector<std::int64_t> mRowIds;
 
-  void getFaceId(std::shared_ptr<common::RecognizedObjectMetadata> resnetObj);
+  common::ErrorCode initTpu(const std::vector<float>& db_vec);
+  common::ErrorCode initCpu(const std::string& db_data_path,
+                            const nlohmann::json& configure);
+  /**
+   * @brief 一帧中的所有人脸一次查询
+   */
+  void getFaceIds(
+      const std::vector<std::shared_ptr<common::RecognizedObjectMetadata>>&
+          resnetObjs);
+  void searchTpu(const float* queries, int num, int* labels);
   bm_handle_t handle = nullptr;
   bm_device_mem_t query_data_dev_mem;
   bm_device_mem_t db_data_dev_mem;
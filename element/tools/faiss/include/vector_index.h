@@ -0,0 +1,292 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_FAISS_VECTOR_INDEX_H_
+#define SOPHON_STREAM_ELEMENT_FAISS_VECTOR_INDEX_H_
+
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/no_copyable.h"
+
+namespace sophon_stream {
+namespace element {
+namespace faiss {
+
+/**
+ * @brief 二进制底库格式:
+ * 文件头为MAGIC、VERSION、维度与向量个数(各4字节，count为8字节)，
+ * 之后依次为count个int64的id与count*dim个float的向量，按小端存储。
+ * 文件以mmap方式打开，不需要逐行解析。
+ */
+struct VectorDbFormat {
+  static constexpr std::uint32_t MAGIC = 0x44565353;  // "SSVD"
+  static constexpr std::uint32_t VERSION = 1;
+};
+
+/**
+ * @brief 以只读mmap打开的二进制底库
+ */
+class MappedVectorDb : public common::NoCopyable {
+ public:
+  ~MappedVectorDb();
+
+  bool open(const std::string& path);
+
+  int dim() const { return mDim; }
+  std::size_t count() const { return mCount; }
+  const std::int64_t* ids() const { return mIds; }
+  const float* vectors() const { return mVectors; }
+
+  /**
+   * @brief 判断文件是否为二进制底库
+   */
+  static bool isBinary(const std::string& path);
+
+ private:
+  void* mAddr = nullptr;
+  std::size_t mLength = 0;
+  int mDim = 0;
+  std::size_t mCount = 0;
+  const std::int64_t* mIds = nullptr;
+  const float* mVectors = nullptr;
+};
+
+/**
+ * @brief 读取每行一个向量的文本底库，id为行号
+ */
+bool loadTextVectorDb(const std::string& path, std::vector<float>& vectors,
+                      int& dim);
+
+bool saveVectorDb(const std::string& path, const float* vectors,
+                  const std::int64_t* ids, std::size_t count, int dim);
+
+struct VectorIndexParams {
+  std::string type = "flat";  // flat, ivf, ivf_pq, hnsw
+  int dim = 0;
+  int nlist = 1024;
+  int nprobe = 16;
+  int pqM = 64;
+  int hnswM = 16;
+  int efConstruction = 128;
+  int efSearch = 64;
+};
+
+/**
+ * @brief 内积检索的CPU索引。
+ * search之间不互斥，可以在多个element线程中并发调用；add/remove与search互斥。
+ * 批量查询时一次遍历底库同时计算所有查询向量，底库只从内存读取一次。
+ */
+class VectorIndex : public common::NoCopyable {
+ public:
+  virtual ~VectorIndex() = default;
+
+  int dim() const { return mDim; }
+  virtual std::size_t size() const = 0;
+
+  /**
+   * @brief 训练聚类中心与量化码本，只有ivf与ivf_pq需要。
+   * 训练点不足或索引中已有训练后添加的向量时不训练，返回false
+   */
+  bool train(const float* vectors, std::size_t n);
+
+  /**
+   * @brief 添加向量，id已存在时替换原来的向量
+   */
+  void add(const float* vectors, const std::int64_t* ids, std::size_t n);
+
+  bool remove(std::int64_t id);
+
+  /**
+   * @brief 批量查询，scores与ids的大小为nq * k，按内积从大到小排列，
+   * 结果不足k个时ids填-1
+   */
+  void search(const float* queries, std::size_t nq, int k, float* scores,
+              std::int64_t* ids) const;
+
+  /**
+   * @brief 创建索引，type不支持时返回nullptr
+   */
+  static std::unique_ptr<VectorIndex> create(const VectorIndexParams& params);
+
+ protected:
+  explicit VectorIndex(int dim) : mDim(dim) {}
+
+  virtual bool trainImpl(const float* vectors, std::size_t n) { return true; }
+  virtual void addImpl(const float* vectors, const std::int64_t* ids,
+                       std::size_t n) = 0;
+  virtual bool removeImpl(std::int64_t id) = 0;
+  virtual void searchImpl(const float* queries, std::size_t nq, int k,
+                          float* scores, std::int64_t* ids) const = 0;
+
+  int mDim;
+  mutable std::shared_mutex mMutex;
+};
+
+/**
+ * @brief 暴力内积检索，可以直接使用mmap的底库，第一次add/remove时才复制到内存
+ */
+class FlatIndex : public VectorIndex {
+ public:
+  explicit FlatIndex(int dim) : VectorIndex(dim) {}
+
+  std::size_t size() const override { return mIds.size(); }
+
+  /**
+   * @brief 以mmap的底库作为初始数据，只能在索引为空时调用
+   */
+  bool attach(std::shared_ptr<MappedVectorDb> db);
+
+  static constexpr std::size_t ROW_BLOCK = 128;
+
+ protected:
+  void addImpl(const float* vectors, const std::int64_t* ids,
+               std::size_t n) override;
+  bool removeImpl(std::int64_t id) override;
+  void searchImpl(const float* queries, std::size_t nq, int k, float* scores,
+                  std::int64_t* ids) const override;
+
+ private:
+  void ensureOwned();
+
+  std::shared_ptr<MappedVectorDb> mMapped;
+  std::vector<float> mOwned;
+  const float* mData = nullptr;
+  std::vector<std::int64_t> mIds;
+  std::unordered_map<std::int64_t, std::size_t> mRows;
+};
+
+/**
+ * @brief 倒排索引，nprobe个最近的聚类中每个向量原样存储(ivf)，
+ * 或以pqM段、每段256个码字的乘积量化存储残差(ivf_pq)。
+ * 训练前添加的向量先原样暂存并暴力检索，攒够minTrainPoints()个后用它们训练，
+ * 避免用很少的向量训练出过少的聚类与码字
+ */
+class IvfIndex : public VectorIndex {
+ public:
+  IvfIndex(int dim, int nlist, int nprobe, int pqM);
+
+  std::size_t size() const override {
+    return mLocations.size() + mPendingIds.size();
+  }
+
+  bool trained() const { return mTrained; }
+
+  /**
+   * @brief 训练需要的最少向量数：ivf为nlist，ivf_pq还需要能训练256个码字
+   */
+  std::size_t minTrainPoints() const;
+
+  static constexpr int PQ_CODEBOOK_SIZE = 256;
+  static constexpr int KMEANS_ITERATIONS = 10;
+  static constexpr std::size_t MAX_TRAIN_POINTS_PER_CENTROID = 32;
+  static constexpr std::size_t MAX_PQ_TRAIN_POINTS = 8192;
+
+ protected:
+  bool trainImpl(const float* vectors, std::size_t n) override;
+  void addImpl(const float* vectors, const std::int64_t* ids,
+               std::size_t n) override;
+  bool removeImpl(std::int64_t id) override;
+  void searchImpl(const float* queries, std::size_t nq, int k, float* scores,
+                  std::int64_t* ids) const override;
+
+ private:
+  struct InvertedList {
+    std::vector<std::int64_t> mIds;
+    // ivf时为float向量，ivf_pq时为每个向量pqM字节的码字
+    std::vector<float> mVectors;
+    std::vector<std::uint8_t> mCodes;
+  };
+
+  void addTrained(const float* vectors, const std::int64_t* ids,
+                  std::size_t n);
+  bool removePending(std::int64_t id);
+  int assign(const float* vector) const;
+  static void kmeans(const float* points, std::size_t n, int dim, int k,
+                     bool spherical, std::vector<float>& centroids);
+  void encode(const float* residual, std::uint8_t* code) const;
+
+  int mNlist;
+  int mNprobe;
+  int mPqM;
+  int mDsub = 0;
+  int mKsub = 0;
+  bool mTrained = false;
+  std::vector<float> mCentroids;
+  // [pqM][ksub][dsub]
+  std::vector<float> mCodebooks;
+  std::vector<InvertedList> mLists;
+  // id -> (list, offset)
+  std::unordered_map<std::int64_t, std::pair<int, std::size_t>> mLocations;
+  // 训练前暂存的向量
+  std::vector<float> mPendingVectors;
+  std::vector<std::int64_t> mPendingIds;
+  std::unordered_map<std::int64_t, std::size_t> mPendingRows;
+};
+
+/**
+ * @brief 分层可导航小世界图，删除的节点只做标记，仍参与图的遍历
+ */
+class HnswIndex : public VectorIndex {
+ public:
+  HnswIndex(int dim, int m, int efConstruction, int efSearch);
+
+  std::size_t size() const override { return mNodeOfId.size(); }
+
+ protected:
+  void addImpl(const float* vectors, const std::int64_t* ids,
+               std::size_t n) override;
+  bool removeImpl(std::int64_t id) override;
+  void searchImpl(const float* queries, std::size_t nq, int k, float* scores,
+                  std::int64_t* ids) const override;
+
+ private:
+  using Candidate = std::pair<float, int>;
+
+  void insert(const float* vector, std::int64_t id);
+  int greedySearch(const float* query, int entry, int fromLevel,
+                   int toLevel) const;
+  std::vector<Candidate> searchLayer(const float* query, int entry, int ef,
+                                     int level) const;
+  std::vector<int>& neighbors(int node, int level);
+  const std::vector<int>& neighbors(int node, int level) const;
+  float similarity(const float* query, int node) const;
+  int randomLevel();
+  int maxNeighbors(int level) const { return level == 0 ? 2 * mM : mM; }
+
+  int mM;
+  int mEfConstruction;
+  int mEfSearch;
+  double mLevelMult;
+  int mEntry = -1;
+  int mMaxLevel = -1;
+  std::uint64_t mRandomState = 0x9E3779B97F4A7C15ull;
+
+  std::vector<float> mVectors;
+  std::vector<std::int64_t> mIds;
+  std::vector<char> mDeleted;
+  // mLinks[node][level]
+  std::vector<std::vector<std::vector<int>>> mLinks;
+  std::unordered_map<std::int64_t, int> mNodeOfId;
+};
+
+/**
+ * @brief 内积，x86上运行时选择AVX-512/AVX2，aarch64上使用NEON
+ */
+float innerProduct(const float* a, const float* b, int dim);
+
+}  // namespace faiss
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_FAISS_VECTOR_INDEX_H_
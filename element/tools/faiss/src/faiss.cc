@@ -10,6 +10,7 @@
 
 //#if BMCV_VERSION_MAJOR <= 1
 
+#include <algorithm>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <sstream>
@@ -26,16 +27,17 @@ Faiss::~Faiss() {
   delete[] db_data;
   delete[] output_dis;
   delete[] output_inx;
-  bm_free_device(handle, query_data_dev_mem);
-  bm_free_device(handle, db_data_dev_mem);
-  bm_free_device(handle, buffer_dev_mem);
-  bm_free_device(handle, sorted_similarity_dev_mem);
-  bm_free_device(handle, sorted_index_dev_mem);
+  if (handle != nullptr) {
+    bm_free_device(handle, query_data_dev_mem);
+    bm_free_device(handle, db_data_dev_mem);
+    bm_free_device(handle, buffer_dev_mem);
+    bm_free_device(handle, sorted_similarity_dev_mem);
+    bm_free_device(handle, sorted_index_dev_mem);
+  }
 }
 
 common::ErrorCode Faiss::initInternal(const std::string& json) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
-  STREAM_CHECK(bmcv_faiss_indexflatIP != nullptr, "bmcv_faiss_indexflatIP not support, please update SDK version");
   do {
     auto configure = nlohmann::json::parse(json, nullptr, false);
     if (!configure.is_object()) {
@@ -43,35 +45,17 @@ common::ErrorCode Faiss::initInternal(const std::string& json) {
       break;
     }
 
+    auto backendIt = configure.find(CONFIG_INTERNAL_BACKEND_FILED);
+    if (backendIt != configure.end() && backendIt->is_string())
+      mBackend = backendIt->get<std::string>();
+
+    auto maxBatchIt = configure.find(CONFIG_INTERNAL_MAX_BATCH_FILED);
+    if (maxBatchIt != configure.end() && maxBatchIt->is_number_integer())
+      query_vecs_num = std::max(1, maxBatchIt->get<int>());
+
     auto db_data_path =
         configure.find(CONFIG_INTERNAL_DB_DATA_PATH_FILED)->get<std::string>();
 
-    std::vector<float> db_vec(0);
-    std::ifstream db_data_file;
-    db_data_file.open(db_data_path);
-    assert(db_data_file.is_open());
-    // 读取文件数据到数组
-    if (db_data_file) {
-      std::string line;
-      int row_count = 0;
-      while (std::getline(db_data_file, line)) {
-        std::vector<float> row;
-        std::stringstream ss(line);
-        float val;
-        int col_count = 0;
-        while (ss >> val) {
-          db_vec.push_back(val);
-          col_count++;
-        }
-        if (row_count == 0) {
-          vec_dims = col_count;
-        }
-        row_count++;
-      }
-      db_vecs_num = row_count;
-    }
-    db_data_file.close();
-
     auto label_path =
         configure.find(CONFIG_INTERNAL_LABEL_PATH_FILED)->get<std::string>();
     std::ifstream istream;
@@ -84,50 +68,159 @@ common::ErrorCode Faiss::initInternal(const std::string& json) {
     }
     istream.close();
 
-    db_data = new float[db_vecs_num * vec_dims];
-    output_dis = new float[query_vecs_num * sort_cnt];
-    output_inx = new int[query_vecs_num * sort_cnt];
-    std::memcpy(db_data, db_vec.data(), db_vec.size() * sizeof(float));
-
-    bm_dev_request(&handle, 0);
-    bm_malloc_device_byte(handle, &buffer_dev_mem,
-                          query_vecs_num * db_vecs_num * sizeof(float));
-    bm_malloc_device_byte(handle, &sorted_similarity_dev_mem,
-                          query_vecs_num * sort_cnt * sizeof(float));
-    bm_malloc_device_byte(handle, &sorted_index_dev_mem,
-                          query_vecs_num * sort_cnt * sizeof(int));
-    bm_malloc_device_byte(handle, &query_data_dev_mem,
-                          query_vecs_num * vec_dims * sizeof(float));
-    bm_malloc_device_byte(handle, &db_data_dev_mem,
-                          db_vecs_num * vec_dims * sizeof(float));
-    bm_memcpy_s2d(handle, db_data_dev_mem, db_data);
+    if (mBackend == BACKEND_CPU) {
+      errorCode = initCpu(db_data_path, configure);
+      break;
+    }
+    if (mBackend != BACKEND_TPU) {
+      IVS_ERROR("Unknown faiss backend: {0}", mBackend);
+      errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+      break;
+    }
 
+    STREAM_CHECK(bmcv_faiss_indexflatIP != nullptr, "bmcv_faiss_indexflatIP not support, please update SDK version");
+    // 读取文件数据到数组，二进制底库直接从mmap复制
+    std::vector<float> db_vec(0);
+    if (MappedVectorDb::isBinary(db_data_path)) {
+      MappedVectorDb db;
+      if (!db.open(db_data_path)) {
+        errorCode = common::ErrorCode::PARAMETER_ERROR;
+        break;
+      }
+      vec_dims = db.dim();
+      db_vec.assign(db.vectors(), db.vectors() + db.count() * db.dim());
+      mRowIds.assign(db.ids(), db.ids() + db.count());
+    } else if (!loadTextVectorDb(db_data_path, db_vec, vec_dims)) {
+      errorCode = common::ErrorCode::PARAMETER_ERROR;
+      break;
+    }
+    db_vecs_num = db_vec.size() / vec_dims;
+    errorCode = initTpu(db_vec);
   } while (false);
   return errorCode;
 }
 
-void Faiss::getFaceId(
-    std::shared_ptr<common::RecognizedObjectMetadata> resnetObj) {
-  if (resnetObj != nullptr) {
-    // float *input_data = new float[query_vecs_num * vec_dims];
-    float* input_data = resnetObj->feature_vector.get();
-    // 将 input_data 的值赋给 feature_vector
-    // bm_handle_t handle=obj->mFrame->mHandle;
-   {
-    std::lock_guard<std::mutex> lock(mutex);
-    bm_memcpy_s2d(handle, query_data_dev_mem, input_data);
+common::ErrorCode Faiss::initTpu(const std::vector<float>& db_vec) {
+  db_data = new float[db_vecs_num * vec_dims];
+  output_dis = new float[query_vecs_num * sort_cnt];
+  output_inx = new int[query_vecs_num * sort_cnt];
+  std::memcpy(db_data, db_vec.data(), db_vec.size() * sizeof(float));
+
+  bm_dev_request(&handle, 0);
+  bm_malloc_device_byte(handle, &buffer_dev_mem,
+                        query_vecs_num * db_vecs_num * sizeof(float));
+  bm_malloc_device_byte(handle, &sorted_similarity_dev_mem,
+                        query_vecs_num * sort_cnt * sizeof(float));
+  bm_malloc_device_byte(handle, &sorted_index_dev_mem,
+                        query_vecs_num * sort_cnt * sizeof(int));
+  bm_malloc_device_byte(handle, &query_data_dev_mem,
+                        query_vecs_num * vec_dims * sizeof(float));
+  bm_malloc_device_byte(handle, &db_data_dev_mem,
+                        db_vecs_num * vec_dims * sizeof(float));
+  bm_memcpy_s2d(handle, db_data_dev_mem, db_data);
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode Faiss::initCpu(const std::string& db_data_path,
+                                 const nlohmann::json& configure) {
+  VectorIndexParams params;
+  params.type = configure.value(CONFIG_INTERNAL_INDEX_TYPE_FILED, params.type);
+  params.nlist = configure.value(CONFIG_INTERNAL_NLIST_FILED, params.nlist);
+  params.nprobe = configure.value(CONFIG_INTERNAL_NPROBE_FILED, params.nprobe);
+  params.pqM = configure.value(CONFIG_INTERNAL_PQ_M_FILED, params.pqM);
+  params.hnswM = configure.value(CONFIG_INTERNAL_HNSW_M_FILED, params.hnswM);
+  params.efConstruction = configure.value(
+      CONFIG_INTERNAL_EF_CONSTRUCTION_FILED, params.efConstruction);
+  params.efSearch =
+      configure.value(CONFIG_INTERNAL_EF_SEARCH_FILED, params.efSearch);
+
+  std::shared_ptr<MappedVectorDb> mapped;
+  std::vector<float> vectors;
+  std::vector<std::int64_t> ids;
+  if (MappedVectorDb::isBinary(db_data_path)) {
+    mapped = std::make_shared<MappedVectorDb>();
+    if (!mapped->open(db_data_path)) return common::ErrorCode::PARAMETER_ERROR;
+    vec_dims = mapped->dim();
+    db_vecs_num = mapped->count();
+  } else {
+    if (!loadTextVectorDb(db_data_path, vectors, vec_dims))
+      return common::ErrorCode::PARAMETER_ERROR;
+    db_vecs_num = vectors.size() / vec_dims;
+    ids.resize(db_vecs_num);
+    for (int i = 0; i < db_vecs_num; ++i) ids[i] = i;
+  }
+
+  params.dim = vec_dims;
+  mIndex = VectorIndex::create(params);
+  if (mIndex == nullptr) {
+    IVS_ERROR("Unknown faiss index type: {0}", params.type);
+    return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+  FlatIndex* flatIndex = dynamic_cast<FlatIndex*>(mIndex.get());
+  if (mapped && flatIndex != nullptr) {
+    // 暴力检索直接使用mmap的底库
+    flatIndex->attach(mapped);
+  } else {
+    const float* data = mapped ? mapped->vectors() : vectors.data();
+    const std::int64_t* dataIds = mapped ? mapped->ids() : ids.data();
+    // ivf/ivf_pq在向量足够时用整个底库训练，不足时暂存并暴力检索
+    mIndex->add(data, dataIds, db_vecs_num);
+  }
+  IVS_INFO("Faiss cpu index ready, type: {0}, dim: {1}, size: {2}",
+           params.type, vec_dims, mIndex->size());
+  return common::ErrorCode::SUCCESS;
+}
+
+void Faiss::searchTpu(const float* queries, int num, int* labels) {
+  // 设备上的查询与结果缓冲只有一份
+  std::lock_guard<std::mutex> lock(mutex);
+  for (int begin = 0; begin < num; begin += query_vecs_num) {
+    int batch = std::min(query_vecs_num, num - begin);
+    bm_memcpy_s2d_partial(handle, query_data_dev_mem,
+                          const_cast<float*>(queries + begin * vec_dims),
+                          batch * vec_dims * sizeof(float));
     bmcv_faiss_indexflatIP(handle, query_data_dev_mem, db_data_dev_mem,
                            buffer_dev_mem, sorted_similarity_dev_mem,
-                           sorted_index_dev_mem, vec_dims, query_vecs_num,
+                           sorted_index_dev_mem, vec_dims, batch,
                            db_vecs_num, sort_cnt, is_transpose, input_dtype,
                            output_dtype);
+    bm_memcpy_d2s_partial(handle, output_inx, sorted_index_dev_mem,
+                          batch * sort_cnt * sizeof(int));
+    for (int i = 0; i < batch; ++i) {
+      int row = output_inx[i * sort_cnt];
+      labels[begin + i] = mRowIds.empty() ? row : mRowIds[row];
+    }
+  }
+}
 
-    bm_memcpy_d2s(handle, output_dis, sorted_similarity_dev_mem);
-    bm_memcpy_d2s(handle, output_inx, sorted_index_dev_mem);
-   }
-    int label_index = output_inx[0];
-    resnetObj->mLabelName = mClassNames[label_index];
-    resnetObj->mTopKLabels.push_back(output_inx[0]);
+void Faiss::getFaceIds(
+    const std::vector<std::shared_ptr<common::RecognizedObjectMetadata>>&
+        resnetObjs) {
+  std::vector<std::shared_ptr<common::RecognizedObjectMetadata>> faces;
+  std::vector<float> queries;
+  for (auto& resnetObj : resnetObjs) {
+    if (resnetObj == nullptr || resnetObj->feature_vector == nullptr) continue;
+    float* input_data = resnetObj->feature_vector.get();
+    queries.insert(queries.end(), input_data, input_data + vec_dims);
+    faces.push_back(resnetObj);
+  }
+  if (faces.empty()) return;
+
+  std::vector<int> labels(faces.size(), -1);
+  if (mIndex) {
+    std::vector<float> scores(faces.size());
+    std::vector<std::int64_t> ids(faces.size());
+    mIndex->search(queries.data(), faces.size(), 1, scores.data(), ids.data());
+    for (int i = 0; i < faces.size(); ++i) labels[i] = ids[i];
+  } else {
+    searchTpu(queries.data(), faces.size(), labels.data());
+  }
+
+  for (int i = 0; i < faces.size(); ++i) {
+    int label_index = labels[i];
+    if (label_index < 0 || label_index >= mClassNames.size()) continue;
+    faces[i]->mLabelName = mClassNames[label_index];
+    faces[i]->mTopKLabels.push_back(label_index);
   }
 }
 
@@ -153,10 +246,8 @@ common::ErrorCode Faiss::doWork(int dataPipeId) {
   int subId = 0;
   // 从resnet取出一个objectMetadata
   // 从data里面取人脸，对一个个人脸做处理，首先需要取出
-  for (auto resnetObj : objectMetadata->mRecognizedObjectMetadatas) {
-    // mRecognizedObjectMetadatas是一个数组，每个数组包含人脸的框、特征等等,需要做的只是提取特征，填充label
-    Faiss::getFaceId(resnetObj);
-  }
+  // mRecognizedObjectMetadatas是一个数组，每个数组包含人脸的框、特征等等,需要做的只是提取特征，填充label
+  getFaceIds(objectMetadata->mRecognizedObjectMetadatas);
 
   int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
   int outDataPipeId =
@@ -0,0 +1,907 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "vector_index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <sstream>
+
+#include "common/logger.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STREAM_VECTOR_INDEX_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define STREAM_VECTOR_INDEX_NEON 1
+#endif
+
+namespace sophon_stream {
+namespace element {
+namespace faiss {
+
+namespace {
+
+struct VectorDbHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t dim;
+  std::uint32_t reserved;
+  std::uint64_t count;
+};
+
+float innerProductScalar(const float* a, const float* b, int dim) {
+  float sum = 0.f;
+  for (int i = 0; i < dim; ++i) sum += a[i] * b[i];
+  return sum;
+}
+
+#ifdef STREAM_VECTOR_INDEX_X86
+__attribute__((target("avx512f"))) float innerProductAvx512(const float* a,
+                                                            const float* b,
+                                                            int dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  int i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i),
+                           acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16),
+                           _mm512_loadu_ps(b + i + 16), acc1);
+  }
+  for (; i + 16 <= dim; i += 16)
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i),
+                           acc0);
+  float sum = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+  return sum + innerProductScalar(a + i, b + i, dim - i);
+}
+
+__attribute__((target("avx2,fma"))) float innerProductAvx2(const float* a,
+                                                           const float* b,
+                                                           int dim) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  int i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                           acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),
+                           _mm256_loadu_ps(b + i + 8), acc1);
+  }
+  for (; i + 8 <= dim; i += 8)
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                           acc0);
+  __m256 acc = _mm256_add_ps(acc0, acc1);
+  __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(acc),
+                           _mm256_extractf128_ps(acc, 1));
+  sum4 = _mm_hadd_ps(sum4, sum4);
+  sum4 = _mm_hadd_ps(sum4, sum4);
+  return _mm_cvtss_f32(sum4) + innerProductScalar(a + i, b + i, dim - i);
+}
+#endif
+
+#ifdef STREAM_VECTOR_INDEX_NEON
+float innerProductNeon(const float* a, const float* b, int dim) {
+  float32x4_t acc0 = vdupq_n_f32(0.f);
+  float32x4_t acc1 = vdupq_n_f32(0.f);
+  int i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+  }
+  for (; i + 4 <= dim; i += 4)
+    acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+  return vaddvq_f32(vaddq_f32(acc0, acc1)) +
+         innerProductScalar(a + i, b + i, dim - i);
+}
+#endif
+
+using InnerProductFunc = float (*)(const float*, const float*, int);
+
+InnerProductFunc selectInnerProduct() {
+#if defined(STREAM_VECTOR_INDEX_X86)
+  if (__builtin_cpu_supports("avx512f")) return innerProductAvx512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return innerProductAvx2;
+#elif defined(STREAM_VECTOR_INDEX_NEON)
+  return innerProductNeon;
+#endif
+  return innerProductScalar;
+}
+
+const InnerProductFunc gInnerProduct = selectInnerProduct();
+
+float squaredDistance(const float* a, const float* b, int dim) {
+  float sum = 0.f;
+  for (int i = 0; i < dim; ++i) {
+    float d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+/**
+ * @brief 保留内积最大的k个结果，堆顶为当前第k大
+ */
+class TopK {
+ public:
+  explicit TopK(int k) : mK(k) { mHeap.reserve(k); }
+
+  void push(float score, std::int64_t id) {
+    if (mHeap.size() < static_cast<std::size_t>(mK)) {
+      mHeap.emplace_back(score, id);
+      std::push_heap(mHeap.begin(), mHeap.end(), std::greater<Item>());
+    } else if (score > mHeap.front().first) {
+      std::pop_heap(mHeap.begin(), mHeap.end(), std::greater<Item>());
+      mHeap.back() = Item(score, id);
+      std::push_heap(mHeap.begin(), mHeap.end(), std::greater<Item>());
+    }
+  }
+
+  void output(float* scores, std::int64_t* ids) {
+    std::sort_heap(mHeap.begin(), mHeap.end(), std::greater<Item>());
+    for (int i = 0; i < mK; ++i) {
+      if (i < mHeap.size()) {
+        scores[i] = mHeap[i].first;
+        ids[i] = mHeap[i].second;
+      } else {
+        scores[i] = -std::numeric_limits<float>::max();
+        ids[i] = -1;
+      }
+    }
+  }
+
+ private:
+  using Item = std::pair<float, std::int64_t>;
+  int mK;
+  std::vector<Item> mHeap;
+};
+
+}  // namespace
+
+float innerProduct(const float* a, const float* b, int dim) {
+  return gInnerProduct(a, b, dim);
+}
+
+MappedVectorDb::~MappedVectorDb() {
+  if (mAddr != nullptr) munmap(mAddr, mLength);
+}
+
+bool MappedVectorDb::isBinary(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  std::uint32_t magic = 0;
+  file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+  return file && magic == VectorDbFormat::MAGIC;
+}
+
+bool MappedVectorDb::open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    IVS_ERROR("Open vector db {0} fail", path);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < sizeof(VectorDbHeader)) {
+    IVS_ERROR("Vector db {0} is too small", path);
+    ::close(fd);
+    return false;
+  }
+  mLength = st.st_size;
+  mAddr = mmap(nullptr, mLength, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mAddr == MAP_FAILED) {
+    mAddr = nullptr;
+    IVS_ERROR("Mmap vector db {0} fail", path);
+    return false;
+  }
+
+  VectorDbHeader header;
+  std::memcpy(&header, mAddr, sizeof(header));
+  std::size_t expected = sizeof(VectorDbHeader) +
+                         header.count * sizeof(std::int64_t) +
+                         header.count * header.dim * sizeof(float);
+  if (header.magic != VectorDbFormat::MAGIC ||
+      header.version != VectorDbFormat::VERSION || header.dim == 0 ||
+      mLength < expected) {
+    IVS_ERROR("Invalid vector db {0}", path);
+    munmap(mAddr, mLength);
+    mAddr = nullptr;
+    return false;
+  }
+  mDim = header.dim;
+  mCount = header.count;
+  const char* base = static_cast<const char*>(mAddr);
+  mIds = reinterpret_cast<const std::int64_t*>(base + sizeof(VectorDbHeader));
+  mVectors = reinterpret_cast<const float*>(base + sizeof(VectorDbHeader) +
+                                            mCount * sizeof(std::int64_t));
+  return true;
+}
+
+bool loadTextVectorDb(const std::string& path, std::vector<float>& vectors,
+                      int& dim) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    IVS_ERROR("Open vector db {0} fail", path);
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  std::string content = buffer.str();
+
+  vectors.clear();
+  dim = 0;
+  std::size_t row = 0;
+  const char* p = content.c_str();
+  while (*p != '\0') {
+    // 逐行用strtof解析，比stringstream快一个数量级
+    const char* lineEnd = std::strchr(p, '\n');
+    if (lineEnd == nullptr) lineEnd = p + std::strlen(p);
+    int cols = 0;
+    char* next = nullptr;
+    while (p < lineEnd) {
+      float val = std::strtof(p, &next);
+      if (next == p || next > lineEnd) break;
+      vectors.push_back(val);
+      ++cols;
+      p = next;
+    }
+    if (cols > 0) {
+      if (dim == 0) dim = cols;
+      if (cols != dim) {
+        IVS_ERROR("Vector db {0} line {1} has {2} values, expect {3}", path,
+                  row, cols, dim);
+        return false;
+      }
+      ++row;
+    }
+    p = *lineEnd == '\0' ? lineEnd : lineEnd + 1;
+  }
+  return dim > 0;
+}
+
+bool saveVectorDb(const std::string& path, const float* vectors,
+                  const std::int64_t* ids, std::size_t count, int dim) {
+  std::string tmpPath = path + ".tmp";
+  std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+  if (file == nullptr) {
+    IVS_ERROR("Open vector db {0} fail", tmpPath);
+    return false;
+  }
+  VectorDbHeader header = {VectorDbFormat::MAGIC, VectorDbFormat::VERSION,
+                           static_cast<std::uint32_t>(dim), 0, count};
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+            std::fwrite(ids, sizeof(std::int64_t), count, file) == count &&
+            std::fwrite(vectors, sizeof(float) * dim, count, file) == count;
+  ok = std::fclose(file) == 0 && ok;
+  // 写完后再替换，避免读到写了一半的文件
+  if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    IVS_ERROR("Write vector db {0} fail", path);
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool VectorIndex::train(const float* vectors, std::size_t n) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  return trainImpl(vectors, n);
+}
+
+void VectorIndex::add(const float* vectors, const std::int64_t* ids,
+                      std::size_t n) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  addImpl(vectors, ids, n);
+}
+
+bool VectorIndex::remove(std::int64_t id) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  return removeImpl(id);
+}
+
+void VectorIndex::search(const float* queries, std::size_t nq, int k,
+                         float* scores, std::int64_t* ids) const {
+  if (nq == 0 || k <= 0) return;
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  searchImpl(queries, nq, k, scores, ids);
+}
+
+std::unique_ptr<VectorIndex> VectorIndex::create(
+    const VectorIndexParams& params) {
+  if (params.dim <= 0) return nullptr;
+  if (params.type == "flat")
+    return std::unique_ptr<VectorIndex>(new FlatIndex(params.dim));
+  if (params.type == "ivf")
+    return std::unique_ptr<VectorIndex>(
+        new IvfIndex(params.dim, params.nlist, params.nprobe, 0));
+  if (params.type == "ivf_pq")
+    return std::unique_ptr<VectorIndex>(
+        new IvfIndex(params.dim, params.nlist, params.nprobe, params.pqM));
+  if (params.type == "hnsw")
+    return std::unique_ptr<VectorIndex>(new HnswIndex(
+        params.dim, params.hnswM, params.efConstruction, params.efSearch));
+  return nullptr;
+}
+
+bool FlatIndex::attach(std::shared_ptr<MappedVectorDb> db) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  if (!mIds.empty() || db == nullptr || db->dim() != mDim) return false;
+  mMapped = db;
+  mData = db->vectors();
+  mIds.assign(db->ids(), db->ids() + db->count());
+  mRows.reserve(mIds.size());
+  for (std::size_t row = 0; row < mIds.size(); ++row) mRows[mIds[row]] = row;
+  return true;
+}
+
+void FlatIndex::ensureOwned() {
+  if (!mMapped) return;
+  mOwned.assign(mData, mData + mIds.size() * mDim);
+  mData = mOwned.data();
+  mMapped.reset();
+}
+
+void FlatIndex::addImpl(const float* vectors, const std::int64_t* ids,
+                        std::size_t n) {
+  ensureOwned();
+  for (std::size_t i = 0; i < n; ++i) {
+    const float* vector = vectors + i * mDim;
+    auto it = mRows.find(ids[i]);
+    if (it != mRows.end()) {
+      std::copy(vector, vector + mDim, mOwned.begin() + it->second * mDim);
+      continue;
+    }
+    mRows[ids[i]] = mIds.size();
+    mIds.push_back(ids[i]);
+    mOwned.insert(mOwned.end(), vector, vector + mDim);
+  }
+  mData = mOwned.data();
+}
+
+bool FlatIndex::removeImpl(std::int64_t id) {
+  auto it = mRows.find(id);
+  if (it == mRows.end()) return false;
+  ensureOwned();
+  std::size_t row = it->second;
+  std::size_t last = mIds.size() - 1;
+  mRows.erase(it);
+  // 用最后一行填补删除的行
+  if (row != last) {
+    std::copy(mOwned.begin() + last * mDim, mOwned.begin() + (last + 1) * mDim,
+              mOwned.begin() + row * mDim);
+    mIds[row] = mIds[last];
+    mRows[mIds[row]] = row;
+  }
+  mIds.pop_back();
+  mOwned.resize(last * mDim);
+  mData = mOwned.data();
+  return true;
+}
+
+void FlatIndex::searchImpl(const float* queries, std::size_t nq, int k,
+                           float* scores, std::int64_t* ids) const {
+  std::vector<TopK> heaps(nq, TopK(k));
+  std::size_t rows = mIds.size();
+  // 按行分块，一块底库在缓存中时计算所有查询向量
+  for (std::size_t begin = 0; begin < rows; begin += ROW_BLOCK) {
+    std::size_t end = std::min(rows, begin + ROW_BLOCK);
+    for (std::size_t q = 0; q < nq; ++q) {
+      const float* query = queries + q * mDim;
+      for (std::size_t row = begin; row < end; ++row)
+        heaps[q].push(gInnerProduct(query, mData + row * mDim, mDim),
+                      mIds[row]);
+    }
+  }
+  for (std::size_t q = 0; q < nq; ++q)
+    heaps[q].output(scores + q * k, ids + q * k);
+}
+
+IvfIndex::IvfIndex(int dim, int nlist, int nprobe, int pqM)
+    : VectorIndex(dim),
+      mNlist(std::max(1, nlist)),
+      mNprobe(std::max(1, nprobe)),
+      mPqM(std::max(0, pqM)) {
+  if (mPqM > 0) {
+    // 段数必须整除维度，取不大于pqM的最大约数
+    while (mDim % mPqM != 0) --mPqM;
+    if (mPqM != pqM)
+      IVS_WARN("pq_m {0} does not divide dim {1}, use {2}", pqM, mDim, mPqM);
+    mDsub = mDim / mPqM;
+  }
+}
+
+void IvfIndex::kmeans(const float* points, std::size_t n, int dim, int k,
+                      bool spherical, std::vector<float>& centroids) {
+  centroids.assign(static_cast<std::size_t>(k) * dim, 0.f);
+  for (int c = 0; c < k; ++c)
+    std::copy(points + (c * n / k) * dim, points + (c * n / k + 1) * dim,
+              centroids.begin() + c * dim);
+
+  std::vector<int> assignment(n, 0);
+  std::vector<float> sums(centroids.size());
+  std::vector<std::size_t> counts(k);
+  for (int iter = 0; iter <= KMEANS_ITERATIONS; ++iter) {
+    if (spherical) {
+      for (int c = 0; c < k; ++c) {
+        float* centroid = centroids.data() + c * dim;
+        float norm = std::sqrt(gInnerProduct(centroid, centroid, dim));
+        if (norm > 0)
+          for (int d = 0; d < dim; ++d) centroid[d] /= norm;
+      }
+    }
+    if (iter == KMEANS_ITERATIONS) break;
+    for (std::size_t i = 0; i < n; ++i) {
+      const float* point = points + i * dim;
+      int best = 0;
+      float bestValue = std::numeric_limits<float>::max();
+      for (int c = 0; c < k; ++c) {
+        const float* centroid = centroids.data() + c * dim;
+        float value = spherical ? -gInnerProduct(point, centroid, dim)
+                                : squaredDistance(point, centroid, dim);
+        if (value < bestValue) {
+          bestValue = value;
+          best = c;
+        }
+      }
+      assignment[i] = best;
+    }
+    std::fill(sums.begin(), sums.end(), 0.f);
+    std::fill(counts.begin(), counts.end(), 0);
+    for (std::size_t i = 0; i < n; ++i) {
+      float* sum = sums.data() + assignment[i] * dim;
+      const float* point = points + i * dim;
+      for (int d = 0; d < dim; ++d) sum[d] += point[d];
+      ++counts[assignment[i]];
+    }
+    for (int c = 0; c < k; ++c) {
+      float* centroid = centroids.data() + c * dim;
+      if (counts[c] == 0) {
+        // 空的聚类重新取一个训练点
+        std::size_t i = (static_cast<std::size_t>(c) * 7919 + iter) % n;
+        std::copy(points + i * dim, points + (i + 1) * dim, centroid);
+        continue;
+      }
+      for (int d = 0; d < dim; ++d)
+        centroid[d] = sums[c * dim + d] / counts[c];
+    }
+  }
+}
+
+std::size_t IvfIndex::minTrainPoints() const {
+  std::size_t points = mNlist;
+  if (mPqM > 0) points = std::max<std::size_t>(points, PQ_CODEBOOK_SIZE);
+  return points;
+}
+
+bool IvfIndex::trainImpl(const float* vectors, std::size_t n) {
+  if (mTrained && !mLocations.empty()) {
+    // pq码字无法还原原向量，不能按新的聚类中心重新分配，已有的向量也不能丢弃
+    IVS_WARN("Ivf index already holds {0} vectors, skip training",
+             mLocations.size());
+    return false;
+  }
+  if (n < minTrainPoints()) {
+    IVS_WARN("Ivf index needs {0} training points, got {1}", minTrainPoints(),
+             n);
+    return false;
+  }
+  // 训练点过多时均匀抽样
+  std::size_t trainNum = std::min(
+      n, std::max(static_cast<std::size_t>(mNlist) *
+                      MAX_TRAIN_POINTS_PER_CENTROID,
+                  minTrainPoints()));
+  std::vector<float> train(trainNum * mDim);
+  for (std::size_t i = 0; i < trainNum; ++i) {
+    std::size_t src = i * n / trainNum;
+    std::copy(vectors + src * mDim, vectors + (src + 1) * mDim,
+              train.begin() + i * mDim);
+  }
+  kmeans(train.data(), trainNum, mDim, mNlist, true, mCentroids);
+
+  if (mPqM > 0) {
+    std::size_t pqNum = std::min(trainNum, MAX_PQ_TRAIN_POINTS);
+    mKsub = PQ_CODEBOOK_SIZE;
+    mCodebooks.assign(static_cast<std::size_t>(mPqM) * mKsub * mDsub, 0.f);
+    std::vector<float> residuals(pqNum * mDim);
+    for (std::size_t i = 0; i < pqNum; ++i) {
+      const float* vector = train.data() + (i * trainNum / pqNum) * mDim;
+      const float* centroid = mCentroids.data() + assign(vector) * mDim;
+      for (int d = 0; d < mDim; ++d)
+        residuals[i * mDim + d] = vector[d] - centroid[d];
+    }
+    std::vector<float> sub(pqNum * mDsub);
+    std::vector<float> codebook;
+    for (int m = 0; m < mPqM; ++m) {
+      for (std::size_t i = 0; i < pqNum; ++i)
+        std::copy(residuals.begin() + i * mDim + m * mDsub,
+                  residuals.begin() + i * mDim + (m + 1) * mDsub,
+                  sub.begin() + i * mDsub);
+      kmeans(sub.data(), pqNum, mDsub, mKsub, false, codebook);
+      std::copy(codebook.begin(), codebook.end(),
+                mCodebooks.begin() + m * mKsub * mDsub);
+    }
+  }
+
+  mLists.assign(mNlist, InvertedList());
+  mTrained = true;
+  IVS_INFO("Train ivf index, dim: {0}, nlist: {1}, pq_m: {2}, points: {3}",
+           mDim, mNlist, mPqM, trainNum);
+
+  // 训练前暂存的向量放入倒排表
+  std::vector<float> pendingVectors;
+  std::vector<std::int64_t> pendingIds;
+  pendingVectors.swap(mPendingVectors);
+  pendingIds.swap(mPendingIds);
+  mPendingRows.clear();
+  addTrained(pendingVectors.data(), pendingIds.data(), pendingIds.size());
+  return true;
+}
+
+int IvfIndex::assign(const float* vector) const {
+  int best = 0;
+  float bestScore = -std::numeric_limits<float>::max();
+  for (int c = 0; c < mNlist; ++c) {
+    float score = gInnerProduct(vector, mCentroids.data() + c * mDim, mDim);
+    if (score > bestScore) {
+      bestScore = score;
+      best = c;
+    }
+  }
+  return best;
+}
+
+void IvfIndex::encode(const float* residual, std::uint8_t* code) const {
+  for (int m = 0; m < mPqM; ++m) {
+    const float* sub = residual + m * mDsub;
+    const float* codebook = mCodebooks.data() + m * mKsub * mDsub;
+    int best = 0;
+    float bestDistance = std::numeric_limits<float>::max();
+    for (int j = 0; j < mKsub; ++j) {
+      float distance = squaredDistance(sub, codebook + j * mDsub, mDsub);
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        best = j;
+      }
+    }
+    code[m] = static_cast<std::uint8_t>(best);
+  }
+}
+
+void IvfIndex::addImpl(const float* vectors, const std::int64_t* ids,
+                       std::size_t n) {
+  if (mTrained) {
+    addTrained(vectors, ids, n);
+    return;
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    const float* vector = vectors + i * mDim;
+    auto it = mPendingRows.find(ids[i]);
+    if (it != mPendingRows.end()) {
+      std::copy(vector, vector + mDim,
+                mPendingVectors.begin() + it->second * mDim);
+      continue;
+    }
+    mPendingRows[ids[i]] = mPendingIds.size();
+    mPendingIds.push_back(ids[i]);
+    mPendingVectors.insert(mPendingVectors.end(), vector, vector + mDim);
+  }
+  // 攒够训练点后用暂存的向量训练，trainImpl在用完训练点后才清空暂存
+  if (mPendingIds.size() >= minTrainPoints())
+    trainImpl(mPendingVectors.data(), mPendingIds.size());
+}
+
+void IvfIndex::addTrained(const float* vectors, const std::int64_t* ids,
+                          std::size_t n) {
+  std::vector<float> residual(mDim);
+  std::vector<std::uint8_t> code(mPqM);
+  for (std::size_t i = 0; i < n; ++i) {
+    const float* vector = vectors + i * mDim;
+    removeImpl(ids[i]);
+    int list = assign(vector);
+    InvertedList& invertedList = mLists[list];
+    mLocations[ids[i]] = {list, invertedList.mIds.size()};
+    invertedList.mIds.push_back(ids[i]);
+    if (mPqM > 0) {
+      const float* centroid = mCentroids.data() + list * mDim;
+      for (int d = 0; d < mDim; ++d) residual[d] = vector[d] - centroid[d];
+      encode(residual.data(), code.data());
+      invertedList.mCodes.insert(invertedList.mCodes.end(), code.begin(),
+                                 code.end());
+    } else {
+      invertedList.mVectors.insert(invertedList.mVectors.end(), vector,
+                                   vector + mDim);
+    }
+  }
+}
+
+bool IvfIndex::removePending(std::int64_t id) {
+  auto it = mPendingRows.find(id);
+  if (it == mPendingRows.end()) return false;
+  std::size_t row = it->second;
+  std::size_t last = mPendingIds.size() - 1;
+  mPendingRows.erase(it);
+  if (row != last) {
+    std::copy(mPendingVectors.begin() + last * mDim,
+              mPendingVectors.begin() + (last + 1) * mDim,
+              mPendingVectors.begin() + row * mDim);
+    mPendingIds[row] = mPendingIds[last];
+    mPendingRows[mPendingIds[row]] = row;
+  }
+  mPendingIds.pop_back();
+  mPendingVectors.resize(last * mDim);
+  return true;
+}
+
+bool IvfIndex::removeImpl(std::int64_t id) {
+  if (!mTrained) return removePending(id);
+  auto it = mLocations.find(id);
+  if (it == mLocations.end()) return false;
+  InvertedList& list = mLists[it->second.first];
+  std::size_t pos = it->second.second;
+  std::size_t last = list.mIds.size() - 1;
+  mLocations.erase(it);
+  if (pos != last) {
+    list.mIds[pos] = list.mIds[last];
+    mLocations[list.mIds[pos]].second = pos;
+    if (mPqM > 0)
+      std::copy(list.mCodes.begin() + last * mPqM,
+                list.mCodes.begin() + (last + 1) * mPqM,
+                list.mCodes.begin() + pos * mPqM);
+    else
+      std::copy(list.mVectors.begin() + last * mDim,
+                list.mVectors.begin() + (last + 1) * mDim,
+                list.mVectors.begin() + pos * mDim);
+  }
+  list.mIds.pop_back();
+  if (mPqM > 0)
+    list.mCodes.resize(last * mPqM);
+  else
+    list.mVectors.resize(last * mDim);
+  return true;
+}
+
+void IvfIndex::searchImpl(const float* queries, std::size_t nq, int k,
+                          float* scores, std::int64_t* ids) const {
+  int nprobe = std::min(mNprobe, mNlist);
+  std::vector<std::pair<float, int>> coarse(mTrained ? mNlist : 0);
+  std::vector<float> table(static_cast<std::size_t>(mPqM) * mKsub);
+  for (std::size_t q = 0; q < nq; ++q) {
+    const float* query = queries + q * mDim;
+    TopK heap(k);
+    // 未训练时暴力检索暂存的向量
+    for (std::size_t row = 0; row < mPendingIds.size(); ++row)
+      heap.push(gInnerProduct(query, mPendingVectors.data() + row * mDim, mDim),
+                mPendingIds[row]);
+    if (mTrained) {
+      for (int c = 0; c < mNlist; ++c)
+        coarse[c] = {gInnerProduct(query, mCentroids.data() + c * mDim, mDim),
+                     c};
+      std::partial_sort(coarse.begin(), coarse.begin() + nprobe, coarse.end(),
+                        std::greater<std::pair<float, int>>());
+      // 每个查询向量只算一次各段与码字的内积表
+      for (int m = 0; m < mPqM; ++m)
+        for (int j = 0; j < mKsub; ++j)
+          table[m * mKsub + j] =
+              gInnerProduct(query + m * mDsub,
+                            mCodebooks.data() + (m * mKsub + j) * mDsub, mDsub);
+    }
+    for (int p = 0; p < nprobe && mTrained; ++p) {
+      const InvertedList& list = mLists[coarse[p].second];
+      float base = coarse[p].first;
+      for (std::size_t i = 0; i < list.mIds.size(); ++i) {
+        float score;
+        if (mPqM > 0) {
+          const std::uint8_t* code = list.mCodes.data() + i * mPqM;
+          score = base;
+          for (int m = 0; m < mPqM; ++m) score += table[m * mKsub + code[m]];
+        } else {
+          score = gInnerProduct(query, list.mVectors.data() + i * mDim, mDim);
+        }
+        heap.push(score, list.mIds[i]);
+      }
+    }
+    heap.output(scores + q * k, ids + q * k);
+  }
+}
+
+HnswIndex::HnswIndex(int dim, int m, int efConstruction, int efSearch)
+    : VectorIndex(dim),
+      mM(std::max(2, m)),
+      mEfConstruction(std::max(1, efConstruction)),
+      mEfSearch(std::max(1, efSearch)) {
+  mLevelMult = 1.0 / std::log(static_cast<double>(mM));
+}
+
+int HnswIndex::randomLevel() {
+  // splitmix64
+  std::uint64_t z = (mRandomState += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  z ^= z >> 31;
+  double uniform = ((z >> 11) + 0.5) / 9007199254740992.0;
+  return static_cast<int>(-std::log(uniform) * mLevelMult);
+}
+
+std::vector<int>& HnswIndex::neighbors(int node, int level) {
+  return mLinks[node][level];
+}
+
+const std::vector<int>& HnswIndex::neighbors(int node, int level) const {
+  return mLinks[node][level];
+}
+
+float HnswIndex::similarity(const float* query, int node) const {
+  return gInnerProduct(query, mVectors.data() + node * mDim, mDim);
+}
+
+int HnswIndex::greedySearch(const float* query, int entry, int fromLevel,
+                            int toLevel) const {
+  int current = entry;
+  float currentSimilarity = similarity(query, current);
+  for (int level = fromLevel; level >= toLevel; --level) {
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int neighbor : neighbors(current, level)) {
+        float s = similarity(query, neighbor);
+        if (s > currentSimilarity) {
+          currentSimilarity = s;
+          current = neighbor;
+          changed = true;
+        }
+      }
+    }
+  }
+  return current;
+}
+
+std::vector<HnswIndex::Candidate> HnswIndex::searchLayer(const float* query,
+                                                         int entry, int ef,
+                                                         int level) const {
+  // 每个线程一份访问标记，用递增的tag代替清空
+  thread_local std::vector<std::uint32_t> visited;
+  thread_local std::uint32_t tag = 0;
+  if (visited.size() < mIds.size()) visited.resize(mIds.size(), 0);
+  if (++tag == 0) {
+    std::fill(visited.begin(), visited.end(), 0);
+    tag = 1;
+  }
+
+  std::priority_queue<Candidate> candidates;
+  std::priority_queue<Candidate, std::vector<Candidate>,
+                      std::greater<Candidate>>
+      results;
+  float s = similarity(query, entry);
+  candidates.emplace(s, entry);
+  results.emplace(s, entry);
+  visited[entry] = tag;
+  while (!candidates.empty()) {
+    Candidate current = candidates.top();
+    if (results.size() >= ef && current.first < results.top().first) break;
+    candidates.pop();
+    for (int neighbor : neighbors(current.second, level)) {
+      if (visited[neighbor] == tag) continue;
+      visited[neighbor] = tag;
+      float ns = similarity(query, neighbor);
+      if (results.size() < ef || ns > results.top().first) {
+        candidates.emplace(ns, neighbor);
+        results.emplace(ns, neighbor);
+        if (results.size() > ef) results.pop();
+      }
+    }
+  }
+
+  std::vector<Candidate> sorted;
+  sorted.reserve(results.size());
+  while (!results.empty()) {
+    sorted.push_back(results.top());
+    results.pop();
+  }
+  std::reverse(sorted.begin(), sorted.end());
+  return sorted;
+}
+
+void HnswIndex::insert(const float* vector, std::int64_t id) {
+  int node = mIds.size();
+  int nodeLevel = randomLevel();
+  mVectors.insert(mVectors.end(), vector, vector + mDim);
+  mIds.push_back(id);
+  mDeleted.push_back(0);
+  mLinks.emplace_back(nodeLevel + 1);
+  mNodeOfId[id] = node;
+  if (mEntry < 0) {
+    mEntry = node;
+    mMaxLevel = nodeLevel;
+    return;
+  }
+
+  const float* query = mVectors.data() + node * mDim;
+  int entry = mEntry;
+  if (mMaxLevel > nodeLevel)
+    entry = greedySearch(query, mEntry, mMaxLevel, nodeLevel + 1);
+  for (int level = std::min(nodeLevel, mMaxLevel); level >= 0; --level) {
+    std::vector<Candidate> candidates =
+        searchLayer(query, entry, mEfConstruction, level);
+    int maxLinks = maxNeighbors(level);
+    std::vector<int>& links = neighbors(node, level);
+    for (int i = 0; i < candidates.size() && links.size() < mM; ++i)
+      links.push_back(candidates[i].second);
+    for (int neighbor : links) {
+      std::vector<int>& reverse = neighbors(neighbor, level);
+      reverse.push_back(node);
+      if (reverse.size() <= maxLinks) continue;
+      // 超出上限时保留与neighbor最相似的maxLinks个
+      const float* base = mVectors.data() + neighbor * mDim;
+      std::vector<Candidate> scored;
+      scored.reserve(reverse.size());
+      for (int other : reverse)
+        scored.emplace_back(similarity(base, other), other);
+      std::partial_sort(scored.begin(), scored.begin() + maxLinks,
+                        scored.end(), std::greater<Candidate>());
+      reverse.resize(maxLinks);
+      for (int i = 0; i < maxLinks; ++i) reverse[i] = scored[i].second;
+    }
+    entry = candidates.front().second;
+  }
+  if (nodeLevel > mMaxLevel) {
+    mMaxLevel = nodeLevel;
+    mEntry = node;
+  }
+}
+
+void HnswIndex::addImpl(const float* vectors, const std::int64_t* ids,
+                        std::size_t n) {
+  mVectors.reserve(mVectors.size() + n * mDim);
+  for (std::size_t i = 0; i < n; ++i) {
+    removeImpl(ids[i]);
+    insert(vectors + i * mDim, ids[i]);
+  }
+}
+
+bool HnswIndex::removeImpl(std::int64_t id) {
+  auto it = mNodeOfId.find(id);
+  if (it == mNodeOfId.end()) return false;
+  mDeleted[it->second] = 1;
+  mNodeOfId.erase(it);
+  return true;
+}
+
+void HnswIndex::searchImpl(const float* queries, std::size_t nq, int k,
+                           float* scores, std::int64_t* ids) const {
+  for (std::size_t q = 0; q < nq; ++q) {
+    const float* query = queries + q * mDim;
+    TopK heap(k);
+    if (mEntry >= 0) {
+      int entry = greedySearch(query, mEntry, mMaxLevel, 1);
+      for (const Candidate& candidate :
+           searchLayer(query, entry, std::max(mEfSearch, k), 0)) {
+        if (!mDeleted[candidate.second])
+          heap.push(candidate.first, mIds[candidate.second]);
+      }
+    }
+    heap.output(scores + q * k, ids + q * k);
+  }
+}
+
+}  // namespace faiss
+}  // namespace element
+}  // namespace sophon_stream
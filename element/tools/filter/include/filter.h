@@ -20,19 +20,80 @@
 namespace sophon_stream {
 namespace element {
 namespace filter {
+/**
+ * @brief 区域的网格索引，初始化时把多边形的外接矩形划分为网格，
+ * 每个格子标记为完全在区域内、完全在区域外或与边界相交。
+ * 查询时用前缀和统计检测框覆盖的格子，只有覆盖边界格子时才做精确的几何判断。
+ */
+struct ZoneGrid {
+  int mMinX = 0;
+  int mMinY = 0;
+  int mMaxX = -1;
+  int mMaxY = -1;
+  int mCellSize = 0;
+  int mGridWidth = 0;
+  int mGridHeight = 0;
+  // (mGridWidth + 1) * (mGridHeight + 1)的二维前缀和
+  std::vector<int> mOutsideSum;
+  std::vector<int> mBoundarySum;
+
+  bool empty() const { return mCellSize == 0; }
+};
+
 struct Area {
   std::vector<common::Point<int>> points;
+  ZoneGrid grid;
+};
+
+/**
+ * @brief 按key(trackId或识别结果)统计连续出现的次数。
+ * 以key排序的vector存储，每次update后删除本次未出现的key，不做整表重建。
+ */
+class DwellCounter {
+ public:
+  /**
+   * @brief 开始新的一次统计，之后对本次出现的每个key调用touch
+   */
+  void begin() { ++mSeq; }
+  /**
+   * @brief 记录key在本次出现，返回连续出现的次数
+   */
+  int touch(std::int64_t key);
+  /**
+   * @brief 删除本次未出现的key
+   */
+  void end();
+
+ private:
+  struct Entry {
+    std::int64_t mKey;
+    int mCount;
+    std::uint64_t mSeq;
+  };
+  std::vector<Entry> mEntries;
+  std::uint64_t mSeq = 0;
 };
+
 class Filter_Imp {
  public:
   Filter_Imp(){};
-  bool isInDirection(std::shared_ptr<common::ObjectMetadata> objectMetadata);
-  bool isInPolygon(std::shared_ptr<common::ObjectMetadata> objectMetadata);
-  bool isinclasses(std::shared_ptr<common::ObjectMetadata> objectMetadata);
-  bool isOutsideWorkingHours(
-      std::shared_ptr<common::ObjectMetadata> objectMetadata);
+  bool isInWorkingHours(std::int64_t timestamp) const;
+  bool isInClasses(int classify) const;
+  /**
+   * @brief 返回第一个包含检测框的区域下标，没有时返回-1
+   */
+  int matchArea(const common::Rectangle<int>& box) const;
+  /**
+   * @brief 以indexes中的检测结果更新运动方向，返回是否有目标的方向满足要求
+   */
+  bool isInDirection(std::shared_ptr<common::ObjectMetadata> objectMetadata,
+                     const std::vector<int>& indexes);
+  /**
+   * @brief 以indexes中的检测结果更新该路共用的连续出现计数，
+   * 有需要上报的目标时indexes中只保留这些检测结果
+   */
   bool istrack(std::shared_ptr<common::ObjectMetadata> objectMetadata,
-               std::unordered_map<std::string, int>& continue_frame_num_);
+               DwellCounter& dwellCounter, std::vector<int>& indexes);
   void push_class(int Class) { classes.push_back(Class); };
   void set_alert_first_frames(int alert_first_frames_) {
     alert_first_frames = alert_first_frames_;
@@ -41,11 +102,18 @@ class Filter_Imp {
     alert_frame_skip_nums = alert_frame_skip_nums_;
   };
   void push_time(std::pair<int64_t, int64_t> time) { times.push_back(time); };
-  void push_area(Area area) { areas.push_back(area); };
+  void push_area(Area area) {
+    buildZoneGrid(area);
+    areas.push_back(std::move(area));
+  };
+  const std::vector<Area>& get_areas() const { return areas; }
   void set_type(int type_) { type = type_; };
   void set_direction(int x, int y) { direction.mX = x; direction.mY = y; }
   void set_trajectory_interval(int t) { trajectory_interval = t; };
 
+  static constexpr int ZONE_GRID_CELL_SIZE = 16;
+  static constexpr int ZONE_GRID_MAX_CELLS = 1 << 16;
+
  private:
   std::vector<int> classes;
   int alert_first_frames;
@@ -56,22 +124,32 @@ class Filter_Imp {
   common::Point<int> direction; //预设方向，如不设置则不限方向筛选，如设置则只筛选轨迹方向与预设方向夹角<=90°的框
   int trajectory_interval = 5;
   int frame_count = 0;
-  std::unordered_map<std::string, common::Point<int>> trajectories_cnt; // 每个trackId的轨迹数据(当前帧)。
-  std::unordered_map<std::string, common::Point<int>> trajectories_pre; // 每个trackId的轨迹数据(trajectory_interval帧前)。
-  bool onSegment(const common::Point<int>& p, const common::Point<int>& q,
-                 const common::Point<int>& r);
+  std::unordered_map<std::int64_t, common::Point<int>> trajectories_cnt; // 每个trackId的轨迹数据(当前帧)。
+  std::unordered_map<std::int64_t, common::Point<int>> trajectories_pre; // 每个trackId的轨迹数据(trajectory_interval帧前)。
+  void buildZoneGrid(Area& area);
 
-  int orientation(const common::Point<int>& p, const common::Point<int>& q,
-                  const common::Point<int>& r);
+  bool isRectangleInsideArea(int top, int left, int bottom, int right,
+                             const Area& area) const;
 
-  bool doIntersect(const common::Point<int>& p1, const common::Point<int>& q1,
-                   const common::Point<int>& p2, const common::Point<int>& q2);
+  static bool onSegment(const common::Point<int>& p, const common::Point<int>& q,
+                        const common::Point<int>& r);
 
-  bool isPointInsidePolygon(const common::Point<int>& p,
-                            const std::vector<common::Point<int>>& polygon);
+  static int orientation(const common::Point<int>& p,
+                         const common::Point<int>& q,
+                         const common::Point<int>& r);
 
-  bool isRectangleInsidePolygon(std::vector<common::Point<int>>& rectangle,
-                                const std::vector<common::Point<int>>& polygon);
+  static bool doIntersect(const common::Point<int>& p1,
+                          const common::Point<int>& q1,
+                          const common::Point<int>& p2,
+                          const common::Point<int>& q2);
+
+  static bool isPointInsidePolygon(
+      const common::Point<int>& p,
+      const std::vector<common::Point<int>>& polygon);
+
+  static bool isRectangleInsidePolygon(
+      const std::vector<common::Point<int>>& rectangle,
+      const std::vector<common::Point<int>>& polygon);
 };
 class Filter : public ::sophon_stream::framework::Element {
  public:
@@ -81,6 +159,9 @@ class Filter : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  // 只使用检测框与跟踪结果，不读取图像
+  bool needsPixelData() const override { return false; }
+
   static constexpr const char* CONFIG_INTERNAL_RULES_FILED = "rules";
   static constexpr const char* CONFIG_INTERNAL_CHANNEL_ID_FILED = "channel_id";
   static constexpr const char* CONFIG_INTERNAL_FILTERS_FILED = "filters";
@@ -108,8 +189,8 @@ class Filter : public ::sophon_stream::framework::Element {
   std::vector<std::vector<Filter_Imp>> Filter_imps;  // 不同路的不同过滤器
   std::unordered_map<int, int>
       channel_id_indexs;  // 每一路对应的channel_id的index
-  std::vector<std::unordered_map<std::string, int>>
-      continue_frame_num;  // 每一路连续追踪计数，map中key代表追踪的id,value代表追踪帧数
+  std::vector<DwellCounter>
+      dwell_counters;  // 每一路的连续追踪计数，同一路的过滤器共用
   // std::mutex condit_mtx;
 };
 
@@ -9,10 +9,13 @@
 
 #include "filter.h"
 
+#include <algorithm>
+#include <numeric>
+
 namespace sophon_stream {
 namespace element {
 namespace filter {
-Filter::Filter() {}
+Filter::Filter() { mUseDetectionTable = true; }
 Filter::~Filter() {}
 
 common::ErrorCode Filter::initInternal(const std::string& json) {
@@ -144,8 +147,7 @@ common::ErrorCode Filter::initInternal(const std::string& json) {
         Filter_Imp_s.push_back(Filter_Imp_);
       }
       Filter_imps.push_back(Filter_Imp_s);
-      std::unordered_map<std::string, int> continue_frame_num_;
-      continue_frame_num.push_back(continue_frame_num_);
+      dwell_counters.emplace_back();
     }
 
   } while (false);
@@ -206,71 +208,61 @@ common::ErrorCode Filter::doWork(int dataPipeId) {
     return errorCode;
   }
 
-  channel_id_internal = channel_id_indexs[objectMetadata->mFrame->mChannelId];
-  for (int i = 0; i < Filter_imps[channel_id_internal].size(); i++) {
-    bool flag = true;
+  int channelIndex = channel_id_indexs[objectMetadata->mFrame->mChannelId];
+  auto& filters = Filter_imps[channelIndex];
+  const common::DetectionTable& table = objectMetadata->mDetectionTable;
+  int detectionNum = table.size();
+  // 同一路的过滤器按顺序串联，alive为通过了前面所有过滤器的检测框，
+  // 每个过滤器只判断alive中的检测框，最后统一从检测表中删除其余的检测结果
+  std::vector<int> alive(detectionNum);
+  std::iota(alive.begin(), alive.end(), 0);
+  std::vector<int> matched;
+  for (int i = 0; i < filters.size() && !alive.empty(); i++) {
     // 时间规则
-
-    if (objectMetadata->mDetectedObjectMetadatas.size())
-      flag &= Filter_imps[channel_id_internal][i].isOutsideWorkingHours(
-          objectMetadata);
-    if (!flag) continue;
-
-    flag &= Filter_imps[channel_id_internal][i].isinclasses(objectMetadata);
-
-    if (!flag) continue;
-
-    flag &= Filter_imps[channel_id_internal][i].isInPolygon(objectMetadata);
-
-    if (!flag) continue;
-
-    flag &= Filter_imps[channel_id_internal][i].isInDirection(objectMetadata);
-    
-    if (!flag) continue;
-
-    {
-      // std::lock_guard<std::mutex> lock(condit_mtx);
-      std::unordered_map<std::string, int> names;
-
-      if (objectMetadata->mSubObjectMetadatas.size())
-        for (int j = 0; j < objectMetadata->mSubObjectMetadatas.size(); j++) {
-          if (objectMetadata->mSubObjectMetadatas[j]
-                  ->mRecognizedObjectMetadatas.size() == 1) {
-            std::string name = objectMetadata->mSubObjectMetadatas[j]
-                                   ->mRecognizedObjectMetadatas[0]
-                                   ->mLabelName;
-
-            continue_frame_num[channel_id_internal][name]++;
-            names[name] = continue_frame_num[channel_id_internal][name];
-          }
-        }
-      if (objectMetadata->mTrackedObjectMetadatas.size())
-        for (int j = 0; j < objectMetadata->mTrackedObjectMetadatas.size();
-             j++) {
-          std::string name = std::to_string(
-              objectMetadata->mTrackedObjectMetadatas[j]->mTrackId);
-          continue_frame_num[channel_id_internal][name]++;
-          names[name] = continue_frame_num[channel_id_internal][name];
-        }
-
-      continue_frame_num[channel_id_internal].clear();
-      for (auto j : names) {
-        continue_frame_num[channel_id_internal][j.first] = j.second;
-      }
-
-      // continue_frame_num[channel_id_internal]=continue_frame_num_;
-      flag &= Filter_imps[channel_id_internal][i].istrack(
-          objectMetadata, continue_frame_num[channel_id_internal]);
-      if (!flag) continue;
+    if (!filters[i].isInWorkingHours(objectMetadata->mFrame->mTimestamp))
+      continue;
+    // 类别与区域规则，不满足的检测框不再参与后面的过滤器
+    int matchedArea = -1;
+    matched.clear();
+    for (int j : alive) {
+      if (!filters[i].isInClasses(table.mClassId[j])) continue;
+      int areaIndex = filters[i].matchArea(table.box(j));
+      if (areaIndex < 0) continue;
+      matched.push_back(j);
+      if (matchedArea < 0) matchedArea = areaIndex;
     }
+    alive.swap(matched);
+    if (alive.empty()) break;
+
+    if (!filters[i].isInDirection(objectMetadata, alive)) continue;
+    if (!filters[i].istrack(objectMetadata, dwell_counters[channelIndex],
+                            alive))
+      continue;
+    objectMetadata->areas.push_back(
+        filters[i].get_areas()[matchedArea].points);
+    objectMetadata->tag |=
+        1
+        << i;  // 二进制代表，i位是1代表满足第i个筛选器，之后在业务里根据tag判断这个数据是经过几号筛选器过滤的
+  }
 
-    // 区域规则
-    // ... 可以在这里添加区域规则的实现
-    if (flag)
-      objectMetadata->tag |=
-          1
-          << i;  // 二进制代表，i位是1代表满足第i个筛选器，之后在业务里根据tag判断这个数据是经过几号筛选器过滤的
+  std::vector<char> keep(detectionNum, 0);
+  for (int j : alive) keep[j] = 1;
+
+  // 只保留通过了所有过滤器的检测结果，跟踪结果在检测表中一起保留，
+  // 子对象和检测结果一一对应时一起保留
+  bool withSub = objectMetadata->mSubObjectMetadatas.size() == detectionNum;
+  if (withSub) {
+    int kept = 0;
+    for (int j = 0; j < detectionNum; j++) {
+      if (!keep[j]) continue;
+      if (kept != j)
+        objectMetadata->mSubObjectMetadatas[kept] =
+            std::move(objectMetadata->mSubObjectMetadatas[j]);
+      kept++;
+    }
+    objectMetadata->mSubObjectMetadatas.resize(kept);
   }
+  objectMetadata->mDetectionTable.compact(keep);
 
   if (objectMetadata->tag) {
     common::ErrorCode errorCode =
@@ -288,155 +280,159 @@ common::ErrorCode Filter::doWork(int dataPipeId) {
   return common::ErrorCode::SUCCESS;
 }
 
-bool Filter_Imp::isOutsideWorkingHours(
-    std::shared_ptr<common::ObjectMetadata> objectMetadata) {
-  int channel_id = objectMetadata->mFrame->mChannelIdInternal;
+int DwellCounter::touch(std::int64_t key) {
+  auto it = std::lower_bound(
+      mEntries.begin(), mEntries.end(), key,
+      [](const Entry& entry, std::int64_t k) { return entry.mKey < k; });
+  if (it == mEntries.end() || it->mKey != key) {
+    mEntries.insert(it, {key, 1, mSeq});
+    return 1;
+  }
+  // 同一帧中重复出现的key只计一次
+  if (it->mSeq != mSeq) {
+    it->mCount = it->mSeq + 1 == mSeq ? it->mCount + 1 : 1;
+    it->mSeq = mSeq;
+  }
+  return it->mCount;
+}
+
+void DwellCounter::end() {
+  std::uint64_t seq = mSeq;
+  mEntries.erase(
+      std::remove_if(mEntries.begin(), mEntries.end(),
+                     [seq](const Entry& entry) { return entry.mSeq != seq; }),
+      mEntries.end());
+}
 
+bool Filter_Imp::isInWorkingHours(std::int64_t timestamp) const {
+  timestamp %= (1000 * 60 * 60 * 24);
   for (int i = 0; i < times.size(); i++) {
-    std::int64_t timestamp =
-        objectMetadata->mFrame->mTimestamp % ((1000 * 60 * 60 * 24));
-    int channel_id = objectMetadata->mFrame->mChannelIdInternal;
     std::int64_t timestamp_start = times[i].first;
     std::int64_t timestamp_end = times[i].second;
     if (timestamp <= timestamp_end && timestamp >= timestamp_start) return true;
   }
   return false;
 }
-bool Filter_Imp::isinclasses(
-    std::shared_ptr<common::ObjectMetadata> objectMetadata) {
-  int channel_id = objectMetadata->mFrame->mChannelIdInternal;
-  bool flag_tot = false;
-  std::vector<std::shared_ptr<common::DetectedObjectMetadata>>
-      new_mDetectedObjectMetadatas;
-  std::vector<std::shared_ptr<common::ObjectMetadata>> new_mSubObjectMetadatas;
-  std::vector<std::shared_ptr<common::TrackedObjectMetadata>>
-      new_mTrackedObjectMetadatas;
-
-  for (int j = 0; j < objectMetadata->mDetectedObjectMetadatas.size(); j++) {
-    bool flag = false;
-
-    for (int i = 0; i < classes.size(); i++) {
-      int name = objectMetadata->mDetectedObjectMetadatas[j]->mClassify;
-
-      flag |= name == classes[i];
-      if (flag) break;
-    }
-    if (flag) {
-      new_mDetectedObjectMetadatas.push_back(
-          objectMetadata->mDetectedObjectMetadatas[j]);
-      if (type == 0) {
-        new_mSubObjectMetadatas.push_back(
-            objectMetadata->mSubObjectMetadatas[j]);
-
-      } else if (type == 1) {
-        new_mTrackedObjectMetadatas.push_back(
-            objectMetadata->mTrackedObjectMetadatas[j]);
-      }
-    }
 
-    flag_tot |= flag;
+bool Filter_Imp::isInClasses(int classify) const {
+  for (int i = 0; i < classes.size(); i++) {
+    if (classify == classes[i]) return true;
   }
+  return false;
+}
 
-  if (flag_tot) {
-    objectMetadata->mDetectedObjectMetadatas.clear();
-    objectMetadata->mDetectedObjectMetadatas = new_mDetectedObjectMetadatas;
-    if (type == 0) {
-      objectMetadata->mSubObjectMetadatas.clear();
-      objectMetadata->mSubObjectMetadatas = new_mSubObjectMetadatas;
-    } else if (type == 1) {
-      objectMetadata->mTrackedObjectMetadatas.clear();
-      objectMetadata->mTrackedObjectMetadatas = new_mTrackedObjectMetadatas;
-    }
-  }else{
-      objectMetadata->mDetectedObjectMetadatas.clear();
-    if (type == 0) {
-      objectMetadata->mSubObjectMetadatas.clear();
-    } else if (type == 1) {
-      objectMetadata->mTrackedObjectMetadatas.clear();
-    }
+int Filter_Imp::matchArea(const common::Rectangle<int>& box) const {
+  for (int i = 0; i < areas.size(); ++i) {
+    if (isRectangleInsideArea(box.top(), box.left(), box.bottom(),
+                              box.right(), areas[i]))
+      return i;
   }
-
-  return flag_tot;
+  return -1;
 }
 
-bool Filter_Imp::isInPolygon(
-    std::shared_ptr<common::ObjectMetadata> objectMetadata) {
-  int channel_id = objectMetadata->mFrame->mChannelIdInternal;
-  bool flag_tot = false;
-  std::vector<std::shared_ptr<common::DetectedObjectMetadata>>
-      new_mDetectedObjectMetadatas;
-  std::vector<std::shared_ptr<common::ObjectMetadata>> new_mSubObjectMetadatas;
-  std::vector<std::shared_ptr<common::TrackedObjectMetadata>>
-      new_mTrackedObjectMetadatas;
-
-  for (int j = 0; j < objectMetadata->mDetectedObjectMetadatas.size(); j++) {
-    bool flag = false;
-    int top = objectMetadata->mDetectedObjectMetadatas[j]->mBox.top();
-    int bottom = objectMetadata->mDetectedObjectMetadatas[j]->mBox.bottom();
-    int left = objectMetadata->mDetectedObjectMetadatas[j]->mBox.left();
-    int right = objectMetadata->mDetectedObjectMetadatas[j]->mBox.right();
-    std::vector<common::Point<int>> rectangle = {
-        common::Point<int>(top, left), common::Point<int>(top, right),
-        common::Point<int>(bottom, right), common::Point<int>(bottom, left)};
-    for (int i = 0; i < areas.size(); ++i) {
-      flag |= isRectangleInsidePolygon(rectangle, areas[i].points);
-      if (flag) {
-        objectMetadata->areas.push_back(areas[i].points);
-        break;
-      }
-    }     
-    if (flag) {
-      new_mDetectedObjectMetadatas.push_back(
-          objectMetadata->mDetectedObjectMetadatas[j]);
-      if (type == 0) {
-        new_mSubObjectMetadatas.push_back(
-            objectMetadata->mSubObjectMetadatas[j]);
-
-      } else if (type == 1) {
-        new_mTrackedObjectMetadatas.push_back(
-            objectMetadata->mTrackedObjectMetadatas[j]);
-      }
-    }
-
-    flag_tot |= flag;
+void Filter_Imp::buildZoneGrid(Area& area) {
+  const auto& polygon = area.points;
+  // 点和线段的规则判断很快，不建索引
+  if (polygon.size() < 3) return;
+  ZoneGrid& grid = area.grid;
+  grid.mMinX = grid.mMaxX = polygon[0].mX;
+  grid.mMinY = grid.mMaxY = polygon[0].mY;
+  for (const auto& point : polygon) {
+    grid.mMinX = std::min(grid.mMinX, point.mX);
+    grid.mMaxX = std::max(grid.mMaxX, point.mX);
+    grid.mMinY = std::min(grid.mMinY, point.mY);
+    grid.mMaxY = std::max(grid.mMaxY, point.mY);
   }
-  if (flag_tot) {
-    objectMetadata->mDetectedObjectMetadatas.clear();
-    objectMetadata->mDetectedObjectMetadatas = new_mDetectedObjectMetadatas;
-    if (type == 0) {
-      objectMetadata->mSubObjectMetadatas.clear();
-      objectMetadata->mSubObjectMetadatas = new_mSubObjectMetadatas;
-    } else if (type == 1) {
-      objectMetadata->mTrackedObjectMetadatas.clear();
-      objectMetadata->mTrackedObjectMetadatas = new_mTrackedObjectMetadatas;
-    }
-  }else{
-      objectMetadata->mDetectedObjectMetadatas.clear();
-    if (type == 0) {
-      objectMetadata->mSubObjectMetadatas.clear();
-    } else if (type == 1) {
-      objectMetadata->mTrackedObjectMetadatas.clear();
+  int spanX = grid.mMaxX - grid.mMinX;
+  int spanY = grid.mMaxY - grid.mMinY;
+  int cell = ZONE_GRID_CELL_SIZE;
+  while (static_cast<std::int64_t>(spanX / cell + 1) * (spanY / cell + 1) >
+         ZONE_GRID_MAX_CELLS)
+    cell *= 2;
+  grid.mCellSize = cell;
+  grid.mGridWidth = spanX / cell + 1;
+  grid.mGridHeight = spanY / cell + 1;
+  int stride = grid.mGridHeight + 1;
+  grid.mOutsideSum.assign((grid.mGridWidth + 1) * stride, 0);
+  grid.mBoundarySum.assign((grid.mGridWidth + 1) * stride, 0);
+
+  for (int cx = 0; cx < grid.mGridWidth; ++cx) {
+    for (int cy = 0; cy < grid.mGridHeight; ++cy) {
+      int x0 = grid.mMinX + cx * cell, x1 = x0 + cell;
+      int y0 = grid.mMinY + cy * cell, y1 = y0 + cell;
+      std::vector<common::Point<int>> rectangle = {
+          common::Point<int>(x0, y0), common::Point<int>(x0, y1),
+          common::Point<int>(x1, y1), common::Point<int>(x1, y0)};
+      int outside = 0, boundary = 0;
+      if (!isRectangleInsidePolygon(rectangle, polygon)) {
+        // 格子与区域有任何接触即为边界格子，否则完全在区域外
+        bool touch = false;
+        for (const auto& corner : rectangle)
+          touch = touch || isPointInsidePolygon(corner, polygon);
+        for (const auto& point : polygon)
+          touch = touch || (point.mX >= x0 && point.mX <= x1 &&
+                            point.mY >= y0 && point.mY <= y1);
+        for (int i = 0; i < rectangle.size() && !touch; ++i) {
+          for (int j = 0; j < polygon.size() && !touch; ++j) {
+            touch = doIntersect(rectangle[i],
+                                rectangle[(i + 1) % rectangle.size()],
+                                polygon[j], polygon[(j + 1) % polygon.size()]);
+          }
+        }
+        touch ? boundary = 1 : outside = 1;
+      }
+      int index = (cx + 1) * stride + cy + 1;
+      grid.mOutsideSum[index] = outside + grid.mOutsideSum[index - stride] +
+                                grid.mOutsideSum[index - 1] -
+                                grid.mOutsideSum[index - stride - 1];
+      grid.mBoundarySum[index] = boundary + grid.mBoundarySum[index - stride] +
+                                 grid.mBoundarySum[index - 1] -
+                                 grid.mBoundarySum[index - stride - 1];
     }
   }
+}
 
-  return flag_tot;
+bool Filter_Imp::isRectangleInsideArea(int top, int left, int bottom,
+                                       int right, const Area& area) const {
+  const ZoneGrid& grid = area.grid;
+  if (!grid.empty() && top <= bottom && left <= right) {
+    // 超出外接矩形的检测框一定不在区域内
+    if (top < grid.mMinX || bottom > grid.mMaxX || left < grid.mMinY ||
+        right > grid.mMaxY)
+      return false;
+    int x0 = (top - grid.mMinX) / grid.mCellSize;
+    int x1 = (bottom - grid.mMinX) / grid.mCellSize + 1;
+    int y0 = (left - grid.mMinY) / grid.mCellSize;
+    int y1 = (right - grid.mMinY) / grid.mCellSize + 1;
+    int stride = grid.mGridHeight + 1;
+    auto sum = [&](const std::vector<int>& s) {
+      return s[x1 * stride + y1] - s[x0 * stride + y1] - s[x1 * stride + y0] +
+             s[x0 * stride + y0];
+    };
+    if (sum(grid.mOutsideSum) > 0) return false;
+    if (sum(grid.mBoundarySum) == 0) return true;
+  }
+  std::vector<common::Point<int>> rectangle = {
+      common::Point<int>(top, left), common::Point<int>(top, right),
+      common::Point<int>(bottom, right), common::Point<int>(bottom, left)};
+  return isRectangleInsidePolygon(rectangle, area.points);
 }
 
 bool Filter_Imp::isInDirection(
-    std::shared_ptr<common::ObjectMetadata> objectMetadata) {
+    std::shared_ptr<common::ObjectMetadata> objectMetadata,
+    const std::vector<int>& indexes) {
   if((direction.mX == 0 && direction.mY == 0) || type != 1){
     return true; //没有方向，跳过筛选。
   }
   bool flag = false;
   if(frame_count % trajectory_interval == 0){
     //记录轨迹
-    for (int i = 0; i < objectMetadata->mDetectedObjectMetadatas.size(); i++) {
-      std::string name = std::to_string(objectMetadata->mTrackedObjectMetadatas[i]->mTrackId);
-      int top = objectMetadata->mDetectedObjectMetadatas[i]->mBox.top();
-      int left = objectMetadata->mDetectedObjectMetadatas[i]->mBox.left();
-      int bottom = objectMetadata->mDetectedObjectMetadatas[i]->mBox.bottom();
-      int right = objectMetadata->mDetectedObjectMetadatas[i]->mBox.right();
-      common::Point<int> trajectory((left + right) / 2, (top + bottom) / 2);
+    const common::DetectionTable& table = objectMetadata->mDetectionTable;
+    for (int i : indexes) {
+      if (!table.hasTracks()) break;
+      std::int64_t name = table.mTrackId[i];
+      common::Point<int> trajectory(table.mX[i] + table.mWidth[i] / 2,
+                                    table.mY[i] + table.mHeight[i] / 2);
       if(trajectories_pre.find(name) == trajectories_pre.end()) {
         trajectories_pre[name] = trajectory;
       }else {
@@ -446,84 +442,54 @@ bool Filter_Imp::isInDirection(
     //计算目标方向与预设方向的点积：
     //因为a·b=|a|·|b|·cosθ, 当90°>=θ>=-90°时, cosθ>=0，
     //即a·b>=0，此时可认为在目标方向与预设方向的夹角<=90°。
-    for (auto& pair : trajectories_pre){
-      auto name = pair.first;
-      if(trajectories_cnt.find(name) != trajectories_cnt.end()){
-        common::Point<int> cnt = trajectories_cnt[name];
-        common::Point<int> pre = trajectories_pre[name];
-        common::Point<int> dir_obj(cnt.mX - pre.mX, cnt.mY - pre.mY);
-        int dot_product = dir_obj.mX * direction.mX 
-                        + dir_obj.mY * direction.mY;
-        if(dot_product >= 0){
-          flag = true;
-        }
-        trajectories_pre[name] = trajectories_cnt[name];
-        trajectories_cnt.erase(name);
+    for (auto& pair : trajectories_cnt){
+      common::Point<int>& pre = trajectories_pre[pair.first];
+      common::Point<int> dir_obj(pair.second.mX - pre.mX,
+                                 pair.second.mY - pre.mY);
+      int dot_product = dir_obj.mX * direction.mX 
+                      + dir_obj.mY * direction.mY;
+      if(dot_product >= 0){
+        flag = true;
       }
+      pre = pair.second;
     }
+    trajectories_cnt.clear();
   }
   frame_count++;
   return flag;
 }
-bool Filter_Imp::istrack(
-    std::shared_ptr<common::ObjectMetadata> objectMetadata,
-    std::unordered_map<std::string, int>& continue_frame_num_) {
+
+bool Filter_Imp::istrack(std::shared_ptr<common::ObjectMetadata> objectMetadata,
+                         DwellCounter& dwellCounter,
+                         std::vector<int>& indexes) {
   if (type != 1 && type != 0) return true;
-  int channel_id = objectMetadata->mFrame->mChannelIdInternal;
-  std::unordered_map<std::string, int> up_list;
-  for (auto i : continue_frame_num_) {
-    if (i.second > alert_first_frames) {
-      if (((i.second - alert_first_frames - 1) % alert_frame_skip_nums) == 0) {
-        up_list[i.first] = 1;
-      }
-    }
-  }
-  if (up_list.size() == 0) return false;
-  std::vector<std::shared_ptr<common::DetectedObjectMetadata>>
-      new_mDetectedObjectMetadatas;
-  std::vector<std::shared_ptr<common::ObjectMetadata>> new_mSubObjectMetadatas;
-  std::vector<std::shared_ptr<common::TrackedObjectMetadata>>
-      new_mTrackedObjectMetadatas;
-
-  if (objectMetadata->mDetectedObjectMetadatas.size()) {
-    for (int i = 0; i < objectMetadata->mDetectedObjectMetadatas.size(); i++) {
-      std::string name;
-      if (type == 0) {
-        name = objectMetadata->mSubObjectMetadatas[i]
-                   ->mRecognizedObjectMetadatas[0]
-                   ->mLabelName;
-      } else if (type == 1) {
-        name = std::to_string(
-            objectMetadata->mTrackedObjectMetadatas[i]->mTrackId);
-      }
-      if (up_list.find(name) != up_list.end()) {
-        new_mDetectedObjectMetadatas.push_back(
-            objectMetadata->mDetectedObjectMetadatas[i]);
-        if (type == 0) {
-          new_mSubObjectMetadatas.push_back(
-              objectMetadata->mSubObjectMetadatas[i]);
-
-        } else if (type == 1) {
-          new_mTrackedObjectMetadatas.push_back(
-              objectMetadata->mTrackedObjectMetadatas[i]);
-        }
-      }
-    }
-    objectMetadata->mDetectedObjectMetadatas.clear();
-    objectMetadata->mDetectedObjectMetadatas = new_mDetectedObjectMetadatas;
+  std::vector<int> up_list;
+  dwellCounter.begin();
+  for (int i : indexes) {
+    std::int64_t key;
     if (type == 0) {
-      objectMetadata->mSubObjectMetadatas.clear();
-      objectMetadata->mSubObjectMetadatas = new_mSubObjectMetadatas;
-    } else if (type == 1) {
-      objectMetadata->mTrackedObjectMetadatas.clear();
-      objectMetadata->mTrackedObjectMetadatas = new_mTrackedObjectMetadatas;
+      if (i >= objectMetadata->mSubObjectMetadatas.size() ||
+          objectMetadata->mSubObjectMetadatas[i]
+                  ->mRecognizedObjectMetadatas.size() != 1)
+        continue;
+      // 识别结果以字符串hash作为key
+      key = std::hash<std::string>()(objectMetadata->mSubObjectMetadatas[i]
+                                         ->mRecognizedObjectMetadatas[0]
+                                         ->mLabelName);
+    } else {
+      if (!objectMetadata->mDetectionTable.hasTracks()) continue;
+      key = objectMetadata->mDetectionTable.mTrackId[i];
     }
-    // objectMetadata->mSubObjectMetadatas[0]->mRecognizedObjectMetadatas.clear();
-    // for(auto j :mRecognizedObjectMetadatas_)
-    // objectMetadata->mSubObjectMetadatas[0]->mRecognizedObjectMetadatas.push_back(j);
+    int count = dwellCounter.touch(key);
+    if (count > alert_first_frames &&
+        ((count - alert_first_frames - 1) % alert_frame_skip_nums) == 0)
+      up_list.push_back(i);
   }
-
-  return up_list.size() > 0;
+  dwellCounter.end();
+  // 没有需要上报的目标时不删除检测结果，留给后面的过滤器判断
+  if (up_list.empty()) return false;
+  indexes.swap(up_list);
+  return true;
 }
 
 bool Filter_Imp::onSegment(const common::Point<int>& p,
@@ -590,7 +556,7 @@ bool Filter_Imp::isPointInsidePolygon(
 }
 
 bool Filter_Imp::isRectangleInsidePolygon(
-    std::vector<common::Point<int>>& rectangle,
+    const std::vector<common::Point<int>>& rectangle,
     const std::vector<common::Point<int>>& polygon) {
   if (polygon.size() == 0) return true;
 
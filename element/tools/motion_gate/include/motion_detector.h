@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_MOTION_DETECTOR_H_
+#define SOPHON_STREAM_ELEMENT_MOTION_DETECTOR_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "common/graphics.h"
+
+namespace sophon_stream {
+namespace element {
+namespace motion_gate {
+
+struct MotionDetectorParams {
+  /**
+   * @brief 亮度图的宽高，输入必须是这个尺寸
+   */
+  int mWidth = 160;
+  int mHeight = 90;
+  /**
+   * @brief 与背景的亮度差超过threshold的像素视为变化
+   */
+  int mThreshold = 20;
+  /**
+   * @brief 背景每帧向当前帧靠近1/2^learningShift
+   */
+  int mLearningShift = 5;
+  /**
+   * @brief 按cellSize x cellSize统计变化像素，变化像素占比不低于cellRatio的cell视为变化
+   */
+  int mCellSize = 8;
+  float mCellRatio = 0.2f;
+};
+
+/**
+ * @brief 一行像素与背景比较并更新背景。背景按Q8定点存放。
+ * @param[out] mask : 变化的像素写1，否则写0
+ */
+void diffAndUpdateRow(const std::uint8_t* luma, std::uint16_t* background,
+                      std::uint8_t* mask, int width, int threshold,
+                      int learningShift);
+
+/**
+ * @brief 基于低分辨率亮度背景差分的运动检测，只依赖CPU。
+ * 每帧与背景比较得到变化的cell，同时以滑动平均更新背景，
+ * 静止不动的新目标会逐渐融入背景
+ */
+class MotionDetector {
+ public:
+  explicit MotionDetector(const MotionDetectorParams& params);
+
+  /**
+   * @brief 输入一帧亮度图，返回变化的cell数。第一帧只用来初始化背景，返回0
+   * @param[in] stride : 一行的字节数
+   */
+  int update(const std::uint8_t* luma, int stride);
+
+  /**
+   * @brief 相连的变化cell合并为一个矩形，坐标为亮度图中的像素坐标
+   */
+  std::vector<common::Rectangle<int>> changedRegions() const;
+
+  /**
+   * @brief 丢弃背景，下一帧重新初始化
+   */
+  void reset() { mInitialized = false; }
+
+  int cellsX() const { return mCellsX; }
+  int cellsY() const { return mCellsY; }
+  const std::vector<std::uint8_t>& changedCells() const { return mCells; }
+
+ private:
+  MotionDetectorParams mParams;
+  int mCellsX;
+  int mCellsY;
+  bool mInitialized = false;
+  std::vector<std::uint16_t> mBackground;
+  std::vector<std::uint8_t> mMask;
+  std::vector<int> mCellCounts;
+  std::vector<std::uint8_t> mCells;
+};
+
+/**
+ * @brief 运动结束后继续放行holdFrames帧，避免目标短暂静止时漏检
+ */
+class MotionHold {
+ public:
+  /**
+   * @brief 第一帧只用来初始化背景，算在开始的保持期内
+   */
+  explicit MotionHold(int holdFrames)
+      : mHoldFrames(holdFrames), mRemaining(std::max(holdFrames, 1)) {}
+
+  /**
+   * @brief 输入本帧是否有运动，返回本帧是否放行
+   */
+  bool update(bool moving) {
+    if (moving) {
+      mRemaining = mHoldFrames;
+      return true;
+    }
+    if (mRemaining <= 0) return false;
+    --mRemaining;
+    return true;
+  }
+
+ private:
+  int mHoldFrames;
+  int mRemaining;
+};
+
+}  // namespace motion_gate
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_MOTION_DETECTOR_H_
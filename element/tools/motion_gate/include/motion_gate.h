@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_MOTION_GATE_H_
+#define SOPHON_STREAM_ELEMENT_MOTION_GATE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/metrics.h"
+#include "common/object_metadata.h"
+#include "element.h"
+#include "motion_detector.h"
+
+namespace sophon_stream {
+namespace element {
+namespace motion_gate {
+
+/**
+ * @brief 单路码流的运动检测状态
+ */
+struct ChannelState {
+  ChannelState(const MotionDetectorParams& params, int holdFrames)
+      : mDetector(params), mHold(holdFrames) {}
+  ~ChannelState();
+
+  MotionDetector mDetector;
+  /**
+   * @brief 缩小后的灰度图，设备内存在第一帧时分配
+   */
+  bm_image mLumaImage;
+  bool mLumaCreated = false;
+  std::vector<std::uint8_t> mLuma;
+  MotionHold mHold;
+};
+
+/**
+ * @brief 放在decode之后，按通道维护缩小的亮度背景。
+ * 画面没有变化的帧置mFilter并加入skip_elements，后面的检测element跳过推理；
+ * 有变化时可以把变化区域写入ObjectMetadata::mMotionRegions
+ */
+class MotionGate : public ::sophon_stream::framework::Element {
+ public:
+  MotionGate();
+  ~MotionGate() override;
+
+  common::ErrorCode initInternal(const std::string& json) override;
+
+  common::ErrorCode doWork(int dataPipeId) override;
+
+  static constexpr const char* CONFIG_INTERNAL_WIDTH_FIELD = "width";
+  static constexpr const char* CONFIG_INTERNAL_HEIGHT_FIELD = "height";
+  static constexpr const char* CONFIG_INTERNAL_THRESHOLD_FIELD = "threshold";
+  static constexpr const char* CONFIG_INTERNAL_LEARNING_SHIFT_FIELD =
+      "learning_shift";
+  static constexpr const char* CONFIG_INTERNAL_CELL_SIZE_FIELD = "cell_size";
+  static constexpr const char* CONFIG_INTERNAL_CELL_RATIO_FIELD = "cell_ratio";
+  static constexpr const char* CONFIG_INTERNAL_MIN_CELLS_FIELD = "min_cells";
+  static constexpr const char* CONFIG_INTERNAL_HOLD_FRAMES_FIELD =
+      "hold_frames";
+  static constexpr const char* CONFIG_INTERNAL_GATE_FIELD = "gate";
+  static constexpr const char* CONFIG_INTERNAL_SKIP_ELEMENTS_FIELD =
+      "skip_elements";
+  static constexpr const char* CONFIG_INTERNAL_OUTPUT_REGIONS_FIELD =
+      "output_regions";
+
+  static constexpr const char* MOTION_GATE_IDLE_METRIC =
+      "sophon_stream_motion_gate_idle_frames_total";
+
+ private:
+  /**
+   * @brief 对一帧做运动检测
+   * @return 画面有变化，或者仍在运动结束后的保持期内
+   */
+  bool detect(const std::shared_ptr<common::ObjectMetadata>& objectMetadata,
+              ChannelState& state);
+
+  std::shared_ptr<ChannelState> getChannelState(int channelId);
+  void removeChannelState(int channelId);
+
+  MotionDetectorParams mParams;
+  int mMinCells = 1;
+  int mHoldFrames = 25;
+  bool mGate = true;
+  std::vector<int> mSkipElements;
+  bool mOutputRegions = false;
+
+  common::Counter* mIdleFrames = nullptr;
+
+  std::mutex mChannelMutex;
+  std::map<int, std::shared_ptr<ChannelState>> mChannels;
+};
+
+}  // namespace motion_gate
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_MOTION_GATE_H_
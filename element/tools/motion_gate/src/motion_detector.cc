@@ -0,0 +1,198 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "motion_detector.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sophon_stream {
+namespace element {
+namespace motion_gate {
+
+void diffAndUpdateRow(const std::uint8_t* luma, std::uint16_t* background,
+                      std::uint8_t* mask, int width, int threshold,
+                      int learningShift) {
+  int x = 0;
+  // 差值在Q8下用饱和减法分别求正负两部分，不需要有符号扩展
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  const __m128i thresh = _mm_set1_epi16(threshold);
+  const __m128i shift = _mm_cvtsi32_si128(learningShift);
+  for (; x + 16 <= width; x += 16) {
+    __m128i pixels =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(luma + x));
+    __m128i lumaLo = _mm_unpacklo_epi8(zero, pixels);
+    __m128i lumaHi = _mm_unpackhi_epi8(zero, pixels);
+    __m128i* bg = reinterpret_cast<__m128i*>(background + x);
+    __m128i bgLo = _mm_loadu_si128(bg);
+    __m128i bgHi = _mm_loadu_si128(bg + 1);
+    __m128i upLo = _mm_subs_epu16(lumaLo, bgLo);
+    __m128i downLo = _mm_subs_epu16(bgLo, lumaLo);
+    __m128i upHi = _mm_subs_epu16(lumaHi, bgHi);
+    __m128i downHi = _mm_subs_epu16(bgHi, lumaHi);
+    __m128i diffLo = _mm_srli_epi16(_mm_or_si128(upLo, downLo), 8);
+    __m128i diffHi = _mm_srli_epi16(_mm_or_si128(upHi, downHi), 8);
+    __m128i changed = _mm_packs_epi16(_mm_cmpgt_epi16(diffLo, thresh),
+                                      _mm_cmpgt_epi16(diffHi, thresh));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(mask + x),
+                     _mm_and_si128(changed, one));
+    bgLo = _mm_sub_epi16(_mm_add_epi16(bgLo, _mm_srl_epi16(upLo, shift)),
+                         _mm_srl_epi16(downLo, shift));
+    bgHi = _mm_sub_epi16(_mm_add_epi16(bgHi, _mm_srl_epi16(upHi, shift)),
+                         _mm_srl_epi16(downHi, shift));
+    _mm_storeu_si128(bg, bgLo);
+    _mm_storeu_si128(bg + 1, bgHi);
+  }
+#elif defined(__ARM_NEON)
+  const uint16x8_t thresh = vdupq_n_u16(threshold);
+  const int16x8_t shift = vdupq_n_s16(-learningShift);
+  const uint8x16_t one = vdupq_n_u8(1);
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t pixels = vld1q_u8(luma + x);
+    uint16x8_t lumaLo = vshll_n_u8(vget_low_u8(pixels), 8);
+    uint16x8_t lumaHi = vshll_n_u8(vget_high_u8(pixels), 8);
+    uint16x8_t bgLo = vld1q_u16(background + x);
+    uint16x8_t bgHi = vld1q_u16(background + x + 8);
+    uint16x8_t upLo = vqsubq_u16(lumaLo, bgLo);
+    uint16x8_t downLo = vqsubq_u16(bgLo, lumaLo);
+    uint16x8_t upHi = vqsubq_u16(lumaHi, bgHi);
+    uint16x8_t downHi = vqsubq_u16(bgHi, lumaHi);
+    uint16x8_t diffLo = vshrq_n_u16(vorrq_u16(upLo, downLo), 8);
+    uint16x8_t diffHi = vshrq_n_u16(vorrq_u16(upHi, downHi), 8);
+    uint8x16_t changed = vcombine_u8(vmovn_u16(vcgtq_u16(diffLo, thresh)),
+                                     vmovn_u16(vcgtq_u16(diffHi, thresh)));
+    vst1q_u8(mask + x, vandq_u8(changed, one));
+    bgLo = vsubq_u16(vaddq_u16(bgLo, vshlq_u16(upLo, shift)),
+                     vshlq_u16(downLo, shift));
+    bgHi = vsubq_u16(vaddq_u16(bgHi, vshlq_u16(upHi, shift)),
+                     vshlq_u16(downHi, shift));
+    vst1q_u16(background + x, bgLo);
+    vst1q_u16(background + x + 8, bgHi);
+  }
+#endif
+  for (; x < width; ++x) {
+    int value = luma[x] << 8;
+    int up = std::max(value - background[x], 0);
+    int down = std::max(background[x] - value, 0);
+    mask[x] = ((up | down) >> 8) > threshold ? 1 : 0;
+    background[x] += (up >> learningShift) - (down >> learningShift);
+  }
+}
+
+MotionDetector::MotionDetector(const MotionDetectorParams& params)
+    : mParams(params) {
+  mParams.mWidth = std::max(mParams.mWidth, 1);
+  mParams.mHeight = std::max(mParams.mHeight, 1);
+  mParams.mCellSize = std::max(mParams.mCellSize, 1);
+  mParams.mLearningShift = std::min(std::max(mParams.mLearningShift, 0), 15);
+  mCellsX = (mParams.mWidth + mParams.mCellSize - 1) / mParams.mCellSize;
+  mCellsY = (mParams.mHeight + mParams.mCellSize - 1) / mParams.mCellSize;
+  mBackground.resize(mParams.mWidth * mParams.mHeight);
+  mMask.resize(mParams.mWidth);
+  mCellCounts.resize(mCellsX * mCellsY);
+  mCells.resize(mCellsX * mCellsY);
+}
+
+int MotionDetector::update(const std::uint8_t* luma, int stride) {
+  int width = mParams.mWidth;
+  int height = mParams.mHeight;
+  int cellSize = mParams.mCellSize;
+  if (!mInitialized) {
+    for (int y = 0; y < height; ++y) {
+      const std::uint8_t* row = luma + y * stride;
+      std::uint16_t* bg = mBackground.data() + y * width;
+      for (int x = 0; x < width; ++x) bg[x] = row[x] << 8;
+    }
+    std::fill(mCells.begin(), mCells.end(), 0);
+    mInitialized = true;
+    return 0;
+  }
+
+  std::fill(mCellCounts.begin(), mCellCounts.end(), 0);
+  for (int y = 0; y < height; ++y) {
+    diffAndUpdateRow(luma + y * stride, mBackground.data() + y * width,
+                     mMask.data(), width, mParams.mThreshold,
+                     mParams.mLearningShift);
+    int* counts = mCellCounts.data() + (y / cellSize) * mCellsX;
+    for (int cx = 0; cx < mCellsX; ++cx) {
+      int begin = cx * cellSize;
+      int end = std::min(begin + cellSize, width);
+      int count = 0;
+      for (int x = begin; x < end; ++x) count += mMask[x];
+      counts[cx] += count;
+    }
+  }
+
+  int changedCells = 0;
+  for (int cy = 0; cy < mCellsY; ++cy) {
+    int cellH = std::min(cellSize, height - cy * cellSize);
+    for (int cx = 0; cx < mCellsX; ++cx) {
+      int cellW = std::min(cellSize, width - cx * cellSize);
+      int index = cy * mCellsX + cx;
+      // 边缘的cell不足cellSize，按实际像素数计算占比
+      bool changed = mCellCounts[index] > 0 &&
+                     mCellCounts[index] >= mParams.mCellRatio * cellW * cellH;
+      mCells[index] = changed ? 1 : 0;
+      changedCells += mCells[index];
+    }
+  }
+  return changedCells;
+}
+
+std::vector<common::Rectangle<int>> MotionDetector::changedRegions() const {
+  std::vector<common::Rectangle<int>> regions;
+  std::vector<std::uint8_t> visited(mCells.size(), 0);
+  std::vector<int> stack;
+  int cellSize = mParams.mCellSize;
+  for (int start = 0; start < static_cast<int>(mCells.size()); ++start) {
+    if (!mCells[start] || visited[start]) continue;
+    int minX = mCellsX, minY = mCellsY, maxX = -1, maxY = -1;
+    visited[start] = 1;
+    stack.assign(1, start);
+    // 8邻域连通
+    while (!stack.empty()) {
+      int index = stack.back();
+      stack.pop_back();
+      int cx = index % mCellsX;
+      int cy = index / mCellsX;
+      minX = std::min(minX, cx);
+      maxX = std::max(maxX, cx);
+      minY = std::min(minY, cy);
+      maxY = std::max(maxY, cy);
+      for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, mCellsY - 1);
+           ++ny) {
+        for (int nx = std::max(cx - 1, 0);
+             nx <= std::min(cx + 1, mCellsX - 1); ++nx) {
+          int neighbor = ny * mCellsX + nx;
+          if (mCells[neighbor] && !visited[neighbor]) {
+            visited[neighbor] = 1;
+            stack.push_back(neighbor);
+          }
+        }
+      }
+    }
+    int x = minX * cellSize;
+    int y = minY * cellSize;
+    int right = std::min((maxX + 1) * cellSize, mParams.mWidth);
+    int bottom = std::min((maxY + 1) * cellSize, mParams.mHeight);
+    regions.emplace_back(x, y, right - x, bottom - y);
+  }
+  return regions;
+}
+
+}  // namespace motion_gate
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,224 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "motion_gate.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/logger.h"
+#include "element_factory.h"
+
+namespace sophon_stream {
+namespace element {
+namespace motion_gate {
+
+ChannelState::~ChannelState() {
+  if (mLumaCreated) bm_image_destroy(mLumaImage);
+}
+
+MotionGate::MotionGate() {}
+
+MotionGate::~MotionGate() {}
+
+common::ErrorCode MotionGate::initInternal(const std::string& json) {
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  do {
+    auto configure = nlohmann::json::parse(json, nullptr, false);
+    if (!configure.is_object()) {
+      IVS_ERROR("Parse json fail or json is not object, json: {0}", json);
+      errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+      break;
+    }
+
+    auto widthIt = configure.find(CONFIG_INTERNAL_WIDTH_FIELD);
+    if (configure.end() != widthIt && widthIt->is_number_integer())
+      mParams.mWidth = widthIt->get<int>();
+
+    auto heightIt = configure.find(CONFIG_INTERNAL_HEIGHT_FIELD);
+    if (configure.end() != heightIt && heightIt->is_number_integer())
+      mParams.mHeight = heightIt->get<int>();
+
+    auto thresholdIt = configure.find(CONFIG_INTERNAL_THRESHOLD_FIELD);
+    if (configure.end() != thresholdIt && thresholdIt->is_number_integer())
+      mParams.mThreshold = thresholdIt->get<int>();
+
+    auto learningShiftIt =
+        configure.find(CONFIG_INTERNAL_LEARNING_SHIFT_FIELD);
+    if (configure.end() != learningShiftIt &&
+        learningShiftIt->is_number_integer())
+      mParams.mLearningShift = learningShiftIt->get<int>();
+
+    auto cellSizeIt = configure.find(CONFIG_INTERNAL_CELL_SIZE_FIELD);
+    if (configure.end() != cellSizeIt && cellSizeIt->is_number_integer())
+      mParams.mCellSize = cellSizeIt->get<int>();
+
+    auto cellRatioIt = configure.find(CONFIG_INTERNAL_CELL_RATIO_FIELD);
+    if (configure.end() != cellRatioIt && cellRatioIt->is_number())
+      mParams.mCellRatio = cellRatioIt->get<float>();
+
+    auto minCellsIt = configure.find(CONFIG_INTERNAL_MIN_CELLS_FIELD);
+    if (configure.end() != minCellsIt && minCellsIt->is_number_integer())
+      mMinCells = std::max(minCellsIt->get<int>(), 1);
+
+    auto holdFramesIt = configure.find(CONFIG_INTERNAL_HOLD_FRAMES_FIELD);
+    if (configure.end() != holdFramesIt && holdFramesIt->is_number_integer())
+      mHoldFrames = std::max(holdFramesIt->get<int>(), 0);
+
+    auto gateIt = configure.find(CONFIG_INTERNAL_GATE_FIELD);
+    if (configure.end() != gateIt && gateIt->is_boolean())
+      mGate = gateIt->get<bool>();
+
+    auto skipElementsIt = configure.find(CONFIG_INTERNAL_SKIP_ELEMENTS_FIELD);
+    if (configure.end() != skipElementsIt && skipElementsIt->is_array())
+      mSkipElements = skipElementsIt->get<std::vector<int>>();
+
+    auto outputRegionsIt =
+        configure.find(CONFIG_INTERNAL_OUTPUT_REGIONS_FIELD);
+    if (configure.end() != outputRegionsIt && outputRegionsIt->is_boolean())
+      mOutputRegions = outputRegionsIt->get<bool>();
+
+    mIdleFrames = common::SingletonMetricsRegistry::getInstance().counter(
+        MOTION_GATE_IDLE_METRIC, "Frames without motion skipped by motion gate",
+        {{"element_id", std::to_string(getId())}});
+
+    IVS_INFO(
+        "Motion gate luma size: {0}x{1}, threshold: {2}, learning shift: {3}, "
+        "cell size: {4}, cell ratio: {5}, min cells: {6}, hold frames: {7}",
+        mParams.mWidth, mParams.mHeight, mParams.mThreshold,
+        mParams.mLearningShift, mParams.mCellSize, mParams.mCellRatio,
+        mMinCells, mHoldFrames);
+  } while (false);
+  return errorCode;
+}
+
+std::shared_ptr<ChannelState> MotionGate::getChannelState(int channelId) {
+  std::lock_guard<std::mutex> lock(mChannelMutex);
+  auto& state = mChannels[channelId];
+  if (!state) {
+    state = std::make_shared<ChannelState>(mParams, mHoldFrames);
+  }
+  return state;
+}
+
+void MotionGate::removeChannelState(int channelId) {
+  std::lock_guard<std::mutex> lock(mChannelMutex);
+  mChannels.erase(channelId);
+}
+
+bool MotionGate::detect(
+    const std::shared_ptr<common::ObjectMetadata>& objectMetadata,
+    ChannelState& state) {
+  const auto& frame = objectMetadata->mFrame;
+  if (!frame->mSpData) return true;
+
+  // 用vpp缩小并转为灰度，只把很小的亮度图拷回host
+  if (!state.mLumaCreated) {
+    bm_image_create(frame->mHandle, mParams.mHeight, mParams.mWidth,
+                    FORMAT_GRAY, DATA_TYPE_EXT_1N_BYTE, &state.mLumaImage);
+    if (bm_image_alloc_dev_mem(state.mLumaImage, 1) != BM_SUCCESS) {
+      IVS_ERROR("Motion gate alloc device memory failed, channel id: {0}",
+                frame->mChannelId);
+      bm_image_destroy(state.mLumaImage);
+      return true;
+    }
+    state.mLumaCreated = true;
+  }
+  bm_status_t ret =
+      bmcv_image_vpp_convert(frame->mHandle, 1, *frame->mSpData,
+                             &state.mLumaImage, nullptr, BMCV_INTER_LINEAR);
+  if (ret != BM_SUCCESS) {
+    IVS_WARN("Motion gate vpp convert failed, channel id: {0}, ret: {1}",
+             frame->mChannelId, static_cast<int>(ret));
+    return true;
+  }
+  int stride = mParams.mWidth;
+  bm_image_get_stride(state.mLumaImage, &stride);
+  state.mLuma.resize(stride * mParams.mHeight);
+  void* buffers[1] = {state.mLuma.data()};
+  bm_image_copy_device_to_host(state.mLumaImage, buffers);
+
+  bool moving =
+      state.mDetector.update(state.mLuma.data(), stride) >= mMinCells;
+  if (!state.mHold.update(moving)) return false;
+  if (!moving) return true;
+
+  if (mOutputRegions) {
+    float scaleX = static_cast<float>(frame->mSpData->width) / mParams.mWidth;
+    float scaleY =
+        static_cast<float>(frame->mSpData->height) / mParams.mHeight;
+    objectMetadata->mMotionRegions.clear();
+    for (const auto& region : state.mDetector.changedRegions()) {
+      int x = std::floor(region.mX * scaleX);
+      int y = std::floor(region.mY * scaleY);
+      int right = std::min<int>(std::ceil(region.right() * scaleX),
+                                frame->mSpData->width);
+      int bottom = std::min<int>(std::ceil(region.bottom() * scaleY),
+                                 frame->mSpData->height);
+      objectMetadata->mMotionRegions.emplace_back(x, y, right - x, bottom - y);
+    }
+  }
+  return true;
+}
+
+common::ErrorCode MotionGate::doWork(int dataPipeId) {
+  std::vector<int> inputPorts = getInputPorts();
+  int inputPort = inputPorts[0];
+  int outputPort = 0;
+  if (!getSinkElementFlag()) {
+    std::vector<int> outputPorts = getOutputPorts();
+    outputPort = outputPorts[0];
+  }
+
+  auto data = popInputData(inputPort, dataPipeId);
+  while (!data && (getThreadStatus() == ThreadStatus::RUN)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    data = popInputData(inputPort, dataPipeId);
+  }
+  if (data == nullptr) return common::ErrorCode::SUCCESS;
+
+  auto objectMetadata = std::static_pointer_cast<common::ObjectMetadata>(data);
+  int channelId = objectMetadata->mFrame->mChannelId;
+  if (objectMetadata->mFrame->mEndOfStream) {
+    removeChannelState(channelId);
+  } else {
+    // 跳过检测的帧也要更新背景
+    auto state = getChannelState(channelId);
+    bool moving = detect(objectMetadata, *state);
+    if (!moving && mGate && !objectMetadata->mFilter) {
+      objectMetadata->mFilter = true;
+      objectMetadata->mSkipElements.insert(
+          objectMetadata->mSkipElements.end(), mSkipElements.begin(),
+          mSkipElements.end());
+      mIdleFrames->inc();
+    }
+  }
+
+  int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
+  int outDataPipeId =
+      getSinkElementFlag()
+          ? 0
+          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+  common::ErrorCode errorCode =
+      pushOutputData(outputPort, outDataPipeId,
+                     std::static_pointer_cast<void>(objectMetadata));
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_WARN(
+        "Send data fail, element id: {0:d}, output port: {1:d}, data: "
+        "{2:p}",
+        getId(), outputPort, static_cast<void*>(objectMetadata.get()));
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+REGISTER_WORKER("motion_gate", MotionGate)
+
+}  // namespace motion_gate
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_NULL_SINK_H_
+#define SOPHON_STREAM_ELEMENT_NULL_SINK_H_
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "common/object_metadata.h"
+#include "element.h"
+
+namespace sophon_stream {
+namespace element {
+namespace null_sink {
+
+/**
+ * @brief 单路码流的到达统计
+ */
+struct ChannelStatistics {
+  std::uint64_t mFrames = 0;
+  std::int64_t mFirstArrivalUs = 0;
+  std::int64_t mLastArrivalUs = 0;
+  bool mEndOfStream = false;
+};
+
+/**
+ * @brief 统计到达帧数、吞吐与端到端延时后丢弃数据的sink element。
+ * 延时为到达时刻减去Frame::mTimestamp，只在上游是synthetic_source
+ * 时有意义（decode填入的是码流pts）。停止时把结果写为JSON，用于回归比较。
+ */
+class NullSink : public ::sophon_stream::framework::Element {
+ public:
+  NullSink();
+  ~NullSink() override;
+
+  common::ErrorCode initInternal(const std::string& json) override;
+
+  common::ErrorCode doWork(int dataPipeId) override;
+
+  // 只统计帧率与延迟，不读取图像
+  bool needsPixelData() const override { return false; }
+
+  void onStop() override;
+
+  /**
+   * @brief 以JSON返回当前的统计结果
+   */
+  nlohmann::json report();
+
+  static constexpr const char* CONFIG_INTERNAL_REPORT_PATH_FIELD =
+      "report_path";
+  static constexpr const char* CONFIG_INTERNAL_MAX_SAMPLES_FIELD =
+      "max_latency_samples";
+  static constexpr const char* CONFIG_INTERNAL_FORWARD_FIELD = "forward";
+
+ private:
+  void record(const std::shared_ptr<common::ObjectMetadata>& objectMetadata);
+
+  std::string mReportPath;
+  std::size_t mMaxSamples = 1000000;
+  bool mForward = true;
+
+  common::Histogram* mLatency = nullptr;
+
+  std::mutex mMutex;
+  std::map<int, ChannelStatistics> mChannels;
+  // 延时采样，单位us，超过mMaxSamples后不再记录
+  std::vector<std::int64_t> mLatencySamples;
+  std::int64_t mLatencySumUs = 0;
+  std::uint64_t mLatencyCount = 0;
+};
+
+}  // namespace null_sink
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_NULL_SINK_H_
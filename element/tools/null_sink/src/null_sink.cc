@@ -0,0 +1,203 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "null_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include "common/logger.h"
+#include "element_factory.h"
+
+namespace sophon_stream {
+namespace element {
+namespace null_sink {
+
+namespace {
+
+std::int64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::int64_t percentile(std::vector<std::int64_t>& samples, double ratio) {
+  if (samples.empty()) return 0;
+  std::size_t index = static_cast<std::size_t>(ratio * (samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+}  // namespace
+
+NullSink::NullSink() {}
+
+NullSink::~NullSink() {}
+
+common::ErrorCode NullSink::initInternal(const std::string& json) {
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  do {
+    auto configure = nlohmann::json::parse(json, nullptr, false);
+    if (!configure.is_object()) {
+      IVS_ERROR("Parse json fail or json is not object, json: {0}", json);
+      errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+      break;
+    }
+
+    auto reportPathIt = configure.find(CONFIG_INTERNAL_REPORT_PATH_FIELD);
+    if (configure.end() != reportPathIt && reportPathIt->is_string())
+      mReportPath = reportPathIt->get<std::string>();
+
+    auto maxSamplesIt = configure.find(CONFIG_INTERNAL_MAX_SAMPLES_FIELD);
+    if (configure.end() != maxSamplesIt && maxSamplesIt->is_number_integer())
+      mMaxSamples = maxSamplesIt->get<std::size_t>();
+
+    auto forwardIt = configure.find(CONFIG_INTERNAL_FORWARD_FIELD);
+    if (configure.end() != forwardIt && forwardIt->is_boolean())
+      mForward = forwardIt->get<bool>();
+
+    mLatencySamples.reserve(std::min<std::size_t>(mMaxSamples, 1 << 16));
+    mLatency = registerStageLatency("arrival");
+  } while (false);
+  return errorCode;
+}
+
+common::ErrorCode NullSink::doWork(int dataPipeId) {
+  std::vector<int> inputPorts = getInputPorts();
+  int inputPort = inputPorts[0];
+  int outputPort = 0;
+  bool forward = mForward;
+  if (!getSinkElementFlag()) {
+    std::vector<int> outputPorts = getOutputPorts();
+    if (outputPorts.empty())
+      forward = false;
+    else
+      outputPort = outputPorts[0];
+  }
+
+  auto data = popInputData(inputPort, dataPipeId);
+  while (!data && (getThreadStatus() == ThreadStatus::RUN)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    data = popInputData(inputPort, dataPipeId);
+  }
+  if (data == nullptr) return common::ErrorCode::SUCCESS;
+
+  auto objectMetadata = std::static_pointer_cast<common::ObjectMetadata>(data);
+  record(objectMetadata);
+
+  // 不转发时EOF仍要交给sink handler，否则程序无法判断码流结束
+  if (!forward &&
+      !(getSinkElementFlag() && objectMetadata->mFrame->mEndOfStream))
+    return common::ErrorCode::SUCCESS;
+
+  int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
+  int outDataPipeId =
+      getSinkElementFlag()
+          ? 0
+          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+  common::ErrorCode errorCode =
+      pushOutputData(outputPort, outDataPipeId,
+                     std::static_pointer_cast<void>(objectMetadata));
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_WARN(
+        "Send data fail, element id: {0:d}, output port: {1:d}, data: "
+        "{2:p}",
+        getId(), outputPort, static_cast<void*>(objectMetadata.get()));
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+void NullSink::record(
+    const std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
+  std::int64_t now = nowUs();
+  std::int64_t latencyUs = now - objectMetadata->mFrame->mTimestamp;
+  bool endOfStream = objectMetadata->mFrame->mEndOfStream;
+  if (!endOfStream && mLatency != nullptr) mLatency->observe(latencyUs / 1e6);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto& channel = mChannels[objectMetadata->mFrame->mChannelId];
+  if (endOfStream) {
+    channel.mEndOfStream = true;
+    return;
+  }
+  if (channel.mFrames == 0) channel.mFirstArrivalUs = now;
+  channel.mLastArrivalUs = now;
+  ++channel.mFrames;
+  mLatencySumUs += latencyUs;
+  ++mLatencyCount;
+  if (mLatencySamples.size() < mMaxSamples)
+    mLatencySamples.push_back(latencyUs);
+}
+
+nlohmann::json NullSink::report() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  nlohmann::json result;
+  nlohmann::json channels = nlohmann::json::object();
+  std::uint64_t frames = 0;
+  std::int64_t firstUs = 0;
+  std::int64_t lastUs = 0;
+  int finished = 0;
+  for (const auto& it : mChannels) {
+    const ChannelStatistics& channel = it.second;
+    double seconds = (channel.mLastArrivalUs - channel.mFirstArrivalUs) / 1e6;
+    channels[std::to_string(it.first)] = {
+        {"frames", channel.mFrames},
+        {"fps", seconds > 0 ? (channel.mFrames - 1) / seconds : 0},
+        {"eos", channel.mEndOfStream}};
+    if (channel.mFrames == 0) continue;
+    frames += channel.mFrames;
+    firstUs = firstUs == 0 ? channel.mFirstArrivalUs
+                           : std::min(firstUs, channel.mFirstArrivalUs);
+    lastUs = std::max(lastUs, channel.mLastArrivalUs);
+    finished += channel.mEndOfStream ? 1 : 0;
+  }
+  double seconds = (lastUs - firstUs) / 1e6;
+
+  std::vector<std::int64_t> samples(mLatencySamples);
+  nlohmann::json latency = {
+      {"count", mLatencyCount},
+      {"mean", mLatencyCount > 0 ? mLatencySumUs / double(mLatencyCount) : 0},
+      {"min", samples.empty()
+                  ? 0
+                  : *std::min_element(samples.begin(), samples.end())},
+      {"p50", percentile(samples, 0.5)},
+      {"p90", percentile(samples, 0.9)},
+      {"p99", percentile(samples, 0.99)},
+      {"max", samples.empty()
+                  ? 0
+                  : *std::max_element(samples.begin(), samples.end())}};
+
+  result["element_id"] = getId();
+  result["frames"] = frames;
+  result["duration_s"] = seconds;
+  result["fps"] = seconds > 0 ? frames / seconds : 0;
+  result["finished_channels"] = finished;
+  result["latency_us"] = latency;
+  result["channels"] = channels;
+  return result;
+}
+
+void NullSink::onStop() {
+  nlohmann::json result = report();
+  IVS_INFO("Null sink report: {0}", result.dump());
+  if (mReportPath.empty()) return;
+  std::ofstream out(mReportPath);
+  if (!out.is_open()) {
+    IVS_ERROR("Can not open report file: {0}", mReportPath);
+    return;
+  }
+  out << result.dump(4) << std::endl;
+}
+
+REGISTER_WORKER("null_sink", NullSink)
+
+}  // namespace null_sink
+}  // namespace element
+}  // namespace sophon_stream
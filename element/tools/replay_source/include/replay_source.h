@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_REPLAY_SOURCE_H_
+#define SOPHON_STREAM_ELEMENT_REPLAY_SOURCE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+#include "common/metadata_recorder.h"
+#include "common/object_metadata.h"
+#include "element.h"
+// channel.h依赖bmcv_rect_t，需在bmcv头文件之后
+#include "channel.h"
+
+namespace sophon_stream {
+namespace element {
+namespace replay_source {
+
+/**
+ * @brief 一路回放的状态，只由收到START任务的线程访问
+ */
+struct ReplayChannel {
+  int mGraphId;
+  int mChannelId;
+  int mChannelIdInternal;
+  std::string mPath;
+  int mLoopNum = 1;
+  int mLoop = 0;
+  // 循环回放时frame id接着上一轮递增
+  std::int64_t mFrameIdOffset = 0;
+  std::int64_t mMaxFrameId = -1;
+  std::uint64_t mFrames = 0;
+  bool mStopped = false;
+  common::MetadataReader mReader;
+  // 已读出、等待到期送出的记录
+  std::shared_ptr<common::ObjectMetadata> mNext;
+  std::int64_t mNextRecordUs = 0;
+  std::int64_t mFirstRecordUs = -1;
+  std::int64_t mStartUs = 0;
+  std::int64_t mNextDueUs = 0;
+};
+
+/**
+ * @brief 回放MetadataRecorder录制的ObjectMetadata，作为source
+ * element接入任意element或子图。与decode一样接收ChannelTask，
+ * 每一路只回放录制文件中channel_id相同的记录，可以按原始节奏或最快速度发送。
+ */
+class ReplaySource : public ::sophon_stream::framework::Element {
+ public:
+  ReplaySource();
+  ~ReplaySource() override;
+
+  common::ErrorCode initInternal(const std::string& json) override;
+
+  common::ErrorCode doWork(int dataPipeId) override;
+
+  static constexpr const char* CONFIG_INTERNAL_PATH_FIELD = "path";
+  static constexpr const char* CONFIG_INTERNAL_SPEED_FIELD = "speed";
+  static constexpr const char* CONFIG_INTERNAL_LOOP_NUM_FIELD = "loop_num";
+  static constexpr const char* CONFIG_INTERNAL_RESTAMP_FIELD = "restamp";
+  static constexpr const char* JSON_CHANNEL_URL_FIELD = "url";
+  static constexpr const char* JSON_CHANNEL_LOOP_NUM_FIELD = "loop_num";
+
+ private:
+  common::ErrorCode startChannel(
+      int dataPipeId, const std::shared_ptr<decode::ChannelTask>& channelTask);
+  common::ErrorCode stopChannel(
+      int dataPipeId, const std::shared_ptr<decode::ChannelTask>& channelTask);
+
+  /**
+   * @brief 读出本路的下一条记录，文件读完时按loop_num重新打开
+   * @return 没有更多记录时返回false
+   */
+  bool readNext(ReplayChannel& channel);
+  std::shared_ptr<common::ObjectMetadata> makeEndOfStream(
+      const ReplayChannel& channel);
+  common::ErrorCode sendFrame(
+      const std::shared_ptr<common::ObjectMetadata>& objectMetadata);
+
+  std::string mPath;
+  double mSpeed = 1.0;
+  int mLoopNum = 1;
+  bool mRestamp = false;
+
+  bm_handle_t mHandle = nullptr;
+
+  // 每个线程负责自己收到的码流，{dataPipeId : channels}
+  std::vector<std::vector<std::shared_ptr<ReplayChannel>>> mChannels;
+
+  // channelIdInternal的分配与回收，规则与decode一致
+  std::mutex mChannelIdMutex;
+  std::map<int, int> mChannelCountMap;
+  std::map<int, std::queue<int>> mReleasedChannelIdMap;
+};
+
+}  // namespace replay_source
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_REPLAY_SOURCE_H_
@@ -0,0 +1,298 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "replay_source.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "common/logger.h"
+#include "element_factory.h"
+
+namespace sophon_stream {
+namespace element {
+namespace replay_source {
+
+namespace {
+
+std::int64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+ReplaySource::ReplaySource() {}
+
+ReplaySource::~ReplaySource() {
+  for (auto& channels : mChannels) channels.clear();
+  if (mHandle != nullptr) bm_dev_free(mHandle);
+}
+
+common::ErrorCode ReplaySource::initInternal(const std::string& json) {
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  do {
+    auto configure = nlohmann::json::parse(json, nullptr, false);
+    if (!configure.is_object()) {
+      IVS_ERROR("Parse json fail or json is not object, json: {0}", json);
+      errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+      break;
+    }
+
+    auto pathIt = configure.find(CONFIG_INTERNAL_PATH_FIELD);
+    if (configure.end() != pathIt && pathIt->is_string())
+      mPath = pathIt->get<std::string>();
+
+    auto speedIt = configure.find(CONFIG_INTERNAL_SPEED_FIELD);
+    if (configure.end() != speedIt && speedIt->is_number())
+      mSpeed = speedIt->get<double>();
+
+    auto loopNumIt = configure.find(CONFIG_INTERNAL_LOOP_NUM_FIELD);
+    if (configure.end() != loopNumIt && loopNumIt->is_number_integer())
+      mLoopNum = loopNumIt->get<int>();
+
+    auto restampIt = configure.find(CONFIG_INTERNAL_RESTAMP_FIELD);
+    if (configure.end() != restampIt && restampIt->is_boolean())
+      mRestamp = restampIt->get<bool>();
+
+    if (mSpeed < 0) {
+      IVS_ERROR("Invalid replay speed, json: {0}", json);
+      errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+      break;
+    }
+
+    // 录制文件中带图像时需要handle恢复bm_image
+    int dev_id = getDeviceId();
+    bm_dev_request(&mHandle, dev_id);
+    mChannels.resize(getThreadNumber());
+  } while (false);
+  return errorCode;
+}
+
+common::ErrorCode ReplaySource::doWork(int dataPipeId) {
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  int inputPort = 0;
+  auto data = popInputData(inputPort, dataPipeId);
+  if (data) {
+    auto channelTask = std::static_pointer_cast<decode::ChannelTask>(data);
+    if (channelTask->request.operation ==
+        decode::ChannelOperateRequest::ChannelOperate::START) {
+      errorCode = startChannel(dataPipeId, channelTask);
+    } else if (channelTask->request.operation ==
+               decode::ChannelOperateRequest::ChannelOperate::STOP) {
+      errorCode = stopChannel(dataPipeId, channelTask);
+    }
+  }
+
+  auto& channels = mChannels[dataPipeId];
+  if (channels.empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return errorCode;
+  }
+
+  // 每轮给每一路发出所有到期的记录，都未到期时睡到最早的到期时间
+  std::int64_t now = nowUs();
+  std::int64_t nextDue = now + 10000;
+  for (auto it = channels.begin(); it != channels.end();) {
+    auto& channel = **it;
+    if (!channel.mStopped && channel.mNextDueUs > now) {
+      nextDue = std::min(nextDue, channel.mNextDueUs);
+      ++it;
+      continue;
+    }
+    if (channel.mStopped || !channel.mNext) {
+      sendFrame(makeEndOfStream(channel));
+      IVS_INFO("Replay channel {0} finished, frames: {1}", channel.mChannelId,
+               channel.mFrames);
+      channel.mReader.close();
+      std::lock_guard<std::mutex> lock(mChannelIdMutex);
+      mReleasedChannelIdMap[channel.mGraphId].push(channel.mChannelIdInternal);
+      it = channels.erase(it);
+      continue;
+    }
+
+    auto objectMetadata = std::move(channel.mNext);
+    auto& frame = objectMetadata->mFrame;
+    frame->mChannelIdInternal = channel.mChannelIdInternal;
+    frame->mFrameId += channel.mFrameIdOffset;
+    for (auto& subFrameId : frame->mSubFrameIdVec)
+      subFrameId += channel.mFrameIdOffset;
+    channel.mMaxFrameId = std::max(channel.mMaxFrameId, frame->mFrameId);
+    if (mRestamp) frame->mTimestamp = nowUs();
+    objectMetadata->mGraphId = channel.mGraphId;
+    sendFrame(objectMetadata);
+    ++channel.mFrames;
+
+    // speed为0时不等待，否则按录制时的间隔除以speed发送
+    readNext(channel);
+    if (channel.mNext && mSpeed > 0) {
+      channel.mNextDueUs =
+          channel.mStartUs +
+          static_cast<std::int64_t>(
+              (channel.mNextRecordUs - channel.mFirstRecordUs) / mSpeed);
+    } else {
+      channel.mNextDueUs = 0;
+    }
+    nextDue = std::min(nextDue, channel.mNextDueUs);
+    ++it;
+  }
+
+  std::int64_t sleepUs = nextDue - nowUs();
+  if (sleepUs > 0)
+    std::this_thread::sleep_for(std::chrono::microseconds(sleepUs));
+  return errorCode;
+}
+
+common::ErrorCode ReplaySource::startChannel(
+    int dataPipeId, const std::shared_ptr<decode::ChannelTask>& channelTask) {
+  auto channel = std::make_shared<ReplayChannel>();
+  channel->mGraphId = channelTask->request.graphId;
+  channel->mChannelId = channelTask->request.channelId;
+  channel->mPath = mPath;
+  channel->mLoopNum = mLoopNum;
+
+  auto configure =
+      nlohmann::json::parse(channelTask->request.json, nullptr, false);
+  if (configure.is_object()) {
+    auto urlIt = configure.find(JSON_CHANNEL_URL_FIELD);
+    if (configure.end() != urlIt && urlIt->is_string() &&
+        !urlIt->get<std::string>().empty())
+      channel->mPath = urlIt->get<std::string>();
+    auto loopNumIt = configure.find(JSON_CHANNEL_LOOP_NUM_FIELD);
+    if (configure.end() != loopNumIt && loopNumIt->is_number_integer())
+      channel->mLoopNum = loopNumIt->get<int>();
+  }
+
+  if (!channel->mReader.open(channel->mPath)) {
+    channelTask->response.errorCode = common::ErrorCode::PARAMETER_ERROR;
+    return common::ErrorCode::PARAMETER_ERROR;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mChannelIdMutex);
+    auto& released = mReleasedChannelIdMap[channel->mGraphId];
+    if (released.empty()) {
+      channel->mChannelIdInternal = mChannelCountMap[channel->mGraphId]++;
+    } else {
+      channel->mChannelIdInternal = released.front();
+      released.pop();
+    }
+  }
+
+  readNext(*channel);
+  if (!channel->mNext) {
+    IVS_WARN("No record of channel {0} in {1}", channel->mChannelId,
+             channel->mPath);
+  }
+  channel->mStartUs = nowUs();
+  channel->mNextDueUs = 0;
+
+  IVS_INFO("Replay channel {0} start, path: {1}, speed: {2}, loop num: {3}",
+           channel->mChannelId, channel->mPath, mSpeed, channel->mLoopNum);
+  mChannels[dataPipeId].push_back(channel);
+  channelTask->response.errorCode = common::ErrorCode::SUCCESS;
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode ReplaySource::stopChannel(
+    int dataPipeId, const std::shared_ptr<decode::ChannelTask>& channelTask) {
+  auto& channels = mChannels[dataPipeId];
+  for (auto& channel : channels) {
+    // 下一轮发出EOF，下游按正常结束处理
+    if (channel->mChannelId == channelTask->request.channelId) {
+      channel->mStopped = true;
+      channelTask->response.errorCode = common::ErrorCode::SUCCESS;
+      return common::ErrorCode::SUCCESS;
+    }
+  }
+  IVS_WARN("Replay channel {0} is not running", channelTask->request.channelId);
+  channelTask->response.errorCode = common::ErrorCode::UNKNOWN;
+  return common::ErrorCode::UNKNOWN;
+}
+
+bool ReplaySource::readNext(ReplayChannel& channel) {
+  while (true) {
+    std::int64_t recordUs = 0;
+    auto objectMetadata = channel.mReader.next(recordUs, mHandle);
+    if (!objectMetadata) {
+      // 文件读完，loop_num小于等于0时无限循环
+      ++channel.mLoop;
+      if ((channel.mLoopNum > 0 && channel.mLoop >= channel.mLoopNum) ||
+          channel.mFrames == 0) {
+        channel.mNext.reset();
+        return false;
+      }
+      channel.mReader.close();
+      if (!channel.mReader.open(channel.mPath)) {
+        channel.mNext.reset();
+        return false;
+      }
+      channel.mFrameIdOffset = channel.mMaxFrameId + 1;
+      // 新一轮从当前时刻重新计时
+      channel.mFirstRecordUs = -1;
+      continue;
+    }
+    // 录制的EOF不回放，结束时统一发出
+    if (objectMetadata->mFrame == nullptr ||
+        objectMetadata->mFrame->mChannelId != channel.mChannelId ||
+        objectMetadata->mFrame->mEndOfStream)
+      continue;
+    if (channel.mFirstRecordUs < 0) {
+      channel.mFirstRecordUs = recordUs;
+      channel.mStartUs = nowUs();
+    }
+    channel.mNextRecordUs = recordUs;
+    channel.mNext = objectMetadata;
+    return true;
+  }
+}
+
+std::shared_ptr<common::ObjectMetadata> ReplaySource::makeEndOfStream(
+    const ReplayChannel& channel) {
+  auto objectMetadata = std::make_shared<common::ObjectMetadata>();
+  objectMetadata->mFrame = std::make_shared<common::Frame>();
+  auto& frame = objectMetadata->mFrame;
+  frame->mChannelId = channel.mChannelId;
+  frame->mChannelIdInternal = channel.mChannelIdInternal;
+  frame->mFrameId = channel.mMaxFrameId + 1;
+  frame->mSubFrameIdVec.push_back(frame->mFrameId);
+  frame->mTimestamp = nowUs();
+  frame->mHandle = mHandle;
+  frame->mEndOfStream = true;
+  objectMetadata->mGraphId = channel.mGraphId;
+  return objectMetadata;
+}
+
+common::ErrorCode ReplaySource::sendFrame(
+    const std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
+  int outputPort = 0;
+  if (!getSinkElementFlag()) {
+    std::vector<int> outputPorts = getOutputPorts();
+    outputPort = outputPorts[0];
+  }
+  int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
+  int dataPipeId =
+      getSinkElementFlag()
+          ? 0
+          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+  common::ErrorCode errorCode = pushOutputData(
+      outputPort, dataPipeId, std::static_pointer_cast<void>(objectMetadata));
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_WARN("Send data fail, element id: {0}, output port: {1}, data: {2:p}",
+             getId(), outputPort, static_cast<void*>(objectMetadata.get()));
+  }
+  return errorCode;
+}
+
+REGISTER_WORKER("replay_source", ReplaySource)
+
+}  // namespace replay_source
+}  // namespace element
+}  // namespace sophon_stream
@@ -10,6 +10,7 @@
 #ifndef SOPHON_STREAM_ELEMENT_STITCH_H_
 #define SOPHON_STREAM_ELEMENT_STITCH_H_
 
+#include "common/input_synchronizer.h"
 #include "common/object_metadata.h"
 #include "element.h"
 #include "common/profiler.h"
@@ -40,6 +41,9 @@ class Stitch : public ::sophon_stream::framework::Element {
   std::string stitch_mode;
 
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
+
+  // 每个dataPipe一个，按frame id或时间戳对齐各输入端口的帧
+  std::vector<::sophon_stream::common::InputSynchronizer> mSynchronizers;
 };
 
 }  // namespace dpu
@@ -27,6 +27,12 @@ common::ErrorCode Stitch::initInternal(const std::string& json) {
   }
   mFpsProfiler.config("stitch fps:", 100);
   stitch_mode = configure.find(CONFIG_INTERNAL_STITCH_MODE_FILED)->get<std::string>();
+
+  mSynchronizers.resize(getThreadNumber());
+  for (auto& synchronizer : mSynchronizers) {
+    errorCode = synchronizer.init(configure);
+    if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
+  }
   
 
   return common::ErrorCode::SUCCESS;
@@ -104,25 +110,24 @@ common::ErrorCode Stitch::doWork(int dataPipeId) {
 
   common::ObjectMetadatas inputs;
 
-  for (auto inputPort : inputPorts) {
-    auto data = popInputData(inputPort, dataPipeId);
-    while (!data && (getThreadStatus() == ThreadStatus::RUN)) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      data = popInputData(inputPort, dataPipeId);
-    }
-    if (data == nullptr) return common::ErrorCode::SUCCESS;
-
-    auto objectMetadata =
-        std::static_pointer_cast<common::ObjectMetadata>(data);
-    inputs.emplace_back(objectMetadata);
-    IVS_DEBUG("Got Input, port id = {0}, channel_id = {1}, frame_id = {2}",
-              inputPort, objectMetadata->mFrame->mChannelId,
+  auto& synchronizer = mSynchronizers[dataPipeId];
+  while (!synchronizer.pop(inputs)) {
+    if (getThreadStatus() != ThreadStatus::RUN)
+      return common::ErrorCode::SUCCESS;
+    bool fetched = synchronizer.fetch(
+        inputPorts.size(), [this, &inputPorts, dataPipeId](int portIndex) {
+          return popInputData(inputPorts[portIndex], dataPipeId);
+        });
+    if (!fetched) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  for (auto& objectMetadata : inputs) {
+    IVS_DEBUG("Got Input, channel_id = {0}, frame_id = {1}",
+              objectMetadata->mFrame->mChannelId,
               objectMetadata->mFrame->mFrameId);
   }
 
   if (inputs[0]->mFrame->mSpData != nullptr &&
-      inputs[1]->mFrame->mSpData != nullptr &&
-      inputs[0]->mFrame->mFrameId == inputs[1]->mFrame->mFrameId) {
+      inputs[1]->mFrame->mSpData != nullptr) {
     std::shared_ptr<common::ObjectMetadata> stitchObj =
         std::make_shared<common::ObjectMetadata>();
     stitchObj->mFrame = std::make_shared<sophon_stream::common::Frame>();
@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_SYNTHETIC_SOURCE_H_
+#define SOPHON_STREAM_ELEMENT_SYNTHETIC_SOURCE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+#include "common/object_metadata.h"
+#include "element.h"
+// channel.h依赖bmcv_rect_t，需在bmcv头文件之后
+#include "channel.h"
+
+namespace sophon_stream {
+namespace element {
+namespace synthetic_source {
+
+/**
+ * @brief 一路合成码流的状态，只由收到START任务的线程访问
+ */
+struct SyntheticChannel {
+  int mGraphId;
+  int mChannelId;
+  int mChannelIdInternal;
+  std::vector<int> mSkipElements;
+  std::int64_t mFrameId = 0;
+  std::int64_t mFrameNum = 0;
+  std::int64_t mIntervalUs = 0;
+  std::int64_t mNextDueUs = 0;
+  bool mStopped = false;
+  std::shared_ptr<bm_image> mImage;
+  std::shared_ptr<common::MetadataPool> mMetadataPool;
+};
+
+/**
+ * @brief 不经过解码，按配置的帧率、分辨率与目标数生成ObjectMetadata的source
+ * element，用于在没有视频与模型的情况下测量框架本身的开销。
+ * 与decode一样接收ChannelTask，START时开始生成，STOP时停止。
+ */
+class SyntheticSource : public ::sophon_stream::framework::Element {
+ public:
+  SyntheticSource();
+  ~SyntheticSource() override;
+
+  common::ErrorCode initInternal(const std::string& json) override;
+
+  common::ErrorCode doWork(int dataPipeId) override;
+
+  static constexpr const char* CONFIG_INTERNAL_WIDTH_FIELD = "width";
+  static constexpr const char* CONFIG_INTERNAL_HEIGHT_FIELD = "height";
+  static constexpr const char* CONFIG_INTERNAL_FPS_FIELD = "fps";
+  static constexpr const char* CONFIG_INTERNAL_FRAME_NUM_FIELD = "frame_num";
+  static constexpr const char* CONFIG_INTERNAL_DETECTIONS_FIELD =
+      "detections_per_frame";
+  static constexpr const char* CONFIG_INTERNAL_CLASS_NUM_FIELD = "class_num";
+  static constexpr const char* CONFIG_INTERNAL_WITH_IMAGE_FIELD = "with_image";
+  static constexpr const char* JSON_CHANNEL_FPS_FIELD = "fps";
+  static constexpr const char* JSON_CHANNEL_SKIP_ELEMENT_FIELD =
+      "skip_element";
+
+ private:
+  common::ErrorCode startChannel(
+      int dataPipeId,
+      const std::shared_ptr<decode::ChannelTask>& channelTask);
+  common::ErrorCode stopChannel(
+      int dataPipeId,
+      const std::shared_ptr<decode::ChannelTask>& channelTask);
+
+  std::shared_ptr<common::ObjectMetadata> makeFrame(
+      SyntheticChannel& channel);
+  void fillDetections(const SyntheticChannel& channel,
+                      std::shared_ptr<common::ObjectMetadata>& objectMetadata);
+  common::ErrorCode sendFrame(
+      const std::shared_ptr<common::ObjectMetadata>& objectMetadata);
+
+  int mWidth = 1920;
+  int mHeight = 1080;
+  double mFps = 0;
+  std::int64_t mFrameNum = 1000;
+  int mDetectionsPerFrame = 10;
+  int mClassNum = 1;
+  bool mWithImage = true;
+
+  bm_handle_t mHandle = nullptr;
+
+  // 每个线程负责自己收到的码流，{dataPipeId : channels}
+  std::vector<std::vector<std::shared_ptr<SyntheticChannel>>> mChannels;
+
+  // channelIdInternal的分配与回收，规则与decode一致
+  std::mutex mChannelIdMutex;
+  std::map<int, int> mChannelCountMap;
+  std::map<int, std::queue<int>> mReleasedChannelIdMap;
+};
+
+}  // namespace synthetic_source
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_SYNTHETIC_SOURCE_H_
@@ -0,0 +1,313 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "synthetic_source.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "common/logger.h"
+#include "element_factory.h"
+
+namespace sophon_stream {
+namespace element {
+namespace synthetic_source {
+
+namespace {
+
+std::int64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+SyntheticSource::SyntheticSource() {}
+
+SyntheticSource::~SyntheticSource() {
+  for (auto& channels : mChannels) channels.clear();
+  if (mHandle != nullptr) bm_dev_free(mHandle);
+}
+
+common::ErrorCode SyntheticSource::initInternal(const std::string& json) {
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  do {
+    auto configure = nlohmann::json::parse(json, nullptr, false);
+    if (!configure.is_object()) {
+      IVS_ERROR("Parse json fail or json is not object, json: {0}", json);
+      errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+      break;
+    }
+
+    auto widthIt = configure.find(CONFIG_INTERNAL_WIDTH_FIELD);
+    if (configure.end() != widthIt && widthIt->is_number_integer())
+      mWidth = widthIt->get<int>();
+
+    auto heightIt = configure.find(CONFIG_INTERNAL_HEIGHT_FIELD);
+    if (configure.end() != heightIt && heightIt->is_number_integer())
+      mHeight = heightIt->get<int>();
+
+    auto fpsIt = configure.find(CONFIG_INTERNAL_FPS_FIELD);
+    if (configure.end() != fpsIt && fpsIt->is_number())
+      mFps = fpsIt->get<double>();
+
+    auto frameNumIt = configure.find(CONFIG_INTERNAL_FRAME_NUM_FIELD);
+    if (configure.end() != frameNumIt && frameNumIt->is_number_integer())
+      mFrameNum = frameNumIt->get<std::int64_t>();
+
+    auto detectionsIt = configure.find(CONFIG_INTERNAL_DETECTIONS_FIELD);
+    if (configure.end() != detectionsIt && detectionsIt->is_number_integer())
+      mDetectionsPerFrame = detectionsIt->get<int>();
+
+    auto classNumIt = configure.find(CONFIG_INTERNAL_CLASS_NUM_FIELD);
+    if (configure.end() != classNumIt && classNumIt->is_number_integer())
+      mClassNum = std::max(1, classNumIt->get<int>());
+
+    auto withImageIt = configure.find(CONFIG_INTERNAL_WITH_IMAGE_FIELD);
+    if (configure.end() != withImageIt && withImageIt->is_boolean())
+      mWithImage = withImageIt->get<bool>();
+
+    if (mWidth <= 0 || mHeight <= 0 || mDetectionsPerFrame < 0) {
+      IVS_ERROR("Invalid synthetic source configure, json: {0}", json);
+      errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+      break;
+    }
+
+    if (mWithImage) {
+      int dev_id = getDeviceId();
+      bm_dev_request(&mHandle, dev_id);
+    }
+    mChannels.resize(getThreadNumber());
+  } while (false);
+  return errorCode;
+}
+
+common::ErrorCode SyntheticSource::doWork(int dataPipeId) {
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  int inputPort = 0;
+  auto data = popInputData(inputPort, dataPipeId);
+  if (data) {
+    auto channelTask = std::static_pointer_cast<decode::ChannelTask>(data);
+    if (channelTask->request.operation ==
+        decode::ChannelOperateRequest::ChannelOperate::START) {
+      errorCode = startChannel(dataPipeId, channelTask);
+    } else if (channelTask->request.operation ==
+               decode::ChannelOperateRequest::ChannelOperate::STOP) {
+      errorCode = stopChannel(dataPipeId, channelTask);
+    }
+  }
+
+  auto& channels = mChannels[dataPipeId];
+  if (channels.empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return errorCode;
+  }
+
+  // 每轮给每一路到期的码流各生成一帧，都未到期时睡到最早的到期时间
+  std::int64_t now = nowUs();
+  std::int64_t nextDue = now + 10000;
+  for (auto it = channels.begin(); it != channels.end();) {
+    auto& channel = **it;
+    if (channel.mNextDueUs > now) {
+      nextDue = std::min(nextDue, channel.mNextDueUs);
+      ++it;
+      continue;
+    }
+    auto objectMetadata = makeFrame(channel);
+    sendFrame(objectMetadata);
+    if (objectMetadata->mFrame->mEndOfStream) {
+      IVS_INFO("Synthetic channel {0} finished, frames: {1}",
+               channel.mChannelId, channel.mFrameId - 1);
+      std::lock_guard<std::mutex> lock(mChannelIdMutex);
+      mReleasedChannelIdMap[channel.mGraphId].push(channel.mChannelIdInternal);
+      it = channels.erase(it);
+      continue;
+    }
+    channel.mNextDueUs =
+        channel.mIntervalUs > 0 ? channel.mNextDueUs + channel.mIntervalUs : 0;
+    nextDue = std::min(nextDue, channel.mNextDueUs);
+    ++it;
+  }
+
+  std::int64_t sleepUs = nextDue - nowUs();
+  if (sleepUs > 0)
+    std::this_thread::sleep_for(std::chrono::microseconds(sleepUs));
+  return errorCode;
+}
+
+common::ErrorCode SyntheticSource::startChannel(
+    int dataPipeId, const std::shared_ptr<decode::ChannelTask>& channelTask) {
+  auto channel = std::make_shared<SyntheticChannel>();
+  channel->mGraphId = channelTask->request.graphId;
+  channel->mChannelId = channelTask->request.channelId;
+  channel->mFrameNum = mFrameNum;
+  channel->mMetadataPool =
+      common::SingletonMetadataPools::getInstance().get(channel->mChannelId);
+
+  double fps = mFps;
+  auto configure =
+      nlohmann::json::parse(channelTask->request.json, nullptr, false);
+  if (configure.is_object()) {
+    auto fpsIt = configure.find(JSON_CHANNEL_FPS_FIELD);
+    if (configure.end() != fpsIt && fpsIt->is_number())
+      fps = fpsIt->get<double>();
+    auto skipIt = configure.find(JSON_CHANNEL_SKIP_ELEMENT_FIELD);
+    if (configure.end() != skipIt && skipIt->is_array())
+      channel->mSkipElements = skipIt->get<std::vector<int>>();
+  }
+  channel->mIntervalUs = fps > 0 ? static_cast<std::int64_t>(1e6 / fps) : 0;
+  channel->mNextDueUs = nowUs();
+
+  {
+    std::lock_guard<std::mutex> lock(mChannelIdMutex);
+    auto& released = mReleasedChannelIdMap[channel->mGraphId];
+    if (released.empty()) {
+      channel->mChannelIdInternal = mChannelCountMap[channel->mGraphId]++;
+    } else {
+      channel->mChannelIdInternal = released.front();
+      released.pop();
+    }
+  }
+
+  if (mWithImage) {
+    // 同一路的所有帧共用一张图，只保证下游拿到的帧是合法的bm_image
+    channel->mImage.reset(new bm_image, [](bm_image* p) {
+      bm_image_destroy(*p);
+      delete p;
+    });
+    bm_status_t ret =
+        bm_image_create(mHandle, mHeight, mWidth, FORMAT_YUV420P,
+                        DATA_TYPE_EXT_1N_BYTE, channel->mImage.get());
+    if (ret == BM_SUCCESS) ret = bm_image_alloc_dev_mem(*channel->mImage);
+    if (ret != BM_SUCCESS) {
+      IVS_ERROR("Create synthetic image fail, channel id: {0}",
+                channel->mChannelId);
+      channelTask->response.errorCode = common::ErrorCode::UNKNOWN;
+      return common::ErrorCode::UNKNOWN;
+    }
+  }
+
+  IVS_INFO(
+      "Synthetic channel {0} start, {1}x{2}, fps: {3}, frames: {4}, "
+      "detections per frame: {5}",
+      channel->mChannelId, mWidth, mHeight, fps, channel->mFrameNum,
+      mDetectionsPerFrame);
+  mChannels[dataPipeId].push_back(channel);
+  channelTask->response.errorCode = common::ErrorCode::SUCCESS;
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode SyntheticSource::stopChannel(
+    int dataPipeId, const std::shared_ptr<decode::ChannelTask>& channelTask) {
+  auto& channels = mChannels[dataPipeId];
+  for (auto& channel : channels) {
+    // 下一帧作为EOF发出，下游按正常结束处理
+    if (channel->mChannelId == channelTask->request.channelId) {
+      channel->mStopped = true;
+      channel->mNextDueUs = 0;
+      channelTask->response.errorCode = common::ErrorCode::SUCCESS;
+      return common::ErrorCode::SUCCESS;
+    }
+  }
+  IVS_WARN("Synthetic channel {0} is not running",
+           channelTask->request.channelId);
+  channelTask->response.errorCode = common::ErrorCode::UNKNOWN;
+  return common::ErrorCode::UNKNOWN;
+}
+
+std::shared_ptr<common::ObjectMetadata> SyntheticSource::makeFrame(
+    SyntheticChannel& channel) {
+  auto objectMetadata = common::makeFrameObjectMetadata(channel.mMetadataPool);
+  auto& frame = objectMetadata->mFrame;
+  frame->mChannelId = channel.mChannelId;
+  frame->mChannelIdInternal = channel.mChannelIdInternal;
+  frame->mFrameId = channel.mFrameId;
+  frame->mSubFrameIdVec.push_back(channel.mFrameId);
+  // 生成时刻的系统时间，null_sink据此计算端到端延时
+  frame->mTimestamp = nowUs();
+  frame->mHandle = mHandle;
+  objectMetadata->mGraphId = channel.mGraphId;
+  objectMetadata->mSkipElements = channel.mSkipElements;
+  ++channel.mFrameId;
+
+  if (channel.mStopped ||
+      (channel.mFrameNum > 0 && frame->mFrameId >= channel.mFrameNum)) {
+    frame->mEndOfStream = true;
+    return objectMetadata;
+  }
+
+  frame->mWidth = mWidth;
+  frame->mHeight = mHeight;
+  if (channel.mImage) {
+    frame->mSpData = channel.mImage;
+    frame->mFormatType = FORMAT_YUV420P;
+    frame->mDataType = DATA_TYPE_EXT_1N_BYTE;
+    frame->mChannel = 3;
+    frame->mChannelStep = 1;
+    frame->mWidthStep = mWidth;
+    frame->mHeightStep = mHeight;
+    frame->mDataSize = mWidth * mHeight * 3 / 2;
+  }
+  fillDetections(channel, objectMetadata);
+  return objectMetadata;
+}
+
+void SyntheticSource::fillDetections(
+    const SyntheticChannel& channel,
+    std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
+  // 目标按行排布、匀速水平移动，跟踪器能稳定关联
+  int boxWidth = std::max(1, mWidth / 20);
+  int boxHeight = std::max(1, mHeight / 10);
+  int rangeX = std::max(1, mWidth - boxWidth);
+  int rangeY = std::max(1, mHeight - boxHeight);
+  std::int64_t frameId = objectMetadata->mFrame->mFrameId;
+  objectMetadata->mDetectedObjectMetadatas.reserve(mDetectionsPerFrame);
+  for (int i = 0; i < mDetectionsPerFrame; ++i) {
+    auto detData = common::makeInArena<common::DetectedObjectMetadata>(
+        objectMetadata->mArena);
+    detData->mBox.mX =
+        static_cast<int>((i * 97 + frameId * 4) % rangeX);
+    detData->mBox.mY = mDetectionsPerFrame > 1
+                           ? i * rangeY / (mDetectionsPerFrame - 1)
+                           : rangeY / 2;
+    detData->mBox.mWidth = boxWidth;
+    detData->mBox.mHeight = boxHeight;
+    detData->mClassify = i % mClassNum;
+    detData->mScores.push_back(0.9f);
+    objectMetadata->mDetectedObjectMetadatas.push_back(detData);
+  }
+}
+
+common::ErrorCode SyntheticSource::sendFrame(
+    const std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
+  int outputPort = 0;
+  if (!getSinkElementFlag()) {
+    std::vector<int> outputPorts = getOutputPorts();
+    outputPort = outputPorts[0];
+  }
+  int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
+  int dataPipeId =
+      getSinkElementFlag()
+          ? 0
+          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+  common::ErrorCode errorCode = pushOutputData(
+      outputPort, dataPipeId, std::static_pointer_cast<void>(objectMetadata));
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_WARN("Send data fail, element id: {0}, output port: {1}, data: {2:p}",
+             getId(), outputPort, static_cast<void*>(objectMetadata.get()));
+  }
+  return errorCode;
+}
+
+REGISTER_WORKER("synthetic_source", SyntheticSource)
+
+}  // namespace synthetic_source
+}  // namespace element
+}  // namespace sophon_stream
@@ -10,6 +10,7 @@
 #include <unordered_map>
 
 #include "bmruntime_interface.h"
+#include "device_memory_pool.h"
 #include "no_copyable.h"
 
 extern "C" {
@@ -466,7 +467,12 @@ class BMNNHandle : public ::sophon_stream::common::NoCopyable {
     assert(BM_SUCCESS == ret);
   }
 
-  ~BMNNHandle() { bm_dev_free(m_handle); }
+  ~BMNNHandle() {
+    // 内存池中缓存的显存属于这个handle，需要在handle释放前归还
+    ::sophon_stream::common::SingletonDeviceMemoryPool::getInstance().trim(
+        m_handle);
+    bm_dev_free(m_handle);
+  }
 
   bm_handle_t handle() { return m_handle; }
 
@@ -0,0 +1,276 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "detection_table.h"
+
+#include "object_metadata.h"
+
+namespace sophon_stream {
+namespace common {
+
+LabelTable::LabelTable() {
+  for (auto& block : mBlocks) block.store(nullptr, std::memory_order_relaxed);
+}
+
+LabelTable::~LabelTable() {
+  for (auto& block : mBlocks) delete[] block.load(std::memory_order_relaxed);
+}
+
+int LabelTable::intern(const std::string& label) {
+  if (label.empty()) return -1;
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mIds.find(label);
+  if (it != mIds.end()) return it->second;
+  int id = mSize.load(std::memory_order_relaxed);
+  if (id >= BLOCK_SIZE * MAX_BLOCKS) return -1;
+  std::string* block = mBlocks[id / BLOCK_SIZE].load(std::memory_order_relaxed);
+  if (block == nullptr) {
+    block = new std::string[BLOCK_SIZE];
+    mBlocks[id / BLOCK_SIZE].store(block, std::memory_order_release);
+  }
+  block[id % BLOCK_SIZE] = label;
+  mIds.emplace(label, id);
+  mSize.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+const std::string& LabelTable::name(int id) const {
+  static const std::string empty;
+  if (id < 0 || id >= mSize.load(std::memory_order_acquire)) return empty;
+  return mBlocks[id / BLOCK_SIZE].load(std::memory_order_acquire)
+      [id % BLOCK_SIZE];
+}
+
+void DetectionTable::reserve(std::size_t rows) {
+  mX.reserve(rows);
+  mY.reserve(rows);
+  mWidth.reserve(rows);
+  mHeight.reserve(rows);
+  mScore.reserve(rows);
+  mClassId.reserve(rows);
+  mLabelId.reserve(rows);
+  mTrackId.reserve(rows);
+  mKeypointOffset.reserve(rows + 1);
+  mDetectedSource.reserve(rows);
+  mTrackedSource.reserve(rows);
+}
+
+void DetectionTable::clear() {
+  mX.clear();
+  mY.clear();
+  mWidth.clear();
+  mHeight.clear();
+  mScore.clear();
+  mClassId.clear();
+  mLabelId.clear();
+  mTrackId.clear();
+  mKeypointOffset.assign(1, 0);
+  mKeypointX.clear();
+  mKeypointY.clear();
+  mKeypointScore.clear();
+  mDetectedSource.clear();
+  mTrackedSource.clear();
+  mHasTracks = false;
+}
+
+std::size_t DetectionTable::add(int x, int y, int width, int height,
+                                float score, int classId, int labelId) {
+  mX.push_back(x);
+  mY.push_back(y);
+  mWidth.push_back(width);
+  mHeight.push_back(height);
+  mScore.push_back(score);
+  mClassId.push_back(classId);
+  mLabelId.push_back(labelId);
+  mTrackId.push_back(-1);
+  mKeypointOffset.push_back(mKeypointOffset.back());
+  mDetectedSource.emplace_back();
+  mTrackedSource.emplace_back();
+  return mX.size() - 1;
+}
+
+void DetectionTable::addKeypoint(int x, int y, float score) {
+  mKeypointX.push_back(x);
+  mKeypointY.push_back(y);
+  mKeypointScore.push_back(score);
+  ++mKeypointOffset.back();
+}
+
+void DetectionTable::compact(const std::vector<char>& keep) {
+  std::size_t rows = size();
+  std::size_t kept = 0;
+  std::size_t keptKeypoints = 0;
+  for (std::size_t i = 0; i < rows; ++i) {
+    if (!keep[i]) continue;
+    std::size_t begin = mKeypointOffset[i];
+    std::size_t end = mKeypointOffset[i + 1];
+    if (kept != i) {
+      mX[kept] = mX[i];
+      mY[kept] = mY[i];
+      mWidth[kept] = mWidth[i];
+      mHeight[kept] = mHeight[i];
+      mScore[kept] = mScore[i];
+      mClassId[kept] = mClassId[i];
+      mLabelId[kept] = mLabelId[i];
+      mTrackId[kept] = mTrackId[i];
+      mDetectedSource[kept] = std::move(mDetectedSource[i]);
+      mTrackedSource[kept] = std::move(mTrackedSource[i]);
+    }
+    for (std::size_t k = begin; k < end; ++k, ++keptKeypoints) {
+      mKeypointX[keptKeypoints] = mKeypointX[k];
+      mKeypointY[keptKeypoints] = mKeypointY[k];
+      mKeypointScore[keptKeypoints] = mKeypointScore[k];
+    }
+    ++kept;
+    mKeypointOffset[kept] = keptKeypoints;
+  }
+  mX.resize(kept);
+  mY.resize(kept);
+  mWidth.resize(kept);
+  mHeight.resize(kept);
+  mScore.resize(kept);
+  mClassId.resize(kept);
+  mLabelId.resize(kept);
+  mTrackId.resize(kept);
+  mKeypointOffset.resize(kept + 1);
+  mKeypointX.resize(keptKeypoints);
+  mKeypointY.resize(keptKeypoints);
+  mKeypointScore.resize(keptKeypoints);
+  mDetectedSource.resize(kept);
+  mTrackedSource.resize(kept);
+}
+
+namespace {
+
+bool pointFitsColumns(const PointMetadata& point) {
+  return point.mScores.size() == 1 && point.mTopKLabels.empty();
+}
+
+bool detectionFitsColumns(const DetectedObjectMetadata& detection) {
+  const auto& cropped = detection.mCroppedBox;
+  if (detection.mScores.size() != 1 || !detection.mTopKLabels.empty() ||
+      !detection.mItemName.empty() || !detection.mClassifyName.empty() ||
+      detection.mTrackIouThreshold != 0.f || cropped.mX != 0 ||
+      cropped.mY != 0 || cropped.mWidth != 0 || cropped.mHeight != 0)
+    return false;
+  for (const auto& point : detection.mKeyPoints) {
+    if (!point || !pointFitsColumns(*point)) return false;
+  }
+  return true;
+}
+
+bool trackFitsColumns(const TrackedObjectMetadata& track) {
+  return track.mUuid.empty() && track.mPerferScore == 0.f &&
+         track.mCoverArea == 0 && track.mName.empty() &&
+         !track.mTrackerFilter && track.mTrackFlag == TrNormal &&
+         track.mQualityScore == 0.f && track.mCaptureTime.empty() &&
+         track.mImagePath.empty();
+}
+
+}  // namespace
+
+void absorbDetections(ObjectMetadata& objectMetadata) {
+  if (objectMetadata.mDetectionsInTable) return;
+  DetectionTable& table = objectMetadata.mDetectionTable;
+  auto& detections = objectMetadata.mDetectedObjectMetadatas;
+  auto& tracks = objectMetadata.mTrackedObjectMetadatas;
+  // 跟踪结果与检测结果一一对应时才放进表，否则留在原vector
+  bool withTrack = !detections.empty() && tracks.size() == detections.size();
+  LabelTable& labels = SingletonLabelTable::getInstance();
+
+  table.clear();
+  table.reserve(detections.size());
+  table.setHasTracks(withTrack);
+  // 同一帧中的label大多相同，只在变化时查表
+  const std::string* lastLabel = nullptr;
+  int lastLabelId = -1;
+  for (std::size_t i = 0; i < detections.size(); ++i) {
+    const auto& detection = detections[i];
+    const auto& box = detection->mBox;
+    if (lastLabel == nullptr || *lastLabel != detection->mLabelName) {
+      lastLabel = &detection->mLabelName;
+      lastLabelId = labels.intern(detection->mLabelName);
+    }
+    float score = detection->mScores.size() == 1 ? detection->mScores[0]
+                                                 : detection->getScore();
+    table.add(box.mX, box.mY, box.mWidth, box.mHeight, score,
+              detection->mClassify, lastLabelId);
+    for (const auto& point : detection->mKeyPoints) {
+      if (!point) continue;
+      table.addKeypoint(point->mPoint.mX, point->mPoint.mY,
+                        point->mScores.size() == 1 ? point->mScores[0]
+                                                   : point->getScore());
+    }
+    if (!detectionFitsColumns(*detection)) table.mDetectedSource[i] = detection;
+    if (withTrack) {
+      table.mTrackId[i] = tracks[i]->mTrackId;
+      if (!trackFitsColumns(*tracks[i])) table.mTrackedSource[i] = tracks[i];
+    }
+  }
+  detections.clear();
+  if (withTrack) tracks.clear();
+  objectMetadata.mDetectionsInTable = true;
+}
+
+void materializeDetections(ObjectMetadata& objectMetadata) {
+  for (auto& subObjectMetadata : objectMetadata.mSubObjectMetadatas) {
+    if (subObjectMetadata) materializeDetections(*subObjectMetadata);
+  }
+  if (!objectMetadata.mDetectionsInTable) return;
+  DetectionTable& table = objectMetadata.mDetectionTable;
+  auto& detections = objectMetadata.mDetectedObjectMetadatas;
+  auto& tracks = objectMetadata.mTrackedObjectMetadatas;
+  const auto& arena = objectMetadata.mArena;
+  LabelTable& labels = SingletonLabelTable::getInstance();
+
+  detections.clear();
+  detections.reserve(table.size());
+  if (table.hasTracks()) {
+    tracks.clear();
+    tracks.reserve(table.size());
+  }
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    std::shared_ptr<DetectedObjectMetadata> detection =
+        table.mDetectedSource[i];
+    if (!detection) detection = makeInArena<DetectedObjectMetadata>(arena);
+    detection->mBox = table.box(i);
+    // 多个分数的对象保留原分数
+    if (detection->mScores.size() <= 1)
+      detection->mScores.assign(1, table.mScore[i]);
+    detection->mClassify = table.mClassId[i];
+    detection->mLabelName = labels.name(table.mLabelId[i]);
+
+    std::size_t begin = table.keypointBegin(i);
+    std::size_t end = table.keypointEnd(i);
+    if (detection->mKeyPoints.size() != end - begin) {
+      detection->mKeyPoints.clear();
+      for (std::size_t k = begin; k < end; ++k)
+        detection->mKeyPoints.push_back(makeInArena<PointMetadata>(arena));
+    }
+    for (std::size_t k = begin; k < end; ++k) {
+      auto& point = detection->mKeyPoints[k - begin];
+      point->mPoint = Point<int>(table.mKeypointX[k], table.mKeypointY[k]);
+      if (point->mScores.size() <= 1)
+        point->mScores.assign(1, table.mKeypointScore[k]);
+    }
+    detections.push_back(std::move(detection));
+
+    if (table.hasTracks()) {
+      std::shared_ptr<TrackedObjectMetadata> track = table.mTrackedSource[i];
+      if (!track) track = makeInArena<TrackedObjectMetadata>(arena);
+      track->mTrackId = table.mTrackId[i];
+      tracks.push_back(std::move(track));
+    }
+  }
+  table.clear();
+  objectMetadata.mDetectionsInTable = false;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
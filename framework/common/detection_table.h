@@ -0,0 +1,160 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_DETECTION_TABLE_H_
+#define SOPHON_STREAM_COMMON_DETECTION_TABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "detected_object_metadata.h"
+#include "graphics.h"
+#include "no_copyable.h"
+#include "singleton.h"
+#include "tracked_object_metadata.h"
+
+namespace sophon_stream {
+namespace common {
+
+struct ObjectMetadata;
+
+/**
+ * @brief 进程内的label字符串表，每个字符串只存一份，检测结果中用id引用。
+ * 写入加锁，按id查字符串不加锁
+ */
+class LabelTable : public NoCopyable {
+ public:
+  ~LabelTable();
+
+  /**
+   * @brief 返回字符串的id，空字符串返回-1。
+   * 有锁，element应在初始化时为类别名取好id，不要逐个检测框调用
+   */
+  int intern(const std::string& label);
+
+  /**
+   * @brief id对应的字符串，id无效时返回空字符串
+   */
+  const std::string& name(int id) const;
+
+  static constexpr int BLOCK_SIZE = 256;
+  static constexpr int MAX_BLOCKS = 1024;
+
+ private:
+  friend class Singleton<LabelTable>;
+  LabelTable();
+
+  std::mutex mMutex;
+  std::unordered_map<std::string, int> mIds;
+  // 字符串按块存放，块一旦分配不再移动，读者不需要加锁
+  std::atomic<std::string*> mBlocks[MAX_BLOCKS];
+  std::atomic<int> mSize{0};
+};
+
+using SingletonLabelTable = Singleton<LabelTable>;
+
+/**
+ * @brief 一帧的检测结果，按列(structure of arrays)存放，一行对应一个目标。
+ * 框、分数、类别、跟踪id等都在连续数组中，每帧只有列的分配，没有逐个框的分配。
+ * 不能用列表示的信息(多个分数、mCroppedBox、mItemName等)保留原对象，
+ * 转换回DetectedObjectMetadata时在原对象上更新，转换不丢信息
+ */
+class DetectionTable {
+ public:
+  DetectionTable() : mKeypointOffset(1, 0) {}
+
+  std::size_t size() const { return mX.size(); }
+  bool empty() const { return mX.empty(); }
+
+  void reserve(std::size_t rows);
+  void clear();
+
+  /**
+   * @brief 追加一行，返回行号
+   * @param[in] labelId : LabelTable中的id，-1表示没有label
+   */
+  std::size_t add(int x, int y, int width, int height, float score,
+                  int classId, int labelId = -1);
+
+  /**
+   * @brief 为最后一行追加一个关键点
+   */
+  void addKeypoint(int x, int y, float score);
+
+  std::size_t keypointBegin(std::size_t row) const {
+    return mKeypointOffset[row];
+  }
+  std::size_t keypointEnd(std::size_t row) const {
+    return mKeypointOffset[row + 1];
+  }
+
+  Rectangle<int> box(std::size_t row) const {
+    return Rectangle<int>(mX[row], mY[row], mWidth[row], mHeight[row]);
+  }
+
+  /**
+   * @brief 跟踪id列是否有效，没有跟踪结果时mTrackId全为-1
+   */
+  bool hasTracks() const { return mHasTracks; }
+  void setHasTracks(bool hasTracks) { mHasTracks = hasTracks; }
+
+  /**
+   * @brief 只保留keep[i]不为0的行，保持原顺序
+   */
+  void compact(const std::vector<char>& keep);
+
+  std::vector<int> mX;
+  std::vector<int> mY;
+  std::vector<int> mWidth;
+  std::vector<int> mHeight;
+  std::vector<float> mScore;
+  std::vector<int> mClassId;
+  std::vector<int> mLabelId;
+  std::vector<std::int64_t> mTrackId;
+
+  /**
+   * @brief 第i行的关键点为[mKeypointOffset[i], mKeypointOffset[i + 1])
+   */
+  std::vector<std::uint32_t> mKeypointOffset;
+  std::vector<int> mKeypointX;
+  std::vector<int> mKeypointY;
+  std::vector<float> mKeypointScore;
+
+  /**
+   * @brief 列中放不下的信息所在的原对象，大多数行为空
+   */
+  std::vector<std::shared_ptr<DetectedObjectMetadata>> mDetectedSource;
+  std::vector<std::shared_ptr<TrackedObjectMetadata>> mTrackedSource;
+
+ private:
+  bool mHasTracks = false;
+};
+
+/**
+ * @brief 把ObjectMetadata中mDetectedObjectMetadatas(以及与之一一对应的
+ * mTrackedObjectMetadatas)转为DetectionTable，转换后清空原vector
+ */
+void absorbDetections(ObjectMetadata& objectMetadata);
+
+/**
+ * @brief 把DetectionTable转回mDetectedObjectMetadatas与mTrackedObjectMetadatas，
+ * 新对象从帧的arena分配
+ */
+void materializeDetections(ObjectMetadata& objectMetadata);
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_DETECTION_TABLE_H_
@@ -0,0 +1,210 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "device_memory_pool.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "logger.h"
+
+namespace sophon_stream {
+namespace common {
+
+bm_status_t DeviceMemoryBackend::alloc(bm_handle_t handle, int heapMask,
+                                       size_t size, bm_device_mem_t* mem) {
+  return bm_malloc_device_byte_heap_mask(handle, mem, heapMask, size);
+}
+
+void DeviceMemoryBackend::free(bm_handle_t handle, bm_device_mem_t mem) {
+  bm_free_device(handle, mem);
+}
+
+bm_status_t HostMemoryBackend::alloc(bm_handle_t handle, int heapMask,
+                                     size_t size, bm_device_mem_t* mem) {
+  void* ptr = std::malloc(size);
+  if (ptr == nullptr) return BM_ERR_NOMEM;
+  memset(mem, 0, sizeof(bm_device_mem_t));
+  bm_mem_set_device_addr(mem, reinterpret_cast<unsigned long long>(ptr));
+  bm_mem_set_device_size(mem, size);
+  return BM_SUCCESS;
+}
+
+void HostMemoryBackend::free(bm_handle_t handle, bm_device_mem_t mem) {
+  std::free(reinterpret_cast<void*>(bm_mem_get_device_addr(mem)));
+}
+
+DeviceMemoryPool::DeviceMemoryPool()
+    : mBackend(std::make_shared<DeviceMemoryBackend>()) {}
+
+void DeviceMemoryPool::setBackend(std::shared_ptr<MemoryBackend> backend) {
+  std::lock_guard<std::mutex> lk(mMutex);
+  if (!mUsedBlocks.empty() || !mFreeBlocks.empty()) {
+    IVS_WARN("DeviceMemoryPool already in use, backend not changed");
+    return;
+  }
+  mBackend = backend;
+}
+
+size_t DeviceMemoryPool::sizeClass(size_t size) {
+  constexpr size_t MIN_CLASS = 4096;
+  if (size <= MIN_CLASS) return MIN_CLASS;
+  size_t power = MIN_CLASS;
+  while (power * 2 <= size) power *= 2;
+  size_t step = power / 8;
+  return (size + step - 1) / step * step;
+}
+
+bm_status_t DeviceMemoryPool::allocHeap(bm_handle_t handle,
+                                        bm_device_mem_t* mem, int heapId,
+                                        size_t size) {
+  return alloc(handle, mem, 1 << heapId, size);
+}
+
+bm_status_t DeviceMemoryPool::alloc(bm_handle_t handle, bm_device_mem_t* mem,
+                                    int heapMask, size_t size) {
+  PoolKey key(handle, heapMask, sizeClass(size));
+  bm_device_mem_t block;
+  std::shared_ptr<MemoryBackend> backend;
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    auto freeIt = mFreeBlocks.find(key);
+    if (freeIt != mFreeBlocks.end() && !freeIt->second.empty()) {
+      block = freeIt->second.back();
+      freeIt->second.pop_back();
+      mStats.mCachedBytes -= std::get<2>(key);
+      ++mStats.mHits;
+      recordUsed(key, block);
+      *mem = block;
+      bm_mem_set_device_size(mem, size);
+      return BM_SUCCESS;
+    }
+    backend = mBackend;
+  }
+
+  // 设备分配器可能很慢，不持有锁，其他handle与档位的申请不用等待
+  auto ret = backend->alloc(handle, heapMask, std::get<2>(key), &block);
+  if (ret != BM_SUCCESS) {
+    // 缓存占住了heap，释放该heap上的缓存后再试一次
+    std::vector<bm_device_mem_t> flushed;
+    {
+      std::lock_guard<std::mutex> lk(mMutex);
+      for (auto it = mFreeBlocks.begin(); it != mFreeBlocks.end(); ++it) {
+        if (std::get<0>(it->first) != handle ||
+            std::get<1>(it->first) != heapMask)
+          continue;
+        flushed.insert(flushed.end(), it->second.begin(), it->second.end());
+        mStats.mCachedBytes -= std::get<2>(it->first) * it->second.size();
+        it->second.clear();
+      }
+    }
+    for (auto& cached : flushed) backend->free(handle, cached);
+    ret = backend->alloc(handle, heapMask, std::get<2>(key), &block);
+    if (ret != BM_SUCCESS) {
+      IVS_ERROR("DeviceMemoryPool alloc failed, heap mask: {0}, size: {1}",
+                heapMask, size);
+      return ret;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    ++mStats.mMisses;
+    recordUsed(key, block);
+  }
+  *mem = block;
+  bm_mem_set_device_size(mem, size);
+  return BM_SUCCESS;
+}
+
+void DeviceMemoryPool::recordUsed(const PoolKey& key,
+                                  const bm_device_mem_t& block) {
+  mUsedBlocks[BlockKey(std::get<0>(key), bm_mem_get_device_addr(block))] = {
+      key, block};
+  mStats.mInUseBytes += std::get<2>(key);
+  if (mStats.mInUseBytes > mStats.mHighWaterBytes)
+    mStats.mHighWaterBytes = mStats.mInUseBytes;
+}
+
+void DeviceMemoryPool::free(bm_handle_t handle, bm_device_mem_t mem) {
+  std::shared_ptr<MemoryBackend> backend;
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    auto usedIt =
+        mUsedBlocks.find(BlockKey(handle, bm_mem_get_device_addr(mem)));
+    if (usedIt != mUsedBlocks.end()) {
+      const PoolKey& key = usedIt->second.mKey;
+      mFreeBlocks[key].push_back(usedIt->second.mMem);
+      mStats.mInUseBytes -= std::get<2>(key);
+      mStats.mCachedBytes += std::get<2>(key);
+      mUsedBlocks.erase(usedIt);
+      return;
+    }
+    backend = mBackend;
+  }
+  // 不是从内存池申请的
+  backend->free(handle, mem);
+}
+
+bm_status_t DeviceMemoryPool::allocImage(bm_handle_t handle, bm_image& image,
+                                         int heapMask) {
+  int planeNum = bm_image_get_plane_num(image);
+  int sizes[4] = {0};
+  bm_device_mem_t mems[4];
+  auto ret = bm_image_get_byte_size(image, sizes);
+  if (ret != BM_SUCCESS) return ret;
+  for (int i = 0; i < planeNum; ++i) {
+    ret = alloc(handle, &mems[i], heapMask, sizes[i]);
+    if (ret != BM_SUCCESS) {
+      for (int j = 0; j < i; ++j) free(handle, mems[j]);
+      return ret;
+    }
+  }
+  ret = bm_image_attach(image, mems);
+  if (ret != BM_SUCCESS) {
+    for (int i = 0; i < planeNum; ++i) free(handle, mems[i]);
+  }
+  return ret;
+}
+
+void DeviceMemoryPool::freeImage(bm_handle_t handle, bm_image& image) {
+  if (!bm_image_is_attached(image)) return;
+  int planeNum = bm_image_get_plane_num(image);
+  bm_device_mem_t mems[4];
+  bm_image_get_device_mem(image, mems);
+  bm_image_detach(image);
+  for (int i = 0; i < planeNum; ++i) free(handle, mems[i]);
+}
+
+void DeviceMemoryPool::trim(bm_handle_t handle) {
+  std::map<PoolKey, std::vector<bm_device_mem_t>> trimmed;
+  std::shared_ptr<MemoryBackend> backend;
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    for (auto it = mFreeBlocks.begin(); it != mFreeBlocks.end();) {
+      if (handle != nullptr && std::get<0>(it->first) != handle) {
+        ++it;
+        continue;
+      }
+      mStats.mCachedBytes -= std::get<2>(it->first) * it->second.size();
+      trimmed.insert(mFreeBlocks.extract(it++));
+    }
+    backend = mBackend;
+  }
+  for (auto& blocks : trimmed)
+    for (auto& cached : blocks.second)
+      backend->free(std::get<0>(blocks.first), cached);
+}
+
+DeviceMemoryPool::Stats DeviceMemoryPool::getStats() {
+  std::lock_guard<std::mutex> lk(mMutex);
+  return mStats;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,158 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_DEVICE_MEMORY_POOL_H_
+#define SOPHON_STREAM_COMMON_DEVICE_MEMORY_POOL_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "bmcv_api_ext.h"
+#include "bmlib_runtime.h"
+#include "no_copyable.h"
+#include "singleton.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 内存池向下申请/释放内存的接口
+ */
+class MemoryBackend {
+ public:
+  virtual ~MemoryBackend() = default;
+  virtual bm_status_t alloc(bm_handle_t handle, int heapMask, size_t size,
+                            bm_device_mem_t* mem) = 0;
+  virtual void free(bm_handle_t handle, bm_device_mem_t mem) = 0;
+};
+
+/**
+ * @brief 默认实现，从设备的heap中申请显存
+ */
+class DeviceMemoryBackend : public MemoryBackend {
+ public:
+  bm_status_t alloc(bm_handle_t handle, int heapMask, size_t size,
+                    bm_device_mem_t* mem) override;
+  void free(bm_handle_t handle, bm_device_mem_t mem) override;
+};
+
+/**
+ * @brief 用主机内存模拟显存，device_addr中保存的是主机地址，
+ * 只用于在没有设备的环境下验证内存池本身的逻辑，不能交给bmcv/bmrt使用
+ */
+class HostMemoryBackend : public MemoryBackend {
+ public:
+  bm_status_t alloc(bm_handle_t handle, int heapMask, size_t size,
+                    bm_device_mem_t* mem) override;
+  void free(bm_handle_t handle, bm_device_mem_t mem) override;
+};
+
+/**
+ * @brief 逐帧申请的显存（前处理的bm_image、输入输出tensor）的回收池
+ * 按(handle, heap, 大小档位)分组缓存释放的内存块，下次申请同一档位时直接复用，
+ * 避免每帧都进入设备分配器。大小档位按2的幂次再8等分，浪费不超过1/8。
+ * 返回的bm_device_mem_t大小仍是申请的大小，bm_memcpy等接口的行为不变。
+ * 释放时按地址查找内存块，不是从内存池申请的地址直接交给backend释放。
+ * mMutex只保护缓存与统计，调用backend申请、释放时不持有锁。
+ */
+class DeviceMemoryPool : public NoCopyable {
+ public:
+  struct Stats {
+    // 正在使用的字节数（按档位大小计）
+    size_t mInUseBytes = 0;
+    // 正在使用的字节数的历史最大值
+    size_t mHighWaterBytes = 0;
+    // 缓存在池中、等待复用的字节数
+    size_t mCachedBytes = 0;
+    // 从池中复用的次数
+    size_t mHits = 0;
+    // 向backend申请的次数
+    size_t mMisses = 0;
+  };
+
+  /**
+   * @brief 替换backend，需要在第一次申请之前调用
+   */
+  void setBackend(std::shared_ptr<MemoryBackend> backend);
+
+  /**
+   * @brief 按heap id申请，与bm_malloc_device_byte_heap对应
+   */
+  bm_status_t allocHeap(bm_handle_t handle, bm_device_mem_t* mem, int heapId,
+                        size_t size);
+
+  /**
+   * @brief 按heap mask申请，与bm_malloc_device_byte_heap_mask对应
+   */
+  bm_status_t alloc(bm_handle_t handle, bm_device_mem_t* mem, int heapMask,
+                    size_t size);
+
+  /**
+   * @brief 归还内存块，与bm_free_device对应
+   */
+  void free(bm_handle_t handle, bm_device_mem_t mem);
+
+  /**
+   * @brief 为已create的bm_image按plane申请显存并attach，
+   * 与bm_image_alloc_dev_mem_heap_mask对应
+   */
+  bm_status_t allocImage(bm_handle_t handle, bm_image& image, int heapMask);
+
+  /**
+   * @brief detach并归还bm_image的显存，之后仍需调用bm_image_destroy
+   */
+  void freeImage(bm_handle_t handle, bm_image& image);
+
+  /**
+   * @brief 释放缓存的内存块，handle为nullptr时释放所有handle的缓存
+   */
+  void trim(bm_handle_t handle = nullptr);
+
+  Stats getStats();
+
+  static size_t sizeClass(size_t size);
+
+ private:
+  friend class Singleton<DeviceMemoryPool>;
+
+  DeviceMemoryPool();
+  ~DeviceMemoryPool() = default;
+
+  // (handle, heap mask, 档位大小)
+  using PoolKey = std::tuple<bm_handle_t, int, size_t>;
+  // (handle, 地址)
+  using BlockKey = std::tuple<bm_handle_t, unsigned long long>;
+
+  struct Block {
+    PoolKey mKey;
+    bm_device_mem_t mMem;
+  };
+
+  /**
+   * @brief 记录申请出去的内存块并更新统计，需要持有mMutex
+   */
+  void recordUsed(const PoolKey& key, const bm_device_mem_t& block);
+
+  std::mutex mMutex;
+  std::shared_ptr<MemoryBackend> mBackend;
+  std::map<PoolKey, std::vector<bm_device_mem_t>> mFreeBlocks;
+  std::map<BlockKey, Block> mUsedBlocks;
+  Stats mStats;
+};
+
+using SingletonDeviceMemoryPool = Singleton<DeviceMemoryPool>;
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_DEVICE_MEMORY_POOL_H_
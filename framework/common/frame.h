@@ -53,6 +53,17 @@ struct Frame {
            0 == mDataSize || !mSpData;
   }
 
+  /**
+   * @brief 释放图像，保留宽高、时间戳等信息
+   */
+  void releasePixelData() {
+    mSpData.reset();
+    mSpDataOsd.reset();
+    mSpDataDwa.reset();
+    mSpDataDpu.reset();
+    mMat.release();
+  }
+
   int mChannelId;
   int mChannelIdInternal;
   std::int64_t mFrameId;
@@ -0,0 +1,201 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "frame_tracer.h"
+
+#include <chrono>
+#include <fstream>
+#include <set>
+#include <utility>
+
+#include "common/logger.h"
+#include "nlohmann/json.hpp"
+
+namespace sophon_stream {
+namespace common {
+
+namespace {
+
+/**
+ * @brief 线程退出时归还缓冲，缓冲本身由FrameTracer持有
+ */
+struct ThreadBufferHolder {
+  std::shared_ptr<void> mBuffer;
+  std::atomic<bool>* mOwned = nullptr;
+  int mThreadId = -1;
+  ~ThreadBufferHolder() {
+    if (mOwned != nullptr) mOwned->store(false, std::memory_order_release);
+  }
+};
+
+thread_local ThreadBufferHolder tlsHolder;
+
+}  // namespace
+
+std::int64_t FrameTracer::nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+void FrameTracer::start(int durationSec) {
+  mDeadlineUs.store(durationSec > 0 ? nowUs() + durationSec * 1000000LL : 0,
+                    std::memory_order_relaxed);
+  // 各线程在下一次record时发现代数变化，自行清空自己的缓冲
+  mGeneration.fetch_add(1, std::memory_order_acq_rel);
+  mEnabled.store(true, std::memory_order_release);
+  IVS_INFO("Frame trace started, duration: {0}s", durationSec);
+}
+
+void FrameTracer::stop() {
+  if (mEnabled.exchange(false, std::memory_order_acq_rel))
+    IVS_INFO("Frame trace stopped");
+}
+
+FrameTracer::ThreadBuffer* FrameTracer::getThreadBuffer() {
+  if (tlsHolder.mBuffer)
+    return static_cast<ThreadBuffer*>(tlsHolder.mBuffer.get());
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::shared_ptr<ThreadBuffer> buffer;
+  int threadId = 0;
+  for (; threadId < static_cast<int>(mBuffers.size()); ++threadId) {
+    bool owned = false;
+    if (mBuffers[threadId]->mOwned.compare_exchange_strong(owned, true)) {
+      buffer = mBuffers[threadId];
+      break;
+    }
+  }
+  if (!buffer) {
+    buffer = std::make_shared<ThreadBuffer>();
+    buffer->mEvents.resize(EVENTS_PER_THREAD);
+    buffer->mOwned.store(true);
+    mBuffers.push_back(buffer);
+  }
+  tlsHolder.mBuffer = buffer;
+  tlsHolder.mOwned = &buffer->mOwned;
+  tlsHolder.mThreadId = threadId;
+  return buffer.get();
+}
+
+void FrameTracer::record(const char* name, std::int64_t startUs,
+                         std::int64_t endUs, int elementId, int channelId,
+                         std::int64_t frameId, int subId) {
+  if (!isEnabled()) return;
+  std::int64_t deadline = mDeadlineUs.load(std::memory_order_relaxed);
+  if (deadline > 0 && endUs > deadline) {
+    stop();
+    return;
+  }
+
+  ThreadBuffer* buffer = getThreadBuffer();
+  std::uint64_t generation = mGeneration.load(std::memory_order_acquire);
+  if (buffer->mGeneration.load(std::memory_order_relaxed) != generation) {
+    buffer->mSize.store(0, std::memory_order_relaxed);
+    buffer->mDropped.store(0, std::memory_order_relaxed);
+    buffer->mGeneration.store(generation, std::memory_order_release);
+  }
+
+  std::size_t size = buffer->mSize.load(std::memory_order_relaxed);
+  if (size >= buffer->mEvents.size()) {
+    buffer->mDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  TraceEvent& event = buffer->mEvents[size];
+  event.mName = name;
+  event.mStartUs = startUs;
+  event.mDurationUs = endUs > startUs ? endUs - startUs : 0;
+  event.mElementId = elementId;
+  event.mChannelId = channelId;
+  event.mFrameId = frameId;
+  event.mSubId = subId;
+  event.mThreadId = tlsHolder.mThreadId;
+  // 先写事件再发布size，读端只读取已发布的部分
+  buffer->mSize.store(size + 1, std::memory_order_release);
+}
+
+void FrameTracer::setElementName(int elementId, const std::string& name) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mElementNames[elementId] = name;
+}
+
+std::string FrameTracer::exportChromeTrace() const {
+  std::uint64_t generation = mGeneration.load(std::memory_order_acquire);
+  nlohmann::json events = nlohmann::json::array();
+  std::set<int> channels;
+  std::set<std::pair<int, int>> threads;
+  std::uint64_t dropped = 0;
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  for (const auto& buffer : mBuffers) {
+    if (buffer->mGeneration.load(std::memory_order_acquire) != generation)
+      continue;
+    std::size_t size = buffer->mSize.load(std::memory_order_acquire);
+    dropped += buffer->mDropped.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < size; ++i) {
+      const TraceEvent& event = buffer->mEvents[i];
+      // 同一帧（含拆分出的子对象）的所有片段用flow连接
+      std::uint64_t bindId =
+          (static_cast<std::uint64_t>(event.mChannelId) << 40) |
+          (static_cast<std::uint64_t>(event.mFrameId) & ((1ULL << 40) - 1));
+      events.push_back({{"name", event.mName},
+                        {"cat", "frame"},
+                        {"ph", "X"},
+                        {"ts", event.mStartUs},
+                        {"dur", event.mDurationUs},
+                        {"pid", event.mChannelId},
+                        {"tid", event.mElementId},
+                        {"bind_id", bindId},
+                        {"flow_in", true},
+                        {"flow_out", true},
+                        {"args",
+                         {{"frame_id", event.mFrameId},
+                          {"sub_id", event.mSubId},
+                          {"thread", event.mThreadId}}}});
+      channels.insert(event.mChannelId);
+      threads.emplace(event.mChannelId, event.mElementId);
+    }
+  }
+
+  for (int channel : channels) {
+    events.push_back({{"name", "process_name"},
+                      {"ph", "M"},
+                      {"pid", channel},
+                      {"args", {{"name", "channel " + std::to_string(channel)}}}});
+  }
+  for (const auto& thread : threads) {
+    std::string name = "element " + std::to_string(thread.second);
+    auto it = mElementNames.find(thread.second);
+    if (it != mElementNames.end() && !it->second.empty())
+      name += " (" + it->second + ")";
+    events.push_back({{"name", "thread_name"},
+                      {"ph", "M"},
+                      {"pid", thread.first},
+                      {"tid", thread.second},
+                      {"args", {{"name", name}}}});
+  }
+
+  nlohmann::json trace = {{"traceEvents", std::move(events)},
+                          {"displayTimeUnit", "ms"},
+                          {"otherData", {{"dropped_events", dropped}}}};
+  return trace.dump();
+}
+
+bool FrameTracer::dump(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    IVS_ERROR("Can not open trace file: {0}", path);
+    return false;
+  }
+  out << exportChromeTrace();
+  return out.good();
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_FRAME_TRACER_H_
+#define SOPHON_STREAM_COMMON_FRAME_TRACER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "no_copyable.h"
+#include "singleton.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 一段帧追踪记录，name必须是静态字符串
+ */
+struct TraceEvent {
+  const char* mName;
+  std::int64_t mStartUs;
+  std::int64_t mDurationUs;
+  int mElementId;
+  int mChannelId;
+  std::int64_t mFrameId;
+  int mSubId;
+  int mThreadId;
+};
+
+/**
+ * @brief 逐帧追踪，记录每一帧在各element中排队(queue)与处理(process)的时间段，
+ * 导出为Chrome trace JSON，可以用chrome://tracing或ui.perfetto.dev打开。
+ * 每个线程写自己的定长缓冲，写入只有原子store，缓冲写满后丢弃新的记录。
+ * 时间使用与Frame::mTimestamp相同的墙上时钟，单位为微秒。
+ * 未开启时Element中只有一次原子load的开销。
+ */
+class FrameTracer : public NoCopyable {
+ public:
+  /**
+   * @brief 清空之前的记录并开始追踪
+   * @param[in] durationSec : 大于0时追踪durationSec秒后自动停止
+   */
+  void start(int durationSec = 0);
+
+  void stop();
+
+  bool isEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+  void record(const char* name, std::int64_t startUs, std::int64_t endUs,
+              int elementId, int channelId, std::int64_t frameId, int subId);
+
+  /**
+   * @brief 设置element在trace中显示的名字
+   */
+  void setElementName(int elementId, const std::string& name);
+
+  /**
+   * @brief 导出当前的记录，追踪可以仍在进行
+   */
+  std::string exportChromeTrace() const;
+
+  bool dump(const std::string& path) const;
+
+  static std::int64_t nowUs();
+
+  static constexpr std::size_t EVENTS_PER_THREAD = 1 << 15;
+
+ private:
+  friend class Singleton<FrameTracer>;
+  FrameTracer() = default;
+
+  struct ThreadBuffer {
+    std::vector<TraceEvent> mEvents;
+    std::atomic<std::size_t> mSize{0};
+    std::atomic<std::uint64_t> mGeneration{0};
+    std::atomic<std::uint64_t> mDropped{0};
+    // 线程退出后缓冲交给新线程复用
+    std::atomic<bool> mOwned{false};
+  };
+
+  ThreadBuffer* getThreadBuffer();
+
+  std::atomic<bool> mEnabled{false};
+  std::atomic<std::uint64_t> mGeneration{0};
+  std::atomic<std::int64_t> mDeadlineUs{0};
+
+  mutable std::mutex mMutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> mBuffers;
+  std::map<int, std::string> mElementNames;
+};
+
+using SingletonFrameTracer = Singleton<FrameTracer>;
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_FRAME_TRACER_H_
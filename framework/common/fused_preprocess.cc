@@ -0,0 +1,293 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "fused_preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STREAM_FUSED_PREPROCESS_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define STREAM_FUSED_PREPROCESS_NEON 1
+#endif
+
+namespace sophon_stream {
+namespace common {
+
+namespace {
+
+// BT.601 limited range，与VPP默认的YUV转RGB系数一致
+constexpr float YUV_Y = 1.164f;
+constexpr float YUV_RV = 1.596f;
+constexpr float YUV_GU = -0.391f;
+constexpr float YUV_GV = -0.813f;
+constexpr float YUV_BU = 2.018f;
+
+struct Tap {
+  int i0;
+  int i1;
+  float w;
+};
+
+// 按像素中心对齐计算双线性插值的采样位置，坐标为原图中的绝对坐标
+void buildTaps(int dstLen, int srcStart, int srcLen, std::vector<Tap>& luma,
+               std::vector<Tap>& chroma, int chromaLimit) {
+  luma.resize(dstLen);
+  chroma.resize(dstLen);
+  float scale = static_cast<float>(srcLen) / dstLen;
+  for (int d = 0; d < dstLen; ++d) {
+    float s = std::max((d + 0.5f) * scale - 0.5f, 0.f);
+    int i0 = std::min(static_cast<int>(s), srcLen - 1);
+    int i1 = std::min(i0 + 1, srcLen - 1);
+    luma[d] = {srcStart + i0, srcStart + i1, s - static_cast<int>(s)};
+
+    float c = std::max((srcStart + s + 0.5f) * 0.5f - 0.5f, 0.f);
+    int c0 = std::min(static_cast<int>(c), chromaLimit - 1);
+    int c1 = std::min(c0 + 1, chromaLimit - 1);
+    chroma[d] = {c0, c1, c - static_cast<int>(c)};
+  }
+}
+
+struct ColorCoef {
+  // 按r、g、b顺序
+  float alpha[3];
+  float beta[3];
+};
+
+void convertRowScalar(const float* y, const float* u, const float* v, int n,
+                      const ColorCoef& coef, float* outR, float* outG,
+                      float* outB) {
+  for (int i = 0; i < n; ++i) {
+    float yy = YUV_Y * (y[i] - 16.f);
+    float uu = u[i] - 128.f;
+    float vv = v[i] - 128.f;
+    float r = std::min(std::max(yy + YUV_RV * vv, 0.f), 255.f);
+    float g = std::min(std::max(yy + YUV_GU * uu + YUV_GV * vv, 0.f), 255.f);
+    float b = std::min(std::max(yy + YUV_BU * uu, 0.f), 255.f);
+    outR[i] = r * coef.alpha[0] + coef.beta[0];
+    outG[i] = g * coef.alpha[1] + coef.beta[1];
+    outB[i] = b * coef.alpha[2] + coef.beta[2];
+  }
+}
+
+#ifdef STREAM_FUSED_PREPROCESS_X86
+__attribute__((target("avx2,fma"))) void convertRowAvx2(
+    const float* y, const float* u, const float* v, int n,
+    const ColorCoef& coef, float* outR, float* outG, float* outB) {
+  const __m256 k16 = _mm256_set1_ps(16.f);
+  const __m256 k128 = _mm256_set1_ps(128.f);
+  const __m256 kY = _mm256_set1_ps(YUV_Y);
+  const __m256 kRV = _mm256_set1_ps(YUV_RV);
+  const __m256 kGU = _mm256_set1_ps(YUV_GU);
+  const __m256 kGV = _mm256_set1_ps(YUV_GV);
+  const __m256 kBU = _mm256_set1_ps(YUV_BU);
+  const __m256 kMin = _mm256_setzero_ps();
+  const __m256 kMax = _mm256_set1_ps(255.f);
+  const __m256 aR = _mm256_set1_ps(coef.alpha[0]);
+  const __m256 aG = _mm256_set1_ps(coef.alpha[1]);
+  const __m256 aB = _mm256_set1_ps(coef.alpha[2]);
+  const __m256 bR = _mm256_set1_ps(coef.beta[0]);
+  const __m256 bG = _mm256_set1_ps(coef.beta[1]);
+  const __m256 bB = _mm256_set1_ps(coef.beta[2]);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 yy = _mm256_mul_ps(kY, _mm256_sub_ps(_mm256_loadu_ps(y + i), k16));
+    __m256 uu = _mm256_sub_ps(_mm256_loadu_ps(u + i), k128);
+    __m256 vv = _mm256_sub_ps(_mm256_loadu_ps(v + i), k128);
+    __m256 r = _mm256_fmadd_ps(kRV, vv, yy);
+    __m256 g = _mm256_fmadd_ps(kGV, vv, _mm256_fmadd_ps(kGU, uu, yy));
+    __m256 b = _mm256_fmadd_ps(kBU, uu, yy);
+    r = _mm256_min_ps(_mm256_max_ps(r, kMin), kMax);
+    g = _mm256_min_ps(_mm256_max_ps(g, kMin), kMax);
+    b = _mm256_min_ps(_mm256_max_ps(b, kMin), kMax);
+    _mm256_storeu_ps(outR + i, _mm256_fmadd_ps(r, aR, bR));
+    _mm256_storeu_ps(outG + i, _mm256_fmadd_ps(g, aG, bG));
+    _mm256_storeu_ps(outB + i, _mm256_fmadd_ps(b, aB, bB));
+  }
+  convertRowScalar(y + i, u + i, v + i, n - i, coef, outR + i, outG + i,
+                   outB + i);
+}
+#endif
+
+#ifdef STREAM_FUSED_PREPROCESS_NEON
+void convertRowNeon(const float* y, const float* u, const float* v, int n,
+                    const ColorCoef& coef, float* outR, float* outG,
+                    float* outB) {
+  const float32x4_t k16 = vdupq_n_f32(16.f);
+  const float32x4_t k128 = vdupq_n_f32(128.f);
+  const float32x4_t kMin = vdupq_n_f32(0.f);
+  const float32x4_t kMax = vdupq_n_f32(255.f);
+  const float32x4_t aR = vdupq_n_f32(coef.alpha[0]);
+  const float32x4_t aG = vdupq_n_f32(coef.alpha[1]);
+  const float32x4_t aB = vdupq_n_f32(coef.alpha[2]);
+  const float32x4_t bR = vdupq_n_f32(coef.beta[0]);
+  const float32x4_t bG = vdupq_n_f32(coef.beta[1]);
+  const float32x4_t bB = vdupq_n_f32(coef.beta[2]);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t yy = vmulq_n_f32(vsubq_f32(vld1q_f32(y + i), k16), YUV_Y);
+    float32x4_t uu = vsubq_f32(vld1q_f32(u + i), k128);
+    float32x4_t vv = vsubq_f32(vld1q_f32(v + i), k128);
+    float32x4_t r = vfmaq_n_f32(yy, vv, YUV_RV);
+    float32x4_t g = vfmaq_n_f32(vfmaq_n_f32(yy, uu, YUV_GU), vv, YUV_GV);
+    float32x4_t b = vfmaq_n_f32(yy, uu, YUV_BU);
+    r = vminq_f32(vmaxq_f32(r, kMin), kMax);
+    g = vminq_f32(vmaxq_f32(g, kMin), kMax);
+    b = vminq_f32(vmaxq_f32(b, kMin), kMax);
+    vst1q_f32(outR + i, vfmaq_f32(bR, r, aR));
+    vst1q_f32(outG + i, vfmaq_f32(bG, g, aG));
+    vst1q_f32(outB + i, vfmaq_f32(bB, b, aB));
+  }
+  convertRowScalar(y + i, u + i, v + i, n - i, coef, outR + i, outG + i,
+                   outB + i);
+}
+#endif
+
+using ConvertRowFunc = void (*)(const float*, const float*, const float*, int,
+                                const ColorCoef&, float*, float*, float*);
+
+ConvertRowFunc selectConvertRow() {
+#if defined(STREAM_FUSED_PREPROCESS_X86)
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return convertRowAvx2;
+#elif defined(STREAM_FUSED_PREPROCESS_NEON)
+  return convertRowNeon;
+#endif
+  return convertRowScalar;
+}
+
+inline float lerp(float a, float b, float w) { return a + (b - a) * w; }
+
+}  // namespace
+
+LetterboxRect computeLetterbox(int srcW, int srcH, int netW, int netH) {
+  LetterboxRect rect;
+  float ratioW = static_cast<float>(netW) / srcW;
+  float ratioH = static_cast<float>(netH) / srcH;
+  if (ratioH > ratioW) {
+    rect.ratio = ratioW;
+    rect.w = netW;
+    rect.h = static_cast<int>(srcH * ratioW);
+    rect.x = 0;
+    rect.y = (netH - rect.h) / 2;
+  } else {
+    rect.ratio = ratioH;
+    rect.w = static_cast<int>(srcW * ratioH);
+    rect.h = netH;
+    rect.x = (netW - rect.w) / 2;
+    rect.y = 0;
+  }
+  return rect;
+}
+
+LetterboxRect fusedPreprocess(const YuvImageView& src,
+                              const FusedPreprocessParam& param, float* dst) {
+  static const ConvertRowFunc convertRow = selectConvertRow();
+
+  bool useRoi = param.roiW > 0 && param.roiH > 0;
+  int cropX = useRoi ? param.roiX : 0;
+  int cropY = useRoi ? param.roiY : 0;
+  int cropW = useRoi ? param.roiW : src.width;
+  int cropH = useRoi ? param.roiH : src.height;
+  LetterboxRect rect =
+      computeLetterbox(cropW, cropH, param.netW, param.netH);
+
+  const int planeSize = param.netW * param.netH;
+  ColorCoef coef;
+  float* out[3];
+  float pad[3];
+  for (int c = 0; c < 3; ++c) {
+    // c为r、g、b，p为输出平面
+    int p = param.bgr2rgb ? c : 2 - c;
+    coef.alpha[c] = param.alpha[p];
+    coef.beta[c] = param.beta[p];
+    out[c] = dst + p * planeSize;
+    pad[c] = param.padValue * param.alpha[p] + param.beta[p];
+  }
+
+  thread_local std::vector<Tap> colLuma, colChroma, rowLuma, rowChroma;
+  thread_local std::vector<float> bufY, bufU, bufV;
+  buildTaps(rect.w, cropX, cropW, colLuma, colChroma, (src.width + 1) / 2);
+  buildTaps(rect.h, cropY, cropH, rowLuma, rowChroma, (src.height + 1) / 2);
+  bufY.resize(rect.w);
+  bufU.resize(rect.w);
+  bufV.resize(rect.w);
+
+  for (int dy = 0; dy < param.netH; ++dy) {
+    int offset = dy * param.netW;
+    int ry = dy - rect.y;
+    if (ry < 0 || ry >= rect.h) {
+      for (int c = 0; c < 3; ++c)
+        std::fill(out[c] + offset, out[c] + offset + param.netW, pad[c]);
+      continue;
+    }
+    for (int c = 0; c < 3; ++c) {
+      std::fill(out[c] + offset, out[c] + offset + rect.x, pad[c]);
+      std::fill(out[c] + offset + rect.x + rect.w,
+                out[c] + offset + param.netW, pad[c]);
+    }
+
+    const Tap& ty = rowLuma[ry];
+    const Tap& tc = rowChroma[ry];
+    const uint8_t* y0 = src.data[0] + ty.i0 * src.stride[0];
+    const uint8_t* y1 = src.data[0] + ty.i1 * src.stride[0];
+    for (int x = 0; x < rect.w; ++x) {
+      const Tap& tx = colLuma[x];
+      bufY[x] = lerp(lerp(y0[tx.i0], y0[tx.i1], tx.w),
+                     lerp(y1[tx.i0], y1[tx.i1], tx.w), ty.w);
+    }
+    if (src.format == YuvFormat::NV12) {
+      const uint8_t* c0 = src.data[1] + tc.i0 * src.stride[1];
+      const uint8_t* c1 = src.data[1] + tc.i1 * src.stride[1];
+      for (int x = 0; x < rect.w; ++x) {
+        const Tap& tx = colChroma[x];
+        int u0 = tx.i0 * 2, u1 = tx.i1 * 2;
+        bufU[x] = lerp(lerp(c0[u0], c0[u1], tx.w), lerp(c1[u0], c1[u1], tx.w),
+                       tc.w);
+        bufV[x] = lerp(lerp(c0[u0 + 1], c0[u1 + 1], tx.w),
+                       lerp(c1[u0 + 1], c1[u1 + 1], tx.w), tc.w);
+      }
+    } else {
+      const uint8_t* u0 = src.data[1] + tc.i0 * src.stride[1];
+      const uint8_t* u1 = src.data[1] + tc.i1 * src.stride[1];
+      const uint8_t* v0 = src.data[2] + tc.i0 * src.stride[2];
+      const uint8_t* v1 = src.data[2] + tc.i1 * src.stride[2];
+      for (int x = 0; x < rect.w; ++x) {
+        const Tap& tx = colChroma[x];
+        bufU[x] = lerp(lerp(u0[tx.i0], u0[tx.i1], tx.w),
+                       lerp(u1[tx.i0], u1[tx.i1], tx.w), tc.w);
+        bufV[x] = lerp(lerp(v0[tx.i0], v0[tx.i1], tx.w),
+                       lerp(v1[tx.i0], v1[tx.i1], tx.w), tc.w);
+      }
+    }
+    offset += rect.x;
+    convertRow(bufY.data(), bufU.data(), bufV.data(), rect.w, coef,
+               out[0] + offset, out[1] + offset, out[2] + offset);
+  }
+  return rect;
+}
+
+LetterboxRect fusedPreprocess(const YuvImageView& src,
+                              const FusedPreprocessParam& param, int8_t* dst) {
+  thread_local std::vector<float> buffer;
+  buffer.resize(3 * param.netW * param.netH);
+  LetterboxRect rect = fusedPreprocess(src, param, buffer.data());
+  for (size_t i = 0; i < buffer.size(); ++i) {
+    float value = std::nearbyint(buffer[i]);
+    dst[i] = static_cast<int8_t>(std::min(std::max(value, -128.f), 127.f));
+  }
+  return rect;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
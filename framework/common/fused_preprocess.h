@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_FUSED_PREPROCESS_H_
+#define SOPHON_STREAM_COMMON_FUSED_PREPROCESS_H_
+
+#include <cstdint>
+
+namespace sophon_stream {
+namespace common {
+
+enum class YuvFormat { NV12, YUV420P };
+
+/**
+ * @brief 主机内存中的一帧YUV图像，NV12时data[1]为交织的UV平面
+ */
+struct YuvImageView {
+  YuvFormat format = YuvFormat::NV12;
+  int width = 0;
+  int height = 0;
+  const uint8_t* data[3] = {nullptr, nullptr, nullptr};
+  int stride[3] = {0, 0, 0};
+};
+
+/**
+ * @brief 融合前处理的参数，与Context中的字段对应
+ * 输出第p个平面的值为 pixel * alpha[p] + beta[p]，与bmcv_convert_to_attr一致
+ */
+struct FusedPreprocessParam {
+  int netW = 0;
+  int netH = 0;
+  // true时输出平面顺序为r、g、b，否则为b、g、r
+  bool bgr2rgb = true;
+  float alpha[3] = {1.f, 1.f, 1.f};
+  float beta[3] = {0.f, 0.f, 0.f};
+  // 只处理roi框取的区域，roiW或roiH为0时处理整幅图像
+  int roiX = 0;
+  int roiY = 0;
+  int roiW = 0;
+  int roiH = 0;
+  uint8_t padValue = 114;
+};
+
+/**
+ * @brief 等比缩放后图像在网络输入中的位置
+ */
+struct LetterboxRect {
+  float ratio = 1.f;
+  int x = 0;
+  int y = 0;
+  int w = 0;
+  int h = 0;
+};
+
+/**
+ * @brief 计算居中letterbox的位置，与bmcv_image_vpp_convert_padding的用法一致
+ */
+LetterboxRect computeLetterbox(int srcW, int srcH, int netW, int netH);
+
+/**
+ * @brief 一次遍历完成 YUV转RGB + 双线性缩放 + letterbox填充 + 归一化，
+ * 直接写出netH*netW的平面float tensor，不产生中间图像。
+ * x86上运行时检测AVX2，aarch64上使用NEON，其它平台走标量实现。
+ * @return 图像在网络输入中的位置
+ */
+LetterboxRect fusedPreprocess(const YuvImageView& src,
+                              const FusedPreprocessParam& param, float* dst);
+
+/**
+ * @brief 同上，输出饱和到int8，用于INT8输入的模型
+ */
+LetterboxRect fusedPreprocess(const YuvImageView& src,
+                              const FusedPreprocessParam& param, int8_t* dst);
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_FUSED_PREPROCESS_H_
@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "input_synchronizer.h"
+
+#include <algorithm>
+
+#include "common/logger.h"
+#include "common/metrics.h"
+
+namespace sophon_stream {
+namespace common {
+
+InputSynchronizer::InputSynchronizer()
+    : mMode(MatchMode::FRAME_ID),
+      mTolerance(0),
+      mBufferSize(DEFAULT_BUFFER_SIZE) {}
+
+ErrorCode InputSynchronizer::init(const nlohmann::json& configure) {
+  auto modeIt = configure.find(JSON_SYNC_MODE_FIELD);
+  if (modeIt != configure.end() && modeIt->is_string()) {
+    std::string mode = modeIt->get<std::string>();
+    if (mode == "FRAME_ID") {
+      mMode = MatchMode::FRAME_ID;
+    } else if (mode == "TIMESTAMP") {
+      mMode = MatchMode::TIMESTAMP;
+    } else {
+      IVS_ERROR("{0} only support FRAME_ID and TIMESTAMP, got {1}",
+                JSON_SYNC_MODE_FIELD, mode);
+      return ErrorCode::PARSE_CONFIGURE_FAIL;
+    }
+  }
+
+  auto toleranceIt = configure.find(JSON_SYNC_TOLERANCE_FIELD);
+  if (toleranceIt != configure.end() && toleranceIt->is_number_integer()) {
+    mTolerance = std::max<std::int64_t>(0, toleranceIt->get<std::int64_t>());
+  }
+
+  auto bufferSizeIt = configure.find(JSON_SYNC_BUFFER_SIZE_FIELD);
+  if (bufferSizeIt != configure.end() && bufferSizeIt->is_number_integer()) {
+    mBufferSize = std::max(1, bufferSizeIt->get<int>());
+  }
+  return ErrorCode::SUCCESS;
+}
+
+std::int64_t InputSynchronizer::getKey(
+    const std::shared_ptr<ObjectMetadata>& data) const {
+  if (data->mFrame == nullptr) return -1;
+  return mMode == MatchMode::FRAME_ID ? data->mFrame->mFrameId
+                                      : data->mFrame->mTimestamp;
+}
+
+Counter* InputSynchronizer::syncDropped(int channelId) {
+  auto counterIt = mSyncDropped.find(channelId);
+  if (counterIt != mSyncDropped.end()) return counterIt->second;
+  Counter* counter =
+      SingletonMetricsRegistry::getInstance().frameDroppedCounter(channelId,
+                                                                  "sync");
+  mSyncDropped.emplace(channelId, counter);
+  return counter;
+}
+
+bool InputSynchronizer::fetch(int portNum, const PopHandler& popHandler) {
+  if (mBuffers.size() != static_cast<std::size_t>(portNum)) {
+    mBuffers.resize(portNum);
+    mDroppedCounts.resize(portNum, 0);
+  }
+
+  bool fetched = false;
+  for (int i = 0; i < portNum; ++i) {
+    auto& buffer = mBuffers[i];
+    while (buffer.size() < mBufferSize) {
+      auto data = popHandler(i);
+      if (data == nullptr) break;
+      buffer.push_back(std::static_pointer_cast<ObjectMetadata>(data));
+      fetched = true;
+    }
+  }
+  return fetched;
+}
+
+bool InputSynchronizer::pop(ObjectMetadatas& matched) {
+  if (mBuffers.empty()) return false;
+
+  while (true) {
+    std::int64_t newest = 0;
+    for (std::size_t i = 0; i < mBuffers.size(); ++i) {
+      if (mBuffers[i].empty()) return false;
+      std::int64_t key = getKey(mBuffers[i].front());
+      newest = (i == 0) ? key : std::max(newest, key);
+    }
+
+    bool dropped = false;
+    for (std::size_t i = 0; i < mBuffers.size(); ++i) {
+      auto& buffer = mBuffers[i];
+      if (getKey(buffer.front()) >= newest - mTolerance) continue;
+      ++mDroppedCounts[i];
+      IVS_DEBUG(
+          "Input synchronizer drop frame, port index: {0}, key: {1}, newest "
+          "key: {2}, dropped count: {3}",
+          i, getKey(buffer.front()), newest, mDroppedCounts[i]);
+      if (buffer.front()->mFrame != nullptr) {
+        Counter* counter = syncDropped(buffer.front()->mFrame->mChannelId);
+        if (counter) counter->inc();
+      }
+      buffer.pop_front();
+      dropped = true;
+    }
+    if (dropped) continue;
+
+    matched.clear();
+    for (auto& buffer : mBuffers) {
+      matched.push_back(buffer.front());
+      buffer.pop_front();
+    }
+    return true;
+  }
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_INPUT_SYNCHRONIZER_H_
+#define SOPHON_STREAM_COMMON_INPUT_SYNCHRONIZER_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "common/error_code.h"
+#include "common/metrics.h"
+#include "common/object_metadata.h"
+#include "nlohmann/json.hpp"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 多输入对齐器，供Stitch、Blend等多输入element使用
+ * 每个输入端口维护一个缓冲，按frame id或时间戳匹配各端口的帧，匹配成功后一起输出。
+ * 丢帧策略：
+ * 1. 各端口队首不能对齐时，丢弃比最新队首旧(超出容差)的帧，这些帧已不可能再匹配；
+ * 2. 端口缓冲已满时不再从该端口读取数据，由上游队列反压，不丢弃缓冲中的帧。
+ * 一个实例只能由一个线程使用，多个dataPipe需要各自持有一个实例。
+ */
+class InputSynchronizer {
+ public:
+  enum class MatchMode {
+    FRAME_ID,
+    TIMESTAMP,
+  };
+
+  using PopHandler = std::function<std::shared_ptr<void>(int portIndex)>;
+
+  InputSynchronizer();
+
+  /**
+   * @brief 从element的configure中解析sync_mode、sync_tolerance、sync_buffer_size
+   * @brief 字段均为可选，缺省时按frame id严格匹配
+   */
+  ErrorCode init(const nlohmann::json& configure);
+
+  /**
+   * @brief 从各端口读取数据，直到端口为空或缓冲已满
+   * @param[in] portNum : 输入端口数量
+   * @param[in] popHandler : 按端口下标从输入队列取数据，队列为空时返回nullptr
+   * @return 是否读到了新数据
+   */
+  bool fetch(int portNum, const PopHandler& popHandler);
+
+  /**
+   * @brief 取出一组对齐的帧，按端口顺序放入matched
+   * @return 各端口都有可对齐的帧时返回true
+   */
+  bool pop(ObjectMetadatas& matched);
+
+  static constexpr const char* JSON_SYNC_MODE_FIELD = "sync_mode";
+  static constexpr const char* JSON_SYNC_TOLERANCE_FIELD = "sync_tolerance";
+  static constexpr const char* JSON_SYNC_BUFFER_SIZE_FIELD = "sync_buffer_size";
+
+  static constexpr int DEFAULT_BUFFER_SIZE = 8;
+
+ private:
+  std::int64_t getKey(const std::shared_ptr<ObjectMetadata>& data) const;
+
+  // 该通道对齐时丢帧的计数器，每个通道只在第一次丢帧时查注册表
+  Counter* syncDropped(int channelId);
+
+  MatchMode mMode;
+  // 同一组帧的key允许的最大差值，FRAME_ID模式下一般为0
+  std::int64_t mTolerance;
+  std::size_t mBufferSize;
+
+  std::vector<std::deque<std::shared_ptr<ObjectMetadata>>> mBuffers;
+  std::vector<std::uint64_t> mDroppedCounts;
+  std::map<int, Counter*> mSyncDropped;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_INPUT_SYNCHRONIZER_H_
@@ -0,0 +1,41 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "keyframe_scheduler.h"
+
+namespace sophon_stream {
+namespace common {
+
+bool KeyframeScheduler::nextIsKeyframe(int graphId, int channelId,
+                                       int interval) {
+  if (interval <= 1) return true;
+  std::lock_guard<std::mutex> lock(mMutex);
+  ChannelState& state = mChannels[std::make_pair(graphId, channelId)];
+  if (state.mForced || state.mCount % interval == 0) {
+    state.mForced = false;
+    state.mCount = 1;
+    return true;
+  }
+  ++state.mCount;
+  return false;
+}
+
+void KeyframeScheduler::requestKeyframe(int graphId, int channelId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mChannels.find(std::make_pair(graphId, channelId));
+  if (it != mChannels.end()) it->second.mForced = true;
+}
+
+void KeyframeScheduler::removeChannel(int graphId, int channelId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mChannels.erase(std::make_pair(graphId, channelId));
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_KEYFRAME_SCHEDULER_H_
+#define SOPHON_STREAM_COMMON_KEYFRAME_SCHEDULER_H_
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "no_copyable.h"
+#include "singleton.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 按通道决定哪些帧经过检测(关键帧)，其余帧由跟踪器预测目标框。
+ * 解码element每一帧询问一次，跟踪element在预测不确定时请求下一帧立即检测
+ */
+class KeyframeScheduler : public NoCopyable {
+ public:
+  /**
+   * @brief 当前帧是否需要检测。每interval帧检测一次，
+   * 有requestKeyframe的请求时当前帧检测并重新开始计数
+   */
+  bool nextIsKeyframe(int graphId, int channelId, int interval);
+
+  /**
+   * @brief 请求通道的下一帧检测
+   */
+  void requestKeyframe(int graphId, int channelId);
+
+  /**
+   * @brief 通道开始或结束时清除计数，下一帧一定是关键帧
+   */
+  void removeChannel(int graphId, int channelId);
+
+ private:
+  friend class Singleton<KeyframeScheduler>;
+  KeyframeScheduler() = default;
+
+  struct ChannelState {
+    int mCount = 0;
+    bool mForced = false;
+  };
+
+  std::mutex mMutex;
+  std::map<std::pair<int /* graphId */, int /* channelId */>, ChannelState>
+      mChannels;
+};
+
+using SingletonKeyframeScheduler = Singleton<KeyframeScheduler>;
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_KEYFRAME_SCHEDULER_H_
@@ -1,6 +1,13 @@
 #include "common/logger.h"
 
 #include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 const char* LoggerName = "engine";
 
 Logger::Logger(const std::string& path) {
@@ -19,7 +26,8 @@ Logger::Logger(const std::string& path) {
   // Use sinks to create logger instance
   auto logger =
       std::make_shared<spdlog::logger>(LoggerName, sinks.begin(), sinks.end());
-  logger->set_level(spdlog::level::info);
+  // 级别在IVS_*宏的调用点过滤
+  logger->set_level(spdlog::level::trace);
 
   mLogger = logger;
 }
@@ -33,7 +41,306 @@ std::shared_ptr<spdlog::logger>& Logger::getLogger(const std::string& path) {
   return logger.getInstance();
 }
 
-void logInit(const std::string& name, const std::string& path) {
+namespace ivslog {
+
+std::atomic<std::uint32_t> gLevelGeneration{1};
+
+namespace {
+
+/**
+ * @brief 全局与各模块的运行时级别
+ */
+class LevelTable {
+ public:
+  static LevelTable& get() {
+    static LevelTable table;
+    return table;
+  }
+
+  void setGlobal(int level) {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mGlobal = level;
+    }
+    gLevelGeneration.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void setModule(const std::string& module, int level, bool reset) {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (reset)
+        mModules.erase(module);
+      else
+        mModules[module] = level;
+    }
+    gLevelGeneration.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief 依次匹配文件名与由内向外的目录名，都没有配置时使用全局级别
+   */
+  int resolve(const char* file) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mModules.empty()) return mGlobal;
+    std::string path(file);
+    std::size_t end = path.size();
+    std::size_t slash = path.rfind('/');
+    std::size_t begin = slash == std::string::npos ? 0 : slash + 1;
+    std::size_t dot = path.rfind('.');
+    if (dot != std::string::npos && dot > begin) end = dot;
+    while (true) {
+      auto it = mModules.find(path.substr(begin, end - begin));
+      if (it != mModules.end()) return it->second;
+      if (begin == 0) break;
+      end = begin - 1;
+      slash = end == 0 ? std::string::npos : path.rfind('/', end - 1);
+      begin = slash == std::string::npos ? 0 : slash + 1;
+    }
+    return mGlobal;
+  }
+
+ private:
+  std::mutex mMutex;
+  int mGlobal = IVS_LOG_LEVEL_INFO;
+  std::map<std::string, int> mModules;
+};
+
+constexpr std::size_t RING_SIZE = 512;
+constexpr std::size_t SLOT_TEXT_SIZE = 232;
+constexpr int DRAIN_INTERVAL_MS = 10;
+
+struct Slot {
+  spdlog::log_clock::time_point mTime;
+  std::size_t mThreadId;
+  int mLevel;
+  std::uint32_t mSize;
+  char mText[SLOT_TEXT_SIZE];
+};
+
+/**
+ * @brief 单生产者单消费者的环形缓冲，生产者为所属线程，消费者为后台线程
+ */
+struct ThreadBuffer {
+  ThreadBuffer() : mSlots(RING_SIZE) {}
+
+  std::vector<Slot> mSlots;
+  std::atomic<std::uint64_t> mHead{0};
+  std::atomic<std::uint64_t> mTail{0};
+  // 线程退出后缓冲交给新线程复用
+  std::atomic<bool> mOwned{false};
+};
+
+struct ThreadBufferHolder {
+  ~ThreadBufferHolder() {
+    if (mBuffer) mBuffer->mOwned.store(false, std::memory_order_release);
+  }
+  std::shared_ptr<ThreadBuffer> mBuffer;
+};
+
+std::atomic<bool> gAsyncRunning{false};
+
+/**
+ * @brief 后台写日志线程，按时间顺序合并各线程缓冲中的日志并写入sink
+ */
+class AsyncWriter {
+ public:
+  static AsyncWriter& get() {
+    static AsyncWriter writer;
+    return writer;
+  }
+
+  ~AsyncWriter() { stop(); }
+
+  void start(std::shared_ptr<spdlog::logger> logger) {
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    if (mThread.joinable()) return;
+    mLogger = logger;
+    mStop = false;
+    mThread = std::thread(&AsyncWriter::run, this);
+    gAsyncRunning.store(true, std::memory_order_release);
+  }
+
+  void stop() {
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    if (!mThread.joinable()) return;
+    gAsyncRunning.store(false, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> wakeLock(mWakeMutex);
+      mStop = true;
+    }
+    mWakeCond.notify_one();
+    mThread.join();
+    drain();
+  }
+
+  /**
+   * @brief 缓冲已满时返回false
+   */
+  bool push(int level, const char* message, std::size_t size) {
+    ThreadBuffer* buffer = threadBuffer();
+    std::uint64_t tail = buffer->mTail.load(std::memory_order_relaxed);
+    if (tail - buffer->mHead.load(std::memory_order_acquire) >= RING_SIZE)
+      return false;
+    Slot& slot = buffer->mSlots[tail % RING_SIZE];
+    slot.mTime = spdlog::log_clock::now();
+    slot.mThreadId = spdlog::details::os::thread_id();
+    slot.mLevel = level;
+    slot.mSize = size;
+    std::memcpy(slot.mText, message, size);
+    buffer->mTail.store(tail + 1, std::memory_order_release);
+    if (level >= IVS_LOG_LEVEL_WARN) mWakeCond.notify_one();
+    return true;
+  }
+
+  void dropped() { mDropped.fetch_add(1, std::memory_order_relaxed); }
+
+  void drain() {
+    std::lock_guard<std::mutex> lock(mDrainMutex);
+    if (!mLogger) return;
+    {
+      std::lock_guard<std::mutex> buffersLock(mBuffersMutex);
+      mDraining.assign(mBuffers.begin(), mBuffers.end());
+    }
+    mPending.clear();
+    mTails.resize(mDraining.size());
+    for (std::size_t i = 0; i < mDraining.size(); ++i) {
+      ThreadBuffer* buffer = mDraining[i].get();
+      std::uint64_t head = buffer->mHead.load(std::memory_order_relaxed);
+      mTails[i] = buffer->mTail.load(std::memory_order_acquire);
+      for (std::uint64_t index = head; index < mTails[i]; ++index)
+        mPending.push_back(&buffer->mSlots[index % RING_SIZE]);
+    }
+    std::stable_sort(mPending.begin(), mPending.end(),
+                     [](const Slot* a, const Slot* b) {
+                       return a->mTime < b->mTime;
+                     });
+    for (const Slot* slot : mPending)
+      write(static_cast<spdlog::level::level_enum>(slot->mLevel),
+            slot->mTime, slot->mThreadId, slot->mText, slot->mSize);
+    for (std::size_t i = 0; i < mDraining.size(); ++i)
+      mDraining[i]->mHead.store(mTails[i], std::memory_order_release);
+
+    std::uint64_t dropped = mDropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+      std::string text = "Async log buffer full, dropped " +
+                         std::to_string(dropped) + " messages";
+      write(spdlog::level::warn, spdlog::log_clock::now(),
+            spdlog::details::os::thread_id(), text.data(), text.size());
+    }
+    if (!mPending.empty() || dropped > 0) {
+      for (auto& sink : mLogger->sinks()) sink->flush();
+    }
+  }
+
+ private:
+  AsyncWriter() = default;
+
+  ThreadBuffer* threadBuffer() {
+    thread_local ThreadBufferHolder holder;
+    if (holder.mBuffer) return holder.mBuffer.get();
+    std::lock_guard<std::mutex> lock(mBuffersMutex);
+    for (auto& buffer : mBuffers) {
+      bool owned = false;
+      if (buffer->mOwned.compare_exchange_strong(owned, true,
+                                                 std::memory_order_acquire)) {
+        holder.mBuffer = buffer;
+        return buffer.get();
+      }
+    }
+    holder.mBuffer = std::make_shared<ThreadBuffer>();
+    holder.mBuffer->mOwned.store(true, std::memory_order_relaxed);
+    mBuffers.push_back(holder.mBuffer);
+    return holder.mBuffer.get();
+  }
+
+  void write(spdlog::level::level_enum level,
+             spdlog::log_clock::time_point time, std::size_t threadId,
+             const char* text, std::size_t size) {
+    spdlog::details::log_msg msg(&mLogger->name(), level);
+    msg.time = time;
+    msg.thread_id = threadId;
+    msg.raw.append(text, text + size);
+    for (auto& sink : mLogger->sinks()) {
+      if (sink->should_log(level)) sink->log(msg);
+    }
+  }
+
+  void run() {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWakeCond.wait_for(lock, std::chrono::milliseconds(DRAIN_INTERVAL_MS),
+                           [this] { return mStop; });
+        if (mStop) break;
+      }
+      drain();
+    }
+  }
+
+  std::shared_ptr<spdlog::logger> mLogger;
+  std::thread mThread;
+  std::mutex mStateMutex;
+  std::mutex mWakeMutex;
+  std::condition_variable mWakeCond;
+  bool mStop = false;
+
+  std::mutex mBuffersMutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> mBuffers;
+  std::atomic<std::uint64_t> mDropped{0};
+
+  // 只在drain中使用，复用内存
+  std::mutex mDrainMutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> mDraining;
+  std::vector<std::uint64_t> mTails;
+  std::vector<const Slot*> mPending;
+};
+
+void writeSync(int level, const char* message, std::size_t size) {
+  Logger::getLogger()->log(static_cast<spdlog::level::level_enum>(level),
+                           "{}", fmt::string_view(message, size));
+}
+
+}  // namespace
+
+void CallSite::resolve(std::uint32_t generation) {
+  mLevel.store(LevelTable::get().resolve(mFile), std::memory_order_relaxed);
+  mGeneration.store(generation, std::memory_order_relaxed);
+}
+
+void submit(int level, const char* message, std::size_t size) {
+  // critical与超长的日志直接同步写
+  if (level < IVS_LOG_LEVEL_CRITICAL && size <= SLOT_TEXT_SIZE &&
+      gAsyncRunning.load(std::memory_order_acquire)) {
+    AsyncWriter& writer = AsyncWriter::get();
+    if (writer.push(level, message, size)) return;
+    // 缓冲满时丢弃warn以下的日志
+    if (level < IVS_LOG_LEVEL_WARN) {
+      writer.dropped();
+      return;
+    }
+  }
+  // 先写出已经排队的日志，保持顺序
+  if (gAsyncRunning.load(std::memory_order_acquire)) AsyncWriter::get().drain();
+  writeSync(level, message, size);
+}
+
+}  // namespace ivslog
+
+void logInit(const std::string& name, const std::string& path, bool async) {
   auto logger = Logger::getLogger(path);
-  logger->set_level(spdlog::level::from_str(name));
+  ivslog::LevelTable::get().setGlobal(spdlog::level::from_str(name));
+  if (async)
+    ivslog::AsyncWriter::get().start(logger);
+  else
+    ivslog::AsyncWriter::get().stop();
 };
+
+void logSetModuleLevel(const std::string& module, const std::string& level) {
+  ivslog::LevelTable::get().setModule(module, spdlog::level::from_str(level),
+                                      level.empty());
+}
+
+void logFlush() {
+  if (ivslog::gAsyncRunning.load(std::memory_order_acquire))
+    ivslog::AsyncWriter::get().drain();
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 
 #include "spdlog/sinks/rotating_file_sink.h"
@@ -29,7 +31,85 @@ class Logger {
   Logger& operator=(const Logger&) = delete;
 };
 
-void logInit(const std::string& name = "info", const std::string& path = "");
+/**
+ * @brief 初始化日志
+ * @param[in] name : 全局运行时级别，trace/debug/info/warn/error/critical/off
+ * @param[in] path : 不为空时同时写入滚动日志文件
+ * @param[in] async : 为true时由后台线程写日志，调用线程只写入自己的环形缓冲
+ */
+void logInit(const std::string& name = "info", const std::string& path = "",
+             bool async = true);
+
+/**
+ * @brief 设置模块的运行时级别，模块为源文件名(不含扩展名)或源文件路径中的目录名，
+ * 例如"element"或"yolov5"。level为空时恢复使用全局级别
+ */
+void logSetModuleLevel(const std::string& module, const std::string& level);
+
+/**
+ * @brief 等待后台线程写完已经提交的日志
+ */
+void logFlush();
+
+// 编译期最低级别，低于该级别的IVS_*宏展开为空语句，参数不会被求值
+#define IVS_LOG_LEVEL_TRACE 0
+#define IVS_LOG_LEVEL_DEBUG 1
+#define IVS_LOG_LEVEL_INFO 2
+#define IVS_LOG_LEVEL_WARN 3
+#define IVS_LOG_LEVEL_ERROR 4
+#define IVS_LOG_LEVEL_CRITICAL 5
+#define IVS_LOG_LEVEL_OFF 6
+
+#ifndef IVS_LOG_ACTIVE_LEVEL
+#define IVS_LOG_ACTIVE_LEVEL IVS_LOG_LEVEL_TRACE
+#endif
+
+namespace ivslog {
+
+extern std::atomic<std::uint32_t> gLevelGeneration;
+
+/**
+ * @brief 日志调用点，缓存所在模块的运行时级别，级别配置变化后第一次调用时重新查找。
+ * 常量初始化，没有静态局部变量的初始化保护
+ */
+class CallSite {
+ public:
+  explicit constexpr CallSite(const char* file) : mFile(file) {}
+
+  bool enabled(int level) {
+    std::uint32_t generation =
+        gLevelGeneration.load(std::memory_order_relaxed);
+    if (mGeneration.load(std::memory_order_relaxed) != generation)
+      resolve(generation);
+    return level >= mLevel.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void resolve(std::uint32_t generation);
+
+  const char* mFile;
+  std::atomic<int> mLevel{IVS_LOG_LEVEL_OFF};
+  std::atomic<std::uint32_t> mGeneration{0};
+};
+
+// 格式化后的消息不超过该长度时不分配内存
+constexpr std::size_t MESSAGE_INLINE_SIZE = 256;
+
+void submit(int level, const char* message, std::size_t size);
+
+template <typename... Args>
+inline void log(int level, const char* fmt, const Args&... args) {
+  fmt::basic_memory_buffer<char, MESSAGE_INLINE_SIZE> buffer;
+  try {
+    fmt::format_to(buffer, fmt, args...);
+  } catch (const std::exception& e) {
+    buffer.clear();
+    fmt::format_to(buffer, "[format error: {}] {}", e.what(), fmt);
+  }
+  submit(level, buffer.data(), buffer.size());
+}
+
+}  // namespace ivslog
 
 #define IVSLOG_STR(integer) #integer
 #define IVSLOG_STR_HELP(integer) IVSLOG_STR(integer)
@@ -41,39 +121,71 @@ void logInit(const std::string& name = "info", const std::string& path = "");
 
 #define IVSLOG_FMT(fmt) "[" IVSLOG_FILE ":" IVSLOG_STR_HELP(__LINE__) "] " fmt
 
+#define IVSLOG_CALL(level, fmt, ...)                                  \
+  do {                                                                \
+    static ::ivslog::CallSite ivslogCallSite(IVSLOG_FILE);            \
+    if (ivslogCallSite.enabled(level))                                \
+      ::ivslog::log(level, IVSLOG_FMT(fmt), ##__VA_ARGS__);           \
+  } while (0)
+
 template <typename... Args>
 inline void trace(const char* fmt, const Args&... args) {
-  return Logger::getLogger()->trace(fmt, args...);
+  ::ivslog::log(IVS_LOG_LEVEL_TRACE, fmt, args...);
 }
 
-#define IVS_TRACE(fmt, ...) ::trace(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#if IVS_LOG_ACTIVE_LEVEL <= IVS_LOG_LEVEL_TRACE
+#define IVS_TRACE(fmt, ...) IVSLOG_CALL(IVS_LOG_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#else
+#define IVS_TRACE(fmt, ...) (void)0
+#endif
 
 template <typename... Args>
 inline void debug(const char* fmt, const Args&... args) {
-  return Logger::getLogger()->debug(fmt, args...);
+  ::ivslog::log(IVS_LOG_LEVEL_DEBUG, fmt, args...);
 }
-#define IVS_DEBUG(fmt, ...) ::debug(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#if IVS_LOG_ACTIVE_LEVEL <= IVS_LOG_LEVEL_DEBUG
+#define IVS_DEBUG(fmt, ...) IVSLOG_CALL(IVS_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define IVS_DEBUG(fmt, ...) (void)0
+#endif
 
 template <typename... Args>
 inline void info(const char* fmt, const Args&... args) {
-  return Logger::getLogger()->info(fmt, args...);
+  ::ivslog::log(IVS_LOG_LEVEL_INFO, fmt, args...);
 }
-#define IVS_INFO(fmt, ...) ::info(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#if IVS_LOG_ACTIVE_LEVEL <= IVS_LOG_LEVEL_INFO
+#define IVS_INFO(fmt, ...) IVSLOG_CALL(IVS_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define IVS_INFO(fmt, ...) (void)0
+#endif
 
 template <typename... Args>
 inline void warn(const char* fmt, const Args&... args) {
-  return Logger::getLogger()->warn(fmt, args...);
+  ::ivslog::log(IVS_LOG_LEVEL_WARN, fmt, args...);
 }
-#define IVS_WARN(fmt, ...) ::warn(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#if IVS_LOG_ACTIVE_LEVEL <= IVS_LOG_LEVEL_WARN
+#define IVS_WARN(fmt, ...) IVSLOG_CALL(IVS_LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define IVS_WARN(fmt, ...) (void)0
+#endif
 
 template <typename... Args>
 inline void error(const char* fmt, const Args&... args) {
-  return Logger::getLogger()->error(fmt, args...);
+  ::ivslog::log(IVS_LOG_LEVEL_ERROR, fmt, args...);
 }
-#define IVS_ERROR(fmt, ...) ::error(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#if IVS_LOG_ACTIVE_LEVEL <= IVS_LOG_LEVEL_ERROR
+#define IVS_ERROR(fmt, ...) IVSLOG_CALL(IVS_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define IVS_ERROR(fmt, ...) (void)0
+#endif
 
 template <typename... Args>
 inline void critical(const char* fmt, const Args&... args) {
-  return Logger::getLogger()->critical(fmt, args...);
+  ::ivslog::log(IVS_LOG_LEVEL_CRITICAL, fmt, args...);
 }
-#define IVS_CRITICAL(fmt, ...) ::critical(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#if IVS_LOG_ACTIVE_LEVEL <= IVS_LOG_LEVEL_CRITICAL
+#define IVS_CRITICAL(fmt, ...) \
+  IVSLOG_CALL(IVS_LOG_LEVEL_CRITICAL, fmt, ##__VA_ARGS__)
+#else
+#define IVS_CRITICAL(fmt, ...) (void)0
+#endif
@@ -0,0 +1,156 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "metadata_pool.h"
+
+#include <cstdint>
+#include <new>
+#include <string>
+
+namespace sophon_stream {
+namespace common {
+
+MetadataPool::MetadataPool(int channelId)
+    : mFreeBlocks(MAX_POOLED_SIZE / SIZE_CLASS) {
+  auto& registry = SingletonMetricsRegistry::getInstance();
+  const char* help = "Metadata allocations per channel and source";
+  std::string channel = std::to_string(channelId);
+  mPooledCounter = registry.counter(METADATA_ALLOCATIONS_METRIC, help,
+                                    {{"channel", channel}, {"source", "pool"}});
+  mHeapCounter = registry.counter(METADATA_ALLOCATIONS_METRIC, help,
+                                  {{"channel", channel}, {"source", "heap"}});
+  mArenaCounter = registry.counter(METADATA_ALLOCATIONS_METRIC, help,
+                                   {{"channel", channel}, {"source", "arena"}});
+}
+
+MetadataPool::~MetadataPool() {
+  for (auto& blocks : mFreeBlocks) {
+    for (void* block : blocks) ::operator delete(block);
+  }
+  for (void* chunk : mFreeChunks) ::operator delete(chunk);
+}
+
+void* MetadataPool::allocate(std::size_t size) {
+  if (size == 0 || size > MAX_POOLED_SIZE) {
+    if (mHeapCounter != nullptr) mHeapCounter->inc();
+    return ::operator new(size);
+  }
+  std::size_t index = (size - 1) / SIZE_CLASS;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& blocks = mFreeBlocks[index];
+    if (!blocks.empty()) {
+      void* block = blocks.back();
+      blocks.pop_back();
+      if (mPooledCounter != nullptr) mPooledCounter->inc();
+      return block;
+    }
+  }
+  if (mHeapCounter != nullptr) mHeapCounter->inc();
+  return ::operator new((index + 1) * SIZE_CLASS);
+}
+
+void MetadataPool::deallocate(void* p, std::size_t size) {
+  if (size == 0 || size > MAX_POOLED_SIZE) {
+    ::operator delete(p);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& blocks = mFreeBlocks[(size - 1) / SIZE_CLASS];
+    if (blocks.size() < MAX_FREE_BLOCKS) {
+      blocks.push_back(p);
+      return;
+    }
+  }
+  ::operator delete(p);
+}
+
+void* MetadataPool::allocateChunk() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mFreeChunks.empty()) {
+      void* chunk = mFreeChunks.back();
+      mFreeChunks.pop_back();
+      return chunk;
+    }
+  }
+  if (mHeapCounter != nullptr) mHeapCounter->inc();
+  return ::operator new(ARENA_CHUNK_SIZE);
+}
+
+void MetadataPool::deallocateChunk(void* chunk) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mFreeChunks.size() < MAX_FREE_CHUNKS) {
+      mFreeChunks.push_back(chunk);
+      return;
+    }
+  }
+  ::operator delete(chunk);
+}
+
+std::shared_ptr<MetadataArena> MetadataPool::createArena() {
+  void* memory = allocate(sizeof(MetadataArena));
+  MetadataArena* arena = new (memory) MetadataArena(shared_from_this());
+  return std::shared_ptr<MetadataArena>(
+      arena, [](MetadataArena* p) { p->release(); },
+      PoolAllocator<MetadataArena>(shared_from_this()));
+}
+
+MetadataArena::MetadataArena(std::shared_ptr<MetadataPool> pool)
+    : mPool(std::move(pool)) {}
+
+MetadataArena::~MetadataArena() {
+  for (void* chunk : mChunks) mPool->deallocateChunk(chunk);
+  for (void* large : mLarge) ::operator delete(large);
+  if (mPool->mArenaCounter != nullptr) mPool->mArenaCounter->inc(mAllocations);
+}
+
+void* MetadataArena::allocate(std::size_t size, std::size_t alignment) {
+  mLive.fetch_add(1, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mMutex);
+  ++mAllocations;
+  if (size + alignment > MetadataPool::ARENA_CHUNK_SIZE) {
+    void* large = ::operator new(size);
+    mLarge.push_back(large);
+    return large;
+  }
+  std::uintptr_t cursor = reinterpret_cast<std::uintptr_t>(mCursor);
+  std::uintptr_t aligned = (cursor + alignment - 1) & ~(alignment - 1);
+  if (mCursor == nullptr ||
+      aligned + size > reinterpret_cast<std::uintptr_t>(mEnd)) {
+    char* chunk = static_cast<char*>(mPool->allocateChunk());
+    mChunks.push_back(chunk);
+    mCursor = chunk;
+    mEnd = chunk + MetadataPool::ARENA_CHUNK_SIZE;
+    aligned = (reinterpret_cast<std::uintptr_t>(mCursor) + alignment - 1) &
+              ~(alignment - 1);
+  }
+  mCursor = reinterpret_cast<char*>(aligned + size);
+  return reinterpret_cast<void*>(aligned);
+}
+
+void MetadataArena::release() {
+  if (mLive.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+  // arena本身也从池分配，析构后把内存还给池
+  std::shared_ptr<MetadataPool> pool = mPool;
+  this->~MetadataArena();
+  pool->deallocate(this, sizeof(MetadataArena));
+}
+
+std::shared_ptr<MetadataPool> MetadataPools::get(int channelId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto& pool = mPools[channelId];
+  if (!pool) pool = std::make_shared<MetadataPool>(channelId);
+  return pool;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,200 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_METADATA_POOL_H_
+#define SOPHON_STREAM_COMMON_METADATA_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "metrics.h"
+#include "no_copyable.h"
+#include "singleton.h"
+
+namespace sophon_stream {
+namespace common {
+
+class MetadataArena;
+
+/**
+ * @brief 一个通道的metadata内存池。
+ * ObjectMetadata、Frame等每帧一个的对象按64字节分级放入空闲链表复用，
+ * 帧内的检测框、跟踪结果等子metadata从MetadataArena线性分配，
+ * arena销毁时内存块还给池。每个通道一个池，不同通道之间没有锁竞争。
+ */
+class MetadataPool : public NoCopyable,
+                     public std::enable_shared_from_this<MetadataPool> {
+ public:
+  explicit MetadataPool(int channelId);
+  ~MetadataPool();
+
+  void* allocate(std::size_t size);
+  void deallocate(void* p, std::size_t size);
+
+  void* allocateChunk();
+  void deallocateChunk(void* chunk);
+
+  /**
+   * @brief 为一帧创建arena，返回的指针是arena的持有者
+   */
+  std::shared_ptr<MetadataArena> createArena();
+
+  static constexpr std::size_t SIZE_CLASS = 64;
+  static constexpr std::size_t MAX_POOLED_SIZE = 2048;
+  static constexpr std::size_t MAX_FREE_BLOCKS = 1024;
+  static constexpr std::size_t ARENA_CHUNK_SIZE = 16 * 1024;
+  static constexpr std::size_t MAX_FREE_CHUNKS = 256;
+
+  static constexpr const char* METADATA_ALLOCATIONS_METRIC =
+      "sophon_stream_metadata_allocations_total";
+
+ private:
+  std::mutex mMutex;
+  // 下标为(size - 1) / SIZE_CLASS
+  std::vector<std::vector<void*>> mFreeBlocks;
+  std::vector<void*> mFreeChunks;
+
+  Counter* mPooledCounter = nullptr;
+  Counter* mHeapCounter = nullptr;
+  Counter* mArenaCounter = nullptr;
+
+  friend class MetadataArena;
+};
+
+/**
+ * @brief 一帧内子metadata的线性分配器。单个对象释放时不回收内存，
+ * 持有者释放并且从arena分配的对象都释放后arena才销毁，内存块一起还给池。
+ * 每次分配只计一次存活数，分配器复制时没有引用计数的开销
+ */
+class MetadataArena : public NoCopyable {
+ public:
+  explicit MetadataArena(std::shared_ptr<MetadataPool> pool);
+  ~MetadataArena();
+
+  void* allocate(std::size_t size, std::size_t alignment);
+
+  /**
+   * @brief 释放一次分配或持有者的引用，最后一次释放时销毁arena
+   */
+  void release();
+
+ private:
+  std::shared_ptr<MetadataPool> mPool;
+  std::mutex mMutex;
+  // 初始为1，代表持有者
+  std::atomic<std::size_t> mLive{1};
+  std::uint64_t mAllocations = 0;
+  std::vector<void*> mChunks;
+  // 超过一个内存块大小的分配
+  std::vector<void*> mLarge;
+  char* mCursor = nullptr;
+  char* mEnd = nullptr;
+};
+
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  explicit PoolAllocator(std::shared_ptr<MetadataPool> pool)
+      : mPool(std::move(pool)) {}
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>& other) : mPool(other.mPool) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(mPool->allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, std::size_t n) { mPool->deallocate(p, n * sizeof(T)); }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>& other) const {
+    return mPool == other.mPool;
+  }
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>& other) const {
+    return mPool != other.mPool;
+  }
+
+  std::shared_ptr<MetadataPool> mPool;
+};
+
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(MetadataArena* arena) : mArena(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : mArena(other.mArena) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* p, std::size_t n) { mArena->release(); }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return mArena == other.mArena;
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return mArena != other.mArena;
+  }
+
+  MetadataArena* mArena;
+};
+
+/**
+ * @brief 从通道的池创建对象，对象与引用计数在同一块内存中，pool为空时等同于make_shared
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooled(const std::shared_ptr<MetadataPool>& pool,
+                              Args&&... args) {
+  if (!pool) return std::make_shared<T>(std::forward<Args>(args)...);
+  return std::allocate_shared<T>(PoolAllocator<T>(pool),
+                                 std::forward<Args>(args)...);
+}
+
+/**
+ * @brief 在帧的arena中创建对象，arena为空时等同于make_shared
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> makeInArena(const std::shared_ptr<MetadataArena>& arena,
+                               Args&&... args) {
+  if (!arena) return std::make_shared<T>(std::forward<Args>(args)...);
+  return std::allocate_shared<T>(ArenaAllocator<T>(arena.get()),
+                                 std::forward<Args>(args)...);
+}
+
+/**
+ * @brief 按通道号管理MetadataPool
+ */
+class MetadataPools : public NoCopyable {
+ public:
+  std::shared_ptr<MetadataPool> get(int channelId);
+
+ private:
+  friend class Singleton<MetadataPools>;
+  MetadataPools() = default;
+
+  std::mutex mMutex;
+  std::map<int, std::shared_ptr<MetadataPool>> mPools;
+};
+
+using SingletonMetadataPools = Singleton<MetadataPools>;
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_METADATA_POOL_H_
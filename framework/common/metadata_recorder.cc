@@ -0,0 +1,482 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "metadata_recorder.h"
+
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace common {
+
+namespace {
+
+class BinaryWriter {
+ public:
+  explicit BinaryWriter(std::string& out) : mOut(out) {}
+
+  template <typename T>
+  void pod(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "pod only");
+    mOut.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void str(const std::string& value) {
+    pod<std::uint32_t>(value.size());
+    mOut.append(value);
+  }
+
+  void bytes(const void* data, std::uint32_t size) {
+    pod(size);
+    mOut.append(static_cast<const char*>(data), size);
+  }
+
+  template <typename T>
+  void vec(const std::vector<T>& values) {
+    pod<std::uint32_t>(values.size());
+    for (const auto& value : values) pod(value);
+  }
+
+ private:
+  std::string& mOut;
+};
+
+class BinaryReader {
+ public:
+  BinaryReader(const std::string& in) : mIn(in) {}
+
+  template <typename T>
+  T pod() {
+    T value{};
+    if (mPos + sizeof(T) > mIn.size()) {
+      mGood = false;
+      return value;
+    }
+    std::memcpy(&value, mIn.data() + mPos, sizeof(T));
+    mPos += sizeof(T);
+    return value;
+  }
+
+  std::string str() {
+    std::uint32_t size = pod<std::uint32_t>();
+    if (!mGood || mPos + size > mIn.size()) {
+      mGood = false;
+      return std::string();
+    }
+    std::string value = mIn.substr(mPos, size);
+    mPos += size;
+    return value;
+  }
+
+  const char* bytes(std::uint32_t& size) {
+    size = pod<std::uint32_t>();
+    if (!mGood || mPos + size > mIn.size()) {
+      mGood = false;
+      return nullptr;
+    }
+    const char* data = mIn.data() + mPos;
+    mPos += size;
+    return data;
+  }
+
+  template <typename T>
+  std::vector<T> vec() {
+    std::uint32_t size = pod<std::uint32_t>();
+    std::vector<T> values;
+    if (!mGood || mPos + size * sizeof(T) > mIn.size()) {
+      mGood = false;
+      return values;
+    }
+    values.reserve(size);
+    for (std::uint32_t i = 0; i < size; ++i) values.push_back(pod<T>());
+    return values;
+  }
+
+  bool good() const { return mGood; }
+
+ private:
+  const std::string& mIn;
+  std::size_t mPos = 0;
+  bool mGood = true;
+};
+
+void writeRect(BinaryWriter& writer, const Rectangle<int>& rect) {
+  writer.pod(rect.mX);
+  writer.pod(rect.mY);
+  writer.pod(rect.mWidth);
+  writer.pod(rect.mHeight);
+}
+
+Rectangle<int> readRect(BinaryReader& reader) {
+  Rectangle<int> rect;
+  rect.mX = reader.pod<int>();
+  rect.mY = reader.pod<int>();
+  rect.mWidth = reader.pod<int>();
+  rect.mHeight = reader.pod<int>();
+  return rect;
+}
+
+/**
+ * @brief 把图像按plane拷贝到host，压缩格式先转换为YUV420P
+ */
+void writeImage(BinaryWriter& writer, const std::shared_ptr<Frame>& frame) {
+  bm_image image = *frame->mSpData;
+  bm_image converted;
+  bool needDestroy = false;
+  if (image.image_format == FORMAT_COMPRESSED) {
+    if (bm_image_create(frame->mHandle, image.height, image.width,
+                        FORMAT_YUV420P, DATA_TYPE_EXT_1N_BYTE,
+                        &converted) != BM_SUCCESS ||
+        bmcv_image_vpp_convert(frame->mHandle, 1, image, &converted) !=
+            BM_SUCCESS) {
+      writer.pod<std::uint8_t>(0);
+      return;
+    }
+    image = converted;
+    needDestroy = true;
+  }
+
+  int planeNum = bm_image_get_plane_num(image);
+  int sizes[4] = {0};
+  bm_image_get_byte_size(image, sizes);
+  std::vector<std::vector<char>> planes(planeNum);
+  void* buffers[4] = {nullptr};
+  for (int i = 0; i < planeNum; ++i) {
+    planes[i].resize(sizes[i]);
+    buffers[i] = planes[i].data();
+  }
+  bool ok = bm_image_copy_device_to_host(image, buffers) == BM_SUCCESS;
+  writer.pod<std::uint8_t>(ok ? 1 : 0);
+  if (ok) {
+    writer.pod<int>(image.width);
+    writer.pod<int>(image.height);
+    writer.pod<int>(image.image_format);
+    writer.pod<int>(image.data_type);
+    writer.pod<int>(planeNum);
+    for (int i = 0; i < planeNum; ++i) writer.bytes(planes[i].data(), sizes[i]);
+  }
+  if (needDestroy) bm_image_destroy(converted);
+}
+
+std::shared_ptr<bm_image> readImage(BinaryReader& reader, bm_handle_t handle) {
+  int width = reader.pod<int>();
+  int height = reader.pod<int>();
+  auto format = static_cast<bm_image_format_ext>(reader.pod<int>());
+  auto dataType = static_cast<bm_image_data_format_ext>(reader.pod<int>());
+  int planeNum = reader.pod<int>();
+  if (!reader.good() || planeNum <= 0 || planeNum > 4) return nullptr;
+  void* buffers[4] = {nullptr};
+  for (int i = 0; i < planeNum; ++i) {
+    std::uint32_t size = 0;
+    buffers[i] = const_cast<char*>(reader.bytes(size));
+  }
+  if (!reader.good() || handle == nullptr) return nullptr;
+
+  std::shared_ptr<bm_image> image(new bm_image, [](bm_image* p) {
+    bm_image_destroy(*p);
+    delete p;
+  });
+  if (bm_image_create(handle, height, width, format, dataType, image.get()) !=
+      BM_SUCCESS)
+    return nullptr;
+  if (bm_image_alloc_dev_mem(*image) != BM_SUCCESS ||
+      bm_image_copy_host_to_device(*image, buffers) != BM_SUCCESS)
+    return nullptr;
+  return image;
+}
+
+void serialize(const ObjectMetadata& objectMetadata, bool withFrame,
+               std::string& out) {
+  BinaryWriter writer(out);
+  writer.pod<std::int64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+
+  const auto& frame = objectMetadata.mFrame;
+  writer.pod(frame->mChannelId);
+  writer.pod(frame->mChannelIdInternal);
+  writer.pod(frame->mFrameId);
+  writer.vec(frame->mSubFrameIdVec);
+  writer.pod(frame->mTimestamp);
+  writer.pod<std::uint8_t>(frame->mEndOfStream);
+  writer.pod(frame->mWidth);
+  writer.pod(frame->mHeight);
+  // bit0为mFilter，bit1为mInterpolated，旧记录中bit1总是0
+  writer.pod<std::uint8_t>((objectMetadata.mFilter ? 1 : 0) |
+                           (objectMetadata.mInterpolated ? 2 : 0));
+  writer.pod(objectMetadata.mGraphId);
+  writer.pod(objectMetadata.mSubId);
+  writer.vec(objectMetadata.mSkipElements);
+
+  writer.pod<std::uint32_t>(objectMetadata.mDetectedObjectMetadatas.size());
+  for (const auto& detObj : objectMetadata.mDetectedObjectMetadatas) {
+    writeRect(writer, detObj->mBox);
+    writeRect(writer, detObj->mCroppedBox);
+    writer.str(detObj->mItemName);
+    writer.str(detObj->mLabelName);
+    writer.vec(detObj->mScores);
+    writer.vec(detObj->mTopKLabels);
+    writer.pod(detObj->mClassify);
+    writer.str(detObj->mClassifyName);
+    writer.pod(detObj->mTrackIouThreshold);
+    writer.pod<std::uint32_t>(detObj->mKeyPoints.size());
+    for (const auto& point : detObj->mKeyPoints) {
+      writer.pod(point->mPoint.mX);
+      writer.pod(point->mPoint.mY);
+      writer.vec(point->mScores);
+      writer.vec(point->mTopKLabels);
+    }
+  }
+
+  writer.pod<std::uint32_t>(objectMetadata.mTrackedObjectMetadatas.size());
+  for (const auto& trackObj : objectMetadata.mTrackedObjectMetadatas) {
+    writer.str(trackObj->mUuid);
+    writer.pod(trackObj->mPerferScore);
+    writer.pod(trackObj->mCoverArea);
+    writer.str(trackObj->mName);
+    writer.pod<std::uint8_t>(trackObj->mTrackerFilter);
+    writer.pod<std::int64_t>(trackObj->mTrackId);
+    writer.pod(trackObj->mTrackFlag);
+    writer.pod(trackObj->mQualityScore);
+  }
+
+  writer.pod<std::uint32_t>(objectMetadata.mRecognizedObjectMetadatas.size());
+  for (const auto& recogObj : objectMetadata.mRecognizedObjectMetadatas) {
+    writer.str(recogObj->mItemName);
+    writer.str(recogObj->mLabelName);
+    writer.vec(recogObj->mScores);
+    writer.vec(recogObj->mTopKLabels);
+  }
+
+  writer.pod<std::uint32_t>(objectMetadata.mFaceObjectMetadatas.size());
+  for (const auto& faceObj : objectMetadata.mFaceObjectMetadatas)
+    writer.pod(*faceObj);
+
+  bool hasImage = withFrame && frame->mSpData && !frame->mEndOfStream;
+  if (hasImage)
+    writeImage(writer, frame);
+  else
+    writer.pod<std::uint8_t>(0);
+}
+
+std::shared_ptr<ObjectMetadata> deserialize(const std::string& in,
+                                            std::int64_t& recordUs,
+                                            bm_handle_t handle) {
+  BinaryReader reader(in);
+  auto objectMetadata = std::make_shared<ObjectMetadata>();
+  objectMetadata->mFrame = std::make_shared<Frame>();
+  auto& frame = objectMetadata->mFrame;
+
+  recordUs = reader.pod<std::int64_t>();
+  frame->mChannelId = reader.pod<int>();
+  frame->mChannelIdInternal = reader.pod<int>();
+  frame->mFrameId = reader.pod<std::int64_t>();
+  frame->mSubFrameIdVec = reader.vec<std::int64_t>();
+  frame->mTimestamp = reader.pod<std::int64_t>();
+  frame->mEndOfStream = reader.pod<std::uint8_t>() != 0;
+  frame->mWidth = reader.pod<int>();
+  frame->mHeight = reader.pod<int>();
+  std::uint8_t filter = reader.pod<std::uint8_t>();
+  objectMetadata->mFilter = (filter & 1) != 0;
+  objectMetadata->mInterpolated = (filter & 2) != 0;
+  objectMetadata->mGraphId = reader.pod<int>();
+  objectMetadata->mSubId = reader.pod<int>();
+  objectMetadata->mSkipElements = reader.vec<int>();
+
+  std::uint32_t count = reader.pod<std::uint32_t>();
+  for (std::uint32_t i = 0; i < count && reader.good(); ++i) {
+    auto detObj = std::make_shared<DetectedObjectMetadata>();
+    detObj->mBox = readRect(reader);
+    detObj->mCroppedBox = readRect(reader);
+    detObj->mItemName = reader.str();
+    detObj->mLabelName = reader.str();
+    detObj->mScores = reader.vec<float>();
+    detObj->mTopKLabels = reader.vec<int>();
+    detObj->mClassify = reader.pod<int>();
+    detObj->mClassifyName = reader.str();
+    detObj->mTrackIouThreshold = reader.pod<float>();
+    std::uint32_t pointNum = reader.pod<std::uint32_t>();
+    for (std::uint32_t j = 0; j < pointNum && reader.good(); ++j) {
+      auto point = std::make_shared<PointMetadata>();
+      point->mPoint.mX = reader.pod<int>();
+      point->mPoint.mY = reader.pod<int>();
+      point->mScores = reader.vec<float>();
+      point->mTopKLabels = reader.vec<int>();
+      detObj->mKeyPoints.push_back(point);
+    }
+    objectMetadata->mDetectedObjectMetadatas.push_back(detObj);
+  }
+
+  count = reader.pod<std::uint32_t>();
+  for (std::uint32_t i = 0; i < count && reader.good(); ++i) {
+    auto trackObj = std::make_shared<TrackedObjectMetadata>();
+    trackObj->mUuid = reader.str();
+    trackObj->mPerferScore = reader.pod<float>();
+    trackObj->mCoverArea = reader.pod<int>();
+    trackObj->mName = reader.str();
+    trackObj->mTrackerFilter = reader.pod<std::uint8_t>() != 0;
+    trackObj->mTrackId = reader.pod<std::int64_t>();
+    trackObj->mTrackFlag = reader.pod<int>();
+    trackObj->mQualityScore = reader.pod<float>();
+    objectMetadata->mTrackedObjectMetadatas.push_back(trackObj);
+  }
+
+  count = reader.pod<std::uint32_t>();
+  for (std::uint32_t i = 0; i < count && reader.good(); ++i) {
+    auto recogObj = std::make_shared<RecognizedObjectMetadata>();
+    recogObj->mItemName = reader.str();
+    recogObj->mLabelName = reader.str();
+    recogObj->mScores = reader.vec<float>();
+    recogObj->mTopKLabels = reader.vec<int>();
+    objectMetadata->mRecognizedObjectMetadatas.push_back(recogObj);
+  }
+
+  count = reader.pod<std::uint32_t>();
+  for (std::uint32_t i = 0; i < count && reader.good(); ++i) {
+    auto faceObj = std::make_shared<FaceObjectMetadata>();
+    *faceObj = reader.pod<FaceObjectMetadata>();
+    objectMetadata->mFaceObjectMetadatas.push_back(faceObj);
+  }
+
+  if (reader.pod<std::uint8_t>() != 0) {
+    frame->mHandle = handle;
+    frame->mSpData = readImage(reader, handle);
+    if (frame->mSpData) {
+      frame->mFormatType = frame->mSpData->image_format;
+      frame->mDataType = frame->mSpData->data_type;
+    }
+  }
+  if (!reader.good()) return nullptr;
+  return objectMetadata;
+}
+
+}  // namespace
+
+MetadataRecorder::MetadataRecorder(const std::string& path, bool withFrame,
+                                   std::size_t maxPendingBytes)
+    : mPath(path), mWithFrame(withFrame), mMaxPendingBytes(maxPendingBytes) {}
+
+MetadataRecorder::~MetadataRecorder() { close(); }
+
+bool MetadataRecorder::open() {
+  mFile = std::fopen(mPath.c_str(), "wb");
+  if (mFile == nullptr) {
+    IVS_ERROR("Can not open record file: {0}", mPath);
+    return false;
+  }
+  std::uint32_t header[2] = {MetadataRecordFormat::MAGIC,
+                             MetadataRecordFormat::VERSION};
+  std::fwrite(header, sizeof(header), 1, mFile);
+  mRunning = true;
+  mThread = std::thread(&MetadataRecorder::writeLoop, this);
+  IVS_INFO("Record ObjectMetadata to {0}, with frame: {1}", mPath, mWithFrame);
+  return true;
+}
+
+void MetadataRecorder::write(
+    const std::shared_ptr<ObjectMetadata>& objectMetadata) {
+  if (!objectMetadata || !objectMetadata->mFrame) return;
+  std::string record;
+  // 预留长度字段，序列化后回填
+  record.resize(sizeof(std::uint32_t));
+  serialize(*objectMetadata, mWithFrame, record);
+  std::uint32_t size = record.size() - sizeof(std::uint32_t);
+  std::memcpy(&record[0], &size, sizeof(size));
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mRunning) return;
+    if (mPendingBytes + record.size() > mMaxPendingBytes) {
+      mDropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    mPendingBytes += record.size();
+    mPending.push_back(std::move(record));
+  }
+  mCv.notify_one();
+}
+
+void MetadataRecorder::writeLoop() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (true) {
+    mCv.wait(lock, [this] { return !mPending.empty() || !mRunning; });
+    if (mPending.empty()) break;
+    std::deque<std::string> batch;
+    batch.swap(mPending);
+    mPendingBytes = 0;
+    lock.unlock();
+    for (const auto& record : batch)
+      std::fwrite(record.data(), record.size(), 1, mFile);
+    mRecords += batch.size();
+    lock.lock();
+  }
+}
+
+void MetadataRecorder::close() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mRunning) return;
+    mRunning = false;
+  }
+  mCv.notify_one();
+  if (mThread.joinable()) mThread.join();
+  std::fclose(mFile);
+  mFile = nullptr;
+  IVS_INFO("Record file {0} closed, records: {1}, dropped: {2}", mPath,
+           mRecords, mDropped.load());
+}
+
+MetadataReader::~MetadataReader() { close(); }
+
+bool MetadataReader::open(const std::string& path) {
+  mFile = std::fopen(path.c_str(), "rb");
+  if (mFile == nullptr) {
+    IVS_ERROR("Can not open record file: {0}", path);
+    return false;
+  }
+  std::uint32_t header[2] = {0, 0};
+  if (std::fread(header, sizeof(header), 1, mFile) != 1 ||
+      header[0] != MetadataRecordFormat::MAGIC ||
+      header[1] != MetadataRecordFormat::VERSION) {
+    IVS_ERROR("Invalid record file: {0}", path);
+    close();
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<ObjectMetadata> MetadataReader::next(std::int64_t& recordUs,
+                                                     bm_handle_t handle) {
+  if (mFile == nullptr) return nullptr;
+  std::uint32_t size = 0;
+  if (std::fread(&size, sizeof(size), 1, mFile) != 1) return nullptr;
+  mBuffer.resize(size);
+  if (size > 0 && std::fread(&mBuffer[0], size, 1, mFile) != 1) {
+    IVS_WARN("Record file is truncated");
+    return nullptr;
+  }
+  auto objectMetadata = deserialize(mBuffer, recordUs, handle);
+  if (!objectMetadata) IVS_WARN("Record is corrupted");
+  return objectMetadata;
+}
+
+void MetadataReader::close() {
+  if (mFile != nullptr) {
+    std::fclose(mFile);
+    mFile = nullptr;
+  }
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_METADATA_RECORDER_H_
+#define SOPHON_STREAM_COMMON_METADATA_RECORDER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "no_copyable.h"
+#include "object_metadata.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief ObjectMetadata录制文件格式:
+ * 文件头为MAGIC与VERSION，之后每条记录为4字节长度加内容，整数按小端存储。
+ * 记录包含录制时刻、帧信息、检测/跟踪/识别/人脸结果，图像可选(按plane存原始数据)。
+ * 推理用的tensor与子对象不录制。
+ */
+struct MetadataRecordFormat {
+  static constexpr std::uint32_t MAGIC = 0x52545353;  // "SSTR"
+  static constexpr std::uint32_t VERSION = 1;
+};
+
+/**
+ * @brief 把经过某条连接的ObjectMetadata写入文件。
+ * write在element线程中完成序列化，写文件在独立线程中进行；
+ * 待写数据超过maxPendingBytes时丢弃新的记录并计数，不阻塞pipeline。
+ */
+class MetadataRecorder : public NoCopyable {
+ public:
+  MetadataRecorder(const std::string& path, bool withFrame,
+                   std::size_t maxPendingBytes = 256 << 20);
+  ~MetadataRecorder();
+
+  bool open();
+
+  void write(const std::shared_ptr<ObjectMetadata>& objectMetadata);
+
+  void close();
+
+  const std::string& getPath() const { return mPath; }
+
+ private:
+  void writeLoop();
+
+  std::string mPath;
+  bool mWithFrame;
+  std::size_t mMaxPendingBytes;
+  std::FILE* mFile = nullptr;
+
+  std::mutex mMutex;
+  std::condition_variable mCv;
+  std::deque<std::string> mPending;
+  std::size_t mPendingBytes = 0;
+  bool mRunning = false;
+  std::thread mThread;
+
+  std::uint64_t mRecords = 0;
+  std::atomic<std::uint64_t> mDropped{0};
+};
+
+/**
+ * @brief 读取MetadataRecorder生成的文件
+ */
+class MetadataReader : public NoCopyable {
+ public:
+  ~MetadataReader();
+
+  bool open(const std::string& path);
+
+  /**
+   * @brief 读取下一条记录，文件结束或出错时返回nullptr
+   * @param[out] recordUs : 录制时刻，单位us
+   * @param[in] handle : 恢复图像所用的handle，为nullptr时不恢复图像
+   */
+  std::shared_ptr<ObjectMetadata> next(std::int64_t& recordUs,
+                                       bm_handle_t handle);
+
+  void close();
+
+ private:
+  std::FILE* mFile = nullptr;
+  std::string mBuffer;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_METADATA_RECORDER_H_
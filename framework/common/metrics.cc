@@ -0,0 +1,172 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace common {
+
+const double Histogram::BUCKET_BOUNDS[Histogram::BUCKET_NUM] = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+    0.025,  0.05,    0.1,    0.25,  0.5,    1,     2.5};
+
+Histogram::Histogram() {
+  for (auto& bucket : mBuckets) bucket.store(0, std::memory_order_relaxed);
+  mSumNs.store(0, std::memory_order_relaxed);
+  mCount.store(0, std::memory_order_relaxed);
+}
+
+void Histogram::observe(double seconds) {
+  if (seconds < 0) seconds = 0;
+  int index = std::lower_bound(BUCKET_BOUNDS, BUCKET_BOUNDS + BUCKET_NUM,
+                               seconds) -
+              BUCKET_BOUNDS;
+  mBuckets[index].fetch_add(1, std::memory_order_relaxed);
+  mSumNs.fetch_add(static_cast<std::uint64_t>(seconds * 1e9),
+                   std::memory_order_relaxed);
+  mCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Histogram::snapshot(std::uint64_t buckets[BUCKET_NUM + 1],
+                         std::uint64_t& count, double& sum) const {
+  for (int i = 0; i <= BUCKET_NUM; ++i)
+    buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+  count = mCount.load(std::memory_order_relaxed);
+  sum = mSumNs.load(std::memory_order_relaxed) / 1e9;
+}
+
+MetricsRegistry::Family* MetricsRegistry::getFamily(const std::string& name,
+                                                    const std::string& help,
+                                                    Type type) {
+  auto it = mFamilies.find(name);
+  if (it == mFamilies.end()) {
+    Family& family = mFamilies[name];
+    family.type = type;
+    family.help = help;
+    return &family;
+  }
+  if (it->second.type != type) {
+    IVS_ERROR("Metric {0} is already registered with another type", name);
+    return nullptr;
+  }
+  return &it->second;
+}
+
+Counter* MetricsRegistry::counter(const std::string& name,
+                                  const std::string& help,
+                                  const MetricLabels& labels) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  Family* family = getFamily(name, help, Type::COUNTER);
+  if (family == nullptr) return nullptr;
+  auto& series = family->counters[formatLabels(labels)];
+  if (!series) series.reset(new Counter());
+  return series.get();
+}
+
+Gauge* MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                              const MetricLabels& labels) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  Family* family = getFamily(name, help, Type::GAUGE);
+  if (family == nullptr) return nullptr;
+  auto& series = family->gauges[formatLabels(labels)];
+  if (!series) series.reset(new Gauge());
+  return series.get();
+}
+
+Histogram* MetricsRegistry::histogram(const std::string& name,
+                                      const std::string& help,
+                                      const MetricLabels& labels) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  Family* family = getFamily(name, help, Type::HISTOGRAM);
+  if (family == nullptr) return nullptr;
+  auto& series = family->histograms[formatLabels(labels)];
+  if (!series) series.reset(new Histogram());
+  return series.get();
+}
+
+Counter* MetricsRegistry::frameDroppedCounter(int channelId,
+                                              const std::string& reason) {
+  return counter(FRAME_DROPPED_METRIC, "Frames dropped per channel and reason",
+                 {{"channel", std::to_string(channelId)}, {"reason", reason}});
+}
+
+std::string MetricsRegistry::formatLabels(const MetricLabels& labels) {
+  std::string result;
+  for (const auto& label : labels) {
+    if (!result.empty()) result += ',';
+    result += label.first;
+    result += "=\"";
+    for (char c : label.second) {
+      if (c == '\\' || c == '"') {
+        result += '\\';
+        result += c;
+      } else if (c == '\n') {
+        result += "\\n";
+      } else {
+        result += c;
+      }
+    }
+    result += '"';
+  }
+  return result;
+}
+
+std::string MetricsRegistry::render() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::ostringstream out;
+  for (const auto& familyIt : mFamilies) {
+    const std::string& name = familyIt.first;
+    const Family& family = familyIt.second;
+    const char* type = family.type == Type::COUNTER ? "counter"
+                       : family.type == Type::GAUGE ? "gauge"
+                                                    : "histogram";
+    out << "# HELP " << name << " " << family.help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+    for (const auto& series : family.counters) {
+      out << name;
+      if (!series.first.empty()) out << "{" << series.first << "}";
+      out << " " << series.second->value() << "\n";
+    }
+    for (const auto& series : family.gauges) {
+      out << name;
+      if (!series.first.empty()) out << "{" << series.first << "}";
+      out << " " << series.second->value() << "\n";
+    }
+    for (const auto& series : family.histograms) {
+      std::uint64_t buckets[Histogram::BUCKET_NUM + 1];
+      std::uint64_t count = 0;
+      double sum = 0;
+      series.second->snapshot(buckets, count, sum);
+      std::string prefix = series.first.empty() ? "" : series.first + ",";
+      std::uint64_t cumulative = 0;
+      for (int i = 0; i < Histogram::BUCKET_NUM; ++i) {
+        cumulative += buckets[i];
+        out << name << "_bucket{" << prefix << "le=\""
+            << Histogram::BUCKET_BOUNDS[i] << "\"} " << cumulative << "\n";
+      }
+      // 各桶与count分别读取，+Inf桶用count保证累计值单调
+      out << name << "_bucket{" << prefix << "le=\"+Inf\"} "
+          << std::max(count, cumulative) << "\n";
+      std::string labels =
+          series.first.empty() ? "" : "{" + series.first + "}";
+      out << name << "_sum" << labels << " " << sum << "\n";
+      out << name << "_count" << labels << " " << std::max(count, cumulative)
+          << "\n";
+    }
+  }
+  return out.str();
+}
+
+}  // namespace common
+}  // namespace sophon_stream
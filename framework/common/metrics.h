@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_METRICS_H_
+#define SOPHON_STREAM_COMMON_METRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "no_copyable.h"
+#include "singleton.h"
+
+namespace sophon_stream {
+namespace common {
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief 单调递增的计数器
+ */
+class Counter : public NoCopyable {
+ public:
+  void inc(std::uint64_t n = 1) {
+    mValue.fetch_add(n, std::memory_order_relaxed);
+  }
+  std::uint64_t value() const { return mValue.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<std::uint64_t> mValue{0};
+};
+
+/**
+ * @brief 可增可减的瞬时值，如队列深度
+ */
+class Gauge : public NoCopyable {
+ public:
+  void set(std::int64_t value) {
+    mValue.store(value, std::memory_order_relaxed);
+  }
+  void add(std::int64_t n) { mValue.fetch_add(n, std::memory_order_relaxed); }
+  std::int64_t value() const { return mValue.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<std::int64_t> mValue{0};
+};
+
+/**
+ * @brief 固定分桶的耗时直方图，单位为秒
+ * observe只做原子加，不加锁，可以在多个工作线程中并发调用
+ */
+class Histogram : public NoCopyable {
+ public:
+  static constexpr int BUCKET_NUM = 14;
+  static const double BUCKET_BOUNDS[BUCKET_NUM];
+
+  Histogram();
+
+  void observe(double seconds);
+
+  /**
+   * @brief 读取各桶（非累计）的计数、总数与总耗时
+   */
+  void snapshot(std::uint64_t buckets[BUCKET_NUM + 1], std::uint64_t& count,
+                double& sum) const;
+
+ private:
+  std::atomic<std::uint64_t> mBuckets[BUCKET_NUM + 1];
+  std::atomic<std::uint64_t> mSumNs;
+  std::atomic<std::uint64_t> mCount;
+};
+
+/**
+ * @brief 作用域计时，析构时把耗时记入直方图，histogram为nullptr时不计时
+ */
+class ScopedLatency : public NoCopyable {
+ public:
+  explicit ScopedLatency(Histogram* histogram) : mHistogram(histogram) {
+    if (mHistogram != nullptr) mStart = std::chrono::steady_clock::now();
+  }
+  ~ScopedLatency() {
+    if (mHistogram == nullptr) return;
+    mHistogram->observe(std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - mStart)
+                            .count());
+  }
+
+ private:
+  Histogram* mHistogram;
+  std::chrono::steady_clock::time_point mStart;
+};
+
+/**
+ * @brief 进程内的指标注册表，以Prometheus文本格式输出
+ * 注册时加锁，返回的指针在进程生命周期内有效，热路径上只访问原子变量。
+ * 相同名字与标签重复注册时返回同一个对象；同名但类型不同时返回nullptr。
+ */
+class MetricsRegistry : public NoCopyable {
+ public:
+  Counter* counter(const std::string& name, const std::string& help,
+                   const MetricLabels& labels = {});
+  Gauge* gauge(const std::string& name, const std::string& help,
+               const MetricLabels& labels = {});
+  Histogram* histogram(const std::string& name, const std::string& help,
+                       const MetricLabels& labels = {});
+
+  /**
+   * @brief 按通道与原因统计丢帧的计数器。调用方在通道启动时取一次并缓存，
+   * 丢帧时直接inc()，不在热路径上查注册表
+   */
+  Counter* frameDroppedCounter(int channelId, const std::string& reason);
+
+  /**
+   * @brief 输出Prometheus text exposition format
+   */
+  std::string render() const;
+
+  static constexpr const char* CONTENT_TYPE =
+      "text/plain; version=0.0.4; charset=utf-8";
+  static constexpr const char* FRAME_DROPPED_METRIC =
+      "sophon_stream_channel_frames_dropped_total";
+
+ private:
+  friend class Singleton<MetricsRegistry>;
+  MetricsRegistry() = default;
+
+  enum class Type { COUNTER, GAUGE, HISTOGRAM };
+
+  struct Family {
+    Type type;
+    std::string help;
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+  };
+
+  Family* getFamily(const std::string& name, const std::string& help,
+                    Type type);
+
+  static std::string formatLabels(const MetricLabels& labels);
+
+  mutable std::mutex mMutex;
+  std::map<std::string, Family> mFamilies;
+};
+
+using SingletonMetricsRegistry = Singleton<MetricsRegistry>;
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_METRICS_H_
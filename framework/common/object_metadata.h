@@ -17,10 +17,12 @@
 
 #include "common_defs.h"
 #include "detected_object_metadata.h"
+#include "detection_table.h"
 #include "error_code.h"
 #include "face_object_metadata.h"
 #include "frame.h"
 #include "graphics.h"
+#include "metadata_pool.h"
 #include "posed_object_metadata.h"
 #include "recognized_object_metadata.h"
 #include "segmented_object_metadata.h"
@@ -55,6 +57,9 @@ typedef struct bmTensors_ {
   bm_handle_t handle;
   // cpu data is used to sync dev mem and host mem
   std::vector<float*> cpu_data;
+  // 前处理直接写入的batch输入tensor，以及本帧在其中的位置
+  std::shared_ptr<bmTensors_> batch;
+  int batch_slot = -1;
 } bmTensors;
 
 typedef struct bmSubTensors_ {
@@ -106,6 +111,21 @@ struct ObjectMetadata {
   std::shared_ptr<common::Frame> mFrame;
 
   bool mFilter;
+  /**
+   * @brief 检测间隔内跳过了检测的帧，检测结果是跟踪器预测的目标框。
+   * 这类帧mFilter同样为true
+   */
+  bool mInterpolated = false;
+  /**
+   * @brief motion_gate element检测到画面变化的区域，原图坐标。
+   * 为空表示没有做运动检测
+   */
+  std::vector<common::Rectangle<int>> mMotionRegions;
+  /**
+   * @brief 检测element切块推理时，块在原图中的位置。
+   * 只用于element内部的块，为空表示整帧
+   */
+  common::Rectangle<int> mTileRect;
 
   /**
    * @brief
@@ -129,6 +149,11 @@ struct ObjectMetadata {
   int numBranches;
   int mSubId;
   int mGraphId;
+  /**
+   * @brief 帧追踪用，上一次出队或入队的时间(us)与正在处理它的element
+   */
+  std::int64_t mTraceTs = 0;
+  int mTraceElementId = -1;
   /**
    * @brief
    * 用于posec3d插件中的推理和后处理，表示ObjectMetadata是否包含了多帧输入
@@ -145,6 +170,13 @@ struct ObjectMetadata {
    */
   std::vector<std::shared_ptr<common::DetectedObjectMetadata>>
       mDetectedObjectMetadatas;
+  /**
+   * @brief 按列存放的检测结果，mDetectionsInTable为true时检测结果(以及与之
+   * 一一对应的跟踪结果)在表中，mDetectedObjectMetadatas为空。
+   * element在popInputData时按自己使用的表示自动转换
+   */
+  DetectionTable mDetectionTable;
+  bool mDetectionsInTable = false;
   /**
    * @brief 姿态结果的vector，一个目标对应一个PosedObjectMetadata
    */
@@ -178,10 +210,26 @@ struct ObjectMetadata {
    * @brief obb检测结果的vector，一个目标对应一个ObbObjectMetadata
    */
   std::vector<std::shared_ptr<common::ObbObjectMetadata>> mObbObjectMetadatas;
+
+  /**
+   * @brief 本帧子metadata的arena，检测、跟踪等结果用makeInArena(mArena)创建
+   */
+  std::shared_ptr<MetadataArena> mArena;
 };
 
 using ObjectMetadatas = std::vector<std::shared_ptr<ObjectMetadata>>;
 
+/**
+ * @brief 从通道的池创建一帧的ObjectMetadata与Frame，并为子metadata创建arena
+ */
+inline std::shared_ptr<ObjectMetadata> makeFrameObjectMetadata(
+    const std::shared_ptr<MetadataPool>& pool) {
+  auto objectMetadata = makePooled<ObjectMetadata>(pool);
+  objectMetadata->mFrame = makePooled<Frame>(pool);
+  if (pool) objectMetadata->mArena = pool->createArena();
+  return objectMetadata;
+}
+
 }  // namespace common
 }  // namespace sophon_stream
 
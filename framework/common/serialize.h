@@ -212,7 +212,8 @@ void to_json(nlohmann::json& j, Frame frame) {
   j["mWidth"] = frame.mWidth;
   j["mHeight"] = frame.mHeight;
   j["mEndOfStream"] = frame.mEndOfStream;
-  j["mSpData"] = frame_to_base64(frame);
+  // 图像可能已经被graph释放
+  if (frame.mSpData || frame.mSpDataOsd) j["mSpData"] = frame_to_base64(frame);
 }
 
 NLOHMANN_JSONIFY_ALL_THINGS(TrackedObjectMetadata, mTrackId)
@@ -251,6 +252,8 @@ void to_json(nlohmann::json& j, std::shared_ptr<common::ObjectMetadata> obj) {
   j["mFrame"] = (*(obj->mFrame));
   j["mSubId"] = obj->mSubId;
   j["mGraphId"] = obj->mGraphId;
+  j["mInterpolated"] = obj->mInterpolated;
+  if (!obj->mMotionRegions.empty()) j["mMotionRegions"] = obj->mMotionRegions;
   for (auto subObj : obj->mSubObjectMetadatas) {
     nlohmann::json subJ;
     to_json(subJ, subObj);
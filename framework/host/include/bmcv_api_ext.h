@@ -0,0 +1,201 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// TARGET_ARCH=host时代替libsophon的bmcv_api_ext.h，
+// bm_image数据放在主机内存中，bmcv算子用OpenCV在CPU上实现
+
+#ifndef SOPHON_STREAM_HOST_BMCV_API_EXT_H_
+#define SOPHON_STREAM_HOST_BMCV_API_EXT_H_
+
+#include "bmlib_runtime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum bm_image_format_ext_ {
+  FORMAT_YUV420P,
+  FORMAT_YUV422P,
+  FORMAT_YUV444P,
+  FORMAT_NV12,
+  FORMAT_NV21,
+  FORMAT_NV16,
+  FORMAT_NV61,
+  FORMAT_NV24,
+  FORMAT_RGB_PLANAR,
+  FORMAT_BGR_PLANAR,
+  FORMAT_RGB_PACKED,
+  FORMAT_BGR_PACKED,
+  FORMAT_RGBP_SEPARATE,
+  FORMAT_BGRP_SEPARATE,
+  FORMAT_GRAY,
+  FORMAT_COMPRESSED
+} bm_image_format_ext;
+
+typedef enum bm_image_data_format_ext_ {
+  DATA_TYPE_EXT_FLOAT32,
+  DATA_TYPE_EXT_1N_BYTE,
+  DATA_TYPE_EXT_4N_BYTE,
+  DATA_TYPE_EXT_1N_BYTE_SIGNED,
+  DATA_TYPE_EXT_4N_BYTE_SIGNED,
+  DATA_TYPE_EXT_FP16,
+  DATA_TYPE_EXT_BF16
+} bm_image_data_format_ext;
+
+typedef enum bmcv_resize_algorithm_ {
+  BMCV_INTER_NEAREST = 0,
+  BMCV_INTER_LINEAR = 1,
+  BMCV_INTER_BICUBIC = 2
+} bmcv_resize_algorithm;
+
+struct bm_image_private;
+
+typedef struct bm_image {
+  int width;
+  int height;
+  bm_image_format_ext image_format;
+  bm_image_data_format_ext data_type;
+  struct bm_image_private* image_private;
+} bm_image;
+
+typedef struct bm_image_format_info {
+  int plane_nb;
+  bm_device_mem_t plane_data[8];
+  int stride[8];
+  int width;
+  int height;
+  bm_image_format_ext image_format;
+  bm_image_data_format_ext data_type;
+  int default_stride;
+} bm_image_format_info_t;
+
+typedef struct bmcv_rect {
+  int start_x;
+  int start_y;
+  int crop_w;
+  int crop_h;
+} bmcv_rect_t;
+
+typedef struct {
+  int x;
+  int y;
+} bmcv_point_t;
+
+typedef struct {
+  unsigned char r;
+  unsigned char g;
+  unsigned char b;
+} bmcv_color_t;
+
+typedef struct bmcv_padding_atrr_s {
+  unsigned int dst_crop_stx;
+  unsigned int dst_crop_sty;
+  unsigned int dst_crop_w;
+  unsigned int dst_crop_h;
+  unsigned char padding_r;
+  unsigned char padding_g;
+  unsigned char padding_b;
+  int if_memset;
+} bmcv_padding_atrr_t;
+
+typedef struct bmcv_copy_to_atrr_s {
+  int start_x;
+  int start_y;
+  unsigned char padding_r;
+  unsigned char padding_g;
+  unsigned char padding_b;
+  int if_padding;
+} bmcv_copy_to_atrr_t;
+
+typedef struct bmcv_convert_to_attr_s {
+  float alpha_0;
+  float beta_0;
+  float alpha_1;
+  float beta_1;
+  float alpha_2;
+  float beta_2;
+} bmcv_convert_to_attr;
+
+#ifdef __cplusplus
+#define BMCV_DEFAULT(value) = value
+#else
+#define BMCV_DEFAULT(value)
+#endif
+
+bm_status_t bm_image_create(bm_handle_t handle, int img_h, int img_w,
+                            bm_image_format_ext image_format,
+                            bm_image_data_format_ext data_type,
+                            bm_image* image, int* stride BMCV_DEFAULT(NULL));
+bm_status_t bm_image_destroy(bm_image image);
+bm_handle_t bm_image_get_handle(bm_image* image);
+bm_status_t bm_image_alloc_dev_mem(bm_image image,
+                                   int heap_id BMCV_DEFAULT(BMCV_HEAP_ANY));
+bm_status_t bm_image_alloc_dev_mem_heap_mask(bm_image image, int heap_mask);
+bm_status_t bm_image_attach(bm_image image, bm_device_mem_t* device_memory);
+bm_status_t bm_image_detach(bm_image image);
+bool bm_image_is_attached(bm_image image);
+int bm_image_get_plane_num(bm_image image);
+bm_status_t bm_image_get_byte_size(bm_image image, int* size);
+bm_status_t bm_image_get_stride(bm_image image, int* stride);
+bm_status_t bm_image_get_device_mem(bm_image image, bm_device_mem_t* mem);
+bm_status_t bm_image_get_format_info(bm_image* src,
+                                     bm_image_format_info_t* info);
+bm_status_t bm_image_copy_host_to_device(bm_image image, void* buffers[]);
+bm_status_t bm_image_copy_device_to_host(bm_image image, void* buffers[]);
+
+bm_status_t bmcv_image_storage_convert(bm_handle_t handle, int image_num,
+                                       bm_image* input, bm_image* output);
+bm_status_t bmcv_image_copy_to(bm_handle_t handle, bmcv_copy_to_atrr_t attr,
+                               bm_image input, bm_image output);
+bm_status_t bmcv_image_vpp_convert(
+    bm_handle_t handle, int output_num, bm_image input, bm_image* output,
+    bmcv_rect_t* crop_rect BMCV_DEFAULT(NULL),
+    bmcv_resize_algorithm algorithm BMCV_DEFAULT(BMCV_INTER_LINEAR));
+bm_status_t bmcv_image_vpp_convert_padding(
+    bm_handle_t handle, int output_num, bm_image input, bm_image* output,
+    bmcv_padding_atrr_t* padding_attr,
+    bmcv_rect_t* crop_rect BMCV_DEFAULT(NULL),
+    bmcv_resize_algorithm algorithm BMCV_DEFAULT(BMCV_INTER_LINEAR));
+bm_status_t bmcv_image_crop(bm_handle_t handle, int crop_num,
+                            bmcv_rect_t* rects, bm_image input,
+                            bm_image* output);
+bm_status_t bmcv_image_convert_to(bm_handle_t handle, int input_num,
+                                  bmcv_convert_to_attr convert_to_attr,
+                                  bm_image* input, bm_image* output);
+bm_status_t bmcv_image_draw_rectangle(bm_handle_t handle, bm_image image,
+                                      int rect_num, bmcv_rect_t* rects,
+                                      int line_width, unsigned char r,
+                                      unsigned char g, unsigned char b);
+bm_status_t bmcv_image_fill_rectangle(bm_handle_t handle, bm_image image,
+                                      int rect_num, bmcv_rect_t* rects,
+                                      unsigned char r, unsigned char g,
+                                      unsigned char b);
+bm_status_t bmcv_image_draw_lines(bm_handle_t handle, bm_image img,
+                                  const bmcv_point_t* start,
+                                  const bmcv_point_t* end, int line_num,
+                                  bmcv_color_t color, int thickness);
+bm_status_t bmcv_image_put_text(bm_handle_t handle, bm_image image,
+                                const char* text, bmcv_point_t org,
+                                bmcv_color_t color, float fontScale,
+                                int thickness);
+bm_status_t bmcv_image_jpeg_enc(bm_handle_t handle, int image_num,
+                                bm_image* src, void* p_jpeg_data[],
+                                size_t* out_size,
+                                int quality_factor BMCV_DEFAULT(85));
+bm_status_t bmcv_image_jpeg_dec(bm_handle_t handle, void* p_jpeg_data[],
+                                size_t* in_size, int image_num,
+                                bm_image* dst);
+bm_status_t bmcv_base64_enc(bm_handle_t handle, bm_device_mem_t src,
+                            bm_device_mem_t dst, unsigned long len[2]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SOPHON_STREAM_HOST_BMCV_API_EXT_H_
@@ -0,0 +1,161 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// TARGET_ARCH=host时代替libsophon的bmlib_runtime.h，
+// 只声明框架用到的子集，"显存"是主机内存，device_addr中保存主机地址
+
+#ifndef SOPHON_STREAM_HOST_BMLIB_RUNTIME_H_
+#define SOPHON_STREAM_HOST_BMLIB_RUNTIME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  BM_SUCCESS = 0,
+  BM_ERR_DEVNOTREADY = 1,
+  BM_ERR_FAILURE = 2,
+  BM_ERR_TIMEOUT = 3,
+  BM_ERR_PARAM = 4,
+  BM_ERR_NOMEM = 5,
+  BM_ERR_DATA = 6,
+  BM_ERR_BUSY = 7,
+  BM_ERR_NOFEATURE = 8,
+  BM_NOT_SUPPORTED = 9
+} bm_status_t;
+
+typedef enum {
+  BM_MEM_TYPE_DEVICE = 0,
+  BM_MEM_TYPE_HOST = 1,
+  BM_MEM_TYPE_SYSTEM = 2,
+  BM_MEM_TYPE_INT8_DEVICE = 3,
+  BM_MEM_TYPE_INVALID = 4
+} bm_mem_type_t;
+
+struct bm_context;
+typedef struct bm_context* bm_handle_t;
+
+typedef struct bm_mem_desc {
+  union {
+    struct {
+      unsigned long long device_addr;
+      unsigned int reserved;
+      int dmabuf_fd;
+    } device;
+    struct {
+      void* system_addr;
+      unsigned int reserved0;
+      int reserved1;
+    } system;
+  } u;
+  struct {
+    bm_mem_type_t mem_type : 3;
+    unsigned int gmem_heapid : 3;
+    unsigned int reserved : 26;
+  } flags;
+  unsigned int size;
+} bm_mem_desc_t;
+
+typedef struct bm_mem_desc bm_device_mem_t;
+typedef struct bm_mem_desc bm_system_mem_t;
+
+struct bm_misc_info {
+  int pcie_soc_mode;
+  int ddr_ecc_enable;
+  long long ddr0a_size;
+  long long ddr0b_size;
+  long long ddr1_size;
+  long long ddr2_size;
+  unsigned int chipid;
+  unsigned int chipid_bit_mask;
+  unsigned int driver_version;
+  int domain_bdf;
+  int board_version;
+  int a53_enable;
+  int dyn_enable;
+};
+
+#define BMCV_HEAP_ANY -1
+
+bm_status_t bm_dev_request(bm_handle_t* handle, int devid);
+void bm_dev_free(bm_handle_t handle);
+int bm_get_devid(bm_handle_t handle);
+bm_status_t bm_get_chipid(bm_handle_t handle, unsigned int* p_chipid);
+bm_status_t bm_get_misc_info(bm_handle_t handle, struct bm_misc_info* pmisc_info);
+bm_status_t bm_thread_sync(bm_handle_t handle);
+
+bm_device_mem_t bm_mem_null(void);
+bm_device_mem_t bm_mem_from_device(unsigned long long device_addr,
+                                   unsigned int len);
+bm_system_mem_t bm_mem_from_system(void* system_addr);
+unsigned long long bm_mem_get_device_addr(struct bm_mem_desc mem);
+void bm_mem_set_device_addr(struct bm_mem_desc* pmem, unsigned long long addr);
+unsigned int bm_mem_get_device_size(struct bm_mem_desc mem);
+void bm_mem_set_device_size(struct bm_mem_desc* pmem, unsigned int size);
+
+bm_status_t bm_malloc_device_byte(bm_handle_t handle, bm_device_mem_t* pmem,
+                                  unsigned int size);
+bm_status_t bm_malloc_device_byte_heap(bm_handle_t handle,
+                                       bm_device_mem_t* pmem, int heap_id,
+                                       unsigned int size);
+bm_status_t bm_malloc_device_byte_heap_mask(bm_handle_t handle,
+                                            bm_device_mem_t* pmem,
+                                            int heap_id_mask,
+                                            unsigned int size);
+void bm_free_device(bm_handle_t handle, bm_device_mem_t mem);
+
+bm_status_t bm_memcpy_s2d(bm_handle_t handle, bm_device_mem_t dst, void* src);
+bm_status_t bm_memcpy_d2s(bm_handle_t handle, void* dst, bm_device_mem_t src);
+bm_status_t bm_memcpy_s2d_partial(bm_handle_t handle, bm_device_mem_t dst,
+                                  void* src, unsigned int size);
+bm_status_t bm_memcpy_d2s_partial(bm_handle_t handle, void* dst,
+                                  bm_device_mem_t src, unsigned int size);
+bm_status_t bm_memcpy_s2d_partial_offset(bm_handle_t handle,
+                                         bm_device_mem_t dst, void* src,
+                                         unsigned int size,
+                                         unsigned int offset);
+bm_status_t bm_memcpy_d2s_partial_offset(bm_handle_t handle, void* dst,
+                                         bm_device_mem_t src,
+                                         unsigned int size,
+                                         unsigned int offset);
+bm_status_t bm_memcpy_d2d_byte(bm_handle_t handle, bm_device_mem_t dst,
+                               size_t dst_offset, bm_device_mem_t src,
+                               size_t src_offset, size_t size);
+bm_status_t bm_memset_device(bm_handle_t handle, const int value,
+                             bm_device_mem_t mem);
+
+bm_status_t bm_mem_mmap_device_mem(bm_handle_t handle, bm_device_mem_t* dmem,
+                                   unsigned long long* vmem);
+bm_status_t bm_mem_unmap_device_mem(bm_handle_t handle, void* vmem, int size);
+bm_status_t bm_mem_invalidate_device_mem(bm_handle_t handle,
+                                         bm_device_mem_t* dmem);
+bm_status_t bm_mem_flush_device_mem(bm_handle_t handle, bm_device_mem_t* dmem);
+
+// tpu_kernel在主机上不可用，load/get_function返回空，launch返回BM_NOT_SUPPORTED
+typedef void* tpu_kernel_module_t;
+typedef int tpu_kernel_function_t;
+
+tpu_kernel_module_t tpu_kernel_load_module_file(bm_handle_t handle,
+                                                const char* module_file);
+tpu_kernel_function_t tpu_kernel_get_function(bm_handle_t handle,
+                                              tpu_kernel_module_t module,
+                                              const char* function);
+bm_status_t tpu_kernel_launch(bm_handle_t handle, tpu_kernel_function_t func,
+                              void* args, size_t size);
+bm_status_t tpu_kernel_unload_module(bm_handle_t handle,
+                                     tpu_kernel_module_t p_module);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SOPHON_STREAM_HOST_BMLIB_RUNTIME_H_
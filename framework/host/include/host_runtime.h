@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_HOST_HOST_RUNTIME_H_
+#define SOPHON_STREAM_HOST_HOST_RUNTIME_H_
+
+#include <functional>
+#include <string>
+
+#include "bmruntime_interface.h"
+
+namespace sophon_stream {
+namespace host {
+
+/**
+ * @brief 主机上的"推理"回调，输入输出tensor的device_mem都是主机内存，
+ * output_tensors已按网络最大形状申请好
+ * @return 是否成功
+ */
+using InferenceHandler = std::function<bool(
+    const bm_net_info_t& netInfo, const bm_tensor_t* inputTensors,
+    int inputNum, bm_tensor_t* outputTensors, int outputNum)>;
+
+/**
+ * @brief 为指定名字的网络注册推理回调，覆盖描述文件中配置的输出。
+ * 用于在测试或benchmark中生成与输入相关的输出
+ */
+void registerInferenceHandler(const std::string& netName,
+                              InferenceHandler handler);
+
+/**
+ * @brief 模型描述文件的路径：model_path本身是.json时直接使用，否则为model_path + ".json"
+ * 格式：
+ * {
+ *   "networks": [{
+ *     "name": "yolov5s",
+ *     "inputs":  [{"name": "images", "dtype": "float32", "scale": 1.0,
+ *                  "shape": [4, 3, 640, 640]}],
+ *     "outputs": [{"name": "output0", "dtype": "float32", "scale": 1.0,
+ *                  "shape": [4, 25200, 85], "data": "recorded/output0.bin"}]
+ *   }]
+ * }
+ * outputs中的data为录制的原始输出（按最大batch的字节排列，不足时循环），
+ * 不配置data时输出fill的值（默认为0），配置"random": true时输出[0, 1)的随机数
+ */
+std::string modelDescriptionPath(const std::string& bmodelPath);
+
+}  // namespace host
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_HOST_HOST_RUNTIME_H_
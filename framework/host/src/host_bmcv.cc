@@ -0,0 +1,708 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdlib>
+#include <cstring>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "bmcv_api_ext.h"
+
+struct bm_image_private {
+  bm_handle_t handle = nullptr;
+  int plane_num = 0;
+  int stride[4] = {0};
+  int plane_height[4] = {0};
+  bm_device_mem_t mem[4];
+  bool attached = false;
+  // 内存由bm_image_alloc_dev_mem申请，destroy时释放
+  bool owned = false;
+};
+
+namespace {
+
+inline unsigned char* memPtr(const bm_device_mem_t& mem) {
+  return reinterpret_cast<unsigned char*>(mem.u.device.device_addr);
+}
+
+int elemSize(bm_image_data_format_ext dataType) {
+  switch (dataType) {
+    case DATA_TYPE_EXT_FLOAT32:
+      return 4;
+    case DATA_TYPE_EXT_FP16:
+    case DATA_TYPE_EXT_BF16:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+int cvDepth(bm_image_data_format_ext dataType) {
+  switch (dataType) {
+    case DATA_TYPE_EXT_FLOAT32:
+      return CV_32F;
+    case DATA_TYPE_EXT_FP16:
+      return CV_16F;
+    case DATA_TYPE_EXT_1N_BYTE_SIGNED:
+    case DATA_TYPE_EXT_4N_BYTE_SIGNED:
+      return CV_8S;
+    case DATA_TYPE_EXT_1N_BYTE:
+    case DATA_TYPE_EXT_4N_BYTE:
+      return CV_8U;
+    default:
+      return -1;
+  }
+}
+
+// 每个平面的宽（像素数）和高
+int planeLayout(bm_image_format_ext format, int w, int h, int widths[4],
+                int heights[4]) {
+  int halfW = (w + 1) / 2;
+  int halfH = (h + 1) / 2;
+  switch (format) {
+    case FORMAT_YUV420P:
+      widths[0] = w, heights[0] = h;
+      widths[1] = widths[2] = halfW;
+      heights[1] = heights[2] = halfH;
+      return 3;
+    case FORMAT_YUV422P:
+      widths[0] = w, heights[0] = h;
+      widths[1] = widths[2] = halfW;
+      heights[1] = heights[2] = h;
+      return 3;
+    case FORMAT_YUV444P:
+    case FORMAT_RGBP_SEPARATE:
+    case FORMAT_BGRP_SEPARATE:
+      for (int i = 0; i < 3; ++i) widths[i] = w, heights[i] = h;
+      return 3;
+    case FORMAT_NV12:
+    case FORMAT_NV21:
+      widths[0] = w, heights[0] = h;
+      widths[1] = halfW * 2, heights[1] = halfH;
+      return 2;
+    case FORMAT_NV16:
+    case FORMAT_NV61:
+      widths[0] = w, heights[0] = h;
+      widths[1] = halfW * 2, heights[1] = h;
+      return 2;
+    case FORMAT_NV24:
+      widths[0] = w, heights[0] = h;
+      widths[1] = w * 2, heights[1] = h;
+      return 2;
+    case FORMAT_RGB_PLANAR:
+    case FORMAT_BGR_PLANAR:
+      widths[0] = w, heights[0] = h * 3;
+      return 1;
+    case FORMAT_RGB_PACKED:
+    case FORMAT_BGR_PACKED:
+      widths[0] = w * 3, heights[0] = h;
+      return 1;
+    case FORMAT_GRAY:
+      widths[0] = w, heights[0] = h;
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+cv::Mat planeMat(const bm_image& image, int plane, int type, int rows,
+                 int cols, int rowOffset = 0) {
+  bm_image_private* priv = image.image_private;
+  return cv::Mat(rows, cols, type,
+                 memPtr(priv->mem[plane]) + rowOffset * priv->stride[plane],
+                 priv->stride[plane]);
+}
+
+// 把各平面拷贝成连续排列的YUV420，供cv::cvtColor使用
+cv::Mat toI420(const bm_image& image) {
+  int w = image.width, h = image.height;
+  cv::Mat i420(h * 3 / 2, w, CV_8UC1);
+  planeMat(image, 0, CV_8UC1, h, w).copyTo(i420.rowRange(0, h));
+  cv::Mat u(h / 2, w / 2, CV_8UC1, i420.ptr(h));
+  cv::Mat v(h / 2, w / 2, CV_8UC1, i420.ptr(h) + (h / 2) * (w / 2));
+  if (image.image_format == FORMAT_YUV420P) {
+    planeMat(image, 1, CV_8UC1, h / 2, w / 2).copyTo(u);
+    planeMat(image, 2, CV_8UC1, h / 2, w / 2).copyTo(v);
+  } else {
+    cv::Mat uv[2];
+    cv::split(planeMat(image, 1, CV_8UC2, h / 2, w / 2), uv);
+    bool nv21 = image.image_format == FORMAT_NV21;
+    uv[nv21 ? 1 : 0].copyTo(u);
+    uv[nv21 ? 0 : 1].copyTo(v);
+  }
+  return i420;
+}
+
+bool toBgr(const bm_image& image, cv::Mat& bgr) {
+  if (image.image_private == nullptr || !image.image_private->attached ||
+      cvDepth(image.data_type) != CV_8U)
+    return false;
+  int w = image.width, h = image.height;
+  switch (image.image_format) {
+    case FORMAT_BGR_PACKED:
+      planeMat(image, 0, CV_8UC3, h, w).copyTo(bgr);
+      return true;
+    case FORMAT_RGB_PACKED:
+      cv::cvtColor(planeMat(image, 0, CV_8UC3, h, w), bgr, cv::COLOR_RGB2BGR);
+      return true;
+    case FORMAT_BGR_PLANAR:
+    case FORMAT_RGB_PLANAR:
+    case FORMAT_BGRP_SEPARATE:
+    case FORMAT_RGBP_SEPARATE: {
+      bool separate = image.image_format == FORMAT_BGRP_SEPARATE ||
+                      image.image_format == FORMAT_RGBP_SEPARATE;
+      bool rgb = image.image_format == FORMAT_RGB_PLANAR ||
+                 image.image_format == FORMAT_RGBP_SEPARATE;
+      std::vector<cv::Mat> channels(3);
+      for (int c = 0; c < 3; ++c) {
+        channels[rgb ? 2 - c : c] =
+            separate ? planeMat(image, c, CV_8UC1, h, w)
+                     : planeMat(image, 0, CV_8UC1, h, w, c * h);
+      }
+      cv::merge(channels, bgr);
+      return true;
+    }
+    case FORMAT_GRAY:
+      cv::cvtColor(planeMat(image, 0, CV_8UC1, h, w), bgr,
+                   cv::COLOR_GRAY2BGR);
+      return true;
+    case FORMAT_NV12:
+    case FORMAT_NV21:
+    case FORMAT_YUV420P:
+      if ((w & 1) || (h & 1)) return false;
+      cv::cvtColor(toI420(image), bgr, cv::COLOR_YUV2BGR_I420);
+      return true;
+    case FORMAT_YUV444P: {
+      std::vector<cv::Mat> channels;
+      for (int c = 0; c < 3; ++c)
+        channels.push_back(planeMat(image, c, CV_8UC1, h, w));
+      cv::Mat yuv;
+      cv::merge(channels, yuv);
+      cv::cvtColor(yuv, bgr, cv::COLOR_YUV2BGR);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool fromBgr(const cv::Mat& bgr, bm_image& image) {
+  if (image.image_private == nullptr || !image.image_private->attached ||
+      cvDepth(image.data_type) != CV_8U)
+    return false;
+  int w = image.width, h = image.height;
+  switch (image.image_format) {
+    case FORMAT_BGR_PACKED:
+      bgr.copyTo(planeMat(image, 0, CV_8UC3, h, w));
+      return true;
+    case FORMAT_RGB_PACKED: {
+      cv::Mat dst = planeMat(image, 0, CV_8UC3, h, w);
+      cv::cvtColor(bgr, dst, cv::COLOR_BGR2RGB);
+      return true;
+    }
+    case FORMAT_BGR_PLANAR:
+    case FORMAT_RGB_PLANAR:
+    case FORMAT_BGRP_SEPARATE:
+    case FORMAT_RGBP_SEPARATE: {
+      bool separate = image.image_format == FORMAT_BGRP_SEPARATE ||
+                      image.image_format == FORMAT_RGBP_SEPARATE;
+      bool rgb = image.image_format == FORMAT_RGB_PLANAR ||
+                 image.image_format == FORMAT_RGBP_SEPARATE;
+      std::vector<cv::Mat> channels;
+      cv::split(bgr, channels);
+      for (int c = 0; c < 3; ++c) {
+        cv::Mat dst = separate ? planeMat(image, c, CV_8UC1, h, w)
+                               : planeMat(image, 0, CV_8UC1, h, w, c * h);
+        channels[rgb ? 2 - c : c].copyTo(dst);
+      }
+      return true;
+    }
+    case FORMAT_GRAY: {
+      cv::Mat dst = planeMat(image, 0, CV_8UC1, h, w);
+      cv::cvtColor(bgr, dst, cv::COLOR_BGR2GRAY);
+      return true;
+    }
+    case FORMAT_NV12:
+    case FORMAT_NV21:
+    case FORMAT_YUV420P: {
+      if ((w & 1) || (h & 1)) return false;
+      cv::Mat i420;
+      cv::cvtColor(bgr, i420, cv::COLOR_BGR2YUV_I420);
+      i420.rowRange(0, h).copyTo(planeMat(image, 0, CV_8UC1, h, w));
+      cv::Mat u(h / 2, w / 2, CV_8UC1, i420.ptr(h));
+      cv::Mat v(h / 2, w / 2, CV_8UC1, i420.ptr(h) + (h / 2) * (w / 2));
+      if (image.image_format == FORMAT_YUV420P) {
+        u.copyTo(planeMat(image, 1, CV_8UC1, h / 2, w / 2));
+        v.copyTo(planeMat(image, 2, CV_8UC1, h / 2, w / 2));
+      } else {
+        bool nv21 = image.image_format == FORMAT_NV21;
+        std::vector<cv::Mat> uv = {nv21 ? v : u, nv21 ? u : v};
+        cv::Mat dst = planeMat(image, 1, CV_8UC2, h / 2, w / 2);
+        cv::merge(uv, dst);
+      }
+      return true;
+    }
+    case FORMAT_YUV444P: {
+      cv::Mat yuv;
+      cv::cvtColor(bgr, yuv, cv::COLOR_BGR2YUV);
+      std::vector<cv::Mat> channels;
+      cv::split(yuv, channels);
+      for (int c = 0; c < 3; ++c)
+        channels[c].copyTo(planeMat(image, c, CV_8UC1, h, w));
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// planar/separate/gray/packed图像的第c个通道，packed时返回nullptr
+bool channelMat(const bm_image& image, int c, cv::Mat& mat) {
+  int depth = cvDepth(image.data_type);
+  if (depth < 0) return false;
+  int w = image.width, h = image.height;
+  switch (image.image_format) {
+    case FORMAT_BGR_PLANAR:
+    case FORMAT_RGB_PLANAR:
+      mat = planeMat(image, 0, CV_MAKETYPE(depth, 1), h, w, c * h);
+      return true;
+    case FORMAT_BGRP_SEPARATE:
+    case FORMAT_RGBP_SEPARATE:
+    case FORMAT_YUV444P:
+      mat = planeMat(image, c, CV_MAKETYPE(depth, 1), h, w);
+      return true;
+    case FORMAT_GRAY:
+      if (c != 0) return false;
+      mat = planeMat(image, 0, CV_MAKETYPE(depth, 1), h, w);
+      return true;
+    default:
+      return false;
+  }
+}
+
+int channelNum(const bm_image& image) {
+  return image.image_format == FORMAT_GRAY ? 1 : 3;
+}
+
+int cvInterpolation(bmcv_resize_algorithm algorithm) {
+  switch (algorithm) {
+    case BMCV_INTER_NEAREST:
+      return cv::INTER_NEAREST;
+    case BMCV_INTER_BICUBIC:
+      return cv::INTER_CUBIC;
+    default:
+      return cv::INTER_LINEAR;
+  }
+}
+
+cv::Rect clipRect(const bmcv_rect_t* rect, int w, int h) {
+  cv::Rect full(0, 0, w, h);
+  if (rect == nullptr) return full;
+  return cv::Rect(rect->start_x, rect->start_y, rect->crop_w, rect->crop_h) &
+         full;
+}
+
+bool isCreated(const bm_image& image) {
+  return image.image_private != nullptr;
+}
+
+}  // namespace
+
+extern "C" {
+
+bm_status_t bm_image_create(bm_handle_t handle, int img_h, int img_w,
+                            bm_image_format_ext image_format,
+                            bm_image_data_format_ext data_type,
+                            bm_image* image, int* stride) {
+  int widths[4] = {0}, heights[4] = {0};
+  int planeNum = planeLayout(image_format, img_w, img_h, widths, heights);
+  if (planeNum == 0) return BM_NOT_SUPPORTED;
+  image->width = img_w;
+  image->height = img_h;
+  image->image_format = image_format;
+  image->data_type = data_type;
+  image->image_private = new bm_image_private();
+  image->image_private->handle = handle;
+  image->image_private->plane_num = planeNum;
+  for (int i = 0; i < planeNum; ++i) {
+    image->image_private->stride[i] =
+        stride != nullptr ? stride[i] : widths[i] * elemSize(data_type);
+    image->image_private->plane_height[i] = heights[i];
+    image->image_private->mem[i] = bm_mem_null();
+  }
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_image_destroy(bm_image image) {
+  if (!isCreated(image)) return BM_ERR_PARAM;
+  bm_image_private* priv = image.image_private;
+  if (priv->owned) {
+    for (int i = 0; i < priv->plane_num; ++i)
+      bm_free_device(priv->handle, priv->mem[i]);
+  }
+  delete priv;
+  return BM_SUCCESS;
+}
+
+bm_handle_t bm_image_get_handle(bm_image* image) {
+  return isCreated(*image) ? image->image_private->handle : nullptr;
+}
+
+bm_status_t bm_image_alloc_dev_mem(bm_image image, int heap_id) {
+  if (!isCreated(image)) return BM_ERR_PARAM;
+  bm_image_private* priv = image.image_private;
+  if (priv->attached) return BM_SUCCESS;
+  for (int i = 0; i < priv->plane_num; ++i) {
+    auto ret = bm_malloc_device_byte(priv->handle, &priv->mem[i],
+                                     priv->stride[i] * priv->plane_height[i]);
+    if (ret != BM_SUCCESS) {
+      for (int j = 0; j < i; ++j) bm_free_device(priv->handle, priv->mem[j]);
+      return ret;
+    }
+  }
+  priv->attached = true;
+  priv->owned = true;
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_image_alloc_dev_mem_heap_mask(bm_image image, int heap_mask) {
+  return bm_image_alloc_dev_mem(image, BMCV_HEAP_ANY);
+}
+
+bm_status_t bm_image_attach(bm_image image, bm_device_mem_t* device_memory) {
+  if (!isCreated(image)) return BM_ERR_PARAM;
+  bm_image_private* priv = image.image_private;
+  if (priv->owned) {
+    for (int i = 0; i < priv->plane_num; ++i)
+      bm_free_device(priv->handle, priv->mem[i]);
+  }
+  for (int i = 0; i < priv->plane_num; ++i) priv->mem[i] = device_memory[i];
+  priv->attached = true;
+  priv->owned = false;
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_image_detach(bm_image image) {
+  if (!isCreated(image)) return BM_ERR_PARAM;
+  bm_image_private* priv = image.image_private;
+  if (priv->owned) {
+    for (int i = 0; i < priv->plane_num; ++i)
+      bm_free_device(priv->handle, priv->mem[i]);
+  }
+  for (int i = 0; i < priv->plane_num; ++i) priv->mem[i] = bm_mem_null();
+  priv->attached = false;
+  priv->owned = false;
+  return BM_SUCCESS;
+}
+
+bool bm_image_is_attached(bm_image image) {
+  return isCreated(image) && image.image_private->attached;
+}
+
+int bm_image_get_plane_num(bm_image image) {
+  return isCreated(image) ? image.image_private->plane_num : 0;
+}
+
+bm_status_t bm_image_get_byte_size(bm_image image, int* size) {
+  if (!isCreated(image)) return BM_ERR_PARAM;
+  bm_image_private* priv = image.image_private;
+  for (int i = 0; i < priv->plane_num; ++i)
+    size[i] = priv->stride[i] * priv->plane_height[i];
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_image_get_stride(bm_image image, int* stride) {
+  if (!isCreated(image)) return BM_ERR_PARAM;
+  for (int i = 0; i < image.image_private->plane_num; ++i)
+    stride[i] = image.image_private->stride[i];
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_image_get_device_mem(bm_image image, bm_device_mem_t* mem) {
+  if (!isCreated(image)) return BM_ERR_PARAM;
+  bm_image_private* priv = image.image_private;
+  for (int i = 0; i < priv->plane_num; ++i) {
+    mem[i] = priv->mem[i];
+    mem[i].size = priv->stride[i] * priv->plane_height[i];
+  }
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_image_get_format_info(bm_image* src,
+                                     bm_image_format_info_t* info) {
+  if (!isCreated(*src)) return BM_ERR_PARAM;
+  bm_image_private* priv = src->image_private;
+  memset(info, 0, sizeof(bm_image_format_info_t));
+  info->plane_nb = priv->plane_num;
+  for (int i = 0; i < priv->plane_num; ++i) {
+    info->plane_data[i] = priv->mem[i];
+    info->stride[i] = priv->stride[i];
+  }
+  info->width = src->width;
+  info->height = src->height;
+  info->image_format = src->image_format;
+  info->data_type = src->data_type;
+  info->default_stride = 1;
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_image_copy_host_to_device(bm_image image, void* buffers[]) {
+  if (!isCreated(image)) return BM_ERR_PARAM;
+  if (!image.image_private->attached) {
+    auto ret = bm_image_alloc_dev_mem(image, BMCV_HEAP_ANY);
+    if (ret != BM_SUCCESS) return ret;
+  }
+  bm_image_private* priv = image.image_private;
+  for (int i = 0; i < priv->plane_num; ++i)
+    memcpy(memPtr(priv->mem[i]), buffers[i],
+           priv->stride[i] * priv->plane_height[i]);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_image_copy_device_to_host(bm_image image, void* buffers[]) {
+  if (!bm_image_is_attached(image)) return BM_ERR_PARAM;
+  bm_image_private* priv = image.image_private;
+  for (int i = 0; i < priv->plane_num; ++i)
+    memcpy(buffers[i], memPtr(priv->mem[i]),
+           priv->stride[i] * priv->plane_height[i]);
+  return BM_SUCCESS;
+}
+
+bm_status_t bmcv_image_storage_convert(bm_handle_t handle, int image_num,
+                                       bm_image* input, bm_image* output) {
+  for (int i = 0; i < image_num; ++i) {
+    if (!bm_image_is_attached(output[i]) &&
+        bm_image_alloc_dev_mem(output[i], BMCV_HEAP_ANY) != BM_SUCCESS)
+      return BM_ERR_NOMEM;
+    cv::Mat bgr;
+    if (!toBgr(input[i], bgr)) return BM_NOT_SUPPORTED;
+    if (bgr.cols != output[i].width || bgr.rows != output[i].height)
+      return BM_ERR_PARAM;
+    if (!fromBgr(bgr, output[i])) return BM_NOT_SUPPORTED;
+  }
+  return BM_SUCCESS;
+}
+
+bm_status_t bmcv_image_copy_to(bm_handle_t handle, bmcv_copy_to_atrr_t attr,
+                               bm_image input, bm_image output) {
+  cv::Mat src, dst;
+  if (!toBgr(input, src)) return BM_NOT_SUPPORTED;
+  if (attr.if_padding) {
+    dst = cv::Mat(output.height, output.width, CV_8UC3,
+                  cv::Scalar(attr.padding_b, attr.padding_g, attr.padding_r));
+  } else if (!toBgr(output, dst)) {
+    return BM_NOT_SUPPORTED;
+  }
+  cv::Rect target(attr.start_x, attr.start_y, src.cols, src.rows);
+  target &= cv::Rect(0, 0, dst.cols, dst.rows);
+  src(cv::Rect(0, 0, target.width, target.height)).copyTo(dst(target));
+  return fromBgr(dst, output) ? BM_SUCCESS : BM_NOT_SUPPORTED;
+}
+
+bm_status_t bmcv_image_vpp_convert(bm_handle_t handle, int output_num,
+                                   bm_image input, bm_image* output,
+                                   bmcv_rect_t* crop_rect,
+                                   bmcv_resize_algorithm algorithm) {
+  cv::Mat src;
+  if (!toBgr(input, src)) return BM_NOT_SUPPORTED;
+  for (int i = 0; i < output_num; ++i) {
+    if (!bm_image_is_attached(output[i]) &&
+        bm_image_alloc_dev_mem(output[i], BMCV_HEAP_ANY) != BM_SUCCESS)
+      return BM_ERR_NOMEM;
+    cv::Rect roi = clipRect(crop_rect == nullptr ? nullptr : &crop_rect[i],
+                            src.cols, src.rows);
+    cv::Mat dst;
+    cv::resize(src(roi), dst, cv::Size(output[i].width, output[i].height), 0,
+               0, cvInterpolation(algorithm));
+    if (!fromBgr(dst, output[i])) return BM_NOT_SUPPORTED;
+  }
+  return BM_SUCCESS;
+}
+
+bm_status_t bmcv_image_vpp_convert_padding(bm_handle_t handle, int output_num,
+                                           bm_image input, bm_image* output,
+                                           bmcv_padding_atrr_t* padding_attr,
+                                           bmcv_rect_t* crop_rect,
+                                           bmcv_resize_algorithm algorithm) {
+  cv::Mat src;
+  if (!toBgr(input, src)) return BM_NOT_SUPPORTED;
+  for (int i = 0; i < output_num; ++i) {
+    if (!bm_image_is_attached(output[i]) &&
+        bm_image_alloc_dev_mem(output[i], BMCV_HEAP_ANY) != BM_SUCCESS)
+      return BM_ERR_NOMEM;
+    const bmcv_padding_atrr_t& attr = padding_attr[i];
+    cv::Mat dst;
+    if (attr.if_memset) {
+      dst = cv::Mat(output[i].height, output[i].width, CV_8UC3,
+                    cv::Scalar(attr.padding_b, attr.padding_g, attr.padding_r));
+    } else if (!toBgr(output[i], dst)) {
+      return BM_NOT_SUPPORTED;
+    }
+    cv::Rect roi = clipRect(crop_rect == nullptr ? nullptr : &crop_rect[i],
+                            src.cols, src.rows);
+    cv::Rect target(attr.dst_crop_stx, attr.dst_crop_sty, attr.dst_crop_w,
+                    attr.dst_crop_h);
+    target &= cv::Rect(0, 0, dst.cols, dst.rows);
+    if (target.area() > 0) {
+      cv::Mat resized;
+      cv::resize(src(roi), resized, target.size(), 0, 0,
+                 cvInterpolation(algorithm));
+      resized.copyTo(dst(target));
+    }
+    if (!fromBgr(dst, output[i])) return BM_NOT_SUPPORTED;
+  }
+  return BM_SUCCESS;
+}
+
+bm_status_t bmcv_image_crop(bm_handle_t handle, int crop_num,
+                            bmcv_rect_t* rects, bm_image input,
+                            bm_image* output) {
+  for (int i = 0; i < crop_num; ++i) {
+    auto ret = bmcv_image_vpp_convert(handle, 1, input, &output[i], &rects[i],
+                                      BMCV_INTER_LINEAR);
+    if (ret != BM_SUCCESS) return ret;
+  }
+  return BM_SUCCESS;
+}
+
+bm_status_t bmcv_image_convert_to(bm_handle_t handle, int input_num,
+                                  bmcv_convert_to_attr convert_to_attr,
+                                  bm_image* input, bm_image* output) {
+  const float alpha[3] = {convert_to_attr.alpha_0, convert_to_attr.alpha_1,
+                          convert_to_attr.alpha_2};
+  const float beta[3] = {convert_to_attr.beta_0, convert_to_attr.beta_1,
+                         convert_to_attr.beta_2};
+  for (int i = 0; i < input_num; ++i) {
+    if (!bm_image_is_attached(output[i]) &&
+        bm_image_alloc_dev_mem(output[i], BMCV_HEAP_ANY) != BM_SUCCESS)
+      return BM_ERR_NOMEM;
+    if (!bm_image_is_attached(input[i])) return BM_ERR_PARAM;
+    for (int c = 0; c < channelNum(input[i]); ++c) {
+      cv::Mat src, dst;
+      if (!channelMat(input[i], c, src) || !channelMat(output[i], c, dst))
+        return BM_NOT_SUPPORTED;
+      src.convertTo(dst, dst.type(), alpha[c], beta[c]);
+    }
+  }
+  return BM_SUCCESS;
+}
+
+bm_status_t bmcv_image_draw_rectangle(bm_handle_t handle, bm_image image,
+                                      int rect_num, bmcv_rect_t* rects,
+                                      int line_width, unsigned char r,
+                                      unsigned char g, unsigned char b) {
+  cv::Mat bgr;
+  if (!toBgr(image, bgr)) return BM_NOT_SUPPORTED;
+  for (int i = 0; i < rect_num; ++i) {
+    cv::rectangle(bgr,
+                  cv::Rect(rects[i].start_x, rects[i].start_y, rects[i].crop_w,
+                           rects[i].crop_h),
+                  cv::Scalar(b, g, r), line_width);
+  }
+  return fromBgr(bgr, image) ? BM_SUCCESS : BM_NOT_SUPPORTED;
+}
+
+bm_status_t bmcv_image_fill_rectangle(bm_handle_t handle, bm_image image,
+                                      int rect_num, bmcv_rect_t* rects,
+                                      unsigned char r, unsigned char g,
+                                      unsigned char b) {
+  cv::Mat bgr;
+  if (!toBgr(image, bgr)) return BM_NOT_SUPPORTED;
+  for (int i = 0; i < rect_num; ++i) {
+    cv::rectangle(bgr,
+                  cv::Rect(rects[i].start_x, rects[i].start_y, rects[i].crop_w,
+                           rects[i].crop_h),
+                  cv::Scalar(b, g, r), cv::FILLED);
+  }
+  return fromBgr(bgr, image) ? BM_SUCCESS : BM_NOT_SUPPORTED;
+}
+
+bm_status_t bmcv_image_draw_lines(bm_handle_t handle, bm_image img,
+                                  const bmcv_point_t* start,
+                                  const bmcv_point_t* end, int line_num,
+                                  bmcv_color_t color, int thickness) {
+  cv::Mat bgr;
+  if (!toBgr(img, bgr)) return BM_NOT_SUPPORTED;
+  for (int i = 0; i < line_num; ++i) {
+    cv::line(bgr, cv::Point(start[i].x, start[i].y),
+             cv::Point(end[i].x, end[i].y),
+             cv::Scalar(color.b, color.g, color.r), thickness);
+  }
+  return fromBgr(bgr, img) ? BM_SUCCESS : BM_NOT_SUPPORTED;
+}
+
+bm_status_t bmcv_image_put_text(bm_handle_t handle, bm_image image,
+                                const char* text, bmcv_point_t org,
+                                bmcv_color_t color, float fontScale,
+                                int thickness) {
+  cv::Mat bgr;
+  if (!toBgr(image, bgr)) return BM_NOT_SUPPORTED;
+  cv::putText(bgr, text, cv::Point(org.x, org.y), cv::FONT_HERSHEY_SIMPLEX,
+              fontScale, cv::Scalar(color.b, color.g, color.r), thickness);
+  return fromBgr(bgr, image) ? BM_SUCCESS : BM_NOT_SUPPORTED;
+}
+
+bm_status_t bmcv_image_jpeg_enc(bm_handle_t handle, int image_num,
+                                bm_image* src, void* p_jpeg_data[],
+                                size_t* out_size, int quality_factor) {
+  for (int i = 0; i < image_num; ++i) {
+    cv::Mat bgr;
+    if (!toBgr(src[i], bgr)) return BM_NOT_SUPPORTED;
+    std::vector<uchar> jpeg;
+    cv::imencode(".jpg", bgr, jpeg, {cv::IMWRITE_JPEG_QUALITY, quality_factor});
+    if (p_jpeg_data[i] == nullptr) p_jpeg_data[i] = malloc(jpeg.size());
+    memcpy(p_jpeg_data[i], jpeg.data(), jpeg.size());
+    out_size[i] = jpeg.size();
+  }
+  return BM_SUCCESS;
+}
+
+bm_status_t bmcv_image_jpeg_dec(bm_handle_t handle, void* p_jpeg_data[],
+                                size_t* in_size, int image_num,
+                                bm_image* dst) {
+  for (int i = 0; i < image_num; ++i) {
+    cv::Mat jpeg(1, in_size[i], CV_8UC1, p_jpeg_data[i]);
+    cv::Mat bgr = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+    if (bgr.empty()) return BM_ERR_DATA;
+    if (!isCreated(dst[i])) {
+      // 与设备上的行为一致，未创建时输出YUV420P，奇数宽高时退化为BGR packed
+      bool even = !(bgr.cols & 1) && !(bgr.rows & 1);
+      bm_image_create(handle, bgr.rows, bgr.cols,
+                      even ? FORMAT_YUV420P : FORMAT_BGR_PACKED,
+                      DATA_TYPE_EXT_1N_BYTE, &dst[i]);
+    }
+    if (!bm_image_is_attached(dst[i]) &&
+        bm_image_alloc_dev_mem(dst[i], BMCV_HEAP_ANY) != BM_SUCCESS)
+      return BM_ERR_NOMEM;
+    if (!fromBgr(bgr, dst[i])) return BM_NOT_SUPPORTED;
+  }
+  return BM_SUCCESS;
+}
+
+bm_status_t bmcv_base64_enc(bm_handle_t handle, bm_device_mem_t src,
+                            bm_device_mem_t dst, unsigned long len[2]) {
+  static const char table[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  const unsigned char* in = memPtr(src);
+  unsigned char* out = memPtr(dst);
+  unsigned long n = len[0], o = 0;
+  for (unsigned long i = 0; i < n; i += 3) {
+    unsigned int v = in[i] << 16;
+    if (i + 1 < n) v |= in[i + 1] << 8;
+    if (i + 2 < n) v |= in[i + 2];
+    out[o++] = table[(v >> 18) & 0x3f];
+    out[o++] = table[(v >> 12) & 0x3f];
+    out[o++] = i + 1 < n ? table[(v >> 6) & 0x3f] : '=';
+    out[o++] = i + 2 < n ? table[v & 0x3f] : '=';
+  }
+  len[1] = o;
+  return BM_SUCCESS;
+}
+
+}  // extern "C"
@@ -0,0 +1,224 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdlib>
+#include <cstring>
+
+#include "bmlib_runtime.h"
+
+struct bm_context {
+  int devid;
+};
+
+namespace {
+
+constexpr size_t HOST_MEM_ALIGN = 64;
+
+inline unsigned char* memPtr(const bm_device_mem_t& mem) {
+  return reinterpret_cast<unsigned char*>(mem.u.device.device_addr);
+}
+
+}  // namespace
+
+extern "C" {
+
+bm_status_t bm_dev_request(bm_handle_t* handle, int devid) {
+  *handle = new bm_context{devid};
+  return BM_SUCCESS;
+}
+
+void bm_dev_free(bm_handle_t handle) { delete handle; }
+
+int bm_get_devid(bm_handle_t handle) {
+  return handle == nullptr ? 0 : handle->devid;
+}
+
+bm_status_t bm_get_chipid(bm_handle_t handle, unsigned int* p_chipid) {
+  // 按BM1684X处理，走1684/1684X的分支
+  *p_chipid = 0x1686;
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_get_misc_info(bm_handle_t handle,
+                             struct bm_misc_info* pmisc_info) {
+  memset(pmisc_info, 0, sizeof(struct bm_misc_info));
+  // 主机内存可以直接访问，与soc模式的行为一致
+  pmisc_info->pcie_soc_mode = 1;
+  pmisc_info->chipid = 0x1686;
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_thread_sync(bm_handle_t handle) { return BM_SUCCESS; }
+
+bm_device_mem_t bm_mem_null(void) {
+  bm_device_mem_t mem;
+  memset(&mem, 0, sizeof(mem));
+  mem.flags.mem_type = BM_MEM_TYPE_INVALID;
+  return mem;
+}
+
+bm_device_mem_t bm_mem_from_device(unsigned long long device_addr,
+                                   unsigned int len) {
+  bm_device_mem_t mem;
+  memset(&mem, 0, sizeof(mem));
+  mem.u.device.device_addr = device_addr;
+  mem.flags.mem_type = BM_MEM_TYPE_DEVICE;
+  mem.size = len;
+  return mem;
+}
+
+bm_system_mem_t bm_mem_from_system(void* system_addr) {
+  bm_system_mem_t mem;
+  memset(&mem, 0, sizeof(mem));
+  mem.u.system.system_addr = system_addr;
+  mem.flags.mem_type = BM_MEM_TYPE_SYSTEM;
+  return mem;
+}
+
+unsigned long long bm_mem_get_device_addr(struct bm_mem_desc mem) {
+  return mem.u.device.device_addr;
+}
+
+void bm_mem_set_device_addr(struct bm_mem_desc* pmem,
+                            unsigned long long addr) {
+  pmem->u.device.device_addr = addr;
+}
+
+unsigned int bm_mem_get_device_size(struct bm_mem_desc mem) {
+  return mem.size;
+}
+
+void bm_mem_set_device_size(struct bm_mem_desc* pmem, unsigned int size) {
+  pmem->size = size;
+}
+
+bm_status_t bm_malloc_device_byte(bm_handle_t handle, bm_device_mem_t* pmem,
+                                  unsigned int size) {
+  size_t alignedSize = (size + HOST_MEM_ALIGN - 1) / HOST_MEM_ALIGN *
+                       HOST_MEM_ALIGN;
+  if (alignedSize == 0) alignedSize = HOST_MEM_ALIGN;
+  void* ptr = std::aligned_alloc(HOST_MEM_ALIGN, alignedSize);
+  if (ptr == nullptr) return BM_ERR_NOMEM;
+  *pmem = bm_mem_from_device(reinterpret_cast<unsigned long long>(ptr), size);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_malloc_device_byte_heap(bm_handle_t handle,
+                                       bm_device_mem_t* pmem, int heap_id,
+                                       unsigned int size) {
+  return bm_malloc_device_byte(handle, pmem, size);
+}
+
+bm_status_t bm_malloc_device_byte_heap_mask(bm_handle_t handle,
+                                            bm_device_mem_t* pmem,
+                                            int heap_id_mask,
+                                            unsigned int size) {
+  return bm_malloc_device_byte(handle, pmem, size);
+}
+
+void bm_free_device(bm_handle_t handle, bm_device_mem_t mem) {
+  std::free(memPtr(mem));
+}
+
+bm_status_t bm_memcpy_s2d(bm_handle_t handle, bm_device_mem_t dst,
+                          void* src) {
+  memcpy(memPtr(dst), src, dst.size);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_memcpy_d2s(bm_handle_t handle, void* dst,
+                          bm_device_mem_t src) {
+  memcpy(dst, memPtr(src), src.size);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_memcpy_s2d_partial(bm_handle_t handle, bm_device_mem_t dst,
+                                  void* src, unsigned int size) {
+  memcpy(memPtr(dst), src, size);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_memcpy_d2s_partial(bm_handle_t handle, void* dst,
+                                  bm_device_mem_t src, unsigned int size) {
+  memcpy(dst, memPtr(src), size);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_memcpy_s2d_partial_offset(bm_handle_t handle,
+                                         bm_device_mem_t dst, void* src,
+                                         unsigned int size,
+                                         unsigned int offset) {
+  memcpy(memPtr(dst) + offset, src, size);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_memcpy_d2s_partial_offset(bm_handle_t handle, void* dst,
+                                         bm_device_mem_t src,
+                                         unsigned int size,
+                                         unsigned int offset) {
+  memcpy(dst, memPtr(src) + offset, size);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_memcpy_d2d_byte(bm_handle_t handle, bm_device_mem_t dst,
+                               size_t dst_offset, bm_device_mem_t src,
+                               size_t src_offset, size_t size) {
+  memmove(memPtr(dst) + dst_offset, memPtr(src) + src_offset, size);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_memset_device(bm_handle_t handle, const int value,
+                             bm_device_mem_t mem) {
+  memset(memPtr(mem), value, mem.size);
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_mem_mmap_device_mem(bm_handle_t handle, bm_device_mem_t* dmem,
+                                   unsigned long long* vmem) {
+  *vmem = dmem->u.device.device_addr;
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_mem_unmap_device_mem(bm_handle_t handle, void* vmem,
+                                    int size) {
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_mem_invalidate_device_mem(bm_handle_t handle,
+                                         bm_device_mem_t* dmem) {
+  return BM_SUCCESS;
+}
+
+bm_status_t bm_mem_flush_device_mem(bm_handle_t handle,
+                                    bm_device_mem_t* dmem) {
+  return BM_SUCCESS;
+}
+
+tpu_kernel_module_t tpu_kernel_load_module_file(bm_handle_t handle,
+                                                const char* module_file) {
+  return nullptr;
+}
+
+tpu_kernel_function_t tpu_kernel_get_function(bm_handle_t handle,
+                                              tpu_kernel_module_t module,
+                                              const char* function) {
+  return -1;
+}
+
+bm_status_t tpu_kernel_launch(bm_handle_t handle, tpu_kernel_function_t func,
+                              void* args, size_t size) {
+  return BM_NOT_SUPPORTED;
+}
+
+bm_status_t tpu_kernel_unload_module(bm_handle_t handle,
+                                     tpu_kernel_module_t p_module) {
+  return BM_SUCCESS;
+}
+
+}  // extern "C"
@@ -0,0 +1,404 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bmruntime_interface.h"
+#include "host_runtime.h"
+
+namespace sophon_stream {
+namespace host {
+
+namespace {
+
+struct HostTensorDesc {
+  std::string name;
+  bm_data_type_t dtype = BM_FLOAT32;
+  float scale = 1.f;
+  bm_shape_t shape;
+  // 录制的原始输出，按调用循环读取
+  std::vector<char> data;
+  size_t cursor = 0;
+  float fill = 0.f;
+  bool random = false;
+};
+
+struct HostNetwork {
+  std::string name;
+  std::vector<HostTensorDesc> inputs;
+  std::vector<HostTensorDesc> outputs;
+  int latencyUs = 0;
+
+  // bm_net_info_t中指针指向的存储
+  std::vector<const char*> inputNames;
+  std::vector<const char*> outputNames;
+  std::vector<bm_data_type_t> inputDtypes;
+  std::vector<bm_data_type_t> outputDtypes;
+  std::vector<float> inputScales;
+  std::vector<float> outputScales;
+  std::vector<bm_shape_t> inputShapes;
+  std::vector<bm_shape_t> outputShapes;
+  std::vector<size_t> maxInputBytes;
+  std::vector<size_t> maxOutputBytes;
+  std::vector<int> inputZeroPoints;
+  std::vector<int> outputZeroPoints;
+  bm_stage_info_t stage;
+  bm_net_info_t info;
+
+  std::mutex mutex;
+  std::mt19937 rng{0};
+};
+
+struct HostRuntime {
+  bm_handle_t handle;
+  std::vector<std::unique_ptr<HostNetwork>> networks;
+  std::vector<const char*> names;
+};
+
+std::mutex gHandlerMutex;
+std::map<std::string, InferenceHandler> gHandlers;
+
+bool parseDtype(const std::string& name, bm_data_type_t& dtype) {
+  static const std::map<std::string, bm_data_type_t> dtypes = {
+      {"float32", BM_FLOAT32}, {"float16", BM_FLOAT16}, {"int8", BM_INT8},
+      {"uint8", BM_UINT8},     {"int16", BM_INT16},     {"uint16", BM_UINT16},
+      {"int32", BM_INT32},     {"uint32", BM_UINT32}};
+  auto it = dtypes.find(name);
+  if (it == dtypes.end()) return false;
+  dtype = it->second;
+  return true;
+}
+
+bool parseTensor(const nlohmann::json& tensor, const std::string& baseDir,
+                 HostTensorDesc& desc) {
+  desc.name = tensor.value("name", "");
+  if (!parseDtype(tensor.value("dtype", "float32"), desc.dtype)) return false;
+  desc.scale = tensor.value("scale", 1.f);
+  auto shape = tensor.find("shape");
+  if (shape == tensor.end() || !shape->is_array() || shape->empty() ||
+      shape->size() > BM_MAX_DIMS_NUM)
+    return false;
+  memset(&desc.shape, 0, sizeof(desc.shape));
+  desc.shape.num_dims = shape->size();
+  for (int i = 0; i < desc.shape.num_dims; ++i)
+    desc.shape.dims[i] = (*shape)[i].get<int>();
+  desc.fill = tensor.value("fill", 0.f);
+  desc.random = tensor.value("random", false);
+  auto data = tensor.find("data");
+  if (data != tensor.end()) {
+    std::string path = data->get<std::string>();
+    if (!path.empty() && path[0] != '/') path = baseDir + path;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    desc.data.assign(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+    if (desc.data.empty()) return false;
+  }
+  return true;
+}
+
+void buildNetInfo(HostNetwork& net) {
+  for (auto& input : net.inputs) {
+    net.inputNames.push_back(input.name.c_str());
+    net.inputDtypes.push_back(input.dtype);
+    net.inputScales.push_back(input.scale);
+    net.inputShapes.push_back(input.shape);
+    net.maxInputBytes.push_back(bmrt_shape_count(&input.shape) *
+                                bmrt_data_type_size(input.dtype));
+    net.inputZeroPoints.push_back(0);
+  }
+  for (auto& output : net.outputs) {
+    net.outputNames.push_back(output.name.c_str());
+    net.outputDtypes.push_back(output.dtype);
+    net.outputScales.push_back(output.scale);
+    net.outputShapes.push_back(output.shape);
+    net.maxOutputBytes.push_back(bmrt_shape_count(&output.shape) *
+                                 bmrt_data_type_size(output.dtype));
+    net.outputZeroPoints.push_back(0);
+  }
+  memset(&net.stage, 0, sizeof(net.stage));
+  net.stage.input_shapes = net.inputShapes.data();
+  net.stage.output_shapes = net.outputShapes.data();
+
+  memset(&net.info, 0, sizeof(net.info));
+  net.info.name = net.name.c_str();
+  net.info.is_dynamic = false;
+  net.info.input_num = net.inputs.size();
+  net.info.input_names = net.inputNames.data();
+  net.info.input_dtypes = net.inputDtypes.data();
+  net.info.input_scales = net.inputScales.data();
+  net.info.output_num = net.outputs.size();
+  net.info.output_names = net.outputNames.data();
+  net.info.output_dtypes = net.outputDtypes.data();
+  net.info.output_scales = net.outputScales.data();
+  net.info.stage_num = 1;
+  net.info.stages = &net.stage;
+  net.info.max_input_bytes = net.maxInputBytes.data();
+  net.info.max_output_bytes = net.maxOutputBytes.data();
+  net.info.input_zero_point = net.inputZeroPoints.data();
+  net.info.output_zero_point = net.outputZeroPoints.data();
+  net.info.core_num = 1;
+}
+
+template <typename T>
+void fillTyped(void* dst, size_t count, float value) {
+  T* p = static_cast<T*>(dst);
+  for (size_t i = 0; i < count; ++i) p[i] = static_cast<T>(value);
+}
+
+void fillValue(void* dst, bm_data_type_t dtype, size_t count, float value) {
+  switch (dtype) {
+    case BM_FLOAT32:
+      fillTyped<float>(dst, count, value);
+      break;
+    case BM_INT8:
+      fillTyped<int8_t>(dst, count, value);
+      break;
+    case BM_UINT8:
+      fillTyped<uint8_t>(dst, count, value);
+      break;
+    case BM_INT16:
+      fillTyped<int16_t>(dst, count, value);
+      break;
+    case BM_UINT16:
+      fillTyped<uint16_t>(dst, count, value);
+      break;
+    case BM_INT32:
+      fillTyped<int32_t>(dst, count, value);
+      break;
+    case BM_UINT32:
+      fillTyped<uint32_t>(dst, count, value);
+      break;
+    default:
+      // FP16只支持填0
+      memset(dst, 0, count * bmrt_data_type_size(dtype));
+      break;
+  }
+}
+
+void synthesizeOutput(HostNetwork& net, HostTensorDesc& desc,
+                      bm_tensor_t& tensor) {
+  unsigned char* dst =
+      reinterpret_cast<unsigned char*>(tensor.device_mem.u.device.device_addr);
+  size_t bytes = bmrt_tensor_bytesize(&tensor);
+  if (!desc.data.empty()) {
+    size_t written = 0;
+    while (written < bytes) {
+      size_t n = std::min(bytes - written, desc.data.size() - desc.cursor);
+      memcpy(dst + written, desc.data.data() + desc.cursor, n);
+      written += n;
+      desc.cursor = (desc.cursor + n) % desc.data.size();
+    }
+  } else if (desc.random && tensor.dtype == BM_FLOAT32) {
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    float* p = reinterpret_cast<float*>(dst);
+    for (size_t i = 0; i < bytes / sizeof(float); ++i) p[i] = dist(net.rng);
+  } else {
+    fillValue(dst, tensor.dtype, bmrt_shape_count(&tensor.shape), desc.fill);
+  }
+}
+
+HostNetwork* findNetwork(void* p_bmrt, const char* net_name) {
+  HostRuntime* runtime = static_cast<HostRuntime*>(p_bmrt);
+  for (auto& net : runtime->networks) {
+    if (net->name == net_name) return net.get();
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+void registerInferenceHandler(const std::string& netName,
+                              InferenceHandler handler) {
+  std::lock_guard<std::mutex> lock(gHandlerMutex);
+  if (handler)
+    gHandlers[netName] = std::move(handler);
+  else
+    gHandlers.erase(netName);
+}
+
+std::string modelDescriptionPath(const std::string& bmodelPath) {
+  const std::string suffix = ".json";
+  if (bmodelPath.size() >= suffix.size() &&
+      bmodelPath.compare(bmodelPath.size() - suffix.size(), suffix.size(),
+                         suffix) == 0)
+    return bmodelPath;
+  return bmodelPath + suffix;
+}
+
+}  // namespace host
+}  // namespace sophon_stream
+
+using sophon_stream::host::HostNetwork;
+using sophon_stream::host::HostRuntime;
+
+extern "C" {
+
+void* bmrt_create(bm_handle_t bm_handle) {
+  HostRuntime* runtime = new HostRuntime();
+  runtime->handle = bm_handle;
+  return runtime;
+}
+
+void bmrt_destroy(void* p_bmrt) { delete static_cast<HostRuntime*>(p_bmrt); }
+
+void* bmrt_get_bm_handle(void* p_bmrt) {
+  return static_cast<HostRuntime*>(p_bmrt)->handle;
+}
+
+bool bmrt_load_bmodel(void* p_bmrt, const char* bmodel_path) {
+  HostRuntime* runtime = static_cast<HostRuntime*>(p_bmrt);
+  std::string path = sophon_stream::host::modelDescriptionPath(bmodel_path);
+  std::ifstream file(path);
+  if (!file.is_open()) return false;
+  nlohmann::json desc = nlohmann::json::parse(file, nullptr, false);
+  if (desc.is_discarded() || !desc.contains("networks")) return false;
+  std::string baseDir;
+  auto slash = path.find_last_of('/');
+  if (slash != std::string::npos) baseDir = path.substr(0, slash + 1);
+
+  for (auto& network : desc["networks"]) {
+    std::unique_ptr<HostNetwork> net(new HostNetwork());
+    net->name = network.value("name", "");
+    net->latencyUs = network.value("latency_us", 0);
+    for (auto& input : network.value("inputs", nlohmann::json::array())) {
+      net->inputs.emplace_back();
+      if (!sophon_stream::host::parseTensor(input, baseDir,
+                                            net->inputs.back()))
+        return false;
+    }
+    for (auto& output : network.value("outputs", nlohmann::json::array())) {
+      net->outputs.emplace_back();
+      if (!sophon_stream::host::parseTensor(output, baseDir,
+                                            net->outputs.back()))
+        return false;
+    }
+    if (net->name.empty() || net->inputs.empty() || net->outputs.empty())
+      return false;
+    sophon_stream::host::buildNetInfo(*net);
+    runtime->networks.push_back(std::move(net));
+  }
+  runtime->names.clear();
+  for (auto& net : runtime->networks)
+    runtime->names.push_back(net->name.c_str());
+  return true;
+}
+
+int bmrt_get_network_number(void* p_bmrt) {
+  return static_cast<HostRuntime*>(p_bmrt)->networks.size();
+}
+
+void bmrt_get_network_names(void* p_bmrt, const char*** network_names) {
+  // 与libsophon一致，数组由调用方free
+  HostRuntime* runtime = static_cast<HostRuntime*>(p_bmrt);
+  *network_names = static_cast<const char**>(
+      malloc(sizeof(const char*) * runtime->names.size()));
+  for (size_t i = 0; i < runtime->names.size(); ++i)
+    (*network_names)[i] = runtime->names[i];
+}
+
+const bm_net_info_t* bmrt_get_network_info(void* p_bmrt,
+                                           const char* net_name) {
+  HostNetwork* net = sophon_stream::host::findNetwork(p_bmrt, net_name);
+  return net == nullptr ? nullptr : &net->info;
+}
+
+bool bmrt_launch_tensor_ex(void* p_bmrt, const char* net_name,
+                           const bm_tensor_t input_tensors[], int input_num,
+                           bm_tensor_t output_tensors[], int output_num,
+                           bool user_mem, bool user_stmode) {
+  HostRuntime* runtime = static_cast<HostRuntime*>(p_bmrt);
+  HostNetwork* net = sophon_stream::host::findNetwork(p_bmrt, net_name);
+  if (net == nullptr || input_num != net->info.input_num ||
+      output_num != net->info.output_num)
+    return false;
+
+  for (int i = 0; i < output_num; ++i) {
+    output_tensors[i].dtype = net->outputs[i].dtype;
+    output_tensors[i].st_mode = BM_STORE_1N;
+    if (!user_mem) {
+      output_tensors[i].shape = net->outputs[i].shape;
+      if (bm_malloc_device_byte(runtime->handle, &output_tensors[i].device_mem,
+                                net->maxOutputBytes[i]) != BM_SUCCESS)
+        return false;
+    } else if (output_tensors[i].shape.num_dims == 0) {
+      output_tensors[i].shape = net->outputs[i].shape;
+    }
+    // 输出的batch与输入一致
+    if (input_num > 0 && input_tensors[0].shape.num_dims > 0)
+      output_tensors[i].shape.dims[0] = input_tensors[0].shape.dims[0];
+  }
+
+  sophon_stream::host::InferenceHandler handler;
+  {
+    std::lock_guard<std::mutex> lock(sophon_stream::host::gHandlerMutex);
+    auto it = sophon_stream::host::gHandlers.find(net->name);
+    if (it != sophon_stream::host::gHandlers.end()) handler = it->second;
+  }
+  if (handler)
+    return handler(net->info, input_tensors, input_num, output_tensors,
+                   output_num);
+
+  std::lock_guard<std::mutex> lock(net->mutex);
+  for (int i = 0; i < output_num; ++i)
+    sophon_stream::host::synthesizeOutput(*net, net->outputs[i],
+                                          output_tensors[i]);
+  if (net->latencyUs > 0)
+    std::this_thread::sleep_for(std::chrono::microseconds(net->latencyUs));
+  return true;
+}
+
+bool bmrt_launch_tensor_multi_cores(void* p_bmrt, const char* net_name,
+                                    const bm_tensor_t input_tensors[],
+                                    int input_num, bm_tensor_t output_tensors[],
+                                    int output_num, bool user_mem,
+                                    bool user_stmode, const int* core_list,
+                                    int core_num) {
+  return bmrt_launch_tensor_ex(p_bmrt, net_name, input_tensors, input_num,
+                               output_tensors, output_num, user_mem,
+                               user_stmode);
+}
+
+uint64_t bmrt_shape_count(const bm_shape_t* shape) {
+  uint64_t count = 1;
+  for (int i = 0; i < shape->num_dims; ++i) count *= shape->dims[i];
+  return count;
+}
+
+size_t bmrt_data_type_size(bm_data_type_t dtype) {
+  switch (dtype) {
+    case BM_FLOAT32:
+    case BM_INT32:
+    case BM_UINT32:
+      return 4;
+    case BM_FLOAT16:
+    case BM_INT16:
+    case BM_UINT16:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+size_t bmrt_tensor_bytesize(const bm_tensor_t* tensor) {
+  return bmrt_shape_count(&tensor->shape) * bmrt_data_type_size(tensor->dtype);
+}
+
+}  // extern "C"
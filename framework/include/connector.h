@@ -30,6 +30,11 @@ class Connector : public ::sophon_stream::common::NoCopyable {
 
   std::shared_ptr<DataPipe> getDataPipe(int id) const;
 
+  /**
+   * @brief 为每个dataPipe注册指标，在labels后追加dataPipe的下标
+   */
+  void enableMetrics(const common::MetricLabels& labels);
+
 
  private:
   std::vector<std::shared_ptr<DataPipe>> mDataPipes;
@@ -20,6 +20,7 @@
 
 #include "common/error_code.h"
 #include "common/logger.h"
+#include "common/metrics.h"
 #include "common/no_copyable.h"
 
 namespace sophon_stream {
@@ -51,12 +52,23 @@ class DataPipe : public ::sophon_stream::common::NoCopyable {
    */
   int getSize();
 
+  /**
+   * @brief 注册队列深度、容量、push次数与队列满次数的指标
+   * @param[in] labels : 标识所属element、输入端口和dataPipe
+   */
+  void enableMetrics(const common::MetricLabels& labels);
+
  private:
   std::deque<std::shared_ptr<void> > mDataQueue;
   mutable std::mutex mDataQueueMutex;
   std::size_t mCapacity;
 
   const std::chrono::milliseconds timeout{200};
+
+  // 指标对象由MetricsRegistry持有，未注册时为nullptr
+  common::Gauge* mDepthGauge = nullptr;
+  common::Counter* mPushCounter = nullptr;
+  common::Counter* mFullCounter = nullptr;
 };
 
 }  // namespace framework
@@ -29,12 +29,18 @@
 #include "common/error_code.h"
 #include "common/http_defs.h"
 // #include "common/logger.h"
+#include "common/metrics.h"
 #include "common/no_copyable.h"
 #include "connector.h"
 #include "datapipe.h"
 #include "listen_thread.h"
 
 namespace sophon_stream {
+namespace common {
+struct ObjectMetadata;
+class MetadataRecorder;
+}  // namespace common
+
 namespace framework {
 
 class Element : public ::sophon_stream::common::NoCopyable {
@@ -107,6 +113,12 @@ class Element : public ::sophon_stream::common::NoCopyable {
 
   void setSinkHandler(int outputPort, SinkHandler sinkHandler);
 
+  /**
+   * @brief 录制经过outputPort的ObjectMetadata，由graph按连接配置中的tap设置
+   */
+  void setOutputTap(int outputPort,
+                    std::shared_ptr<common::MetadataRecorder> recorder);
+
   /**
    * @brief 在执行connect()之后进行，只有Group
    * Element才需要override该函数，用于将group的输入输出与内部preElement和postElement连接起来
@@ -125,8 +137,24 @@ class Element : public ::sophon_stream::common::NoCopyable {
   virtual void groupInsert(
       std::map<int, std::shared_ptr<framework::Element>>& mapPtr) {}
 
+  /**
+   * @brief element是否读取帧的图像(mSpData、mSpDataOsd、mMat等)。
+   * 只使用检测框等结果的element重写为返回false，
+   * graph据此找出最后一个读取图像的element，在它输出时释放图像
+   */
+  virtual bool needsPixelData() const { return true; }
+
+  /**
+   * @brief 由graph设置，为true时输出数据前释放帧的图像
+   */
+  virtual void setReleasePixelData(bool release) {
+    mReleasePixelData = release;
+  }
+
   int getId() const { return mId; }
 
+  const std::string& getName() const { return mName; }
+
   int getGraphId() const { return mGraphId; }
   virtual void setGraphId(int id) { mGraphId = id; }
 
@@ -156,6 +184,7 @@ class Element : public ::sophon_stream::common::NoCopyable {
   virtual void registListenFunc(ListenThread* listener) {}
 
   static constexpr const char* JSON_ID_FIELD = "id";
+  static constexpr const char* JSON_NAME_FIELD = "name";
   static constexpr const char* JSON_SIDE_FIELD = "side";
   static constexpr const char* JSON_DEVICE_ID_FIELD = "device_id";
   static constexpr const char* JSON_THREAD_NUMBER_FIELD = "thread_number";
@@ -212,6 +241,19 @@ class Element : public ::sophon_stream::common::NoCopyable {
   std::vector<int> getInputPorts();
   std::vector<int> getOutputPorts();
 
+  /**
+   * @brief 为true时element读写ObjectMetadata::mDetectionTable，
+   * 否则读写mDetectedObjectMetadatas。在构造函数中设置，
+   * popInputData按此转换上游送来的检测结果
+   */
+  bool mUseDetectionTable = false;
+
+  /**
+   * @brief 注册当前element某个处理阶段(如pre/infer/post)的耗时直方图
+   * @brief 在initInternal中调用，配合common::ScopedLatency在处理时计时
+   */
+  common::Histogram* registerStageLatency(const std::string& stage);
+
   /**
    * @brief 获取指定outputPort对应的Connector中datapipe的数量
    */
@@ -222,8 +264,23 @@ class Element : public ::sophon_stream::common::NoCopyable {
   int getInputConnectorCapacity(int inputPort);
 
  private:
+  /**
+   * @brief 新建inputPort对应的Connector，并注册其中dataPipe的指标
+   */
+  std::shared_ptr<framework::Connector> createInputConnector(int inputPort);
+
+  /**
+   * @brief 帧追踪开启时，在出队/入队处记录queue与process时间段
+   */
+  void traceDequeue(std::shared_ptr<common::ObjectMetadata> data);
+  void traceEnqueue(std::shared_ptr<common::ObjectMetadata> data);
+
+  static constexpr std::int64_t MAX_TRACE_SOURCE_SPAN_US = 10000000;
+
   int mId;
 
+  std::string mName;
+
   int mGraphId;
 
   std::string mSide;
@@ -252,10 +309,16 @@ class Element : public ::sophon_stream::common::NoCopyable {
    */
   std::map<int, SinkHandler> mSinkHandlerMap;
 
+  /**
+   * @brief outputPort到录制器的映射
+   */
+  std::map<int, std::shared_ptr<common::MetadataRecorder>> mOutputTapMap;
+
   std::vector<int> mInputPorts;
   std::vector<int> mOutputPorts;
 
   bool mSinkElementFlag = false;
+  bool mReleasePixelData = false;
 
   friend class ListenThread;
   ListenThread* listenThreadPtr;
@@ -20,6 +20,7 @@
 #include "common/no_copyable.h"
 #include "common/singleton.h"
 #include "graph.h"
+#include "sink_dispatcher.h"
 
 namespace sophon_stream {
 namespace framework {
@@ -27,6 +28,7 @@ namespace framework {
 class Engine : public ::sophon_stream::common::NoCopyable {
  public:
   using SinkHandler = framework::Graph::SinkHandler;
+  using BatchSinkHandler = framework::SinkDispatcher::BatchSinkHandler;
 
   common::ErrorCode start(int graphId);
 
@@ -59,6 +61,13 @@ class Engine : public ::sophon_stream::common::NoCopyable {
   void setSinkHandler(int graphId, int elementId, int outputPort,
                       SinkHandler sinkHandler);
 
+  /**
+   * @brief 同setSinkHandler，graph配置了sink_dispatch时队列中连续的多个结果
+   * 合并为一次回调，最多max_batch个；没有配置时每个结果回调一次
+   */
+  void setBatchSinkHandler(int graphId, int elementId, int outputPort,
+                           BatchSinkHandler sinkHandler);
+
   std::pair<std::string, int> getSideAndDeviceId(int graphId, int elementId);
 
   std::vector<int> getGraphIds();
@@ -68,6 +77,11 @@ class Engine : public ::sophon_stream::common::NoCopyable {
   inline void setListener(ListenThread* p) { listenThreadPtr = p; }
 
   static constexpr const char* JSON_GRAPH_ID_FIELD = "graph_id";
+  static constexpr const char* JSON_SINK_DISPATCH_FIELD = "sink_dispatch";
+  static constexpr const char* JSON_SINK_WORKER_NUMBER_FIELD = "worker_number";
+  static constexpr const char* JSON_SINK_QUEUE_SIZE_FIELD = "queue_size";
+  static constexpr const char* JSON_SINK_POLICY_FIELD = "policy";
+  static constexpr const char* JSON_SINK_MAX_BATCH_FIELD = "max_batch";
 
  private:
   friend class common::Singleton<Engine>;
@@ -76,11 +90,18 @@ class Engine : public ::sophon_stream::common::NoCopyable {
 
   ~Engine();
 
+  /**
+   * @brief 按graph配置中的sink_dispatch为graph创建sink分发队列
+   */
+  common::ErrorCode initSinkDispatch(int graphId, const std::string& json);
+
   std::map<int /* graphId */, std::shared_ptr<framework::Graph> > mGraphMap;
   std::mutex mGraphMapLock;
 
   std::vector<int> mGraphIds;
 
+  SinkDispatcher mSinkDispatcher;
+
   ListenThread* listenThreadPtr;
 };
 
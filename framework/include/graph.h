@@ -14,6 +14,7 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 
 #include "common/error_code.h"
@@ -79,11 +80,26 @@ class Graph : public ::sophon_stream::common::NoCopyable {
   static constexpr const char* JSON_CONNECTION_SRC_PORT_FIELD = "src_port";
   static constexpr const char* JSON_CONNECTION_DST_ID_FIELD = "dst_id";
   static constexpr const char* JSON_CONNECTION_DST_PORT_FIELD = "dst_port";
+  static constexpr const char* JSON_CONNECTION_TAP_FIELD = "tap";
+  static constexpr const char* JSON_TAP_PATH_FIELD = "path";
+  static constexpr const char* JSON_TAP_WITH_FRAME_FIELD = "with_frame";
+  static constexpr const char* JSON_LOG_LEVELS_FIELD = "log_levels";
+  static constexpr const char* JSON_SINK_PIXEL_DATA_FIELD = "sink_pixel_data";
 
  private:
   common::ErrorCode initElements(const std::string& json);
   common::ErrorCode initConnections(const std::string& json);
   common::ErrorCode connect(int srcId, int srcPort, int dstId, int dstPort);
+  /**
+   * @brief 按连接配置中的tap，录制srcElement从srcPort送出的数据
+   */
+  common::ErrorCode addTap(int srcId, int srcPort, const nlohmann::json& tap);
+  /**
+   * @brief 根据各element的needsPixelData()计算每个element之后是否还有element
+   * 读取图像，没有时让该element在输出时释放图像
+   * @param[in] sinkPixelData : sink element的SinkHandler是否读取图像
+   */
+  void initPixelDataRelease(bool sinkPixelData);
 
   int mId;
 
@@ -94,6 +110,11 @@ class Graph : public ::sophon_stream::common::NoCopyable {
   std::map<int /* elementId */, std::shared_ptr<framework::Element> >
       mElementMap;
 
+  // 配置中的element及其下游element，group内部的element不在其中
+  std::map<int /* elementId */, std::set<int> > mDownstreamMap;
+  // 连接上配置了录制图像的源element
+  std::set<int> mFrameTapElements;
+
   // friend class ListenThread;
   ListenThread* listenThreadPtr;
 };
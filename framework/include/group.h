@@ -65,6 +65,15 @@ class Group : public ::sophon_stream::framework::Element {
 
   bool getGroup() override { return true; }
 
+  bool needsPixelData() const override {
+    return preElement->needsPixelData();
+  }
+
+  // 数据由postElement送出
+  void setReleasePixelData(bool release) override {
+    postElement->setReleasePixelData(release);
+  }
+
   void groupInsert(
       std::map<int, std::shared_ptr<framework::Element>>& mapPtr) override {
     auto preElement = this->getPreElement();
@@ -16,6 +16,7 @@
 
 #include "common/error_code.h"
 #include "common/http_defs.h"
+#include "common/metrics.h"
 #include "common/profiler.h"
 #include "httplib.h"
 #include "nlohmann/json.hpp"
@@ -66,6 +67,11 @@ class ListenThread {
   static constexpr const char* JSON_IP_FILED = "ip";
   static constexpr const char* JSON_PORT_FILED = "port";
   static constexpr const char* JSON_PATH_FILED = "path";
+  static constexpr const char* METRICS_PATH = "/metrics";
+  static constexpr const char* TRACE_PATH = "/trace";
+  static constexpr const char* TRACE_START_PATH = "/trace/start";
+  static constexpr const char* TRACE_STOP_PATH = "/trace/stop";
+  static constexpr const char* TRACE_SECONDS_PARAM = "seconds";
 
  private:
   httplib::Server server;
@@ -81,6 +87,23 @@ class ListenThread {
 
   static void handle_task_interact(const httplib::Request& request,
                                    httplib::Response& reponse);
+  /**
+   * @brief 以Prometheus文本格式返回MetricsRegistry中的所有指标
+   */
+  static void handle_metrics(const httplib::Request& request,
+                             httplib::Response& response);
+  /**
+   * @brief 开始帧追踪，可选参数seconds指定追踪时长
+   */
+  static void handle_trace_start(const httplib::Request& request,
+                                 httplib::Response& response);
+  static void handle_trace_stop(const httplib::Request& request,
+                                httplib::Response& response);
+  /**
+   * @brief 以Chrome trace JSON格式返回帧追踪记录
+   */
+  static void handle_trace(const httplib::Request& request,
+                           httplib::Response& response);
   static void listen_loop();
 };
 
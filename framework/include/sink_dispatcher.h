@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_FRAMEWORK_SINK_DISPATCHER_H_
+#define SOPHON_STREAM_FRAMEWORK_SINK_DISPATCHER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/metrics.h"
+#include "common/no_copyable.h"
+#include "element.h"
+
+namespace sophon_stream {
+namespace framework {
+
+/**
+ * @brief 一个graph的sink分发配置
+ */
+struct SinkDispatchOptions {
+  enum class Policy {
+    /**
+     * @brief 队列满时sink element等待
+     */
+    BLOCK,
+    /**
+     * @brief 队列满时丢弃最早的结果，结束帧不丢弃
+     */
+    DROP,
+  };
+
+  int mWorkerNumber = 1;
+  std::size_t mQueueSize = 64;
+  Policy mPolicy = Policy::BLOCK;
+  /**
+   * @brief 批量回调一次最多收到的结果数
+   */
+  std::size_t mMaxBatch = 16;
+};
+
+/**
+ * @brief 在独立线程中调用应用的SinkHandler，sink element只把结果放进graph的队列。
+ * 每个graph一个有界队列，同一个graph的结果按顺序、同一时刻只在一个线程中回调，
+ * 多个分发线程并行处理不同的graph
+ */
+class SinkDispatcher : public ::sophon_stream::common::NoCopyable {
+ public:
+  using SinkHandler = Element::SinkHandler;
+  using BatchSinkHandler =
+      std::function<void(const std::vector<std::shared_ptr<void>>&)>;
+
+  ~SinkDispatcher();
+
+  /**
+   * @brief 为graph创建队列，分发线程不足options.mWorkerNumber时补足
+   */
+  void addGraph(int graphId, const SinkDispatchOptions& options);
+
+  bool hasGraph(int graphId);
+
+  /**
+   * @brief 等待graph队列中的结果都回调完
+   */
+  void flush(int graphId);
+
+  /**
+   * @brief 回调完graph队列中剩余的结果后删除队列
+   */
+  void removeGraph(int graphId);
+
+  /**
+   * @brief 返回设置给sink element的SinkHandler，调用时把结果放入graph的队列
+   */
+  SinkHandler wrap(int graphId, SinkHandler handler);
+
+  /**
+   * @brief 同wrap，队列中连续的多个结果合并为一次回调
+   */
+  SinkHandler wrapBatch(int graphId, BatchSinkHandler handler);
+
+  /**
+   * @brief 回调完所有队列中的结果后结束分发线程，之后的结果在sink element中直接回调
+   */
+  void stop();
+
+  static constexpr const char* SINK_DROPPED_METRIC =
+      "sophon_stream_sink_dropped_total";
+  static constexpr const char* SINK_QUEUE_DEPTH_METRIC =
+      "sophon_stream_sink_queue_depth";
+
+ private:
+  struct Target {
+    SinkHandler mHandler;
+    BatchSinkHandler mBatchHandler;
+  };
+
+  struct Item {
+    std::shared_ptr<Target> mTarget;
+    std::shared_ptr<void> mData;
+  };
+
+  struct GraphQueue {
+    SinkDispatchOptions mOptions;
+    std::deque<Item> mItems;
+    // 有线程正在回调该graph的结果
+    bool mBusy = false;
+    std::condition_variable mNotFull;
+    common::Counter* mDropped = nullptr;
+    common::Gauge* mDepth = nullptr;
+  };
+
+  SinkHandler makeHandler(int graphId, std::shared_ptr<Target> target);
+  void push(const std::shared_ptr<GraphQueue>& queue, Item item);
+  void call(const std::vector<Item>& batch);
+  void run();
+
+  std::mutex mMutex;
+  std::condition_variable mWorkCond;
+  std::map<int /* graphId */, std::shared_ptr<GraphQueue>> mQueues;
+  std::vector<std::thread> mWorkers;
+  bool mStop = false;
+  // 轮询各graph的起点
+  int mNextGraphId = 0;
+};
+
+}  // namespace framework
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_FRAMEWORK_SINK_DISPATCHER_H_
@@ -41,5 +41,13 @@ std::shared_ptr<DataPipe> Connector::getDataPipe(int id) const {
   return mDataPipes[id];
 }
 
+void Connector::enableMetrics(const common::MetricLabels& labels) {
+  for (int i = 0; i < mCapacity; ++i) {
+    common::MetricLabels pipeLabels = labels;
+    pipeLabels.emplace_back("pipe", std::to_string(i));
+    mDataPipes[i]->enableMetrics(pipeLabels);
+  }
+}
+
 }  // namespace framework
 }  // namespace sophon_stream
\ No newline at end of file
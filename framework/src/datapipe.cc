@@ -22,8 +22,11 @@ common::ErrorCode DataPipe::pushData(std::shared_ptr<void> data) {
   std::unique_lock<std::mutex> lock(mDataQueueMutex);
   if(mDataQueue.size() < mCapacity) {
     mDataQueue.push_back(data);
+    if (mDepthGauge != nullptr) mDepthGauge->set(mDataQueue.size());
+    if (mPushCounter != nullptr) mPushCounter->inc();
     return common::ErrorCode::SUCCESS;
   }
+  if (mFullCounter != nullptr) mFullCounter->inc();
   return common::ErrorCode::DATA_PIPE_FULL;
 }
 
@@ -35,6 +38,7 @@ std::shared_ptr<void> DataPipe::popData()
   {
    data = mDataQueue.front();
    mDataQueue.pop_front(); 
+   if (mDepthGauge != nullptr) mDepthGauge->set(mDataQueue.size());
   }
   return data;
 }
@@ -45,5 +49,23 @@ int DataPipe::getSize() {
   return sz;
 }
 
+void DataPipe::enableMetrics(const common::MetricLabels& labels) {
+  auto& registry = common::SingletonMetricsRegistry::getInstance();
+  common::Gauge* capacityGauge = registry.gauge(
+      "sophon_stream_datapipe_capacity", "Capacity of the data pipe", labels);
+  if (capacityGauge != nullptr) capacityGauge->set(mCapacity);
+
+  std::lock_guard<std::mutex> lock(mDataQueueMutex);
+  mDepthGauge = registry.gauge("sophon_stream_datapipe_depth",
+                               "Number of items queued in the data pipe",
+                               labels);
+  mPushCounter = registry.counter("sophon_stream_datapipe_push_total",
+                                  "Items pushed into the data pipe", labels);
+  mFullCounter = registry.counter(
+      "sophon_stream_datapipe_full_total",
+      "Push attempts rejected because the data pipe was full", labels);
+  if (mDepthGauge != nullptr) mDepthGauge->set(mDataQueue.size());
+}
+
 }  // namespace framework
 }  // namespace sophon_stream
@@ -1,14 +1,32 @@
 #include "element.h"
 
+#include <algorithm>
+
+#include "common/frame_tracer.h"
+#include "common/metadata_recorder.h"
+#include "common/object_metadata.h"
+
 namespace sophon_stream {
 namespace framework {
 
+namespace {
+
+void releasePixelData(common::ObjectMetadata& objectMetadata) {
+  if (objectMetadata.mFrame) objectMetadata.mFrame->releasePixelData();
+  if (objectMetadata.mTransformFrame)
+    objectMetadata.mTransformFrame->releasePixelData();
+  for (auto& subObjectMetadata : objectMetadata.mSubObjectMetadatas) {
+    if (subObjectMetadata) releasePixelData(*subObjectMetadata);
+  }
+}
+
+}  // namespace
+
 void Element::connect(Element& srcElement, int srcElementPort,
                       Element& dstElement, int dstElementPort) {
   auto& inputConnector = dstElement.mInputConnectorMap[dstElementPort];
   if (!inputConnector) {
-    inputConnector =
-        std::make_shared<framework::Connector>(dstElement.getThreadNumber());
+    inputConnector = dstElement.createInputConnector(dstElementPort);
     IVS_DEBUG(
         "InputConnector initialized, mId = {0}, inputPort = {1}, dataPipeNum = "
         "{2}",
@@ -52,6 +70,12 @@ common::ErrorCode Element::init(const std::string& json) {
 
     mId = idIt->get<int>();
 
+    auto nameIt = configure.find(JSON_NAME_FIELD);
+    if (configure.end() != nameIt && nameIt->is_string()) {
+      mName = nameIt->get<std::string>();
+    }
+    common::SingletonFrameTracer::getInstance().setElementName(mId, mName);
+
     auto sideIt = configure.find(JSON_SIDE_FIELD);
     if (configure.end() != sideIt && sideIt->is_string()) {
       mSide = sideIt->get<std::string>();
@@ -184,7 +208,7 @@ common::ErrorCode Element::pushInputData(int inputPort, int dataPipeId,
 
   auto& inputConnector = mInputConnectorMap[inputPort];
   if (!inputConnector) {
-    inputConnector = std::make_shared<framework::Connector>(mThreadNumber);
+    inputConnector = createInputConnector(inputPort);
     IVS_DEBUG(
         "InputConnector initialized, mId = {0}, inputPort = {1}, dataPipeNum = "
         "{2}",
@@ -201,9 +225,52 @@ common::ErrorCode Element::pushInputData(int inputPort, int dataPipeId,
 
 std::shared_ptr<void> Element::popInputData(int inputPort, int dataPipeId) {
   if (mInputConnectorMap[inputPort] == nullptr)
-    mInputConnectorMap[inputPort] =
-        std::make_shared<framework::Connector>(mThreadNumber);
-  return mInputConnectorMap[inputPort]->popData(dataPipeId);
+    mInputConnectorMap[inputPort] = createInputConnector(inputPort);
+  auto data = mInputConnectorMap[inputPort]->popData(dataPipeId);
+  // 只有上游element送来的数据是ObjectMetadata，decode收到的是ChannelTask
+  if (data && std::find(mInputPorts.begin(), mInputPorts.end(), inputPort) !=
+                  mInputPorts.end()) {
+    auto objectMetadata = static_cast<common::ObjectMetadata*>(data.get());
+    if (common::SingletonFrameTracer::getInstance().isEnabled())
+      traceDequeue(std::static_pointer_cast<common::ObjectMetadata>(data));
+    // 检测结果转为本element使用的表示
+    if (objectMetadata->mDetectionsInTable != mUseDetectionTable) {
+      if (mUseDetectionTable)
+        common::absorbDetections(*objectMetadata);
+      else
+        common::materializeDetections(*objectMetadata);
+    }
+  }
+  return data;
+}
+
+void Element::traceDequeue(std::shared_ptr<common::ObjectMetadata> data) {
+  std::int64_t now = common::FrameTracer::nowUs();
+  if (data->mTraceTs > 0)
+    common::SingletonFrameTracer::getInstance().record(
+        "queue", data->mTraceTs, now, mId, data->getChannelId(),
+        data->getFrameId(), data->mSubId);
+  data->mTraceTs = now;
+  data->mTraceElementId = mId;
+}
+
+void Element::traceEnqueue(std::shared_ptr<common::ObjectMetadata> data) {
+  std::int64_t now = common::FrameTracer::nowUs();
+  auto& tracer = common::SingletonFrameTracer::getInstance();
+  if (data->mTraceElementId == mId) {
+    // converger等待所有子对象的时间也计入这一段
+    tracer.record("process", data->mTraceTs, now, mId, data->getChannelId(),
+                  data->getFrameId(), data->mSubId);
+  } else if (data->mTraceTs == 0) {
+    // 源头element（decode）没有出队记录，用帧的时间戳作为起点
+    std::int64_t timestamp = data->getTimestamp();
+    if (timestamp > 0 && now - timestamp < MAX_TRACE_SOURCE_SPAN_US)
+      tracer.record("decode", timestamp, now, mId, data->getChannelId(),
+                    data->getFrameId(), data->mSubId);
+  }
+  // 下游出队前的等待（含DataPipe满时的阻塞）记为queue
+  data->mTraceTs = now;
+  data->mTraceElementId = -1;
 }
 
 void Element::setSinkHandler(int outputPort, SinkHandler dataHandler) {
@@ -212,10 +279,33 @@ void Element::setSinkHandler(int outputPort, SinkHandler dataHandler) {
   if (mSinkElementFlag) mSinkHandlerMap[outputPort] = dataHandler;
 }
 
+void Element::setOutputTap(int outputPort,
+                           std::shared_ptr<common::MetadataRecorder> recorder) {
+  IVS_INFO("Set output tap, element id: {0:d}, output port: {1:d}, path: {2}",
+           mId, outputPort, recorder->getPath());
+  mOutputTapMap[outputPort] = recorder;
+}
+
 common::ErrorCode Element::pushOutputData(int outputPort, int dataPipeId,
                                           std::shared_ptr<void> data) {
   IVS_DEBUG("send data, element id: {0:d}, output port: {1:d}, data:{2:p}", mId,
             outputPort, data.get());
+  if (data && common::SingletonFrameTracer::getInstance().isEnabled())
+    traceEnqueue(std::static_pointer_cast<common::ObjectMetadata>(data));
+  // 录制与sink回调只认识mDetectedObjectMetadatas
+  if (data && mUseDetectionTable &&
+      (mSinkElementFlag || mOutputTapMap.count(outputPort) > 0))
+    common::materializeDetections(
+        *static_cast<common::ObjectMetadata*>(data.get()));
+  if (!mOutputTapMap.empty()) {
+    auto tapIt = mOutputTapMap.find(outputPort);
+    if (mOutputTapMap.end() != tapIt && data)
+      tapIt->second->write(
+          std::static_pointer_cast<common::ObjectMetadata>(data));
+  }
+  // 下游没有element再读取图像，录制之后释放
+  if (mReleasePixelData && data)
+    releasePixelData(*static_cast<common::ObjectMetadata*>(data.get()));
   if (mSinkElementFlag) {
     auto handlerIt = mSinkHandlerMap.find(outputPort);
     if (mSinkHandlerMap.end() != handlerIt) {
@@ -252,6 +342,24 @@ int Element::getInputConnectorCapacity(int inputPort) {
   return mInputConnectorMap[inputPort]->getCapacity();
 }
 
+std::shared_ptr<framework::Connector> Element::createInputConnector(
+    int inputPort) {
+  auto connector = std::make_shared<framework::Connector>(mThreadNumber);
+  connector->enableMetrics({{"element_id", std::to_string(mId)},
+                            {"element", mName},
+                            {"port", std::to_string(inputPort)}});
+  return connector;
+}
+
+common::Histogram* Element::registerStageLatency(const std::string& stage) {
+  return common::SingletonMetricsRegistry::getInstance().histogram(
+      "sophon_stream_element_stage_latency_seconds",
+      "Processing latency of each element stage",
+      {{"element_id", std::to_string(mId)},
+       {"element", mName},
+       {"stage", stage}});
+}
+
 void Element::addInputPort(int port) { mInputPorts.push_back(port); }
 void Element::addOutputPort(int port) { mOutputPorts.push_back(port); }
 
@@ -1,6 +1,8 @@
 
 #include "engine.h"
 
+#include <nlohmann/json.hpp>
+
 #include "common/logger.h"
 
 namespace sophon_stream {
@@ -45,8 +47,11 @@ common::ErrorCode Engine::stop(int graphId) {
     return common::ErrorCode::UNKNOWN;
   }
 
+  common::ErrorCode errorCode = graph->stop();
+  // 停止后sink element不再产生结果，等应用回调完已经排队的结果
+  mSinkDispatcher.flush(graphId);
   IVS_INFO("Engine stop graph thread finish, graph id: {0:d}", graphId);
-  return graph->stop();
+  return errorCode;
 }
 
 common::ErrorCode Engine::pause(int graphId) {
@@ -106,6 +111,12 @@ common::ErrorCode Engine::addGraph(const std::string& json) {
       return errorCode;
     }
 
+    errorCode = initSinkDispatch(graph->getId(), json);
+    if (common::ErrorCode::SUCCESS != errorCode) {
+      IVS_ERROR("Init sink dispatch fail, json: {0}", json);
+      return errorCode;
+    }
+
     errorCode = graph->start();
     listenThreadPtr->report_status(errorCode);
 
@@ -127,6 +138,7 @@ void Engine::removeGraph(int graphId) {
   std::lock_guard<std::mutex> lk(mGraphMapLock);
   IVS_INFO("Remove graph start, graph id: {0:d}", graphId);
   mGraphMap.erase(graphId);
+  mSinkDispatcher.removeGraph(graphId);
   IVS_INFO("Remove graph finish, graph id: {0:d}", graphId);
 }
 
@@ -158,7 +170,72 @@ void Engine::setSinkHandler(int graphId, int elementId, int outputPort,
     return;
   }
 
-  graph->setSinkHandler(elementId, outputPort, sinkHandler);
+  graph->setSinkHandler(elementId, outputPort,
+                        mSinkDispatcher.wrap(graphId, sinkHandler));
+}
+
+void Engine::setBatchSinkHandler(int graphId, int elementId, int outputPort,
+                                 BatchSinkHandler sinkHandler) {
+  IVS_INFO(
+      "Set batch data handler, graph id: {0:d}, element id: {1:d}, output "
+      "port: {2:d}",
+      graphId, elementId, outputPort);
+
+  auto graphIt = mGraphMap.find(graphId);
+  if (mGraphMap.end() == graphIt) {
+    IVS_ERROR("Can not find graph, graph id: {0:d}", graphId);
+    return;
+  }
+
+  auto graph = graphIt->second;
+  if (!graph) {
+    IVS_ERROR("Graph is null, graph id: {0:d}", graphId);
+    return;
+  }
+
+  graph->setSinkHandler(elementId, outputPort,
+                        mSinkDispatcher.wrapBatch(graphId, sinkHandler));
+}
+
+common::ErrorCode Engine::initSinkDispatch(int graphId,
+                                           const std::string& json) {
+  auto configure = nlohmann::json::parse(json, nullptr, false);
+  auto dispatchIt = configure.find(JSON_SINK_DISPATCH_FIELD);
+  if (configure.end() == dispatchIt) return common::ErrorCode::SUCCESS;
+  if (!dispatchIt->is_object()) {
+    IVS_ERROR("{0} must be an object, graph id: {1:d}",
+              JSON_SINK_DISPATCH_FIELD, graphId);
+    return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+
+  SinkDispatchOptions options;
+  auto workerNumberIt = dispatchIt->find(JSON_SINK_WORKER_NUMBER_FIELD);
+  if (dispatchIt->end() != workerNumberIt &&
+      workerNumberIt->is_number_integer())
+    options.mWorkerNumber = std::max(workerNumberIt->get<int>(), 1);
+  auto queueSizeIt = dispatchIt->find(JSON_SINK_QUEUE_SIZE_FIELD);
+  if (dispatchIt->end() != queueSizeIt && queueSizeIt->is_number_integer())
+    options.mQueueSize = std::max(queueSizeIt->get<int>(), 1);
+  auto maxBatchIt = dispatchIt->find(JSON_SINK_MAX_BATCH_FIELD);
+  if (dispatchIt->end() != maxBatchIt && maxBatchIt->is_number_integer())
+    options.mMaxBatch = std::max(maxBatchIt->get<int>(), 1);
+  auto policyIt = dispatchIt->find(JSON_SINK_POLICY_FIELD);
+  if (dispatchIt->end() != policyIt) {
+    std::string policy = policyIt->is_string() ? policyIt->get<std::string>()
+                                               : std::string();
+    if ("block" == policy) {
+      options.mPolicy = SinkDispatchOptions::Policy::BLOCK;
+    } else if ("drop" == policy) {
+      options.mPolicy = SinkDispatchOptions::Policy::DROP;
+    } else {
+      IVS_ERROR("{0} must be \"block\" or \"drop\", graph id: {1:d}",
+                JSON_SINK_POLICY_FIELD, graphId);
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    }
+  }
+
+  mSinkDispatcher.addGraph(graphId, options);
+  return common::ErrorCode::SUCCESS;
 }
 
 common::ErrorCode Engine::pushSourceData(int graphId, int elementId,
@@ -11,11 +11,13 @@
 
 #include <dlfcn.h>
 
+#include <functional>
 #include <nlohmann/json.hpp>
 #include <set>
 #include <string>
 
 #include "common/logger.h"
+#include "common/metadata_recorder.h"
 #include "element_factory.h"
 
 namespace sophon_stream {
@@ -54,6 +56,15 @@ common::ErrorCode Graph::init(const std::string& json) {
 
     mId = graphIdIt->get<int>();
 
+    // 模块级别对整个进程生效，放在最前面使初始化element的日志也按此过滤
+    auto logLevelsIt = configure.find(JSON_LOG_LEVELS_FIELD);
+    if (configure.end() != logLevelsIt && logLevelsIt->is_object()) {
+      for (auto& logLevel : logLevelsIt->items()) {
+        if (!logLevel.value().is_string()) continue;
+        logSetModuleLevel(logLevel.key(), logLevel.value().get<std::string>());
+      }
+    }
+
     auto elementsIt = configure.find(JSON_WORKERS_FIELD);
     if (configure.end() != elementsIt) {
       errorCode = initElements(elementsIt->dump());
@@ -70,6 +81,13 @@ common::ErrorCode Graph::init(const std::string& json) {
       }
     }
 
+    bool sinkPixelData = true;
+    auto sinkPixelDataIt = configure.find(JSON_SINK_PIXEL_DATA_FIELD);
+    if (configure.end() != sinkPixelDataIt && sinkPixelDataIt->is_boolean()) {
+      sinkPixelData = sinkPixelDataIt->get<bool>();
+    }
+    initPixelDataRelease(sinkPixelData);
+
   } while (false);
 
   if (common::ErrorCode::SUCCESS != errorCode) {
@@ -87,6 +105,8 @@ void Graph::uninit() {
   stop();
 
   mElementMap.clear();
+  mDownstreamMap.clear();
+  mFrameTapElements.clear();
   mId = -1;
 
   mSharedObjectHandles.clear();
@@ -282,6 +302,7 @@ common::ErrorCode Graph::initElements(const std::string& json) {
       }
 
       mElementMap[element->getId()] = element;
+      mDownstreamMap[element->getId()];
     }
     if (common::ErrorCode::SUCCESS != errorCode) {
       break;
@@ -364,6 +385,14 @@ common::ErrorCode Graph::initConnections(const std::string& json) {
       if (common::ErrorCode::SUCCESS != errorCode) {
         break;
       }
+
+      auto tapIt = connectionConfigure.find(JSON_CONNECTION_TAP_FIELD);
+      if (connectionConfigure.end() != tapIt) {
+        errorCode = addTap(srcElementIdIt->get<int>(), srcElementPort, *tapIt);
+        if (common::ErrorCode::SUCCESS != errorCode) {
+          break;
+        }
+      }
     }
     if (common::ErrorCode::SUCCESS != errorCode) {
       break;
@@ -408,6 +437,7 @@ common::ErrorCode Graph::connect(int srcId, int srcPort, int dstId,
   }
 
   framework::Element::connect(*srcElement, srcPort, *dstElement, dstPort);
+  mDownstreamMap[srcId].insert(dstId);
 
   srcElement->afterConnect(false, true);
   dstElement->afterConnect(true, false);
@@ -417,6 +447,70 @@ common::ErrorCode Graph::connect(int srcId, int srcPort, int dstId,
   return common::ErrorCode::SUCCESS;
 }
 
+common::ErrorCode Graph::addTap(int srcId, int srcPort,
+                                const nlohmann::json& tap) {
+  auto pathIt = tap.find(JSON_TAP_PATH_FIELD);
+  if (!tap.is_object() || tap.end() == pathIt || !pathIt->is_string()) {
+    IVS_ERROR(
+        "Can not find {0} with string type in tap json configure, graph id: "
+        "{1:d}, json: {2}",
+        JSON_TAP_PATH_FIELD, mId, tap.dump());
+    return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+  bool withFrame = false;
+  auto withFrameIt = tap.find(JSON_TAP_WITH_FRAME_FIELD);
+  if (tap.end() != withFrameIt && withFrameIt->is_boolean()) {
+    withFrame = withFrameIt->get<bool>();
+  }
+
+  auto recorder = std::make_shared<common::MetadataRecorder>(
+      pathIt->get<std::string>(), withFrame);
+  if (!recorder->open()) {
+    return common::ErrorCode::PARAMETER_ERROR;
+  }
+  mElementMap[srcId]->setOutputTap(srcPort, recorder);
+  if (withFrame) mFrameTapElements.insert(srcId);
+  return common::ErrorCode::SUCCESS;
+}
+
+void Graph::initPixelDataRelease(bool sinkPixelData) {
+  // 0: 未访问，1: 访问中，2: 需要图像，3: 不需要图像
+  std::map<int, int> states;
+  std::function<bool(int)> needsFrom = [&](int id) {
+    int& state = states[id];
+    // 有环时保守地认为需要
+    if (1 == state) return true;
+    if (0 != state) return 2 == state;
+    state = 1;
+    auto element = mElementMap[id];
+    bool needs = !element || element->needsPixelData() ||
+                 mFrameTapElements.count(id) > 0 ||
+                 (element->getSinkElementFlag() && sinkPixelData);
+    for (int dstId : mDownstreamMap[id]) {
+      if (needs) break;
+      needs = needsFrom(dstId);
+    }
+    state = needs ? 2 : 3;
+    return needs;
+  };
+
+  for (auto& pair : mDownstreamMap) {
+    auto element = mElementMap[pair.first];
+    if (!element) continue;
+    bool release = !(element->getSinkElementFlag() && sinkPixelData);
+    for (int dstId : pair.second) {
+      if (!release) break;
+      release = !needsFrom(dstId);
+    }
+    element->setReleasePixelData(release);
+    if (release)
+      IVS_INFO(
+          "No downstream element reads pixel data, release frame images on "
+          "output, graph id: {0:d}, element id: {1:d}",
+          mId, pair.first);
+  }
+}
+
 void Graph::setSinkHandler(int elementId, int outputPort,
                            SinkHandler sinkHandler) {
   IVS_INFO(
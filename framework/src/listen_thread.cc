@@ -9,6 +9,7 @@
 
 #include "listen_thread.h"
 
+#include "common/frame_tracer.h"
 #include "common/logger.h"
 
 namespace sophon_stream {
@@ -126,7 +127,13 @@ void ListenThread::init(const nlohmann::json& report_json,
              report_config.ip, report_config.port, report_config.path);
   }
 
-  
+  setHandler(METRICS_PATH, RequestType::GET, &ListenThread::handle_metrics);
+  setHandler(TRACE_START_PATH, RequestType::GET,
+             &ListenThread::handle_trace_start);
+  setHandler(TRACE_STOP_PATH, RequestType::GET,
+             &ListenThread::handle_trace_stop);
+  setHandler(TRACE_PATH, RequestType::GET, &ListenThread::handle_trace);
+
   listen_thread_ = std::thread(&ListenThread::listen_loop);
   IVS_INFO("Complete to Init Listen Thread... Path is {0}:{1}{2}",
            listen_config.ip, listen_config.port, listen_config.path);
@@ -193,6 +200,44 @@ void ListenThread::handle_task_interact(const httplib::Request& request,
   response.set_content(str_ret, "application/json");
 }
 
+void ListenThread::handle_metrics(const httplib::Request& request,
+                                  httplib::Response& response) {
+  response.set_content(
+      common::SingletonMetricsRegistry::getInstance().render(),
+      common::MetricsRegistry::CONTENT_TYPE);
+}
+
+void ListenThread::handle_trace_start(const httplib::Request& request,
+                                      httplib::Response& response) {
+  common::Response resp;
+  int seconds = 0;
+  if (request.has_param(TRACE_SECONDS_PARAM)) {
+    seconds = std::atoi(request.get_param_value(TRACE_SECONDS_PARAM).c_str());
+  }
+  common::SingletonFrameTracer::getInstance().start(seconds);
+  resp.code = 0;
+  resp.msg = "success";
+  nlohmann::json j = resp;
+  response.set_content(j.dump(), "application/json");
+}
+
+void ListenThread::handle_trace_stop(const httplib::Request& request,
+                                     httplib::Response& response) {
+  common::Response resp;
+  common::SingletonFrameTracer::getInstance().stop();
+  resp.code = 0;
+  resp.msg = "success";
+  nlohmann::json j = resp;
+  response.set_content(j.dump(), "application/json");
+}
+
+void ListenThread::handle_trace(const httplib::Request& request,
+                                httplib::Response& response) {
+  response.set_content(
+      common::SingletonFrameTracer::getInstance().exportChromeTrace(),
+      "application/json");
+}
+
 void ListenThread::report_status(common::ErrorCode errorcode) {
   if (!if_report_) return;
   std::shared_ptr<nlohmann::json> j_patch =
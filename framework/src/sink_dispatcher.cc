@@ -0,0 +1,234 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "sink_dispatcher.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "common/logger.h"
+#include "common/object_metadata.h"
+
+namespace sophon_stream {
+namespace framework {
+
+namespace {
+
+bool isEndOfStream(const std::shared_ptr<void>& data) {
+  return data &&
+         static_cast<common::ObjectMetadata*>(data.get())->getEndofStream();
+}
+
+}  // namespace
+
+SinkDispatcher::~SinkDispatcher() { stop(); }
+
+void SinkDispatcher::addGraph(int graphId, const SinkDispatchOptions& options) {
+  IVS_INFO(
+      "Add sink dispatch queue, graph id: {0:d}, worker number: {1:d}, queue "
+      "size: {2:d}, max batch: {3:d}",
+      graphId, options.mWorkerNumber, options.mQueueSize, options.mMaxBatch);
+  auto queue = std::make_shared<GraphQueue>();
+  queue->mOptions = options;
+  queue->mOptions.mQueueSize = std::max<std::size_t>(options.mQueueSize, 1);
+  queue->mOptions.mMaxBatch = std::max<std::size_t>(options.mMaxBatch, 1);
+  auto& registry = common::SingletonMetricsRegistry::getInstance();
+  common::MetricLabels labels = {{"graph", std::to_string(graphId)}};
+  queue->mDropped = registry.counter(
+      SINK_DROPPED_METRIC, "Results dropped by full sink queues", labels);
+  queue->mDepth = registry.gauge(SINK_QUEUE_DEPTH_METRIC,
+                                 "Results waiting for the sink handler", labels);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mQueues[graphId] = queue;
+  mStop = false;
+  while (static_cast<int>(mWorkers.size()) < options.mWorkerNumber)
+    mWorkers.emplace_back(&SinkDispatcher::run, this);
+}
+
+bool SinkDispatcher::hasGraph(int graphId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mQueues.end() != mQueues.find(graphId);
+}
+
+void SinkDispatcher::flush(int graphId) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto queueIt = mQueues.find(graphId);
+  if (mQueues.end() == queueIt) return;
+  auto queue = queueIt->second;
+  mWorkCond.wait(lock, [&] {
+    return mWorkers.empty() || (queue->mItems.empty() && !queue->mBusy);
+  });
+}
+
+void SinkDispatcher::removeGraph(int graphId) {
+  flush(graphId);
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto queueIt = mQueues.find(graphId);
+  if (mQueues.end() == queueIt) return;
+  queueIt->second->mNotFull.notify_all();
+  mQueues.erase(queueIt);
+}
+
+SinkDispatcher::SinkHandler SinkDispatcher::wrap(int graphId,
+                                                 SinkHandler handler) {
+  auto target = std::make_shared<Target>();
+  target->mHandler = std::move(handler);
+  return makeHandler(graphId, target);
+}
+
+SinkDispatcher::SinkHandler SinkDispatcher::wrapBatch(
+    int graphId, BatchSinkHandler handler) {
+  auto target = std::make_shared<Target>();
+  target->mBatchHandler = std::move(handler);
+  return makeHandler(graphId, target);
+}
+
+SinkDispatcher::SinkHandler SinkDispatcher::makeHandler(
+    int graphId, std::shared_ptr<Target> target) {
+  std::shared_ptr<GraphQueue> queue;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto queueIt = mQueues.find(graphId);
+    if (mQueues.end() != queueIt) queue = queueIt->second;
+  }
+  // graph没有配置分发时在sink element中直接回调
+  if (!queue) {
+    return [this, target](std::shared_ptr<void> data) {
+      call({Item{target, std::move(data)}});
+    };
+  }
+  return [this, queue, target](std::shared_ptr<void> data) {
+    push(queue, Item{target, std::move(data)});
+  };
+}
+
+void SinkDispatcher::push(const std::shared_ptr<GraphQueue>& queue,
+                          Item item) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto& items = queue->mItems;
+  std::size_t queueSize = queue->mOptions.mQueueSize;
+  if (SinkDispatchOptions::Policy::BLOCK == queue->mOptions.mPolicy) {
+    queue->mNotFull.wait(
+        lock, [&] { return mWorkers.empty() || items.size() < queueSize; });
+  } else if (items.size() >= queueSize && !isEndOfStream(item.mData)) {
+    // 丢弃最早的结果，结束帧要交给应用统计通道是否结束
+    auto dropIt =
+        std::find_if(items.begin(), items.end(), [](const Item& queued) {
+          return !isEndOfStream(queued.mData);
+        });
+    if (items.end() != dropIt) {
+      items.erase(dropIt);
+      queue->mDropped->inc();
+    }
+  }
+  if (mWorkers.empty()) {
+    lock.unlock();
+    call({std::move(item)});
+    return;
+  }
+  items.push_back(std::move(item));
+  queue->mDepth->set(items.size());
+  lock.unlock();
+  mWorkCond.notify_all();
+}
+
+void SinkDispatcher::call(const std::vector<Item>& batch) {
+  const auto& target = batch.front().mTarget;
+  try {
+    if (target->mBatchHandler) {
+      std::vector<std::shared_ptr<void>> data;
+      data.reserve(batch.size());
+      for (const auto& item : batch) data.push_back(item.mData);
+      target->mBatchHandler(data);
+    } else {
+      target->mHandler(batch.front().mData);
+    }
+  } catch (const std::exception& e) {
+    IVS_ERROR("Sink handler throws an exception: {0}", e.what());
+  }
+}
+
+void SinkDispatcher::run() {
+  std::vector<Item> batch;
+  std::unique_lock<std::mutex> lock(mMutex);
+  // 从上次处理的graph之后开始找有结果且没有线程在回调的graph
+  auto pick = [this]() -> std::shared_ptr<GraphQueue> {
+    auto queueIt = mQueues.lower_bound(mNextGraphId);
+    for (std::size_t i = 0; i < mQueues.size(); ++i, ++queueIt) {
+      if (mQueues.end() == queueIt) queueIt = mQueues.begin();
+      auto& queue = queueIt->second;
+      if (!queue->mBusy && !queue->mItems.empty()) {
+        mNextGraphId = queueIt->first + 1;
+        return queue;
+      }
+    }
+    return nullptr;
+  };
+  while (true) {
+    std::shared_ptr<GraphQueue> queue;
+    mWorkCond.wait(lock, [&] {
+      queue = pick();
+      return queue || mStop;
+    });
+    if (!queue) break;
+
+    queue->mBusy = true;
+    auto& items = queue->mItems;
+    batch.clear();
+    batch.push_back(std::move(items.front()));
+    items.pop_front();
+    // 批量回调合并同一个handler的连续结果
+    if (batch.front().mTarget->mBatchHandler) {
+      while (batch.size() < queue->mOptions.mMaxBatch && !items.empty() &&
+             items.front().mTarget == batch.front().mTarget) {
+        batch.push_back(std::move(items.front()));
+        items.pop_front();
+      }
+    }
+    queue->mDepth->set(items.size());
+    queue->mNotFull.notify_all();
+
+    lock.unlock();
+    call(batch);
+    batch.clear();
+    lock.lock();
+
+    queue->mBusy = false;
+    mWorkCond.notify_all();
+  }
+}
+
+void SinkDispatcher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+  mWorkCond.notify_all();
+  // 分发线程回调完队列中的结果后退出
+  for (auto& worker : mWorkers) worker.join();
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mWorkers.clear();
+  for (auto& queue : mQueues) {
+    queue.second->mNotFull.notify_all();
+    // 线程退出前的瞬间放进队列的结果
+    while (!queue.second->mItems.empty()) {
+      Item item = std::move(queue.second->mItems.front());
+      queue.second->mItems.pop_front();
+      lock.unlock();
+      call({std::move(item)});
+      lock.lock();
+    }
+    queue.second->mDepth->set(0);
+  }
+}
+
+}  // namespace framework
+}  // namespace sophon_stream
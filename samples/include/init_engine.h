@@ -30,6 +30,7 @@ constexpr const char* JSON_CONFIG_SRC_ID_FILED = "src_element_id";
 constexpr const char* JSON_CONFIG_SRC_PORT_FILED = "src_port";
 constexpr const char* JSON_CONFIG_DST_ID_FILED = "dst_element_id";
 constexpr const char* JSON_CONFIG_DST_PORT_FILED = "dst_port";
+constexpr const char* JSON_CONFIG_TAP_FILED = "tap";
 constexpr const char* JSON_CONFIG_INNER_ELEMENTS_ID = "inner_elements_id";
 
 void parse_element_json(
@@ -109,6 +110,8 @@ void parse_connection_json(
     connectConf["src_port"] = src_port;
     connectConf["dst_id"] = dst_element_id;
     connectConf["dst_port"] = dst_port;
+    auto tap_it = connect_config.find(JSON_CONFIG_TAP_FILED);
+    if (tap_it != connect_config.end()) connectConf["tap"] = *tap_it;
     graphConfigure["connections"].push_back(connectConf);
   }
 }
@@ -8,7 +8,24 @@
 //===----------------------------------------------------------------------===//
 #include <functional>
 
+#ifdef STREAM_HOST_BACKEND
+// 主机CPU后端没有OSD，只保留demo本身用到的头文件
+#include <sys/stat.h>
+
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <opencv2/opencv.hpp>
+
+#include "channel.h"
+#include "common/clocker.h"
+#include "common/logger.h"
+#include "common/object_metadata.h"
+#include "common/profiler.h"
+#include "engine.h"
+#include "init_engine.h"
+#else
 #include "draw_funcs.h"
+#endif
 
 typedef struct demo_config_ {
   int num_graphs;
@@ -40,6 +57,8 @@ constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_LOOP_NUM_FILED = "loop_num";
 constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_FPS_FILED = "fps";
 constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_SAMPLE_INTERVAL_FILED =
     "sample_interval";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_DETECT_INTERVAL_FILED =
+    "detect_interval";
 constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_SKIP_ELEMENT_FILED =
     "skip_element";
 constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_SAMPLE_STRATEGY_FILED =
@@ -196,6 +215,11 @@ demo_config parse_demo_json(std::string& json_path) {
     if (channel_it.end() != sample_interval_it)
       channel_json["sample_interval"] = sample_interval_it->get<int>();
 
+    auto detect_interval_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_DETECT_INTERVAL_FILED);
+    if (channel_it.end() != detect_interval_it)
+      channel_json["detect_interval"] = detect_interval_it->get<int>();
+
     auto sample_strategy_it =
         channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_SAMPLE_STRATEGY_FILED);
     if (channel_it.end() != sample_strategy_it)
@@ -246,6 +270,12 @@ using drawFuncType =
 drawFuncType getDrawFunc(demo_config& demo_json) {
   drawFuncType draw_func;
   std::string out_dir = "./results";
+#ifdef STREAM_HOST_BACKEND
+  if (demo_json.draw_func_name == "default")
+    draw_func = [](std::shared_ptr<sophon_stream::common::ObjectMetadata>) {};
+  else
+    IVS_ERROR("Only 'default' draw_func_name is supported on host backend.");
+#else
   if (demo_json.draw_func_name == "draw_bytetrack_results")
     draw_func =
         std::bind(draw_bytetrack_results, std::placeholders::_1, out_dir);
@@ -299,6 +329,7 @@ drawFuncType getDrawFunc(demo_config& demo_json) {
                           out_dir, demo_json.class_names);
   else
     IVS_ERROR("No such function! Please check your 'draw_func_name'.");
+#endif
 
   return draw_func;
 }
@@ -0,0 +1,355 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// 框架开销的benchmark，不依赖视频与模型：
+// DataPipe/Connector : 单线程push/pop的开销
+// graph              : synthetic_source -> ... -> sink，按../config下的element
+//                      配置建图，统计吞吐与端到端延时，blank链的长度差即每一跳的开销
+// serialization      : 编码/推送用的json序列化与MetadataRecorder的二进制序列化
+// 结果写入synthetic_benchmark_benchmark.json
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "benchmark_report.h"
+#include "channel.h"
+#include "common/metadata_recorder.h"
+#include "common/serialize.h"
+#include "connector.h"
+#include "datapipe.h"
+#include "engine.h"
+#include "listen_thread.h"
+
+namespace sophon_stream {
+namespace test {
+
+static auto* gReport = ::testing::AddGlobalTestEnvironment(
+    new BenchmarkReport("synthetic_benchmark"));
+
+constexpr int CHANNEL_NUM = 4;
+constexpr int SOURCE_ID = 5000;
+
+static std::int64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief 读取../config下的element配置，shared_object换为编译输出目录中的库
+ */
+static nlohmann::json loadElement(const std::string& config, int id) {
+  std::ifstream in(std::string(SYNTHETIC_BENCHMARK_CONFIG_DIR) + "/" + config);
+  nlohmann::json element = nlohmann::json::parse(in, nullptr, false);
+  EXPECT_TRUE(element.is_object()) << config;
+  element["id"] = id;
+  element["device_id"] = 0;
+  element["shared_object"] = std::string(STREAM_LIB_DIR) + "/lib" +
+                             element["name"].get<std::string>() + ".so";
+  return element;
+}
+
+struct GraphResult {
+  std::int64_t frames = 0;
+  double durationUs = 0;
+  std::vector<std::int64_t> latencies;
+};
+
+/**
+ * @brief 建图运行CHANNEL_NUM路synthetic_source，直到每一路的EOF都到达sink。
+ * elements[0]为synthetic_source，最后一个element为sink
+ */
+static GraphResult runGraph(int graphId, std::vector<nlohmann::json> elements,
+                            const std::vector<std::vector<int>>& connections) {
+  auto& engine = framework::SingletonEngine::getInstance();
+  engine.setListener(framework::ListenThread::getInstance());
+
+  int sinkId = elements.back()["id"].get<int>();
+  elements.back()["is_sink"] = true;
+  // blank每帧打一条info日志，会淹没要测的开销
+  nlohmann::json graph = {{"graph_id", graphId},
+                          {"elements", elements},
+                          {"connections", nlohmann::json::array()},
+                          {"log_levels", {{"blank", "warn"}}}};
+  for (auto& c : connections)
+    graph["connections"].push_back(
+        {{"src_id", c[0]}, {"src_port", c[1]}, {"dst_id", c[2]},
+         {"dst_port", c[3]}});
+
+  GraphResult result;
+  std::mutex mutex;
+  std::condition_variable cv;
+  int finished = 0;
+  EXPECT_EQ(engine.addGraph(graph.dump()), common::ErrorCode::SUCCESS);
+  engine.setSinkHandler(graphId, sinkId, 0, [&](std::shared_ptr<void> data) {
+    auto objectMetadata =
+        std::static_pointer_cast<common::ObjectMetadata>(data);
+    std::int64_t latency = nowUs() - objectMetadata->mFrame->mTimestamp;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (objectMetadata->mFrame->mEndOfStream) {
+      if (++finished == CHANNEL_NUM) cv.notify_one();
+      return;
+    }
+    ++result.frames;
+    result.latencies.push_back(latency);
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  for (int channelId = 0; channelId < CHANNEL_NUM; ++channelId) {
+    auto channelTask = std::make_shared<element::decode::ChannelTask>();
+    channelTask->request.operation =
+        element::decode::ChannelOperateRequest::ChannelOperate::START;
+    channelTask->request.graphId = graphId;
+    channelTask->request.channelId = channelId;
+    channelTask->request.json = nlohmann::json({{"fps", -1}}).dump();
+    engine.pushSourceData(graphId, SOURCE_ID, 0, channelTask);
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::minutes(5),
+                            [&]() { return finished == CHANNEL_NUM; }))
+        << "graph " << graphId << " did not finish";
+  }
+  result.durationUs = std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  engine.stop(graphId);
+  return result;
+}
+
+/**
+ * @brief 吞吐与延时分位数记入BenchmarkReport
+ */
+static nlohmann::json report(const std::string& name, GraphResult& result,
+                             nlohmann::json extra = nlohmann::json::object()) {
+  auto& latencies = result.latencies;
+  std::sort(latencies.begin(), latencies.end());
+  double total = 0;
+  for (auto latency : latencies) total += latency;
+  std::size_t n = std::max<std::size_t>(latencies.size(), 1);
+
+  nlohmann::json json = extra;
+  json["name"] = name;
+  json["channels"] = CHANNEL_NUM;
+  json["frames"] = result.frames;
+  json["fps"] = result.frames * 1e6 / result.durationUs;
+  json["us_per_frame"] =
+      result.durationUs / std::max<std::int64_t>(result.frames, 1);
+  json["latency_mean_us"] = total / n;
+  json["latency_p50_us"] = latencies.empty() ? 0 : latencies[n / 2];
+  json["latency_p99_us"] =
+      latencies.empty() ? 0 : latencies[std::min(n * 99 / 100, n - 1)];
+  if (BenchmarkReport::current()) BenchmarkReport::current()->add(json);
+  std::cout << "[ BENCH    ] " << name << ": " << json["fps"].get<double>()
+            << " fps, latency mean " << json["latency_mean_us"].get<double>()
+            << " us" << std::endl;
+  return json;
+}
+
+/**
+ * @brief synthetic_source的配置，帧数可以用SOPHON_STREAM_BENCHMARK_ITERATIONS覆盖
+ */
+static nlohmann::json source(int detections, bool withImage) {
+  auto element = loadElement("synthetic_source.json", SOURCE_ID);
+  auto& configure = element["configure"];
+  configure["frame_num"] = benchmarkIterations(2000);
+  configure["detections_per_frame"] = detections;
+  configure["with_image"] = withImage;
+  configure["fps"] = 0;
+  return element;
+}
+
+static std::vector<std::vector<int>> chain(
+    const std::vector<nlohmann::json>& elements) {
+  std::vector<std::vector<int>> connections;
+  for (std::size_t i = 1; i < elements.size(); ++i)
+    connections.push_back({elements[i - 1]["id"].get<int>(), 0,
+                           elements[i]["id"].get<int>(), 0});
+  return connections;
+}
+
+// 容量只有20，push后立即pop，对应graph中下游及时取走数据的稳态
+TEST(SyntheticBenchmark, DataPipe) {
+  constexpr int OPS = 1000;
+  auto data = std::make_shared<common::ObjectMetadata>();
+  for (bool metrics : {false, true}) {
+    framework::DataPipe dataPipe;
+    // element创建的dataPipe都注册了指标
+    if (metrics) dataPipe.enableMetrics({{"benchmark", "datapipe"}});
+    auto result = measure(
+        std::string("datapipe_push_pop") + (metrics ? "_metrics" : ""), 200,
+        [&]() {
+          for (int i = 0; i < OPS; ++i) {
+            dataPipe.pushData(data);
+            dataPipe.popData();
+          }
+        },
+        {{"ops", OPS}, {"metrics", metrics}});
+    EXPECT_EQ(dataPipe.getSize(), 0);
+    std::cout << "[ BENCH    ] datapipe per op: "
+              << result["mean_us"].get<double>() / OPS << " us" << std::endl;
+  }
+}
+
+TEST(SyntheticBenchmark, Connector) {
+  constexpr int OPS = 1000;
+  constexpr int PIPES = 4;
+  framework::Connector connector(PIPES);
+  connector.enableMetrics({{"benchmark", "connector"}});
+  auto data = std::make_shared<common::ObjectMetadata>();
+  measure(
+      "connector_push_pop", 200,
+      [&]() {
+        for (int i = 0; i < OPS; ++i) {
+          EXPECT_EQ(connector.pushData(i % PIPES, data),
+                    common::ErrorCode::SUCCESS);
+          connector.popData(i % PIPES);
+        }
+      },
+      {{"ops", OPS}, {"datapipes", PIPES}});
+  for (int i = 0; i < PIPES; ++i)
+    EXPECT_EQ(connector.getDataPipe(i)->getSize(), 0);
+}
+
+TEST(SyntheticBenchmark, Hop) {
+  // 1跳与8跳的延时差均摊到每一跳
+  std::vector<int> hopNums = {1, 8};
+  std::vector<double> latencies;
+  for (std::size_t g = 0; g < hopNums.size(); ++g) {
+    std::vector<nlohmann::json> elements = {source(0, false)};
+    for (int i = 0; i < hopNums[g]; ++i)
+      elements.push_back(loadElement("blank.json", SOURCE_ID + 1 + i));
+    auto result = runGraph(100 + g, elements, chain(elements));
+    EXPECT_EQ(result.frames, CHANNEL_NUM * benchmarkIterations(2000));
+    auto json = report("hop_" + std::to_string(hopNums[g]), result,
+                       {{"hops", hopNums[g]}});
+    latencies.push_back(json["latency_mean_us"].get<double>());
+  }
+  double hopUs = (latencies[1] - latencies[0]) / (hopNums[1] - hopNums[0]);
+  if (BenchmarkReport::current())
+    BenchmarkReport::current()->add(
+        {{"name", "hop_cost"}, {"us_per_hop", hopUs}});
+  std::cout << "[ BENCH    ] hop cost: " << hopUs << " us" << std::endl;
+}
+
+TEST(SyntheticBenchmark, Filter) {
+  for (int detections : {20, 100}) {
+    std::vector<nlohmann::json> elements = {
+        source(detections, false), loadElement("filter.json", SOURCE_ID + 1)};
+    auto result = runGraph(200 + detections, elements, chain(elements));
+    EXPECT_EQ(result.frames, CHANNEL_NUM * benchmarkIterations(2000));
+    report("filter_" + std::to_string(detections), result,
+           {{"detections_per_frame", detections}});
+  }
+}
+
+TEST(SyntheticBenchmark, Bytetrack) {
+  for (int detections : {20, 100}) {
+    std::vector<nlohmann::json> elements = {
+        source(detections, false),
+        loadElement("bytetrack.json", SOURCE_ID + 1)};
+    auto result = runGraph(300 + detections, elements, chain(elements));
+    EXPECT_EQ(result.frames, CHANNEL_NUM * benchmarkIterations(2000));
+    report("bytetrack_" + std::to_string(detections), result,
+           {{"detections_per_frame", detections}});
+  }
+}
+
+#ifndef STREAM_HOST_BACKEND
+// distributor的crop依赖bmcv硬件接口，不在主机后端中编译
+TEST(SyntheticBenchmark, FanOut) {
+  for (int detections : {5, 20}) {
+    auto distributor = loadElement("distributor.json", SOURCE_ID + 1);
+    distributor["configure"]["class_names_file"] =
+        std::string(SYNTHETIC_BENCHMARK_CONFIG_DIR) +
+        "/../data/synthetic.names";
+    std::vector<nlohmann::json> elements = {
+        source(detections, true), distributor,
+        loadElement("blank.json", SOURCE_ID + 2),
+        loadElement("converger.json", SOURCE_ID + 3)};
+    // distributor端口0送整帧到converger，端口1送每个目标经blank到converger
+    std::vector<std::vector<int>> connections = {
+        {SOURCE_ID, 0, SOURCE_ID + 1, 0},
+        {SOURCE_ID + 1, 0, SOURCE_ID + 3, 0},
+        {SOURCE_ID + 1, 1, SOURCE_ID + 2, 0},
+        {SOURCE_ID + 2, 0, SOURCE_ID + 3, 1}};
+    auto result = runGraph(400 + detections, elements, connections);
+    EXPECT_EQ(result.frames, CHANNEL_NUM * benchmarkIterations(2000));
+    report("fanout_" + std::to_string(detections), result,
+           {{"detections_per_frame", detections}});
+  }
+}
+#endif
+
+static std::shared_ptr<common::ObjectMetadata> makeMetadata(int detections) {
+  auto objectMetadata = std::make_shared<common::ObjectMetadata>();
+  objectMetadata->mFrame = std::make_shared<common::Frame>();
+  objectMetadata->mFrame->mWidth = 1920;
+  objectMetadata->mFrame->mHeight = 1080;
+  for (int i = 0; i < detections; ++i) {
+    auto detected = std::make_shared<common::DetectedObjectMetadata>();
+    detected->mBox = {i * 17 % 1800, i * 29 % 1000, 64, 128};
+    detected->mScores = {0.9f};
+    detected->mClassify = 0;
+    objectMetadata->mDetectedObjectMetadatas.push_back(detected);
+    auto tracked = std::make_shared<common::TrackedObjectMetadata>();
+    tracked->mTrackId = i;
+    objectMetadata->mTrackedObjectMetadatas.push_back(tracked);
+  }
+  return objectMetadata;
+}
+
+TEST(SyntheticBenchmark, Serialization) {
+  for (int detections : {20, 100}) {
+    auto objectMetadata = makeMetadata(detections);
+    std::string out;
+    measure(
+        "json_" + std::to_string(detections), 500,
+        [&]() {
+          nlohmann::json serializedObj = objectMetadata;
+          out = serializedObj.dump();
+        },
+        {{"detections_per_frame", detections}});
+    auto parsed = nlohmann::json::parse(out);
+    EXPECT_EQ(parsed["mDetectedObjectMetadatas"].size(), detections);
+    EXPECT_EQ(parsed["mTrackedObjectMetadatas"].size(), detections);
+
+    // write在调用线程中完成二进制序列化，写文件在后台线程
+    const char* dir = std::getenv("SOPHON_STREAM_BENCHMARK_DIR");
+    std::string path = (dir ? std::string(dir) + "/" : std::string()) +
+                       "synthetic_benchmark_record.bin";
+    {
+      common::MetadataRecorder recorder(path, false);
+      ASSERT_TRUE(recorder.open());
+      measure("recorder_" + std::to_string(detections), 500,
+              [&]() { recorder.write(objectMetadata); },
+              {{"detections_per_frame", detections}});
+      recorder.close();
+    }
+    common::MetadataReader reader;
+    ASSERT_TRUE(reader.open(path));
+    std::int64_t recordUs = 0;
+    auto restored = reader.next(recordUs, nullptr);
+    ASSERT_NE(restored, nullptr);
+    EXPECT_EQ(restored->mDetectedObjectMetadatas.size(), detections);
+    reader.close();
+    std::remove(path.c_str());
+  }
+}
+
+}  // namespace test
+}  // namespace sophon_stream
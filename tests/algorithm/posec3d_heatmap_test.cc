@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// posec3d前处理的可分离高斯splat与原来逐点计算的结果对比
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "posec3d/include/posec3d_heatmap.h"
+
+namespace sophon_stream {
+namespace test {
+
+using element::posec3d::splatGaussian;
+
+constexpr int IMG_W = 64;
+constexpr int IMG_H = 56;
+
+/**
+ * @brief 原generatePoseTarget中逐点计算高斯分布的实现
+ */
+void splatReference(float* heatmap, int img_w, int img_h, float mu_x,
+                    float mu_y, float sigma, float peak) {
+  int st_x = std::max(int(mu_x - 3 * sigma), 0);
+  int ed_x = std::min(int(mu_x + 3 * sigma) + 1, img_w);
+  int st_y = std::max(int(mu_y - 3 * sigma), 0);
+  int ed_y = std::min(int(mu_y + 3 * sigma) + 1, img_h);
+  if (st_x >= ed_x || st_y >= ed_y) return;
+  for (int patch_x = st_x; patch_x < ed_x; patch_x++)
+    for (int patch_y = st_y; patch_y < ed_y; patch_y++) {
+      float value =
+          exp(-(std::pow(patch_x - mu_x, 2) + std::pow(patch_y - mu_y, 2)) /
+              2 / std::pow(sigma, 2)) *
+          peak;
+      if (value > heatmap[patch_y * img_w + patch_x])
+        heatmap[patch_y * img_w + patch_x] = value;
+    }
+}
+
+struct Keypoint {
+  float x, y, peak;
+};
+
+void expectSameHeatmap(const std::vector<Keypoint>& keypoints, float sigma) {
+  std::vector<float> expected(IMG_W * IMG_H, 0);
+  std::vector<float> actual(IMG_W * IMG_H, 0);
+  for (const auto& kp : keypoints) {
+    splatReference(expected.data(), IMG_W, IMG_H, kp.x, kp.y, sigma, kp.peak);
+    splatGaussian(actual.data(), IMG_W, IMG_H, kp.x, kp.y, sigma, kp.peak);
+  }
+  for (int i = 0; i < IMG_W * IMG_H; ++i) {
+    ASSERT_NEAR(expected[i], actual[i], 1e-6f)
+        << "sigma " << sigma << " at (" << i % IMG_W << ", " << i / IMG_W
+        << ")";
+  }
+}
+
+class Posec3dHeatmapTest : public ::testing::TestWithParam<float> {};
+
+TEST_P(Posec3dHeatmapTest, RandomKeypoints) {
+  float sigma = GetParam();
+  std::mt19937 rng(17);
+  // 关键点分布在图像外3sigma以内，覆盖各个方向上的边界裁剪
+  std::uniform_real_distribution<float> x(-3 * sigma, IMG_W + 3 * sigma);
+  std::uniform_real_distribution<float> y(-3 * sigma, IMG_H + 3 * sigma);
+  std::uniform_real_distribution<float> score(0.05f, 1.0f);
+  for (int round = 0; round < 50; ++round) {
+    std::vector<Keypoint> keypoints(17);
+    for (auto& kp : keypoints) kp = {x(rng), y(rng), score(rng)};
+    expectSameHeatmap(keypoints, sigma);
+  }
+}
+
+TEST_P(Posec3dHeatmapTest, BorderKeypoints) {
+  float sigma = GetParam();
+  std::vector<Keypoint> keypoints = {
+      {0, 0, 1},
+      {IMG_W - 1, IMG_H - 1, 1},
+      {IMG_W - 0.5f, 0.5f, 0.8f},
+      {-0.7f, IMG_H - 0.3f, 0.6f},
+      {-3 * sigma + 0.5f, IMG_H / 2.f, 0.9f},
+      {IMG_W / 2.f, IMG_H + 3 * sigma - 0.5f, 0.9f},
+      // 完全在图像外，不写入
+      {-4 * sigma - 1, -4 * sigma - 1, 1},
+      {IMG_W + 4 * sigma + 1, IMG_H / 2.f, 1},
+  };
+  for (const auto& kp : keypoints) expectSameHeatmap({kp}, sigma);
+  expectSameHeatmap(keypoints, sigma);
+}
+
+// 12超过了可分离实现的核大小上限，走逐点计算的分支
+INSTANTIATE_TEST_CASE_P(Sigmas, Posec3dHeatmapTest,
+                        ::testing::Values(0.6f, 1.0f, 2.5f, 4.0f, 12.0f));
+
+}  // namespace test
+}  // namespace sophon_stream
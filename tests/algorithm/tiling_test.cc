@@ -0,0 +1,343 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// algorithmApi/tiling.h的切块与跨块合并
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "algorithmApi/tiling.h"
+
+namespace sophon_stream {
+namespace test {
+
+namespace tiling = element::tiling;
+using Rect = common::Rectangle<int>;
+
+/**
+ * @brief 检查块都在area内，并且覆盖area的每个像素
+ */
+void expectCover(const Rect& area, const std::vector<Rect>& tiles) {
+  std::vector<char> covered(area.mWidth * area.mHeight, 0);
+  for (const auto& tile : tiles) {
+    ASSERT_GE(tile.mX, area.mX);
+    ASSERT_GE(tile.mY, area.mY);
+    ASSERT_LE(tile.right(), area.right());
+    ASSERT_LE(tile.bottom(), area.bottom());
+    for (int y = tile.mY; y < tile.bottom(); ++y)
+      for (int x = tile.mX; x < tile.right(); ++x)
+        covered[(y - area.mY) * area.mWidth + (x - area.mX)] = 1;
+  }
+  for (int i = 0; i < covered.size(); ++i)
+    ASSERT_TRUE(covered[i]) << "pixel (" << area.mX + i % area.mWidth << ", "
+                            << area.mY + i / area.mWidth << ")";
+}
+
+TEST(TilingTest, TileOffsetsSmallerThanTile) {
+  EXPECT_EQ(tiling::tileOffsets(320, 640, 0.2f), std::vector<int>{0});
+  EXPECT_EQ(tiling::tileOffsets(640, 640, 0.2f), std::vector<int>{0});
+  EXPECT_EQ(tiling::tileOffsets(100, 0, 0.2f), std::vector<int>{0});
+}
+
+TEST(TilingTest, TileOffsetsExactFit) {
+  // 不重叠时正好放下两块
+  EXPECT_EQ(tiling::tileOffsets(1280, 640, 0.f), (std::vector<int>{0, 640}));
+  // 多出一个像素时多一块，块在边上均匀分布
+  EXPECT_EQ(tiling::tileOffsets(1281, 640, 0.f),
+            (std::vector<int>{0, 320, 641}));
+}
+
+TEST(TilingTest, TileOffsets4K) {
+  for (float overlap : {0.f, 0.2f, 0.5f}) {
+    for (int length : {3840, 2160}) {
+      int tile = 640;
+      auto offsets = tiling::tileOffsets(length, tile, overlap);
+      ASSERT_GE(offsets.size(), 2);
+      EXPECT_EQ(offsets.front(), 0);
+      EXPECT_EQ(offsets.back(), length - tile);
+      int step = static_cast<int>(tile * (1.f - overlap));
+      for (int i = 1; i < offsets.size(); ++i) {
+        // 相邻块的重叠不少于配置的比例
+        EXPECT_GT(offsets[i], offsets[i - 1]);
+        EXPECT_LE(offsets[i] - offsets[i - 1], step);
+      }
+      // 块数为满足重叠比例的最小值
+      int fewer = static_cast<int>(offsets.size()) - 1;
+      EXPECT_GT(length - tile, (fewer - 1) * step);
+    }
+  }
+  EXPECT_EQ(tiling::tileOffsets(3840, 640, 0.2f).size(), 8);
+  EXPECT_EQ(tiling::tileOffsets(2160, 640, 0.2f).size(), 4);
+}
+
+TEST(TilingTest, TileOffsetsClampOverlap) {
+  // 重叠比例限制在[0, 0.9]
+  EXPECT_EQ(tiling::tileOffsets(1280, 640, -1.f),
+            tiling::tileOffsets(1280, 640, 0.f));
+  EXPECT_EQ(tiling::tileOffsets(1280, 640, 1.f),
+            tiling::tileOffsets(1280, 640, 0.9f));
+}
+
+TEST(TilingTest, PlanTilesSmallerThanTile) {
+  tiling::TileParams params;
+  Rect area(0, 0, 320, 240);
+  auto tiles = tiling::planTiles(area, params);
+  ASSERT_EQ(tiles.size(), 1);
+  EXPECT_EQ(tiles[0].mX, 0);
+  EXPECT_EQ(tiles[0].mY, 0);
+  EXPECT_EQ(tiles[0].mWidth, 320);
+  EXPECT_EQ(tiles[0].mHeight, 240);
+
+  // 只有一边小于块时，该边取area的长度
+  tiles = tiling::planTiles(Rect(0, 0, 1920, 480), params);
+  ASSERT_EQ(tiles.size(), 4);
+  for (const auto& tile : tiles) {
+    EXPECT_EQ(tile.mWidth, 640);
+    EXPECT_EQ(tile.mHeight, 480);
+  }
+}
+
+TEST(TilingTest, PlanTiles4K) {
+  tiling::TileParams params;
+  Rect area(0, 0, 3840, 2160);
+  auto tiles = tiling::planTiles(area, params);
+  ASSERT_EQ(tiles.size(), 8 * 4);
+  // 按行排列
+  for (int i = 1; i < tiles.size(); ++i)
+    EXPECT_TRUE(tiles[i].mY > tiles[i - 1].mY ||
+                (tiles[i].mY == tiles[i - 1].mY &&
+                 tiles[i].mX > tiles[i - 1].mX));
+  expectCover(area, tiles);
+}
+
+TEST(TilingTest, PlanTilesRoiOffset) {
+  tiling::TileParams params;
+  params.tileW = 512;
+  params.tileH = 384;
+  Rect area(100, 50, 1000, 700);
+  auto tiles = tiling::planTiles(area, params);
+  ASSERT_EQ(tiles.size(), 3 * 3);
+  EXPECT_EQ(tiles.front().mX, 100);
+  EXPECT_EQ(tiles.front().mY, 50);
+  EXPECT_EQ(tiles.back().right(), area.right());
+  EXPECT_EQ(tiles.back().bottom(), area.bottom());
+  expectCover(area, tiles);
+}
+
+TEST(TilingTest, FrameTilesMotionOnly) {
+  tiling::TileParams params;
+  params.overlap = 0.f;
+  Rect area(0, 0, 1280, 1280);
+  // 4块：左上、右上、左下、右下
+  std::vector<Rect> motion = {Rect(700, 100, 50, 50)};
+
+  // 不打开motion_only时不筛选
+  EXPECT_EQ(tiling::frameTiles(area, motion, params).size(), 4);
+
+  params.motionOnly = true;
+  auto tiles = tiling::frameTiles(area, motion, params);
+  ASSERT_EQ(tiles.size(), 1);
+  EXPECT_EQ(tiles[0].mX, 640);
+  EXPECT_EQ(tiles[0].mY, 0);
+
+  // 跨越块边界的区域与两块相交
+  motion = {Rect(600, 1000, 100, 50)};
+  tiles = tiling::frameTiles(area, motion, params);
+  ASSERT_EQ(tiles.size(), 2);
+  EXPECT_EQ(tiles[0].mX, 0);
+  EXPECT_EQ(tiles[1].mX, 640);
+  EXPECT_EQ(tiles[0].mY, 640);
+
+  // 只与块边界相接不算相交
+  motion = {Rect(0, 0, 640, 640)};
+  EXPECT_EQ(tiling::frameTiles(area, motion, params).size(), 1);
+
+  // 没有变化区域时推理所有块
+  EXPECT_EQ(tiling::frameTiles(area, {}, params).size(), 4);
+}
+
+TEST(TilingTest, FrameTilesFullFrame) {
+  tiling::TileParams params;
+  params.overlap = 0.f;
+  params.fullFrame = true;
+  Rect area(0, 0, 1280, 1280);
+  auto tiles = tiling::frameTiles(area, {}, params);
+  ASSERT_EQ(tiles.size(), 5);
+  EXPECT_EQ(tiles.back().mWidth, 1280);
+  EXPECT_EQ(tiles.back().mHeight, 1280);
+
+  // 只有一块且与area相同时不重复推理
+  EXPECT_EQ(tiling::frameTiles(Rect(0, 0, 640, 480), {}, params).size(), 1);
+
+  // motion_only与full_frame一起使用时整帧总是推理
+  params.motionOnly = true;
+  tiles = tiling::frameTiles(area, {Rect(100, 100, 10, 10)}, params);
+  ASSERT_EQ(tiles.size(), 2);
+  EXPECT_EQ(tiles[0].mX, 0);
+  EXPECT_EQ(tiles[1].mWidth, 1280);
+  // 变化区域在area外时只剩整帧
+  tiles = tiling::frameTiles(area, {Rect(2000, 2000, 10, 10)}, params);
+  ASSERT_EQ(tiles.size(), 1);
+  EXPECT_EQ(tiles[0].mWidth, 1280);
+}
+
+/**
+ * @brief 一个目标在左侧块中完整，在右侧块中被块边界x=150截断
+ */
+std::vector<tiling::Detection> cutAtTileBorder() {
+  return {
+      {100, 100, 200, 300, 0.9f, 0, 0},  // 左侧块中完整的框
+      {150, 100, 200, 300, 0.6f, 0, 1},  // 右侧块中被截断的框，IOU 0.5，IOS 1
+      {500, 500, 540, 540, 0.7f, 0, 2},  // 不相交
+      {100, 100, 200, 300, 0.8f, 1, 3},  // 与第一个框相同但类别不同
+  };
+}
+
+tiling::TileParams mergeParams(tiling::MergeMethod method,
+                               tiling::MatchMetric metric) {
+  tiling::TileParams params;
+  params.mergeMethod = method;
+  params.matchMetric = metric;
+  params.mergeThreshold = 0.5f;
+  return params;
+}
+
+TEST(TilingTest, MatchRatio) {
+  auto dets = cutAtTileBorder();
+  EXPECT_FLOAT_EQ(
+      tiling::matchRatio(dets[0], dets[1], tiling::MatchMetric::IOU), 0.5f);
+  EXPECT_FLOAT_EQ(
+      tiling::matchRatio(dets[0], dets[1], tiling::MatchMetric::IOS), 1.f);
+  EXPECT_EQ(tiling::matchRatio(dets[0], dets[2], tiling::MatchMetric::IOS),
+            0.f);
+}
+
+TEST(TilingTest, MergeNmsIou) {
+  // 被截断的框与完整的框IOU不超过阈值，两个都保留
+  auto results = tiling::mergeDetections(
+      cutAtTileBorder(),
+      mergeParams(tiling::MergeMethod::NMS, tiling::MatchMetric::IOU));
+  ASSERT_EQ(results.size(), 4);
+  // 按分数从高到低排列
+  std::vector<int> sources;
+  for (const auto& det : results) sources.push_back(det.source);
+  EXPECT_EQ(sources, (std::vector<int>{0, 3, 2, 1}));
+}
+
+TEST(TilingTest, MergeNmsIos) {
+  auto results = tiling::mergeDetections(
+      cutAtTileBorder(),
+      mergeParams(tiling::MergeMethod::NMS, tiling::MatchMetric::IOS));
+  ASSERT_EQ(results.size(), 3);
+  // 只保留分数最高的完整框，坐标不变
+  EXPECT_EQ(results[0].source, 0);
+  EXPECT_FLOAT_EQ(results[0].x1, 100);
+  EXPECT_FLOAT_EQ(results[0].x2, 200);
+  EXPECT_FLOAT_EQ(results[0].score, 0.9f);
+  // 类别不同的框不合并
+  EXPECT_EQ(results[1].source, 3);
+  EXPECT_EQ(results[2].source, 2);
+}
+
+TEST(TilingTest, MergeWbfIou) {
+  // IOU不超过阈值时WBF也不合并，坐标保持原样
+  auto results = tiling::mergeDetections(
+      cutAtTileBorder(),
+      mergeParams(tiling::MergeMethod::WBF, tiling::MatchMetric::IOU));
+  ASSERT_EQ(results.size(), 4);
+  EXPECT_FLOAT_EQ(results[0].x1, 100);
+  EXPECT_FLOAT_EQ(results[3].x1, 150);
+}
+
+TEST(TilingTest, MergeWbfIos) {
+  auto results = tiling::mergeDetections(
+      cutAtTileBorder(),
+      mergeParams(tiling::MergeMethod::WBF, tiling::MatchMetric::IOS));
+  ASSERT_EQ(results.size(), 3);
+  // 按分数加权平均坐标，分数取最高值
+  EXPECT_EQ(results[0].source, 0);
+  EXPECT_FLOAT_EQ(results[0].x1, (100 * 0.9f + 150 * 0.6f) / 1.5f);
+  EXPECT_FLOAT_EQ(results[0].y1, 100);
+  EXPECT_FLOAT_EQ(results[0].x2, 200);
+  EXPECT_FLOAT_EQ(results[0].y2, 300);
+  EXPECT_FLOAT_EQ(results[0].score, 0.9f);
+}
+
+TEST(TilingTest, MergeAcrossFourTiles) {
+  // 目标跨在四块的交点上，每块各有一部分，再加上整帧推理的完整框
+  std::vector<tiling::Detection> dets = {
+      {600, 600, 640, 640, 0.5f, 2, 0},  {640, 600, 700, 640, 0.55f, 2, 1},
+      {600, 640, 640, 680, 0.45f, 2, 2}, {640, 640, 700, 680, 0.6f, 2, 3},
+      {600, 600, 700, 680, 0.95f, 2, 4},
+  };
+  auto params = mergeParams(tiling::MergeMethod::NMS, tiling::MatchMetric::IOS);
+  auto results = tiling::mergeDetections(dets, params);
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_EQ(results[0].source, 4);
+
+  // 用IOU时各部分与完整框的重合度都低，全部保留
+  params.matchMetric = tiling::MatchMetric::IOU;
+  EXPECT_EQ(tiling::mergeDetections(dets, params).size(), 5);
+}
+
+TEST(TilingTest, MergeCutOutscoresWhole) {
+  // 没有整帧推理，被截断的框分数比另一块中完整的框高
+  std::vector<tiling::Detection> dets = {
+      {150, 100, 200, 300, 0.9f, 0, 0},
+      {100, 100, 200, 300, 0.6f, 0, 1},
+  };
+  for (auto method : {tiling::MergeMethod::NMM, tiling::MergeMethod::NMS}) {
+    auto results = tiling::mergeDetections(
+        dets, mergeParams(method, tiling::MatchMetric::IOS));
+    ASSERT_EQ(results.size(), 1);
+    // 取到完整的框，分数与source来自分数最高的框
+    EXPECT_FLOAT_EQ(results[0].x1, 100);
+    EXPECT_FLOAT_EQ(results[0].x2, 200);
+    EXPECT_FLOAT_EQ(results[0].score, 0.9f);
+    EXPECT_EQ(results[0].source, 0);
+  }
+}
+
+TEST(TilingTest, MergeNmmFragments) {
+  // 目标比块的重叠宽，三个相邻的块各看到一部分，没有一个框是完整的
+  std::vector<tiling::Detection> dets = {
+      {100, 100, 250, 300, 0.9f, 0, 0},
+      {150, 100, 350, 300, 0.8f, 0, 1},
+      // 与分数最高的框不相交，与前两个框的外接框IOS为0.625
+      {300, 100, 380, 300, 0.7f, 0, 2},
+  };
+  auto results = tiling::mergeDetections(
+      dets, mergeParams(tiling::MergeMethod::NMM, tiling::MatchMetric::IOS));
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_FLOAT_EQ(results[0].x1, 100);
+  EXPECT_FLOAT_EQ(results[0].y1, 100);
+  EXPECT_FLOAT_EQ(results[0].x2, 380);
+  EXPECT_FLOAT_EQ(results[0].y2, 300);
+  EXPECT_FLOAT_EQ(results[0].score, 0.9f);
+  EXPECT_EQ(results[0].source, 0);
+
+  // NMS只与分数最高的框比较，第三部分单独保留，合并的两部分取面积大的框
+  results = tiling::mergeDetections(
+      dets, mergeParams(tiling::MergeMethod::NMS, tiling::MatchMetric::IOS));
+  ASSERT_EQ(results.size(), 2);
+  EXPECT_FLOAT_EQ(results[0].x1, 150);
+  EXPECT_FLOAT_EQ(results[0].x2, 350);
+  EXPECT_EQ(results[1].source, 2);
+
+  // 默认用NMM合并
+  EXPECT_EQ(tiling::TileParams().mergeMethod, tiling::MergeMethod::NMM);
+  tiling::MergeMethod method;
+  ASSERT_TRUE(tiling::parseMergeMethod("nmm", &method));
+  EXPECT_EQ(method, tiling::MergeMethod::NMM);
+  EXPECT_FALSE(tiling::parseMergeMethod("union", &method));
+}
+
+}  // namespace test
+}  // namespace sophon_stream
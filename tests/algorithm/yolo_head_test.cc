@@ -0,0 +1,206 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// algorithmApi/yolo_head.h中的exp、argmax与检测框解码与标量实现的对比
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "algorithmApi/yolo_head.h"
+
+namespace sophon_stream {
+namespace test {
+
+namespace yolo = element::yolo;
+
+float sigmoidReference(float x) { return 1.0 / (1 + expf(-x)); }
+
+/**
+ * @brief 标量argmax，多个最大值时取第一个
+ */
+int argmaxReference(const float* data, int num, float* maxValue) {
+  int index = 0;
+  for (int i = 1; i < num; ++i)
+    if (data[i] > data[index]) index = i;
+  *maxValue = num > 0 ? data[index] : 0.f;
+  return index;
+}
+
+TEST(YoloHeadTest, FastExp) {
+  float maxError = 0;
+  for (float x = -87.f; x <= 88.f; x += 1e-3f) {
+    double expected = std::exp(double(x));
+    maxError = std::max(
+        maxError, float(std::fabs(yolo::fastExp(x) - expected) / expected));
+  }
+  EXPECT_LT(maxError, 2e-7f);
+  EXPECT_FLOAT_EQ(yolo::fastExp(0.f), 1.f);
+  // 超出范围时截断，不产生inf或0
+  EXPECT_FLOAT_EQ(yolo::fastExp(200.f), yolo::fastExp(88.f));
+  EXPECT_FLOAT_EQ(yolo::fastExp(-200.f), yolo::fastExp(-87.f));
+  EXPECT_GT(yolo::fastExp(-200.f), 0.f);
+}
+
+TEST(YoloHeadTest, FastSigmoid) {
+  // 与libm的误差在两个ulp以内
+  for (float x = -30.f; x <= 30.f; x += 1e-3f)
+    ASSERT_NEAR(yolo::fastSigmoid(x), sigmoidReference(x), 2.5e-7f) << x;
+}
+
+TEST(YoloHeadTest, Logit) {
+  for (float p = 0.01f; p < 1.f; p += 0.01f)
+    EXPECT_NEAR(sigmoidReference(yolo::logit(p)), p, 1e-6f);
+  EXPECT_EQ(yolo::logit(0.f), -std::numeric_limits<float>::infinity());
+  EXPECT_EQ(yolo::logit(1.f), std::numeric_limits<float>::infinity());
+  // 阈值换算为logit后，与网络输出的比较结果和先做sigmoid再比较相同
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> dist(-8.f, 8.f);
+  for (float thresh : {0.1f, 0.25f, 0.5f, 0.9f}) {
+    float logitThresh = yolo::logit(thresh);
+    for (int i = 0; i < 10000; ++i) {
+      float x = dist(rng);
+      // 跳过恰好落在阈值附近、受舍入影响的值
+      if (std::fabs(sigmoidReference(x) - thresh) < 1e-6f) continue;
+      ASSERT_EQ(x > logitThresh, sigmoidReference(x) > thresh) << x;
+    }
+  }
+}
+
+TEST(YoloHeadTest, Argmax) {
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> dist(-10.f, 10.f);
+  // 覆盖向量部分与尾部的各种长度
+  for (int num = 1; num <= 90; ++num) {
+    for (int round = 0; round < 50; ++round) {
+      std::vector<float> data(num);
+      for (auto& value : data) value = dist(rng);
+      // 全部为负数时也取真实的最大值
+      if (round % 5 == 1)
+        for (auto& value : data) value = -std::fabs(value) - 1;
+      // 多个最大值时取第一个
+      if (round % 5 == 2 && num > 2) data[num - 1] = data[num / 2] = 20.f;
+      float expectedValue, actualValue;
+      int expected = argmaxReference(data.data(), num, &expectedValue);
+      int actual = yolo::argmax(data.data(), num, &actualValue);
+      ASSERT_EQ(expected, actual) << "num " << num;
+      ASSERT_EQ(expectedValue, actualValue) << "num " << num;
+    }
+  }
+  float value = 1.f;
+  EXPECT_EQ(yolo::argmax(nullptr, 0, &value), 0);
+  EXPECT_EQ(value, 0.f);
+}
+
+TEST(YoloHeadTest, ArgmaxColumns) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  for (int classNum : {1, 3, 80}) {
+    for (int boxNum : {1, 15, 8400}) {
+      std::vector<float> data(classNum * boxNum);
+      for (auto& value : data) value = dist(rng);
+      // 第0个候选框的最大值出现两次
+      if (classNum > 2) data[boxNum] = data[2 * boxNum] = 2.f;
+      std::vector<float> values;
+      std::vector<int> indices;
+      yolo::argmaxColumns(data.data(), classNum, boxNum, values, indices);
+      ASSERT_EQ(values.size(), boxNum);
+      ASSERT_EQ(indices.size(), boxNum);
+      std::vector<float> column(classNum);
+      for (int i = 0; i < boxNum; ++i) {
+        for (int j = 0; j < classNum; ++j) column[j] = data[j * boxNum + i];
+        float expectedValue;
+        int expected = argmaxReference(column.data(), classNum, &expectedValue);
+        ASSERT_EQ(expected, indices[i]) << "box " << i;
+        ASSERT_EQ(expectedValue, values[i]) << "box " << i;
+      }
+    }
+  }
+}
+
+TEST(YoloHeadTest, DecodeAnchorBox) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> dist(-6.f, 6.f);
+  const int netW = 640, netH = 640;
+  for (int featW : {80, 40, 20}) {
+    int featH = featW;
+    for (int cell = 0; cell < featW * featH; cell += 7) {
+      float ptr[4] = {dist(rng), dist(rng), dist(rng), dist(rng)};
+      float anchorW = 30.f, anchorH = 61.f;
+      float box[4];
+      yolo::decodeAnchorBox(ptr, cell, featW, featH, netW, netH, anchorW,
+                            anchorH, box);
+      // 原yolov5后处理中的解码
+      float expected[4] = {
+          (sigmoidReference(ptr[0]) * 2 - 0.5f + cell % featW) / featW * netW,
+          (sigmoidReference(ptr[1]) * 2 - 0.5f + cell / featW) / featH * netH,
+          float(pow((sigmoidReference(ptr[2]) * 2), 2) * anchorW),
+          float(pow((sigmoidReference(ptr[3]) * 2), 2) * anchorH)};
+      for (int k = 0; k < 4; ++k)
+        ASSERT_NEAR(box[k], expected[k], 1e-5f * std::fmax(1.f, expected[k]))
+            << "cell " << cell << " k " << k;
+    }
+  }
+}
+
+TEST(YoloHeadTest, DecodeGridBox) {
+  std::mt19937 rng(13);
+  std::uniform_real_distribution<float> offset(-1.f, 2.f);
+  std::uniform_real_distribution<float> scale(-3.f, 4.f);
+  for (int stride : {8, 16, 32}) {
+    int grid = 640 / stride;
+    for (int gridY = 0; gridY < grid; gridY += 3) {
+      for (int gridX = 0; gridX < grid; gridX += 3) {
+        float ptr[4] = {offset(rng), offset(rng), scale(rng), scale(rng)};
+        float box[4];
+        yolo::decodeGridBox(ptr, gridX, gridY, stride, box);
+        // 原yolox后处理中的解码
+        float expected[4] = {(ptr[0] + gridX) * stride,
+                             (ptr[1] + gridY) * stride,
+                             float(exp(ptr[2]) * stride),
+                             float(exp(ptr[3]) * stride)};
+        for (int k = 0; k < 4; ++k)
+          ASSERT_NEAR(box[k], expected[k],
+                      1e-5f * std::fmax(1.f, expected[k]));
+      }
+    }
+  }
+}
+
+struct ThresholdContext {
+  float thresh_conf_min = 0.25f;
+  bool class_thresh_valid = false;
+  std::vector<std::string> class_names;
+  std::map<std::string, float> thresh_conf;
+};
+
+TEST(YoloHeadTest, ClassThresholds) {
+  auto context = std::make_shared<ThresholdContext>();
+  context->class_names = {"person", "car", "bike"};
+  context->thresh_conf = {{"person", 0.4f}, {"bike", 0.1f}};
+
+  std::vector<float> thresholds = yolo::classThresholds(context, 4);
+  EXPECT_EQ(thresholds, std::vector<float>(4, 0.25f));
+
+  context->class_thresh_valid = true;
+  thresholds = yolo::classThresholds(context, 4);
+  // 没有配置阈值或超出class_names的类别用thresh_conf_min
+  EXPECT_EQ(thresholds, (std::vector<float>{0.4f, 0.25f, 0.1f, 0.25f}));
+  EXPECT_EQ(yolo::minThreshold(thresholds, 0.5f), 0.1f);
+  EXPECT_EQ(yolo::minThreshold({}, 0.5f), 0.5f);
+}
+
+}  // namespace test
+}  // namespace sophon_stream
@@ -0,0 +1,283 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// 融合前处理与链式前处理的对比：
+// fused   : d2s拷回YUV -> fusedPreprocess -> s2d写回tensor
+// chained : storage_convert -> copy_to(宽度不是64对齐时) ->
+//           vpp_convert_padding -> convert_to
+// 两条路径输入同一帧NV12/YUV420P，输出yolov5格式的FP32平面tensor，
+// 先检查两者输出一致，再分别计时
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bmcv_api_ext.h"
+#include "bmlib_runtime.h"
+#include "benchmark_report.h"
+#include "common/fused_preprocess.h"
+
+namespace sophon_stream {
+namespace test {
+
+static auto* gReport =
+    ::testing::AddGlobalTestEnvironment(new BenchmarkReport("preprocess"));
+
+constexpr float INPUT_SCALE = 1.0f / 255;
+constexpr uint8_t PAD_VALUE = 114;
+
+struct PreprocessCase {
+  bm_image_format_ext format;
+  int width;
+  int height;
+  int netW;
+  int netH;
+};
+
+static std::string caseName(const PreprocessCase& c) {
+  return std::string(c.format == FORMAT_NV12 ? "nv12" : "yuv420p") + "_" +
+         std::to_string(c.width) + "x" + std::to_string(c.height) + "_to_" +
+         std::to_string(c.netW) + "x" + std::to_string(c.netH);
+}
+
+/**
+ * @brief 平滑渐变加上几条硬边，既覆盖插值误差，也覆盖色度下采样
+ */
+static void fillFrame(std::vector<uint8_t>& y, std::vector<uint8_t>& u,
+                      std::vector<uint8_t>& v, int width, int height) {
+  y.resize(width * height);
+  u.resize(width * height / 4);
+  v.resize(width * height / 4);
+  for (int r = 0; r < height; ++r)
+    for (int c = 0; c < width; ++c) {
+      int value = 16 + (r * 3 + c * 2) % 200;
+      if ((c / 97) % 2 == 1 && (r / 61) % 2 == 0) value = 235;
+      y[r * width + c] = value;
+    }
+  for (int r = 0; r < height / 2; ++r)
+    for (int c = 0; c < width / 2; ++c) {
+      u[r * width / 2 + c] = 128 + static_cast<int>(60 * std::sin(c * 0.02f));
+      v[r * width / 2 + c] = 128 + static_cast<int>(60 * std::cos(r * 0.03f));
+    }
+}
+
+class PreprocessBenchmark : public ::testing::TestWithParam<PreprocessCase> {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(bm_dev_request(&mHandle, 0), BM_SUCCESS);
+    const auto& c = GetParam();
+    fillFrame(mY, mU, mV, c.width, c.height);
+    ASSERT_EQ(bm_image_create(mHandle, c.height, c.width, c.format,
+                              DATA_TYPE_EXT_1N_BYTE, &mSrc),
+              BM_SUCCESS);
+    ASSERT_EQ(bm_image_alloc_dev_mem(mSrc, 1), BM_SUCCESS);
+    std::vector<uint8_t> uv;
+    void* buffers[3] = {mY.data(), nullptr, nullptr};
+    if (c.format == FORMAT_NV12) {
+      uv.resize(mU.size() * 2);
+      for (size_t i = 0; i < mU.size(); ++i) {
+        uv[2 * i] = mU[i];
+        uv[2 * i + 1] = mV[i];
+      }
+      buffers[1] = uv.data();
+    } else {
+      buffers[1] = mU.data();
+      buffers[2] = mV.data();
+    }
+    ASSERT_EQ(bm_image_copy_host_to_device(mSrc, buffers), BM_SUCCESS);
+
+    int count = 3 * c.netW * c.netH;
+    ASSERT_EQ(bm_malloc_device_byte(mHandle, &mTensor, count * sizeof(float)),
+              BM_SUCCESS);
+    mConverto.alpha_0 = mConverto.alpha_1 = mConverto.alpha_2 = INPUT_SCALE;
+    mConverto.beta_0 = mConverto.beta_1 = mConverto.beta_2 = 0;
+  }
+
+  void TearDown() override {
+    bm_free_device(mHandle, mTensor);
+    bm_image_destroy(mSrc);
+    bm_dev_free(mHandle);
+  }
+
+  /**
+   * @brief 与PreProcess::fusedPreProcessFrame相同：拷回YUV，CPU上一次完成，写回tensor
+   */
+  void runFused() {
+    const auto& c = GetParam();
+    common::YuvImageView view;
+    view.format = c.format == FORMAT_NV12 ? common::YuvFormat::NV12
+                                          : common::YuvFormat::YUV420P;
+    int planeNum = bm_image_get_plane_num(mSrc);
+    int sizes[3] = {0};
+    bm_image_get_byte_size(mSrc, sizes);
+    bm_image_get_stride(mSrc, view.stride);
+    mHostImage.resize(sizes[0] + sizes[1] + sizes[2]);
+    void* buffers[3] = {nullptr};
+    for (int i = 0, offset = 0; i < planeNum; offset += sizes[i], ++i)
+      buffers[i] = mHostImage.data() + offset;
+    bm_image_copy_device_to_host(mSrc, buffers);
+    view.width = c.width;
+    view.height = c.height;
+    for (int i = 0; i < planeNum; ++i)
+      view.data[i] = static_cast<const uint8_t*>(buffers[i]);
+
+    common::FusedPreprocessParam param;
+    param.netW = c.netW;
+    param.netH = c.netH;
+    param.bgr2rgb = true;
+    for (int i = 0; i < 3; ++i) param.alpha[i] = INPUT_SCALE;
+    param.padValue = PAD_VALUE;
+    mHostTensor.resize(3 * c.netW * c.netH);
+    common::fusedPreprocess(view, param, mHostTensor.data());
+    bm_memcpy_s2d_partial(mHandle, mTensor, mHostTensor.data(),
+                          mHostTensor.size() * sizeof(float));
+  }
+
+  /**
+   * @brief 与Yolov5PreProcess::preProcess中的链式调用相同
+   */
+  void runChained() {
+    const auto& c = GetParam();
+    bm_image rgb;
+    bm_image_create(mHandle, c.height, c.width, FORMAT_RGB_PLANAR,
+                    DATA_TYPE_EXT_1N_BYTE, &rgb);
+    bm_image_alloc_dev_mem(rgb, 1);
+    bmcv_image_storage_convert(mHandle, 1, &mSrc, &rgb);
+
+    bm_image aligned = rgb;
+    bool needCopy = c.width & (64 - 1);
+    if (needCopy) {
+      int stride1[3], stride2[3];
+      bm_image_get_stride(rgb, stride1);
+      for (int i = 0; i < 3; ++i) stride2[i] = (stride1[i] + 63) / 64 * 64;
+      bm_image_create(mHandle, c.height, c.width, FORMAT_RGB_PLANAR,
+                      DATA_TYPE_EXT_1N_BYTE, &aligned, stride2);
+      bm_image_alloc_dev_mem(aligned, 1);
+      bmcv_copy_to_atrr_t copyToAttr;
+      memset(&copyToAttr, 0, sizeof(copyToAttr));
+      copyToAttr.if_padding = 1;
+      bmcv_image_copy_to(mHandle, copyToAttr, rgb, aligned);
+    }
+
+    auto letterbox =
+        common::computeLetterbox(c.width, c.height, c.netW, c.netH);
+    bmcv_padding_atrr_t paddingAttr;
+    memset(&paddingAttr, 0, sizeof(paddingAttr));
+    paddingAttr.dst_crop_stx = letterbox.x;
+    paddingAttr.dst_crop_sty = letterbox.y;
+    paddingAttr.dst_crop_w = letterbox.w;
+    paddingAttr.dst_crop_h = letterbox.h;
+    paddingAttr.padding_r = paddingAttr.padding_g = paddingAttr.padding_b =
+        PAD_VALUE;
+    paddingAttr.if_memset = 1;
+    bmcv_rect_t cropRect = {0, 0, c.width, c.height};
+    int alignedNetW = (c.netW + 63) / 64 * 64;
+    int strides[3] = {alignedNetW, alignedNetW, alignedNetW};
+    bm_image resized;
+    bm_image_create(mHandle, c.netH, c.netW, FORMAT_RGB_PLANAR,
+                    DATA_TYPE_EXT_1N_BYTE, &resized, strides);
+    bm_image_alloc_dev_mem(resized, 1);
+    bmcv_image_vpp_convert_padding(mHandle, 1, aligned, &resized, &paddingAttr,
+                                   &cropRect);
+
+    bm_image converto;
+    bm_image_create(mHandle, c.netH, c.netW, FORMAT_RGB_PLANAR,
+                    DATA_TYPE_EXT_FLOAT32, &converto);
+    bm_image_attach(converto, &mTensor);
+    bmcv_image_convert_to(mHandle, 1, mConverto, &resized, &converto);
+
+    bm_image_detach(converto);
+    bm_image_destroy(converto);
+    bm_image_destroy(resized);
+    if (needCopy) bm_image_destroy(aligned);
+    bm_image_destroy(rgb);
+  }
+
+  std::vector<float> readTensor() {
+    const auto& c = GetParam();
+    std::vector<float> out(3 * c.netW * c.netH);
+    bm_memcpy_d2s_partial(mHandle, out.data(), mTensor,
+                          out.size() * sizeof(float));
+    return out;
+  }
+
+  bm_handle_t mHandle = nullptr;
+  bm_image mSrc;
+  bm_device_mem_t mTensor;
+  bmcv_convert_to_attr mConverto;
+  std::vector<uint8_t> mY, mU, mV;
+  std::vector<uint8_t> mHostImage;
+  std::vector<float> mHostTensor;
+};
+
+/**
+ * @brief 两条路径的输出逐像素比较，误差换算回0~255的像素值。
+ * 双线性插值与YUV转RGB的舍入方式不同，允许个别像素有几个灰度的差异，
+ * 但平均误差要小于1个灰度，letterbox的位置必须一致
+ */
+TEST_P(PreprocessBenchmark, FusedMatchesChained) {
+  runChained();
+  auto chained = readTensor();
+  runFused();
+  auto fused = readTensor();
+  ASSERT_EQ(chained.size(), fused.size());
+
+  double sum = 0;
+  std::vector<float> diffs(fused.size());
+  for (size_t i = 0; i < fused.size(); ++i) {
+    diffs[i] = std::fabs(fused[i] - chained[i]) / INPUT_SCALE;
+    sum += diffs[i];
+  }
+  std::sort(diffs.begin(), diffs.end());
+  double mean = sum / diffs.size();
+  float p999 = diffs[diffs.size() * 999 / 1000];
+  EXPECT_LT(mean, 1.0) << caseName(GetParam());
+  EXPECT_LE(p999, 8.f) << caseName(GetParam());
+
+  const auto& c = GetParam();
+  auto letterbox = common::computeLetterbox(c.width, c.height, c.netW, c.netH);
+  // letterbox外的填充区域两者都应是PAD_VALUE
+  for (int ch = 0; ch < 3; ++ch)
+    for (int y = 0; y < c.netH; ++y)
+      for (int x = 0; x < c.netW; ++x) {
+        if (x >= letterbox.x && x < letterbox.x + letterbox.w &&
+            y >= letterbox.y && y < letterbox.y + letterbox.h)
+          continue;
+        size_t i = (static_cast<size_t>(ch) * c.netH + y) * c.netW + x;
+        ASSERT_NEAR(fused[i] / INPUT_SCALE, PAD_VALUE, 0.5f);
+        ASSERT_NEAR(chained[i] / INPUT_SCALE, PAD_VALUE, 0.5f);
+      }
+}
+
+TEST_P(PreprocessBenchmark, Fused) {
+  const auto& c = GetParam();
+  measure("fused_" + caseName(c), 200, [this]() { runFused(); },
+          {{"path", "fused"}, {"width", c.width}, {"height", c.height}});
+}
+
+TEST_P(PreprocessBenchmark, Chained) {
+  const auto& c = GetParam();
+  measure("chained_" + caseName(c), 200, [this]() { runChained(); },
+          {{"path", "chained"}, {"width", c.width}, {"height", c.height}});
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Frames, PreprocessBenchmark,
+    ::testing::Values(PreprocessCase{FORMAT_NV12, 1920, 1080, 640, 640},
+                      PreprocessCase{FORMAT_YUV420P, 1920, 1080, 640, 640},
+                      PreprocessCase{FORMAT_NV12, 1280, 720, 640, 640},
+                      PreprocessCase{FORMAT_NV12, 1000, 700, 640, 384},
+                      PreprocessCase{FORMAT_YUV420P, 3840, 2160, 640, 640}));
+
+}  // namespace test
+}  // namespace sophon_stream
@@ -0,0 +1,391 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// YOLO检测头解码的对比，输入为640x640、80类的随机网络输出：
+// scalar    : 原后处理的实现，逐个候选框用libm的exp做sigmoid与解码，
+//             从0开始的标量argmax，按类别阈值判断
+// yolo_head : algorithmApi/yolo_head.h，先用最小阈值淘汰候选框再做argmax与解码
+// 布局：
+// yolov5 : 3个anchor输出[3][h][w][85]，未经sigmoid
+// yolov7 : 解码后的单输出[25200][85]
+// yolov8 : 类别在前的单输出[84][8400]
+// yolox  : [8400][85]，按stride 8/16/32的网格解码
+// 先检查两者得到的候选框一致，再分别计时
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "algorithmApi/yolo_head.h"
+#include "benchmark_report.h"
+
+namespace sophon_stream {
+namespace test {
+
+static auto* gReport =
+    ::testing::AddGlobalTestEnvironment(new BenchmarkReport("yolo_head"));
+
+namespace yolo = element::yolo;
+
+constexpr int NET_SIZE = 640;
+constexpr int CLASS_NUM = 80;
+constexpr int NOUT = CLASS_NUM + 5;
+constexpr float CONF_THRESH = 0.25f;
+constexpr int STRIDES[3] = {8, 16, 32};
+const float ANCHORS[3][3][2] = {{{10, 13}, {16, 30}, {33, 23}},
+                                {{30, 61}, {62, 45}, {59, 119}},
+                                {{116, 90}, {156, 198}, {373, 326}}};
+
+struct Candidate {
+  float cx, cy, w, h, score;
+  int classId;
+};
+using Candidates = std::vector<Candidate>;
+
+float sigmoid(float x) { return 1.0 / (1 + expf(-x)); }
+
+int argmaxScalar(const float* data, int num) {
+  float max_value = 0.0;
+  int max_index = 0;
+  for (int i = 0; i < num; ++i) {
+    if (data[i] > max_value) {
+      max_value = data[i];
+      max_index = i;
+    }
+  }
+  return max_index;
+}
+
+/**
+ * @brief 随机的网络输出，物体置信度与类别分数大多很低，约1%的候选框超过阈值
+ * @param[in] logits : true时为未经sigmoid的值
+ */
+class HeadOutput {
+ public:
+  explicit HeadOutput(bool logits) : mRng(2024), mLogits(logits) {}
+
+  float box() { return mBox(mRng); }
+  float objectness() { return value(mObjectness(mRng)); }
+  float classScore() { return value(mClass(mRng)); }
+
+ private:
+  float value(float logit) { return mLogits ? logit : sigmoid(logit); }
+
+  std::mt19937 mRng;
+  bool mLogits;
+  std::uniform_real_distribution<float> mBox{-1.f, 2.f};
+  std::normal_distribution<float> mObjectness{-6.f, 2.f};
+  std::normal_distribution<float> mClass{-4.f, 2.f};
+};
+
+/**
+ * @brief [box][85]的行布局
+ */
+std::vector<float> rowMajorOutput(int boxNum, bool logits) {
+  HeadOutput gen(logits);
+  std::vector<float> data(boxNum * NOUT);
+  for (int i = 0; i < boxNum; ++i) {
+    float* ptr = data.data() + i * NOUT;
+    for (int k = 0; k < 4; ++k) ptr[k] = gen.box();
+    ptr[4] = gen.objectness();
+    for (int k = 5; k < NOUT; ++k) ptr[k] = gen.classScore();
+  }
+  return data;
+}
+
+int boxNum() {
+  int num = 0;
+  for (int stride : STRIDES) num += 3 * (NET_SIZE / stride) * (NET_SIZE / stride);
+  return num;
+}
+
+int gridNum() {
+  int num = 0;
+  for (int stride : STRIDES) num += (NET_SIZE / stride) * (NET_SIZE / stride);
+  return num;
+}
+
+// ---------------- yolov5，anchor输出 ----------------
+
+void yolov5Scalar(const std::vector<float>& data, Candidates& out) {
+  float log_conf_threshold = -std::log(1 / CONF_THRESH - 1);
+  const float* ptr = data.data();
+  for (int tidx = 0; tidx < 3; ++tidx) {
+    int feat = NET_SIZE / STRIDES[tidx];
+    for (int anchor_idx = 0; anchor_idx < 3; ++anchor_idx) {
+      for (int i = 0; i < feat * feat; ++i, ptr += NOUT) {
+        if (ptr[4] <= log_conf_threshold) continue;
+        float dst[7];
+        dst[0] = (sigmoid(ptr[0]) * 2 - 0.5 + i % feat) / feat * NET_SIZE;
+        dst[1] = (sigmoid(ptr[1]) * 2 - 0.5 + i / feat) / feat * NET_SIZE;
+        dst[2] = pow((sigmoid(ptr[2]) * 2), 2) * ANCHORS[tidx][anchor_idx][0];
+        dst[3] = pow((sigmoid(ptr[3]) * 2), 2) * ANCHORS[tidx][anchor_idx][1];
+        dst[4] = sigmoid(ptr[4]);
+        dst[5] = ptr[5];
+        dst[6] = 5;
+        for (int d = 6; d < NOUT; d++) {
+          if (ptr[d] > dst[5]) {
+            dst[5] = ptr[d];
+            dst[6] = d;
+          }
+        }
+        dst[6] -= 5;
+        float score = dst[4];
+        if (dst[5] > -std::log(score / CONF_THRESH - 1))
+          out.push_back({dst[0], dst[1], dst[2], dst[3],
+                         sigmoid(dst[5]) * score, int(dst[6])});
+      }
+    }
+  }
+}
+
+void yolov5Head(const std::vector<float>& data, Candidates& out) {
+  std::vector<float> thresholds(CLASS_NUM, CONF_THRESH);
+  float obj_logit_thresh = yolo::logit(yolo::minThreshold(thresholds, CONF_THRESH));
+  const float* ptr = data.data();
+  for (int tidx = 0; tidx < 3; ++tidx) {
+    int feat = NET_SIZE / STRIDES[tidx];
+    for (int anchor_idx = 0; anchor_idx < 3; ++anchor_idx) {
+      for (int i = 0; i < feat * feat; ++i, ptr += NOUT) {
+        if (ptr[4] <= obj_logit_thresh) continue;
+        float score = yolo::fastSigmoid(ptr[4]);
+        float confidence;
+        int class_id = yolo::argmax(ptr + 5, CLASS_NUM, &confidence);
+        confidence = yolo::fastSigmoid(confidence) * score;
+        if (confidence <= thresholds[class_id]) continue;
+        float dst[4];
+        yolo::decodeAnchorBox(ptr, i, feat, feat, NET_SIZE, NET_SIZE,
+                              ANCHORS[tidx][anchor_idx][0],
+                              ANCHORS[tidx][anchor_idx][1], dst);
+        out.push_back({dst[0], dst[1], dst[2], dst[3], confidence, class_id});
+      }
+    }
+  }
+}
+
+// ---------------- yolov7，解码后的单输出 ----------------
+
+void yolov7Scalar(const std::vector<float>& data, Candidates& out) {
+  for (int i = 0; i < boxNum(); i++) {
+    const float* ptr = data.data() + i * NOUT;
+    float score = ptr[4];
+    int class_id = argmaxScalar(&ptr[5], CLASS_NUM);
+    float confidence = ptr[class_id + 5];
+    if (score > CONF_THRESH && confidence * score > CONF_THRESH)
+      out.push_back({ptr[0], ptr[1], ptr[2], ptr[3], confidence * score,
+                     class_id});
+  }
+}
+
+void yolov7Head(const std::vector<float>& data, Candidates& out) {
+  std::vector<float> thresholds(CLASS_NUM, CONF_THRESH);
+  float min_thresh = yolo::minThreshold(thresholds, CONF_THRESH);
+  for (int i = 0; i < boxNum(); i++) {
+    const float* ptr = data.data() + i * NOUT;
+    float score = ptr[4];
+    if (score <= min_thresh) continue;
+    float confidence;
+    int class_id = yolo::argmax(ptr + 5, CLASS_NUM, &confidence);
+    if (confidence * score > thresholds[class_id])
+      out.push_back({ptr[0], ptr[1], ptr[2], ptr[3], confidence * score,
+                     class_id});
+  }
+}
+
+// ---------------- yolov8，类别在前 ----------------
+
+std::vector<float> yolov8Output() {
+  int num = gridNum();
+  HeadOutput gen(false);
+  std::vector<float> data((4 + CLASS_NUM) * num);
+  for (int i = 0; i < 4 * num; ++i) data[i] = gen.box() * NET_SIZE;
+  // 每个候选框的类别分数整体偏低，少数超过阈值
+  for (int i = 4 * num; i < data.size(); ++i)
+    data[i] = gen.classScore() * gen.classScore();
+  return data;
+}
+
+void yolov8Scalar(const std::vector<float>& data, Candidates& out) {
+  int feature_num = gridNum();
+  const float* cls_conf = data.data() + 4 * feature_num;
+  for (int i = 0; i < feature_num; i++) {
+    float max_value = 0.0;
+    int max_index = 0;
+    for (int j = 0; j < CLASS_NUM; j++) {
+      float cur_value = cls_conf[i + j * feature_num];
+      if (cur_value > max_value) {
+        max_value = cur_value;
+        max_index = j;
+      }
+    }
+    if (max_value >= CONF_THRESH)
+      out.push_back({data[i], data[i + feature_num], data[i + 2 * feature_num],
+                     data[i + 3 * feature_num], max_value, max_index});
+  }
+}
+
+void yolov8Head(const std::vector<float>& data, Candidates& out,
+                std::vector<float>& max_values, std::vector<int>& max_indices) {
+  int feature_num = gridNum();
+  yolo::argmaxColumns(data.data() + 4 * feature_num, CLASS_NUM, feature_num,
+                      max_values, max_indices);
+  std::vector<float> thresholds(CLASS_NUM, CONF_THRESH);
+  float min_thresh = yolo::minThreshold(thresholds, CONF_THRESH);
+  for (int i = 0; i < feature_num; i++) {
+    float max_value = max_values[i];
+    if (max_value < min_thresh) continue;
+    int max_index = max_indices[i];
+    if (max_value >= thresholds[max_index])
+      out.push_back({data[i], data[i + feature_num], data[i + 2 * feature_num],
+                     data[i + 3 * feature_num], max_value, max_index});
+  }
+}
+
+// ---------------- yolox，网格解码 ----------------
+
+struct Grids {
+  std::vector<int> x, y, stride;
+};
+
+Grids yoloxGrids() {
+  Grids grids;
+  for (int stride : STRIDES) {
+    int feat = NET_SIZE / stride;
+    for (int gy = 0; gy < feat; ++gy)
+      for (int gx = 0; gx < feat; ++gx) {
+        grids.x.push_back(gx);
+        grids.y.push_back(gy);
+        grids.stride.push_back(stride);
+      }
+  }
+  return grids;
+}
+
+void yoloxScalar(const std::vector<float>& tensor, const Grids& grids,
+                 Candidates& out) {
+  for (size_t i = 0; i < grids.x.size(); ++i) {
+    float box_objectness = tensor[i * NOUT + 4];
+    if (box_objectness < CONF_THRESH) continue;
+    int max_class_idx = argmaxScalar(&tensor[i * NOUT + 5], CLASS_NUM);
+    float box_prob = box_objectness * tensor[i * NOUT + 5 + max_class_idx];
+    if (box_prob > CONF_THRESH) {
+      float center_x = (tensor[i * NOUT + 0] + grids.x[i]) * grids.stride[i];
+      float center_y = (tensor[i * NOUT + 1] + grids.y[i]) * grids.stride[i];
+      float w_temp = exp(tensor[i * NOUT + 2]) * grids.stride[i];
+      float h_temp = exp(tensor[i * NOUT + 3]) * grids.stride[i];
+      out.push_back(
+          {center_x, center_y, w_temp, h_temp, box_prob, max_class_idx});
+    }
+  }
+}
+
+void yoloxHead(const std::vector<float>& tensor, const Grids& grids,
+               Candidates& out) {
+  std::vector<float> thresholds(CLASS_NUM, CONF_THRESH);
+  float min_thresh = yolo::minThreshold(thresholds, CONF_THRESH);
+  for (size_t i = 0; i < grids.x.size(); ++i) {
+    const float* ptr = tensor.data() + i * NOUT;
+    float box_objectness = ptr[4];
+    if (box_objectness < min_thresh) continue;
+    float max_class_prob;
+    int max_class_idx = yolo::argmax(ptr + 5, CLASS_NUM, &max_class_prob);
+    float box_prob = box_objectness * max_class_prob;
+    if (box_prob > thresholds[max_class_idx]) {
+      float decoded[4];
+      yolo::decodeGridBox(ptr, grids.x[i], grids.y[i], grids.stride[i],
+                          decoded);
+      out.push_back({decoded[0], decoded[1], decoded[2], decoded[3], box_prob,
+                     max_class_idx});
+    }
+  }
+}
+
+// ---------------- 对比与计时 ----------------
+
+void expectSameCandidates(const Candidates& expected,
+                          const Candidates& actual) {
+  ASSERT_GT(expected.size(), 0);
+  ASSERT_EQ(expected.size(), actual.size());
+  auto near = [](float a, float b) {
+    return std::fabs(a - b) <= 1e-5f * std::fmax(1.f, std::fabs(a));
+  };
+  for (size_t i = 0; i < expected.size(); ++i) {
+    const Candidate& e = expected[i];
+    const Candidate& a = actual[i];
+    ASSERT_EQ(e.classId, a.classId) << "candidate " << i;
+    ASSERT_TRUE(near(e.cx, a.cx) && near(e.cy, a.cy) && near(e.w, a.w) &&
+                near(e.h, a.h) && near(e.score, a.score))
+        << "candidate " << i;
+  }
+}
+
+void compareAndMeasure(const std::string& layout, int boxes,
+                       const std::function<void(Candidates&)>& scalar,
+                       const std::function<void(Candidates&)>& head) {
+  Candidates expected, actual;
+  scalar(expected);
+  head(actual);
+  expectSameCandidates(expected, actual);
+  if (::testing::Test::HasFatalFailure()) return;
+
+  nlohmann::json extra = {{"layout", layout},
+                          {"boxes", boxes},
+                          {"candidates", expected.size()}};
+  Candidates out;
+  out.reserve(expected.size());
+  measure(layout + "_scalar", 200, [&]() {
+    out.clear();
+    scalar(out);
+  }, extra);
+  measure(layout + "_yolo_head", 200, [&]() {
+    out.clear();
+    head(out);
+  }, extra);
+}
+
+TEST(YoloHeadBenchmark, Yolov5) {
+  std::vector<float> data = rowMajorOutput(boxNum(), true);
+  compareAndMeasure(
+      "yolov5", boxNum(), [&](Candidates& out) { yolov5Scalar(data, out); },
+      [&](Candidates& out) { yolov5Head(data, out); });
+}
+
+TEST(YoloHeadBenchmark, Yolov7) {
+  std::vector<float> data = rowMajorOutput(boxNum(), false);
+  compareAndMeasure(
+      "yolov7", boxNum(), [&](Candidates& out) { yolov7Scalar(data, out); },
+      [&](Candidates& out) { yolov7Head(data, out); });
+}
+
+TEST(YoloHeadBenchmark, Yolov8) {
+  std::vector<float> data = yolov8Output();
+  std::vector<float> max_values;
+  std::vector<int> max_indices;
+  compareAndMeasure(
+      "yolov8", gridNum(), [&](Candidates& out) { yolov8Scalar(data, out); },
+      [&](Candidates& out) {
+        yolov8Head(data, out, max_values, max_indices);
+      });
+}
+
+TEST(YoloHeadBenchmark, Yolox) {
+  std::vector<float> data = rowMajorOutput(gridNum(), false);
+  Grids grids = yoloxGrids();
+  compareAndMeasure(
+      "yolox", gridNum(),
+      [&](Candidates& out) { yoloxScalar(data, grids, out); },
+      [&](Candidates& out) { yoloxHead(data, grids, out); });
+}
+
+}  // namespace test
+}  // namespace sophon_stream
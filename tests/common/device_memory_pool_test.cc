@@ -0,0 +1,240 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// common/device_memory_pool：用HostMemoryBackend验证复用计数、历史最大值、
+// heap占满时释放缓存后重试，以及调用backend时不持有内存池的锁
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/device_memory_pool.h"
+
+namespace sophon_stream {
+namespace test {
+
+using common::DeviceMemoryPool;
+using common::HostMemoryBackend;
+using common::SingletonDeviceMemoryPool;
+
+/**
+ * @brief 记录申请、释放次数，已申请的字节数超过capacity时申请失败，模拟heap占满
+ */
+class CountingBackend : public HostMemoryBackend {
+ public:
+  explicit CountingBackend(size_t capacity = SIZE_MAX)
+      : mCapacity(capacity) {}
+
+  bm_status_t alloc(bm_handle_t handle, int heapMask, size_t size,
+                    bm_device_mem_t* mem) override {
+    {
+      std::lock_guard<std::mutex> lk(mMutex);
+      ++mAllocs;
+      if (mLiveBytes + size > mCapacity) return BM_ERR_NOMEM;
+      mLiveBytes += size;
+    }
+    return HostMemoryBackend::alloc(handle, heapMask, size, mem);
+  }
+
+  void free(bm_handle_t handle, bm_device_mem_t mem) override {
+    {
+      std::lock_guard<std::mutex> lk(mMutex);
+      ++mFrees;
+      mLiveBytes -= bm_mem_get_device_size(mem);
+    }
+    HostMemoryBackend::free(handle, mem);
+  }
+
+  std::mutex mMutex;
+  size_t mCapacity;
+  size_t mLiveBytes = 0;
+  int mAllocs = 0;
+  int mFrees = 0;
+};
+
+/**
+ * @brief 内存池是单例，每个测试前释放缓存并换上新的backend，统计按差值比较
+ */
+class DeviceMemoryPoolTest : public ::testing::Test {
+ protected:
+  template <typename Backend>
+  std::shared_ptr<Backend> useBackend(std::shared_ptr<Backend> backend) {
+    pool().trim();
+    pool().setBackend(backend);
+    mBefore = pool().getStats();
+    return backend;
+  }
+
+  DeviceMemoryPool& pool() { return SingletonDeviceMemoryPool::getInstance(); }
+
+  DeviceMemoryPool::Stats mBefore;
+};
+
+bm_handle_t fakeHandle(std::intptr_t id) {
+  return reinterpret_cast<bm_handle_t>(id);
+}
+
+TEST_F(DeviceMemoryPoolTest, SizeClass) {
+  EXPECT_EQ(DeviceMemoryPool::sizeClass(1), 4096);
+  EXPECT_EQ(DeviceMemoryPool::sizeClass(4096), 4096);
+  EXPECT_EQ(DeviceMemoryPool::sizeClass(4097), 4096 + 512);
+  EXPECT_EQ(DeviceMemoryPool::sizeClass(1 << 20), 1 << 20);
+  // 浪费不超过1/8
+  for (size_t size = 4097; size < (8 << 20); size = size * 5 / 4 + 1) {
+    size_t cls = DeviceMemoryPool::sizeClass(size);
+    ASSERT_GE(cls, size);
+    ASSERT_LE(cls - size, size / 8) << size;
+  }
+}
+
+TEST_F(DeviceMemoryPoolTest, HitsAndMisses) {
+  auto backend = useBackend(std::make_shared<CountingBackend>());
+  bm_handle_t handle = fakeHandle(1);
+  bm_device_mem_t a, b, c;
+  ASSERT_EQ(pool().alloc(handle, &a, 1, 100000), BM_SUCCESS);
+  // 返回的大小仍是申请的大小
+  EXPECT_EQ(bm_mem_get_device_size(a), 100000);
+  pool().free(handle, a);
+  // 同一档位复用刚释放的块
+  ASSERT_EQ(pool().alloc(handle, &b, 1, 100001), BM_SUCCESS);
+  EXPECT_EQ(bm_mem_get_device_addr(b), bm_mem_get_device_addr(a));
+  // 不同的heap或handle不复用
+  ASSERT_EQ(pool().alloc(handle, &c, 2, 100000), BM_SUCCESS);
+  pool().free(handle, c);
+  ASSERT_EQ(pool().alloc(fakeHandle(2), &c, 1, 100000), BM_SUCCESS);
+  pool().free(fakeHandle(2), c);
+  pool().free(handle, b);
+
+  auto stats = pool().getStats();
+  EXPECT_EQ(stats.mHits - mBefore.mHits, 1);
+  EXPECT_EQ(stats.mMisses - mBefore.mMisses, 3);
+  EXPECT_EQ(backend->mAllocs, 3);
+  EXPECT_EQ(backend->mFrees, 0);
+  EXPECT_EQ(stats.mInUseBytes, 0);
+  EXPECT_EQ(stats.mCachedBytes, 3 * DeviceMemoryPool::sizeClass(100000));
+
+  pool().trim(fakeHandle(2));
+  EXPECT_EQ(backend->mFrees, 1);
+  pool().trim();
+  EXPECT_EQ(backend->mFrees, 3);
+  EXPECT_EQ(pool().getStats().mCachedBytes, 0);
+}
+
+TEST_F(DeviceMemoryPoolTest, HighWater) {
+  auto backend = useBackend(std::make_shared<CountingBackend>());
+  bm_handle_t handle = fakeHandle(1);
+  const size_t size = 4 << 20;
+  std::vector<bm_device_mem_t> mems(3);
+  for (auto& mem : mems) ASSERT_EQ(pool().alloc(handle, &mem, 1, size), 0);
+  EXPECT_EQ(pool().getStats().mInUseBytes, 3 * size);
+  for (auto& mem : mems) pool().free(handle, mem);
+  ASSERT_EQ(pool().alloc(handle, &mems[0], 1, size), BM_SUCCESS);
+
+  auto stats = pool().getStats();
+  EXPECT_EQ(stats.mInUseBytes, size);
+  EXPECT_EQ(stats.mCachedBytes, 2 * size);
+  // 历史最大值保持在3块同时使用时
+  EXPECT_EQ(stats.mHighWaterBytes, 3 * size);
+  pool().free(handle, mems[0]);
+  EXPECT_EQ(pool().getStats().mHighWaterBytes, 3 * size);
+}
+
+TEST_F(DeviceMemoryPoolTest, RetryAfterFlush) {
+  // heap只能放下两个64K的块
+  auto backend = useBackend(std::make_shared<CountingBackend>(2 * 65536));
+  bm_handle_t handle = fakeHandle(1);
+  bm_device_mem_t small[2], large, other;
+  for (auto& mem : small)
+    ASSERT_EQ(pool().alloc(handle, &mem, 1, 65536), BM_SUCCESS);
+  for (auto& mem : small) pool().free(handle, mem);
+  // 只释放同一handle、同一heap上的缓存
+  ASSERT_EQ(pool().alloc(handle, &other, 2, 4096), BM_ERR_NOMEM);
+  EXPECT_EQ(backend->mFrees, 0);
+  ASSERT_EQ(pool().alloc(handle, &small[0], 1, 65536), BM_SUCCESS);
+  pool().free(handle, small[0]);
+  // heap 2上失败后重试了一次，heap 1上的申请复用缓存
+  EXPECT_EQ(backend->mAllocs, 4);
+
+  // 缓存占住了heap，释放缓存后重试成功
+  ASSERT_EQ(pool().alloc(handle, &large, 1, 2 * 65536), BM_SUCCESS);
+  EXPECT_EQ(backend->mAllocs, 6);
+  EXPECT_EQ(backend->mFrees, 2);
+  auto stats = pool().getStats();
+  EXPECT_EQ(stats.mCachedBytes, 0);
+  EXPECT_EQ(stats.mInUseBytes, 2 * 65536);
+
+  // 释放缓存后仍然放不下时返回错误，不影响已申请的块
+  ASSERT_EQ(pool().alloc(handle, &other, 1, 4096), BM_ERR_NOMEM);
+  EXPECT_EQ(pool().getStats().mInUseBytes, 2 * 65536);
+  pool().free(handle, large);
+  pool().trim();
+  EXPECT_EQ(backend->mLiveBytes, 0);
+}
+
+/**
+ * @brief 在某个handle上申请时阻塞，直到测试放行
+ */
+class BlockingBackend : public CountingBackend {
+ public:
+  bm_status_t alloc(bm_handle_t handle, int heapMask, size_t size,
+                    bm_device_mem_t* mem) override {
+    if (handle == mBlockedHandle) {
+      mEntered.set_value();
+      mRelease.get_future().wait();
+    }
+    return CountingBackend::alloc(handle, heapMask, size, mem);
+  }
+
+  bm_handle_t mBlockedHandle = nullptr;
+  std::promise<void> mEntered;
+  std::promise<void> mRelease;
+};
+
+TEST_F(DeviceMemoryPoolTest, BackendCalledWithoutLock) {
+  auto backend = useBackend(std::make_shared<BlockingBackend>());
+  bm_handle_t other = fakeHandle(2);
+  bm_device_mem_t cached;
+  ASSERT_EQ(pool().alloc(other, &cached, 1, 4096), BM_SUCCESS);
+  pool().free(other, cached);
+
+  backend->mBlockedHandle = fakeHandle(1);
+  bm_device_mem_t slow;
+  auto slowAlloc = std::async(std::launch::async, [&] {
+    return pool().alloc(fakeHandle(1), &slow, 1, 4096);
+  });
+  backend->mEntered.get_future().wait();
+
+  // 一个handle的申请卡在设备分配器中时，其他handle的申请、释放不用等待
+  auto fastAlloc = std::async(std::launch::async, [&] {
+    bm_device_mem_t mem, fresh;
+    auto ret = pool().alloc(other, &mem, 1, 4096);
+    if (ret == BM_SUCCESS) ret = pool().alloc(other, &fresh, 1, 8192);
+    pool().free(other, mem);
+    pool().free(other, fresh);
+    return ret;
+  });
+  bool finished = fastAlloc.wait_for(std::chrono::seconds(5)) ==
+                  std::future_status::ready;
+  backend->mRelease.set_value();
+  ASSERT_TRUE(finished);
+  EXPECT_EQ(fastAlloc.get(), BM_SUCCESS);
+  ASSERT_EQ(slowAlloc.get(), BM_SUCCESS);
+  pool().free(fakeHandle(1), slow);
+  pool().trim();
+  EXPECT_EQ(backend->mLiveBytes, 0);
+}
+
+}  // namespace test
+}  // namespace sophon_stream
@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TESTS_BENCHMARK_REPORT_H_
+#define SOPHON_STREAM_TESTS_BENCHMARK_REPORT_H_
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sophon_stream {
+namespace test {
+
+/**
+ * @brief gtest写成的benchmark的结果汇总，程序结束时写为json文件。
+ * 文件为$SOPHON_STREAM_BENCHMARK_DIR/{name}_benchmark.json，未设置时写在当前目录。
+ * 每个benchmark程序在全局注册一个：
+ *   static auto* gReport = ::testing::AddGlobalTestEnvironment(
+ *       new sophon_stream::test::BenchmarkReport("preprocess"));
+ */
+class BenchmarkReport : public ::testing::Environment {
+ public:
+  explicit BenchmarkReport(std::string name) : mName(std::move(name)) {
+    current() = this;
+  }
+
+  static BenchmarkReport*& current() {
+    static BenchmarkReport* report = nullptr;
+    return report;
+  }
+
+  void add(nlohmann::json result) { mResults.push_back(std::move(result)); }
+
+  void TearDown() override {
+    const char* dir = std::getenv("SOPHON_STREAM_BENCHMARK_DIR");
+    std::string path = (dir ? std::string(dir) + "/" : std::string()) + mName +
+                       "_benchmark.json";
+    nlohmann::json report = {{"benchmark", mName}, {"results", mResults}};
+    std::ofstream out(path);
+    out << report.dump(2) << std::endl;
+    std::cout << "benchmark results written to " << path << std::endl;
+  }
+
+ private:
+  std::string mName;
+  nlohmann::json mResults = nlohmann::json::array();
+};
+
+/**
+ * @brief 迭代次数，可用环境变量SOPHON_STREAM_BENCHMARK_ITERATIONS统一覆盖，
+ * ctest中设为较小的值只做正确性检查
+ */
+inline int benchmarkIterations(int defaultIterations) {
+  const char* iterations = std::getenv("SOPHON_STREAM_BENCHMARK_ITERATIONS");
+  if (iterations == nullptr) return defaultIterations;
+  return std::max(std::atoi(iterations), 1);
+}
+
+/**
+ * @brief 预热后逐次计时运行func，统计每次的耗时(us)并记入当前的BenchmarkReport
+ * @param[in] extra : 附加在结果中的字段，如分辨率、每次处理的条数
+ * @return 本次的结果
+ */
+template <typename Func>
+nlohmann::json measure(const std::string& name, int iterations, Func&& func,
+                       nlohmann::json extra = nlohmann::json::object()) {
+  iterations = benchmarkIterations(iterations);
+  int warmup = std::max(iterations / 10, 1);
+  for (int i = 0; i < warmup; ++i) func();
+
+  std::vector<double> costs(iterations);
+  for (int i = 0; i < iterations; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    costs[i] = std::chrono::duration<double, std::micro>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+  }
+  std::vector<double> sorted = costs;
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0;
+  for (double cost : costs) total += cost;
+
+  nlohmann::json result = extra;
+  result["name"] = name;
+  result["iterations"] = iterations;
+  result["mean_us"] = total / iterations;
+  result["min_us"] = sorted.front();
+  result["p50_us"] = sorted[iterations / 2];
+  result["p99_us"] = sorted[std::min(iterations * 99 / 100, iterations - 1)];
+  if (BenchmarkReport::current()) BenchmarkReport::current()->add(result);
+  std::cout << "[ BENCH    ] " << name << ": mean "
+            << result["mean_us"].get<double>() << " us, p99 "
+            << result["p99_us"].get<double>() << " us" << std::endl;
+  return result;
+}
+
+}  // namespace test
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_TESTS_BENCHMARK_REPORT_H_
@@ -0,0 +1,262 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// motion_gate的背景差分：逐行差分的向量实现与标量实现对比，
+// 以及静止、运动方块、光照渐变序列上的检测结果与运动结束后的保持
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "motion_detector.h"
+
+namespace sophon_stream {
+namespace test {
+
+using element::motion_gate::diffAndUpdateRow;
+using element::motion_gate::MotionDetector;
+using element::motion_gate::MotionDetectorParams;
+using element::motion_gate::MotionHold;
+
+/**
+ * @brief diffAndUpdateRow的标量实现
+ */
+void diffAndUpdateRowReference(const std::uint8_t* luma,
+                               std::uint16_t* background, std::uint8_t* mask,
+                               int width, int threshold, int learningShift) {
+  for (int x = 0; x < width; ++x) {
+    int value = luma[x] << 8;
+    int diff = value - background[x];
+    int magnitude = diff < 0 ? -diff : diff;
+    mask[x] = (magnitude >> 8) > threshold ? 1 : 0;
+    if (diff > 0)
+      background[x] += diff >> learningShift;
+    else
+      background[x] -= (-diff) >> learningShift;
+  }
+}
+
+TEST(MotionDetectorTest, DiffAndUpdateRowMatchesScalar) {
+  std::mt19937 rng(23);
+  std::uniform_int_distribution<int> pixel(0, 255);
+  std::uniform_int_distribution<int> background(0, 255 << 8);
+  // 16的倍数只走向量部分，其余宽度覆盖标量尾部
+  for (int width : {1, 7, 15, 16, 17, 31, 32, 33, 47, 64, 100, 160}) {
+    for (int threshold : {0, 20, 254}) {
+      for (int shift : {0, 1, 5, 15}) {
+        std::vector<std::uint8_t> luma(width);
+        std::vector<std::uint16_t> expectedBg(width);
+        for (int x = 0; x < width; ++x) {
+          luma[x] = pixel(rng);
+          expectedBg[x] = background(rng);
+        }
+        // 与背景相等、只差一个亮度级的像素
+        luma[0] = expectedBg[0] >> 8;
+        expectedBg[0] = luma[0] << 8;
+        if (width > 1) expectedBg[width - 1] = (luma[width - 1] + 1) << 8;
+        std::vector<std::uint16_t> actualBg = expectedBg;
+        std::vector<std::uint8_t> expectedMask(width), actualMask(width);
+        diffAndUpdateRowReference(luma.data(), expectedBg.data(),
+                                  expectedMask.data(), width, threshold,
+                                  shift);
+        diffAndUpdateRow(luma.data(), actualBg.data(), actualMask.data(),
+                         width, threshold, shift);
+        ASSERT_EQ(expectedMask, actualMask)
+            << "width " << width << " threshold " << threshold << " shift "
+            << shift;
+        ASSERT_EQ(expectedBg, actualBg)
+            << "width " << width << " threshold " << threshold << " shift "
+            << shift;
+      }
+    }
+  }
+}
+
+/**
+ * @brief 纹理背景上的亮度图，stride可以大于宽度
+ */
+class LumaSequence {
+ public:
+  LumaSequence(int width, int height, int stride)
+      : mWidth(width), mHeight(height), mStride(stride) {
+    std::mt19937 rng(31);
+    std::uniform_int_distribution<int> texture(60, 120);
+    mBackground.resize(stride * height);
+    for (auto& pixel : mBackground) pixel = texture(rng);
+  }
+
+  /**
+   * @brief 整体亮度加上offset，并在(blockX, blockY)画一个亮方块
+   */
+  const std::uint8_t* frame(int offset, int blockX = -1, int blockY = -1,
+                            int blockSize = 16) {
+    mFrame = mBackground;
+    for (auto& pixel : mFrame) pixel = std::min(pixel + offset, 255);
+    if (blockX >= 0) {
+      for (int y = blockY; y < std::min(blockY + blockSize, mHeight); ++y)
+        for (int x = blockX; x < std::min(blockX + blockSize, mWidth); ++x)
+          mFrame[y * mStride + x] = 250;
+    }
+    return mFrame.data();
+  }
+
+  int stride() const { return mStride; }
+
+ private:
+  int mWidth;
+  int mHeight;
+  int mStride;
+  std::vector<std::uint8_t> mBackground;
+  std::vector<std::uint8_t> mFrame;
+};
+
+MotionDetectorParams smallParams() {
+  MotionDetectorParams params;
+  params.mWidth = 100;
+  params.mHeight = 60;
+  return params;
+}
+
+TEST(MotionDetectorTest, StaticSequence) {
+  MotionDetectorParams params = smallParams();
+  MotionDetector detector(params);
+  LumaSequence sequence(params.mWidth, params.mHeight, 128);
+  // 第一帧初始化背景
+  EXPECT_EQ(detector.update(sequence.frame(0), sequence.stride()), 0);
+  for (int i = 0; i < 50; ++i) {
+    ASSERT_EQ(detector.update(sequence.frame(0), sequence.stride()), 0);
+    ASSERT_TRUE(detector.changedRegions().empty());
+  }
+}
+
+TEST(MotionDetectorTest, MovingBlock) {
+  MotionDetectorParams params = smallParams();
+  MotionDetector detector(params);
+  LumaSequence sequence(params.mWidth, params.mHeight, params.mWidth);
+  detector.update(sequence.frame(0), sequence.stride());
+
+  for (int step = 0; step < 5; ++step) {
+    int blockX = 8 + step * 16;
+    int blockY = 24;
+    int changed = detector.update(sequence.frame(0, blockX, blockY),
+                                  sequence.stride());
+    // 16x16的方块按8x8的cell对齐，至少覆盖4个cell
+    ASSERT_GE(changed, 4) << "step " << step;
+    auto regions = detector.changedRegions();
+    ASSERT_FALSE(regions.empty());
+    // 方块一定在某个变化区域内
+    bool covered = false;
+    for (const auto& region : regions) {
+      covered = covered || (region.mX <= blockX && region.mY <= blockY &&
+                            region.right() >= blockX + 16 &&
+                            region.bottom() >= blockY + 16);
+      // 区域不超出亮度图
+      ASSERT_GE(region.mX, 0);
+      ASSERT_GE(region.mY, 0);
+      ASSERT_LE(region.right(), params.mWidth);
+      ASSERT_LE(region.bottom(), params.mHeight);
+    }
+    ASSERT_TRUE(covered) << "step " << step;
+  }
+}
+
+TEST(MotionDetectorTest, SeparateRegions) {
+  MotionDetectorParams params = smallParams();
+  MotionDetector detector(params);
+  LumaSequence sequence(params.mWidth, params.mHeight, params.mWidth);
+  detector.update(sequence.frame(0), sequence.stride());
+  // 两个不相邻的方块得到两个区域，右下角的方块被图像边界截断
+  const std::uint8_t* first = sequence.frame(0, 0, 0);
+  std::vector<std::uint8_t> frame(first,
+                                  first + params.mWidth * params.mHeight);
+  for (int y = 50; y < 60; ++y)
+    for (int x = 90; x < 100; ++x) frame[y * params.mWidth + x] = 250;
+  EXPECT_GT(detector.update(frame.data(), params.mWidth), 0);
+  auto regions = detector.changedRegions();
+  ASSERT_EQ(regions.size(), 2);
+  EXPECT_EQ(regions[0].mX, 0);
+  EXPECT_EQ(regions[0].mY, 0);
+  EXPECT_EQ(regions[0].right(), 16);
+  EXPECT_EQ(regions[0].bottom(), 16);
+  // 100x60不是cell的整数倍，边缘cell按实际像素数计算
+  EXPECT_EQ(regions[1].mX, 88);
+  EXPECT_EQ(regions[1].mY, 48);
+  EXPECT_EQ(regions[1].right(), 100);
+  EXPECT_EQ(regions[1].bottom(), 60);
+}
+
+TEST(MotionDetectorTest, LightingDrift) {
+  MotionDetectorParams params = smallParams();
+  MotionDetector detector(params);
+  LumaSequence sequence(params.mWidth, params.mHeight, params.mWidth);
+  detector.update(sequence.frame(0), sequence.stride());
+  // 缓慢的亮度变化被背景吸收
+  for (int i = 0; i < 200; ++i)
+    ASSERT_EQ(detector.update(sequence.frame(i / 4), sequence.stride()), 0)
+        << "frame " << i;
+
+  // 突然的亮度变化使所有cell变化，之后逐渐融入背景
+  int offset = 200 / 4 + 60;
+  EXPECT_EQ(detector.update(sequence.frame(offset), sequence.stride()),
+            detector.cellsX() * detector.cellsY());
+  int frames = 0;
+  while (detector.update(sequence.frame(offset), sequence.stride()) > 0)
+    ASSERT_LT(++frames, 200);
+  EXPECT_GT(frames, 0);
+}
+
+TEST(MotionDetectorTest, Reset) {
+  MotionDetectorParams params = smallParams();
+  MotionDetector detector(params);
+  LumaSequence sequence(params.mWidth, params.mHeight, params.mWidth);
+  detector.update(sequence.frame(0), sequence.stride());
+  EXPECT_GT(detector.update(sequence.frame(80), sequence.stride()), 0);
+  // reset后下一帧重新初始化背景
+  detector.reset();
+  EXPECT_EQ(detector.update(sequence.frame(80), sequence.stride()), 0);
+  EXPECT_EQ(detector.update(sequence.frame(80), sequence.stride()), 0);
+}
+
+TEST(MotionHoldTest, HoldFrames) {
+  MotionHold hold(3);
+  // 第一帧初始化背景，与之后的帧一起在开始的保持期内放行
+  EXPECT_TRUE(hold.update(false));
+  EXPECT_TRUE(hold.update(false));
+  EXPECT_TRUE(hold.update(false));
+  EXPECT_FALSE(hold.update(false));
+
+  // 运动结束后再放行3帧
+  EXPECT_TRUE(hold.update(true));
+  for (int i = 0; i < 3; ++i) EXPECT_TRUE(hold.update(false)) << i;
+  EXPECT_FALSE(hold.update(false));
+  EXPECT_FALSE(hold.update(false));
+
+  // 保持期内再次运动时重新计数
+  EXPECT_TRUE(hold.update(true));
+  EXPECT_TRUE(hold.update(false));
+  EXPECT_TRUE(hold.update(false));
+  EXPECT_TRUE(hold.update(true));
+  for (int i = 0; i < 3; ++i) EXPECT_TRUE(hold.update(false)) << i;
+  EXPECT_FALSE(hold.update(false));
+}
+
+TEST(MotionHoldTest, NoHold) {
+  MotionHold hold(0);
+  // 第一帧总是放行
+  EXPECT_TRUE(hold.update(false));
+  EXPECT_FALSE(hold.update(false));
+  EXPECT_TRUE(hold.update(true));
+  EXPECT_FALSE(hold.update(false));
+}
+
+}  // namespace test
+}  // namespace sophon_stream
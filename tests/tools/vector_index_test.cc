@@ -0,0 +1,309 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// faiss的cpu索引：flat、ivf、ivf_pq与hnsw在聚类数据上的召回率，
+// 以及逐批添加、删除、添加后再训练
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vector_index.h"
+
+namespace sophon_stream {
+namespace test {
+
+using element::faiss::IvfIndex;
+using element::faiss::VectorIndex;
+using element::faiss::VectorIndexParams;
+
+constexpr int DIM = 32;
+
+void normalize(float* vector, int dim) {
+  float norm = 0.f;
+  for (int d = 0; d < dim; ++d) norm += vector[d] * vector[d];
+  norm = std::sqrt(norm);
+  for (int d = 0; d < dim; ++d) vector[d] /= norm;
+}
+
+/**
+ * @brief 围绕clusters个中心的单位向量，与人脸特征一样按内积检索
+ */
+std::vector<float> clusteredVectors(std::size_t n, int clusters,
+                                    unsigned seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> normal(0.f, 1.f);
+  std::vector<float> centers(clusters * DIM);
+  for (auto& value : centers) value = normal(rng);
+  std::vector<float> vectors(n * DIM);
+  for (std::size_t i = 0; i < n; ++i) {
+    const float* center = centers.data() + (i % clusters) * DIM;
+    float* vector = vectors.data() + i * DIM;
+    for (int d = 0; d < DIM; ++d) vector[d] = center[d] + 0.4f * normal(rng);
+    normalize(vector, DIM);
+  }
+  return vectors;
+}
+
+/**
+ * @brief 查询向量为底库向量加上小的扰动
+ */
+std::vector<float> perturbedQueries(const std::vector<float>& db,
+                                    std::size_t nq, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> normal(0.f, 0.05f);
+  std::size_t n = db.size() / DIM;
+  std::vector<float> queries(nq * DIM);
+  for (std::size_t q = 0; q < nq; ++q) {
+    const float* source = db.data() + (q * 7919 % n) * DIM;
+    for (int d = 0; d < DIM; ++d)
+      queries[q * DIM + d] = source[d] + normal(rng);
+    normalize(queries.data() + q * DIM, DIM);
+  }
+  return queries;
+}
+
+std::vector<std::int64_t> sequentialIds(std::size_t n, std::int64_t first) {
+  std::vector<std::int64_t> ids(n);
+  for (std::size_t i = 0; i < n; ++i) ids[i] = first + i;
+  return ids;
+}
+
+/**
+ * @brief 暴力检索得到的最近邻id
+ */
+std::vector<std::int64_t> groundTruth(const std::vector<float>& db,
+                                      const std::vector<std::int64_t>& ids,
+                                      const std::vector<float>& queries) {
+  std::size_t n = db.size() / DIM, nq = queries.size() / DIM;
+  std::vector<std::int64_t> nearest(nq);
+  for (std::size_t q = 0; q < nq; ++q) {
+    float best = -2.f;
+    for (std::size_t i = 0; i < n; ++i) {
+      float score = 0.f;
+      for (int d = 0; d < DIM; ++d)
+        score += queries[q * DIM + d] * db[i * DIM + d];
+      if (score > best) {
+        best = score;
+        nearest[q] = ids[i];
+      }
+    }
+  }
+  return nearest;
+}
+
+/**
+ * @brief 真实的最近邻出现在前k个结果中的比例
+ */
+float recallAtK(const VectorIndex& index, const std::vector<float>& queries,
+                const std::vector<std::int64_t>& truth, int k) {
+  std::size_t nq = truth.size();
+  std::vector<float> scores(nq * k);
+  std::vector<std::int64_t> ids(nq * k);
+  index.search(queries.data(), nq, k, scores.data(), ids.data());
+  int found = 0;
+  for (std::size_t q = 0; q < nq; ++q) {
+    for (int j = 0; j < k; ++j) {
+      if (ids[q * k + j] == truth[q]) {
+        ++found;
+        break;
+      }
+    }
+  }
+  return static_cast<float>(found) / nq;
+}
+
+VectorIndexParams indexParams(const std::string& type) {
+  VectorIndexParams params;
+  params.type = type;
+  params.dim = DIM;
+  params.nlist = 32;
+  params.nprobe = 8;
+  params.pqM = 8;
+  return params;
+}
+
+struct RecallCase {
+  std::string type;
+  int k;
+  float minRecall;
+};
+
+void PrintTo(const RecallCase& param, std::ostream* os) {
+  *os << param.type << " recall@" << param.k;
+}
+
+class VectorIndexRecallTest : public ::testing::TestWithParam<RecallCase> {};
+
+TEST_P(VectorIndexRecallTest, Bulk) {
+  const RecallCase& param = GetParam();
+  std::vector<float> db = clusteredVectors(4000, 64, 1);
+  auto ids = sequentialIds(4000, 100);
+  auto queries = perturbedQueries(db, 200, 2);
+  auto truth = groundTruth(db, ids, queries);
+
+  auto index = VectorIndex::create(indexParams(param.type));
+  ASSERT_NE(index, nullptr);
+  index->add(db.data(), ids.data(), ids.size());
+  EXPECT_EQ(index->size(), ids.size());
+  EXPECT_GE(recallAtK(*index, queries, truth, param.k), param.minRecall);
+}
+
+TEST_P(VectorIndexRecallTest, Incremental) {
+  // 从空索引开始每次添加几个向量，召回率与一次添加整个底库相当
+  const RecallCase& param = GetParam();
+  std::vector<float> db = clusteredVectors(4000, 64, 1);
+  auto ids = sequentialIds(4000, 100);
+  auto queries = perturbedQueries(db, 200, 2);
+  auto truth = groundTruth(db, ids, queries);
+
+  auto index = VectorIndex::create(indexParams(param.type));
+  ASSERT_NE(index, nullptr);
+  const std::size_t batch = 5;
+  for (std::size_t begin = 0; begin < ids.size(); begin += batch)
+    index->add(db.data() + begin * DIM, ids.data() + begin, batch);
+  EXPECT_EQ(index->size(), ids.size());
+  EXPECT_GE(recallAtK(*index, queries, truth, param.k), param.minRecall);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Types, VectorIndexRecallTest,
+    ::testing::Values(RecallCase{"flat", 1, 1.f}, RecallCase{"ivf", 1, 0.9f},
+                      RecallCase{"ivf_pq", 10, 0.8f},
+                      RecallCase{"hnsw", 1, 0.9f}));
+
+class VectorIndexTypeTest : public ::testing::TestWithParam<std::string> {};
+
+TEST_P(VectorIndexTypeTest, RemoveAndReplace) {
+  std::vector<float> db = clusteredVectors(1000, 16, 3);
+  auto ids = sequentialIds(1000, 0);
+  auto index = VectorIndex::create(indexParams(GetParam()));
+  ASSERT_NE(index, nullptr);
+  index->add(db.data(), ids.data(), ids.size());
+
+  // 用底库向量本身查询，删除后不再出现在结果中
+  const int k = 10;
+  std::vector<float> scores(k);
+  std::vector<std::int64_t> result(k);
+  for (std::int64_t id : {0, 1, 500, 999}) {
+    ASSERT_TRUE(index->remove(id));
+    index->search(db.data() + id * DIM, 1, k, scores.data(), result.data());
+    for (std::int64_t found : result) ASSERT_NE(found, id);
+  }
+  EXPECT_FALSE(index->remove(0));
+  EXPECT_FALSE(index->remove(12345));
+  EXPECT_EQ(index->size(), 996);
+
+  // 已有的id再添加时替换原来的向量
+  std::vector<float> replacement(db.begin() + 700 * DIM,
+                                 db.begin() + 701 * DIM);
+  std::int64_t id = 3;
+  index->add(replacement.data(), &id, 1);
+  EXPECT_EQ(index->size(), 996);
+  index->search(replacement.data(), 1, 2, scores.data(), result.data());
+  EXPECT_TRUE(result[0] == 3 || result[1] == 3);
+}
+
+INSTANTIATE_TEST_CASE_P(Types, VectorIndexTypeTest,
+                        ::testing::Values("flat", "ivf", "ivf_pq", "hnsw"));
+
+std::unique_ptr<IvfIndex> createIvf(const std::string& type) {
+  return std::unique_ptr<IvfIndex>(
+      static_cast<IvfIndex*>(VectorIndex::create(indexParams(type)).release()));
+}
+
+TEST(IvfIndexTest, PendingUntilEnoughPoints) {
+  std::vector<float> db = clusteredVectors(400, 16, 4);
+  auto ids = sequentialIds(400, 0);
+  for (std::string type : {"ivf", "ivf_pq"}) {
+    auto index = createIvf(type);
+    // ivf需要nlist个训练点，ivf_pq还需要训练256个码字
+    std::size_t needed = type == "ivf" ? 32 : 256;
+    EXPECT_EQ(index->minTrainPoints(), needed);
+    index->add(db.data(), ids.data(), needed - 1);
+    EXPECT_FALSE(index->trained()) << type;
+    // 训练前暴力检索暂存的向量
+    float score;
+    std::int64_t found;
+    index->search(db.data() + 10 * DIM, 1, 1, &score, &found);
+    EXPECT_EQ(found, 10) << type;
+    ASSERT_TRUE(index->remove(10));
+    EXPECT_EQ(index->size(), needed - 2);
+
+    // 训练点不足时不训练
+    EXPECT_FALSE(index->train(db.data(), needed - 1));
+    EXPECT_FALSE(index->trained()) << type;
+
+    index->add(db.data() + (needed - 1) * DIM, ids.data() + needed - 1, 2);
+    EXPECT_TRUE(index->trained()) << type;
+    EXPECT_EQ(index->size(), needed);
+    index->search(db.data() + 20 * DIM, 1, 1, &score, &found);
+    EXPECT_EQ(found, 20) << type;
+  }
+}
+
+TEST(IvfIndexTest, IncrementalKeepsLists) {
+  // 逐个添加时聚类中心数不受第一批大小限制，nprobe=1只访问一个聚类
+  std::vector<float> db = clusteredVectors(2000, 64, 5);
+  auto ids = sequentialIds(2000, 0);
+  VectorIndexParams params = indexParams("ivf");
+  params.nprobe = 1;
+  auto index = VectorIndex::create(params);
+  for (std::size_t i = 0; i < ids.size(); ++i)
+    index->add(db.data() + i * DIM, ids.data() + i, 1);
+  const int k = 2000;
+  std::vector<float> scores(k);
+  std::vector<std::int64_t> result(k);
+  index->search(db.data(), 1, k, scores.data(), result.data());
+  int returned = 0;
+  for (std::int64_t found : result) returned += found >= 0;
+  EXPECT_EQ(result[0], 0);
+  EXPECT_LT(returned, k / 4);
+}
+
+TEST(IvfIndexTest, TrainAfterAdd) {
+  std::vector<float> db = clusteredVectors(1000, 16, 6);
+  auto ids = sequentialIds(1000, 0);
+  for (std::string type : {"ivf", "ivf_pq"}) {
+    // 先训练再添加
+    auto index = createIvf(type);
+    ASSERT_TRUE(index->train(db.data(), ids.size()));
+    index->add(db.data(), ids.data(), ids.size());
+    EXPECT_EQ(index->size(), ids.size());
+
+    // 已有向量时拒绝重新训练，原有的向量仍然可以检索
+    EXPECT_FALSE(index->train(db.data(), ids.size())) << type;
+    EXPECT_EQ(index->size(), ids.size());
+    float score;
+    std::int64_t found;
+    index->search(db.data() + 123 * DIM, 1, 1, &score, &found);
+    EXPECT_EQ(found, 123) << type;
+
+    // 全部删除后可以重新训练
+    for (std::int64_t id : ids) ASSERT_TRUE(index->remove(id));
+    EXPECT_TRUE(index->train(db.data(), ids.size())) << type;
+
+    // 训练前暂存的向量在显式训练后放入倒排表
+    auto pending = createIvf(type);
+    pending->add(db.data(), ids.data(), 10);
+    ASSERT_TRUE(pending->train(db.data(), ids.size()));
+    EXPECT_EQ(pending->size(), 10);
+    pending->search(db.data() + 5 * DIM, 1, 1, &score, &found);
+    EXPECT_EQ(found, 5) << type;
+  }
+}
+
+}  // namespace test
+}  // namespace sophon_stream